@@ -1,7 +1,11 @@
 #include "jewelgame.h"
 #include "texturemanager.h"
+#include "assetpack.h"
+#include "saveload.h"
+#include "startuptrace.h"
 #include <fstream>
 #include <ctime>
+#include <filesystem>
 #include <random>
 #include <iostream>
 #include <sstream>
@@ -10,29 +14,18 @@
 JewelGame::JewelGame() : window(nullptr), renderer(nullptr), font(nullptr),
                   selectedX1(-1), selectedY1(-1),
                   selectedX2(-1), selectedY2(-1),
-                  isSelecting(false), score(0),
-                  highScore(0), combo(0),
-                  rng(std::mt19937(std::random_device{}())),
+                  isSelecting(false),
+                  highScore(0),
                   boardOffsetX(0), boardOffsetY(0),
-                  gameState(GameState::MainMenu),
+                  gameState(GameState::Loading),
                   shuffleRemaining(3),
                   backgroundTexture(nullptr),
                   isSwapping(false), swapProgress(0.0f), swapDuration(0.0f),
                   selectedScale(1.0f) {
 
-    startButtonRect = {SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 150, 200, 50};
-    continueButtonRect = {SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, 200, 50};
-    instructionsButtonRect = {SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 + 50, 200, 50};
-
-    backButtonRect = {50, 50, 100, 40};
-    shuffleButtonRect = {50, 500, 150, 40};
-    restartButtonRect = {50, 20, 150, 40};
-    pauseButtonRect = {SCREEN_WIDTH - 180, 550, 150, 40};
-    continueButtonRect_pause = {SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, 200, 50};
-
-
     // Khởi tạo texture của đá qusy
-    for (int i = 0; i < NUM_JEWEL_TYPES; ++i) {
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        jewelHandles[i] = INVALID_TEXTURE;
         jewelTextures[i] = nullptr;
     }
 
@@ -46,24 +39,12 @@ JewelGame::JewelGame() : window(nullptr), renderer(nullptr), font(nullptr),
     }
 
     // Khởi tạo Levels
-    timedModeLevels = {
-        {1, 5 * 60, 1500, "Level 1 (5 Minutes - 1500)", 1500}, // Điểm số mục tiêu 5000
-        {2, 10 * 60, 3500, "Level 2 (10 Minutes - 3500)", 3500}, // Điểm số mục tiêu 12000
-        {3, 20 * 60, 8000, "Level 3 (20 Minutes - 8000)", 8000} // Điểm số mục tiêu 25000
-    };
-
-    // Khởi tạo các nút chọn level Timed Mode
-    int numLevels = timedModeLevels.size();
-    timedModeLevelButtonRects.resize(numLevels);
-    int startY = SCREEN_HEIGHT / 2 - (numLevels * 60) / 2; // Để các nút canh giữa màn hình
-
-    for (int i = 0; i < numLevels; ++i) {
-        timedModeLevelButtonRects[i] = {SCREEN_WIDTH / 2 - 150, startY + i * 60, 300, 50};
-    }
-    normalModeButtonRect = {SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 - 200, 300, 50};
-    timedModeButtonRect = {SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 + 100, 300, 50};
+    timedModeLevels = defaultTimedModeLevels();
+    layoutUi();
 
-    backToMainMenuButtonRect = {SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 + 50, 300, 50};
+    engine.rng.seed(((uint64_t)std::random_device{}() << 32) | std::random_device{}());
+    engine.listener = this;
+    endless.listener = this;
     initBoard();
     loadHighScore();
 }
@@ -73,86 +54,382 @@ JewelGame::~JewelGame() {
     cleanup();
 }
 
-// Vòng lặp chính - Game logic
+// Vòng lặp chính: main thread poll event và vẽ, sim thread chạy luật chơi
 void JewelGame::run() {
     if (!init()) return;
 
-    bool quit = false;
+    if (!runLoading()) {
+        cleanup();
+        return;
+    }
+
+    publishRenderState(SDL_GetTicks());
+    simRunning = true;
+    simThread = std::thread(&JewelGame::simulationLoop, this);
+
+    latencyProfiler.setFrequency(SDL_GetPerformanceFrequency());
+    scenarioStart = SDL_GetTicks();
+    bool quitRequested = false;
+    Uint32 nextFrameTime = SDL_GetTicks();
+    while (simRunning) {
+        // Chờ event tới lúc vẽ frame sau: input được bắt và gắn thời gian ngay, không phải đợi frame
+        SDL_Event e;
+        Sint32 waitMs = (Sint32)(nextFrameTime - SDL_GetTicks());
+        if (SDL_WaitEventTimeout(&e, waitMs > 0 ? waitMs : 0)) {
+            ALLOCATION_SITE("render/events");
+            do {
+                InputEvent input = {};
+                input.timestamp = e.common.timestamp;
+                input.captured = SDL_GetPerformanceCounter();
+                if (e.type == SDL_QUIT) {
+                    input.type = InputType::Quit;
+                    quitRequested = true;
+                } else if (e.type == SDL_MOUSEBUTTONDOWN) {
+                    input.type = InputType::MouseDown;
+                    input.x = e.button.x;
+                    input.y = e.button.y;
+                } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+                    showProfiler = !showProfiler; // Overlay thuộc render thread, không qua sim
+                    continue;
+                } else if (e.type == SDL_KEYDOWN) {
+                    input.type = InputType::KeyDown;
+                    input.key = e.key.keysym.sym;
+                } else {
+                    continue;
+                }
+
+                if (!inputQueue.push(input)) {
+                    std::cerr << "Input queue full, dropping event" << std::endl;
+                }
+            } while (SDL_PollEvent(&e));
+        }
+
+        // Quit không được mất dù hàng đợi đầy
+        if (quitRequested && inputQueue.push(InputEvent{InputType::Quit, 0, 0, 0, SDL_GetTicks(), SDL_GetPerformanceCounter()})) {
+            quitRequested = false;
+        }
+        injectScenarioInputs(SDL_GetTicks());
+
+        if ((Sint32)(SDL_GetTicks() - nextFrameTime) >= 0) {
+            renderStates.acquire();
+            const RenderState& view = renderStates.readBuffer();
+            Uint64 frameStart = SDL_GetPerformanceCounter();
+            render(view);
+            Uint64 presented = SDL_GetPerformanceCounter();
+            nextFrameTime = SDL_GetTicks() + FRAME_TIME_MS;
+
+            // Frame đầu tiên hiển thị kết quả của nước đi: chốt độ trễ input-to-photon
+            latencyProfiler.recordFrame(frameStart, presented);
+            if (view.latency.captured != 0 && view.latency.captured != lastPresentedInput) {
+                latencyProfiler.recordInput(view.latency, presented);
+                lastPresentedInput = view.latency.captured;
+            }
+            frameArena.reset();
+            AllocationTracker::endFrame();
+
+            if (!firstFrameRendered) {
+                firstFrameRendered = true;
+                StartupTrace::mark("first frame");
+            }
+        }
+    }
+
+    simThread.join();
+    if (versus && gameState == GameState::Versus) {
+        versus->report(std::cout); // Thoát giữa ván; ván xong đã in trong endVersus
+    }
+    if (!scenario.empty() || latencyProfiler.histogram(LATENCY_TOTAL).count() > 0) {
+        latencyProfiler.report(std::cout);
+        SDL_RendererInfo info = {};
+        SDL_GetRendererInfo(renderer, &info);
+        const LatencyHistogram& frames = latencyProfiler.histogram(LATENCY_FRAME);
+        std::cout << std::fixed << std::setprecision(2) << "[render] " << (info.name ? info.name : "?")
+                  << " renderer, software fast path " << (softRenderer.ready() ? "on" : "off") << ", frame p99 "
+                  << frames.percentile(0.99) << " ms of " << 1000.0 / 60 << " ms budget" << std::endl;
+        flow.report(std::cout);
+        if (wall.active()) {
+            std::cout << "[wall] " << wall.boardCount() << " boards, " << wall.movesPlayed() << " moves, last step "
+                      << wall.lastStepMs() << " ms" << std::endl;
+        }
+    }
+    AllocationTracker::report(std::cout);
+    cleanup();
+}
+
+// Worker decode asset, main thread vẽ thanh tiến độ rồi upload texture (chỉ render thread được tạo texture)
+bool JewelGame::runLoading() {
     SDL_Event e;
+    while (!assetLoader.isDone()) {
+        while (SDL_PollEvent(&e) != 0) {
+            if (e.type == SDL_QUIT) {
+                return false;
+            }
+        }
+
+        renderLoading();
+        SDL_RenderPresent(renderer);
+        SDL_Delay(FRAME_TIME_MS);
+    }
+
+    if (!finishLoading()) {
+        return false;
+    }
+    if (versus) {
+        gameState = GameState::Versus;
+    } else if (wallBoards > 0 && wallRenderer.ready()) {
+        wall.start(wallBoards, ((uint64_t)std::random_device{}() << 32) | std::random_device{}());
+        gameState = GameState::Wall;
+    } else {
+        gameState = autoplay ? GameState::Playing : GameState::MainMenu;
+    }
+    StartupTrace::mark("interactive");
+    return true;
+}
+
+void JewelGame::simulationLoop() {
     Uint32 lastUpdateTime = SDL_GetTicks();
 
-    while (!quit) {
+    while (simRunning) {
         Uint32 currentTime = SDL_GetTicks();
         float deltaTime = (currentTime - lastUpdateTime) / 1000.0f;
         lastUpdateTime = currentTime;
 
-        while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                if (gameState == GameState::Playing || gameState == GameState::Paused) {
-                    saveGameState();
-                }
-                quit = true;
-            } else if (e.type == SDL_MOUSEBUTTONDOWN) {
-                handleMouseClick(e.button.x, e.button.y);
-            }
+        InputEvent input;
+        while (simRunning && inputQueue.pop(input)) {
+            handleInput(input);
         }
+        if (!simRunning) break;
 
-        updateSwapAnimation(deltaTime * 1000.0f);
-        updateMatchAnimations(deltaTime * 1000.0f);
-        updateFallingAnimations(deltaTime * 1000.0f);
-
-        if (gameState == GameState::Playing && isTimedMode) {
-            Uint32 currentTime = SDL_GetTicks();
-            Uint32 elapsedTime = currentTime - timedModeStartTime;
-            int elapsedSeconds = elapsedTime / 1000;
-
-            if (elapsedSeconds >= 1) {
-                timeRemaining -= elapsedSeconds;
-                timedModeStartTime = currentTime;
-
-                TimedModeLevel currentLevel = timedModeLevels[selectedTimedModeLevel];
-                std::cout << "Score: " << score << ", Target: " << currentLevel.targetScore << ", Time: " << timeRemaining << std::endl;
-
-                if (score >= currentLevel.targetScore) {
-                    // Thắng cuộc!
-                    std::cout << "Congratulation! You won!" << std::endl;
-                    winLoseMessage = "Congratulation! You won!";
-                    gameState = GameState::GameOver;
-                    isTimedMode = false;
-                    selectedTimedModeLevel = -1;
-                    timeRemaining = 0;
-                } else if (timeRemaining <= 0) {
-                    // Thua cuộc!
-                    std::cout << "You lose!" << std::endl;
-                    winLoseMessage = "You lose!";
-                    gameState = GameState::GameOver;
-                    isTimedMode = false;
-                    selectedTimedModeLevel = -1;
-                    timeRemaining = 0;
-                }
-            }
+        updateSimulation(currentTime, deltaTime);
+        publishRenderState(currentTime);
+
+        Uint32 tickTime = SDL_GetTicks() - currentTime;
+        if (tickTime < SIM_TICK_MS) {
+            SDL_Delay(SIM_TICK_MS - tickTime);
+        }
+    }
+}
+
+void JewelGame::handleInput(const InputEvent& input) {
+    ALLOCATION_SITE("sim/input");
+    inputTimestamp = input.timestamp;
+    inputLatency = LatencyStamps();
+
+    if (input.type == InputType::Quit) {
+        if (gameState == GameState::Playing || gameState == GameState::Paused) {
+            saveGameState();
         }
+        finishGame(REPLAY_QUIT);
+        simRunning = false;
+    } else if (input.type == InputType::MouseDown) {
+        inputLatency.captured = input.captured;
+        inputLatency.handled = SDL_GetPerformanceCounter();
+        handleMouseClick(input.x, input.y);
+    } else if (input.type == InputType::KeyDown && input.key == SDLK_a) {
+        setAutoplay(!autoplay);
+    }
+
+    // Nước của bot không có input thật, không được tính vào độ trễ
+    inputLatency = LatencyStamps();
+}
 
-        render();
+// Kịch bản: mỗi dòng "<ms> click <x> <y>", "<ms> key <ký tự>" hoặc "<ms> quit", # là chú thích.
+// ms tính từ lúc vào game; không có quit thì game chạy tiếp sau bước cuối.
+bool JewelGame::loadScenario(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if (!file) {
+        std::cerr << "Failed to open scenario: " << filePath << std::endl;
+        return false;
+    }
+
+    scenario.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string command;
+        ScenarioStep step = {};
+        bool ok = (bool)(fields >> step.atMs >> command);
+        if (ok && command == "click") {
+            step.input.type = InputType::MouseDown;
+            ok = (bool)(fields >> step.input.x >> step.input.y);
+        } else if (ok && command == "key") {
+            std::string key;
+            ok = (bool)(fields >> key) && key.size() == 1;
+            step.input.type = InputType::KeyDown;
+            step.input.key = ok ? (SDL_Keycode)key[0] : 0; // Keycode của chữ cái là mã ASCII
+        } else if (ok && command == "quit") {
+            step.input.type = InputType::Quit;
+        } else {
+            ok = false;
+        }
 
-        Uint32 frameTime = SDL_GetTicks() - currentTime;
-        if (frameTime < 16) {
-            SDL_Delay(16 - frameTime);
+        if (!ok) {
+            std::cerr << filePath << ":" << lineNumber << ": invalid scenario step" << std::endl;
+            return false;
         }
+        scenario.push_back(step);
     }
 
-    cleanup();
+    std::stable_sort(scenario.begin(), scenario.end(), [](const ScenarioStep& a, const ScenarioStep& b) {
+        return a.atMs < b.atMs;
+    });
+    return true;
+}
+
+// Input giả lập đi đúng đường của input thật: gắn thời gian rồi đẩy vào inputQueue
+void JewelGame::injectScenarioInputs(Uint32 currentTime) {
+    while (scenarioNext < scenario.size() && currentTime - scenarioStart >= scenario[scenarioNext].atMs) {
+        InputEvent input = scenario[scenarioNext].input;
+        input.timestamp = currentTime;
+        input.captured = SDL_GetPerformanceCounter();
+        if (!inputQueue.push(input)) {
+            break; // Hàng đợi đầy, thử lại vòng sau
+        }
+        ++scenarioNext;
+    }
+}
+
+void JewelGame::updateSimulation(Uint32 currentTime, float deltaTime) {
+    ALLOCATION_SITE("sim/update");
+    if (autoplay && gameState == GameState::Playing) {
+        updateAutoplay(currentTime);
+    }
+    if (versus) {
+        updateVersus(currentTime);
+    }
+    if (gameState == GameState::Wall) {
+        wall.update(currentTime);
+    }
+
+    // Các luồng chờ sự kiện được thức ngay khi trạng thái đổi, không hỏi lại cờ mỗi frame
+    bool swapping = updateSwapAnimation(deltaTime * 1000.0f);
+    bool matching = updateMatchAnimations(deltaTime * 1000.0f);
+    bool falling = updateFallingAnimations(deltaTime * 1000.0f);
+    bool settled = !swapping && !matching && !falling;
+    if (settled && !boardSettled) {
+        flow.signal(FlowEvent::BoardSettled);
+    }
+    boardSettled = settled;
+    flow.update(); // Đồng hồ Timed Mode
+
+    // Autosave định kỳ, để mất điện giữa ván Timed Mode không mất cả phiên
+    if (gameState == GameState::Playing && currentTime - lastAutoSaveTime >= AUTOSAVE_INTERVAL) {
+        saveGameState();
+    }
 }
 
+// Chụp trạng thái cho render thread. Chỉ copy giá trị, render không đọc thẳng member nào của sim.
+void JewelGame::publishRenderState(Uint32 currentTime) {
+    ALLOCATION_SITE("sim/publish");
+    RenderState& view = renderStates.writeBuffer();
+    view.gameState = gameState;
+    view.simTime = currentTime;
+
+    memcpy(view.cells, engine.cells, sizeof(view.cells));
+    memcpy(view.jewelOffsetY, jewelOffsetY, sizeof(view.jewelOffsetY));
+    memcpy(view.matchedScale, matchedScale, sizeof(view.matchedScale));
+    memcpy(view.isAnimatingMatch, isAnimatingMatch, sizeof(view.isAnimatingMatch));
+
+    view.isSelecting = isSelecting;
+    view.selectedX1 = selectedX1;
+    view.selectedY1 = selectedY1;
+    view.selectedScale = selectedScale;
+    view.isSwapping = isSwapping;
+    view.swapProgress = swapProgress;
+    view.animStartX1 = animStartX1;
+    view.animStartY1 = animStartY1;
+    view.animStartX2 = animStartX2;
+    view.animStartY2 = animStartY2;
+
+    view.score = engine.score;
+    view.highScore = isEndlessMode ? endlessBest : highScore;
+    view.combo = engine.combo;
+    view.playerMoney = playerMoney;
+    view.shuffleRemaining = shuffleRemaining;
+    view.scoreHistoryCount = scoreHistoryCount;
+    memcpy(view.scoreHistory, scoreHistory, sizeof(view.scoreHistory));
+
+    view.hasSave = persistence.hasSave();
+    view.isPracticeMode = isPracticeMode;
+    view.undoCount = undoStack.undoCount();
+    view.redoCount = undoStack.redoCount();
+    view.isTimedMode = isTimedMode;
+    view.timeRemaining = timeRemaining;
+    snprintf(view.winLoseMessage, sizeof(view.winLoseMessage), "%s", winLoseMessage.c_str());
+    view.leaderboardRank = leaderboardRank;
+    view.leaderboardSize = leaderboardSize;
+    view.latency = swapLatency;
+    view.wallCount = gameState == GameState::Wall ? wall.boardCount() : 0;
+    wall.capture(view.wallBoards);
+    if (view.wallCount > 0) {
+        memcpy(view.cells, view.wallBoards[0].cells, sizeof(view.cells)); // Bàn đầu tường vẽ qua renderBoard
+    }
+    view.isEndlessMode = isEndlessMode;
+    if (isEndlessMode) {
+        endless.copyPreviewRow(view.endlessPreview);
+        view.endlessCleared = endless.bottomCleared();
+        view.endlessRows = endless.rowsScrolled();
+    }
+
+    const RollbackSession* session = versus ? versus->session() : nullptr;
+    view.versusStarted = session != nullptr;
+    if (session) {
+        const BoardEngine& mine = session->board(session->localPlayer());
+        const BoardEngine& theirs = session->board(1 - session->localPlayer());
+        memcpy(view.cells, mine.cells, sizeof(view.cells));
+        memcpy(view.opponentCells, theirs.cells, sizeof(view.opponentCells));
+        view.score = mine.score;
+        view.combo = mine.combo;
+        view.opponentScore = theirs.score;
+        view.versusTarget = session->targetScore();
+        view.versusRoundTripMs = versus->roundTripMs();
+        view.rollbackDepth = session->stats().lastDepth;
+        view.rollbackMs = (float)session->stats().lastResimMs;
+        view.rollbackCount = session->stats().rollbacks;
+    }
+
+    renderStates.publish();
+}
 
 void JewelGame::cleanup() {
+    if (pendingBotMove.valid()) {
+        pendingBotMove.wait();
+    }
+    saveHighScore();
+    persistence.stop(); // Ghi nốt bản lưu cuối trước khi thoát
+    profiles.close();
+    if (pendingReplayWrite.valid()) {
+        pendingReplayWrite.wait();
+    }
     if (font) {
         TTF_CloseFont(font);
         TTF_Quit();
     }
 
     // Giải phóng texture
+    TextureManager::Instance()->release(backgroundHandle);
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        TextureManager::Instance()->release(jewelHandles[i]);
+    }
+    backgroundHandle = INVALID_TEXTURE;
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        jewelHandles[i] = INVALID_TEXTURE;
+    }
     TextureManager::Instance()->clear();
+    assetLoader.clear();
+    UiScreen* screens[] = {&mainMenuUi, &instructionsUi, &modeSelectionUi, &timedLevelUi, &gameUi, &gameOverUi, &wallUi};
+    for (UiScreen* screen : screens) {
+        screen->release(); // Trước SDL_DestroyRenderer
+    }
+    softRenderer.release();
+    wallRenderer.release();
 
     // Gphong sound effc
     for (auto& pair : m_soundEffects) {
@@ -173,71 +450,172 @@ void JewelGame::cleanup() {
     }
 
     Mix_Quit();
-    saveHighScore();
     SDL_Quit();
 }
 
 //Khởi tạo bảng 8x8 đá quý
-void JewelGame::initBoard() {
+void JewelGame::initBoard(const LevelBand& band) {
+    LevelRecord level;
+    // Pack sinh với bộ lọc hẹp có thể không có bàn nào trong dải, khi đó lấy bàn bất kỳ trong pack
+    if (levelPack.sample(engine.rng, band.minMoves, band.maxMoves, level) ||
+        levelPack.sample(engine.rng, LEVEL_BAND_ANY.minMoves, LEVEL_BAND_ANY.maxMoves, level)) {
+        LevelPack::apply(level, engine);
+    } else {
+        engine.initBoard();
+    }
+
     for (int y = 0; y < BOARD_SIZE; y++) {
         for (int x = 0; x < BOARD_SIZE; x++) {
-            board[y][x] = getRandomJewel(x, y);
             jewelOffsetY[y][x] = -GRID_SIZE;
         }
     }
+}
 
-    bool hasInitialMatches;
-    do {
-        hasInitialMatches = checkMatchesAndMarkMatched();
-        if (hasInitialMatches) {
-            removeMatches();
-            dropJewels();
+// Sự kiện từ BoardEngine: âm thanh và hoạt ảnh
+void JewelGame::onMatchesRemoved(const bool matched[BOARD_SIZE][BOARD_SIZE]) {
+    replayRecorder.onMatchesRemoved(matched);
+    Mix_Chunk* matchSound = m_soundEffects["res/match.wav"];
+    if (matchSound) {
+        Mix_PlayChannel(-1, matchSound, 0);
+    }
+
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            if (matched[y][x]) {
+                matchedScale[y][x] = 1.0f;
+                isAnimatingMatch[y][x] = true;
+            }
         }
-    } while (hasInitialMatches);
+    }
 }
 
-// Hàm tạo ngẫu nhiên đá
-int JewelGame::getRandomJewel(int x, int y) {
-    std::vector<int> possibleJewels;
-    for (int jewel = 0; jewel < NUM_JEWEL_TYPES; ++jewel) {
-        if (!isMatchAt(x, y, jewel)) {
-            possibleJewels.push_back(jewel);
+void JewelGame::onSpecialSpawned(int cell, int value) {
+    replayRecorder.onSpecialSpawned(cell, value);
+}
+
+void JewelGame::onJewelsDropped(const int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]) {
+    replayRecorder.onJewelsDropped(dropDistance);
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        float columnDropDelay = (rand() % 100) / 100.0f;
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            if (dropDistance[y][x] > 0) {
+                jewelOffsetY[y][x] = -GRID_SIZE * dropDistance[y][x] - (columnDropDelay * GRID_SIZE);
+            } else {
+                jewelOffsetY[y][x] = 0.0f;
+            }
         }
     }
 
-    if (possibleJewels.empty()) {
-        std::uniform_int_distribution<int> dist(0, NUM_JEWEL_TYPES - 1);
-        return dist(rng);
+    Mix_Chunk* dropSound = m_soundEffects["res/drop.wav"];
+    if (dropSound) {
+        Mix_PlayChannel(-1, dropSound, 0);
     }
+}
 
-    std::uniform_int_distribution<int> dist(0, possibleJewels.size() - 1);
-    int index = dist(rng);
-    return possibleJewels[index];
+void JewelGame::onCascadeStep() {
+    updateMatchAnimations(16.0f);
 }
 
-// Hàm check điều kiện ăn đá
-bool JewelGame::isMatchAt(int x, int y, int jewel) {
-    // ngang
-    if (x >= 2 &&
-        board[y][x - 1] == jewel &&
-        board[y][x - 2] == jewel) {
-        return true;
+void JewelGame::onScore(const ScoreEvent& scoreEvent) {
+    replayRecorder.onScore(scoreEvent);
+    ScoreEvent event = scoreEvent;
+    event.timestamp = SDL_GetTicks();
+    // Mảng cố định, bỏ sự kiện cũ nhất khi đầy thay vì vector::erase
+    if (scoreHistoryCount == MAX_SCORE_HISTORY) {
+        memmove(scoreHistory, scoreHistory + 1, (MAX_SCORE_HISTORY - 1) * sizeof(ScoreEvent));
+        --scoreHistoryCount;
     }
+    scoreHistory[scoreHistoryCount++] = event;
+    ++scoreEventTotal;
 
-    // dọc
-    if (y >= 2 &&
-        board[y - 1][x] == jewel &&
-        board[y - 2][x] == jewel) {
-        return true;
+    // Endless không có điểm trần nên giữ kỷ lục riêng, không đè High Score của các mode khác
+    if (isEndlessMode) {
+        endlessBest = std::max(endlessBest, endless.score);
+    } else if (engine.score > highScore) {
+        highScore = engine.score;
+    }
+}
+
+// Versus: nước đi vừa chạy hoạt ảnh hóa ra không xảy ra, bỏ hoạt ảnh ăn/rơi và điểm bay lên của nó
+void JewelGame::onMoveRolledBack() {
+    memset(isAnimatingMatch, 0, sizeof(isAnimatingMatch));
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            matchedScale[y][x] = 1.0f;
+            jewelOffsetY[y][x] = 0.0f;
+        }
     }
 
-    return false;
+    // Các nước bị hủy là đuôi của dãy nước còn hiệu lực (ván đã kết thúc sớm hơn): mỗi lần báo bỏ nước cuối,
+    // báo đủ thì điểm bay lên về đúng lúc nước sớm nhất bị hủy bắt đầu. Versus chỉ mở lúc khởi động nên mốc đầu là 0.
+    if (versusMovesApplied == 0) return;
+    --versusMovesApplied;
+    uint32_t moveStart = versusMovesApplied > 0 ? versusMoveScoreEnd[(versusMovesApplied - 1) % VERSUS_RING] : 0;
+    uint32_t recorded = scoreEventTotal - moveStart;
+    scoreHistoryCount -= (int)std::min<uint32_t>(recorded, (uint32_t)scoreHistoryCount);
+    scoreEventTotal = moveStart;
+}
+
+void JewelGame::onMoveApplied() {
+    versusMoveScoreEnd[versusMovesApplied++ % VERSUS_RING] = scoreEventTotal;
 }
 
+// Đổi chỗ hai viên đá, dùng chung cho chuột và bot
+void JewelGame::performSwap(int x1, int y1, int x2, int y2) {
+    ALLOCATION_SITE("sim/performSwap");
+    if (!engine.isAdjacent(x1, y1, x2, y2)) return;
+
+    LatencyStamps stamps = inputLatency;
+    stamps.swapStart = SDL_GetPerformanceCounter();
+
+    GameSnapshot beforeMove = captureSnapshot();
+    isSwapping = true;
+    swapDuration = 200.0f;
+    // Hoạt ảnh tính từ lúc bắt input, không phải lúc sim xử lý
+    swapProgress = std::min(1.0f, (SDL_GetTicks() - inputTimestamp) / swapDuration);
+
+    animStartX1 = x1;
+    animStartY1 = y1;
+    animStartX2 = x2;
+    animStartY2 = y2;
+
+    replayRecorder.beginMove({(int8_t)x1, (int8_t)y1, (int8_t)x2, (int8_t)y2}, SDL_GetTicks());
+    bool accepted;
+    if (isEndlessMode) {
+        accepted = endless.trySwap(x1, y1, x2, y2);
+        syncEndlessWindow();
+    } else {
+        accepted = engine.trySwap(x1, y1, x2, y2);
+    }
+    replayRecorder.endMove(accepted);
+    if (!accepted) {
+        isSwapping = false;
+    } else {
+        if (isPracticeMode) {
+            undoStack.push(beforeMove);
+        }
+        saveGameState(); // Lưu sau mỗi nước đi
+        if (isTimedMode) {
+            flow.spawn(FlowGroup::Game, swapFlow());
+        }
+
+        if (stamps.captured != 0) {
+            stamps.resolved = SDL_GetPerformanceCounter();
+            swapLatency = stamps;
+        }
+    }
+
+    Mix_Chunk* swapSound = m_soundEffects["res/swap.wav"];
+    if (swapSound) {
+        Mix_PlayChannel(-1, swapSound, 0);
+    }
+}
 
 void JewelGame::handleMouseClick(int mouseX, int mouseY) {
     std::cout << "Mouse click at: (" << mouseX << ", " << mouseY << ")" << std::endl;  // DEBUG
-    if (gameState == GameState::MainMenu) {
+    if (gameState == GameState::Loading) {
+        return;
+    } else if (gameState == GameState::MainMenu) {
         handleMainMenuClick(mouseX, mouseY);
         return;
     } else if (gameState == GameState::ModeSelection) {
@@ -249,39 +627,63 @@ void JewelGame::handleMouseClick(int mouseX, int mouseY) {
     }else if (gameState == GameState::GameOver){
         handleGameOverClick(mouseX, mouseY);
         return;
+    } else if (gameState == GameState::Versus) {
+        handleVersusClick(mouseX, mouseY);
+        return;
+    } else if (gameState == GameState::Wall) {
+        wall.stop(); // Người xem bấm vào thì vào game thật
+        gameState = GameState::MainMenu;
+        return;
     }else if (gameState == GameState::Instructions) {
-        if (isButtonClicked(mouseX, mouseY, backButtonRect)) {
+        if (instructionsUi.actionAt(mouseX, mouseY) == UiAction::Back) {
             gameState = GameState::MainMenu;
         }
         return;
     }
 
+    UiAction action = gameUi.actionAt(mouseX, mouseY, gameUiHidden(isPracticeMode, gameState == GameState::Paused));
      if (gameState == GameState::Paused) {
-        if (isButtonClicked(mouseX, mouseY, continueButtonRect_pause)) {
+        if (action == UiAction::Resume) {
             pauseGame();
-        } else if (isButtonClicked(mouseX, mouseY, restartButtonRect)) {
+        } else if (action == UiAction::Restart) {
             restartGame();
         }
         return;
     }
 
-    if (isButtonClicked(mouseX, mouseY, pauseButtonRect)) {
+    if (action == UiAction::Pause) {
         pauseGame();
         return;
     }
 
-    if (isButtonClicked(mouseX, mouseY, restartButtonRect)) {
+    if (action == UiAction::Restart) {
         restartGame();
         return;
     }
 
-    if (shuffleRemaining > 0 && isButtonClicked(mouseX, mouseY, shuffleButtonRect) && (gameState == GameState::Playing)) {
+    if (action == UiAction::Undo) {
+        undoMove();
+        return;
+    }
 
-        int jewelCounts[NUM_JEWEL_TYPES];
-        countJewelTypes(jewelCounts);
-        restoreJewelTypes(jewelCounts);
+    if (action == UiAction::Redo) {
+        redoMove();
+        return;
+    }
+
+    if (shuffleRemaining > 0 && action == UiAction::Shuffle && (gameState == GameState::Playing)) {
+        if (isPracticeMode) {
+            undoStack.push(captureSnapshot());
+        }
 
+        if (isEndlessMode) {
+            endless.shuffle();
+            syncEndlessWindow();
+        } else {
+            engine.shuffle();
+        }
         shuffleRemaining--;
+        replayRecorder.keyframe(KEYFRAME_SHUFFLE, SDL_GetTicks());
         return;
     }
 
@@ -308,34 +710,7 @@ void JewelGame::handleMouseClick(int mouseX, int mouseY) {
             selectedY2 = y;
             selectedScale = 1.0f;
 
-            bool isAdjacent =
-                (abs(selectedX1 - selectedX2) == 1 && selectedY1 == selectedY2) ||
-                (abs(selectedY1 - selectedY2) == 1 && selectedX1 == selectedX2);
-
-            if (isAdjacent) {
-                isSwapping = true;
-                swapProgress = 0.0f;
-                swapDuration = 200.0f;
-
-                animStartX1 = selectedX1;
-                animStartY1 = selectedY1;
-                animStartX2 = selectedX2;
-                animStartY2 = selectedY2;
-
-                swapJewels();
-
-                if (!processSwappedJewels(selectedX1, selectedY1) && !processSwappedJewels(selectedX2, selectedY2)) {
-                    swapJewels();
-                    combo = 0;
-                    isSwapping = false;
-                } else {
-                  processCascadeMatches();
-                }
-                Mix_Chunk* swapSound = m_soundEffects["res/swap.wav"];
-                if (swapSound) {
-                    Mix_PlayChannel(-1, swapSound, 0);
-                }
-            }
+            performSwap(selectedX1, selectedY1, selectedX2, selectedY2);
 
             isSelecting = false;
             selectedX1 = selectedY1 = selectedX2 = selectedY2 = -1;
@@ -344,318 +719,274 @@ void JewelGame::handleMouseClick(int mouseX, int mouseY) {
 }
 
 
-bool JewelGame::processSwappedJewels(int x, int y) {
-    bool hasMatches = false;
-
-    int startX = std::max(0, x - 2);
-    int endX = std::min(BOARD_SIZE - 1, x + 2);
-    for (int i = startX; i <= endX - 2; ++i) {
-        if (board[y][i] != -1 && board[y][i] == board[y][i + 1] && board[y][i] == board[y][i + 2]) {
-            hasMatches = true;
-            break;
-        }
+void JewelGame::setAutoplay(bool enabled) {
+    autoplay = enabled;
+    if (autoplay && !bot) {
+        BotConfig config;
+        config.timeBudgetMs = 200;
+        config.tableBits = 18;
+        bot.reset(new JewelBot(config));
     }
-
-    int startY = std::max(0, y - 2);
-    int endY = std::min(BOARD_SIZE - 1, y + 2);
-    for (int i = startY; i <= endY - 2; ++i) {
-        if (board[i][x] != -1 && board[i][x] == board[i + 1][x] && board[i][x] == board[i + 2][x]) {
-            hasMatches = true;
-            break;
-        }
-    }
-
-    return hasMatches;
+    std::cout << "Autoplay " << (autoplay ? "on" : "off") << std::endl;
 }
 
-bool JewelGame::isButtonClicked(int x, int y, SDL_Rect rect) {
-    return (x >= rect.x && x <= rect.x + rect.w &&
-            y >= rect.y && y <= rect.y + rect.h);
-}
+void JewelGame::updateAutoplay(Uint32 currentTime) {
+    if (pendingBotMove.valid()) {
+        if (pendingBotMove.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
 
-int JewelGame::countMatchedJewels() {
-    int count = 0;
-    for (int y = 0; y < BOARD_SIZE; y++) {
-        for (int x = 0; x < BOARD_SIZE; x++) {
-            if (matched[y][x]) {
-                count++;
+        BotResult result = pendingBotMove.get();
+        if (memcmp(pendingBotCells, engine.cells, sizeof(pendingBotCells)) != 0) {
+            return; // Kết quả của bàn cũ (tắt autoplay giữa chừng rồi bật lại ở ván khác); tìm lại ở tick sau
+        }
+        lastAutoplayMove = currentTime;
+        inputTimestamp = currentTime;
+        if (result.found) {
+            performSwap(result.move.x1, result.move.y1, result.move.x2, result.move.y2);
+        } else {
+            if (isEndlessMode) {
+                endless.shuffle();
+                syncEndlessWindow();
+            } else {
+                engine.shuffle(); // Hết nước thì tráo để màn hình chờ chạy mãi
             }
+            replayRecorder.keyframe(KEYFRAME_SHUFFLE, currentTime);
         }
+        return;
     }
-    return count;
-}
-
-void JewelGame::calculateScore(int matchedJewels, int comboMultiplier) {
-    int basePoints = 0;
 
-    switch (matchedJewels) {
-    case 3:
-        basePoints = 10;
-        break;
-    case 4:
-        basePoints = 30;
-        break;
-    case 5:
-        basePoints = 60;
-        break;
-    default:
-        basePoints = matchedJewels * 10;
+    if (isSwapping || currentTime - lastAutoplayMove < AUTOPLAY_INTERVAL) {
+        return;
     }
 
-    int comboBonus = std::max(1, comboMultiplier);
-    int totalPoints = basePoints * comboBonus;
+    // Bot tìm trên bản copy của bàn, không đụng vào trạng thái đang vẽ
+    BoardEngine position = engine;
+    position.listener = nullptr;
+    memcpy(pendingBotCells, engine.cells, sizeof(pendingBotCells));
+    JewelBot* searcher = bot.get();
+    pendingBotMove = std::async(std::launch::async, [searcher, position] {
+        return searcher->chooseMove(position);
+    });
+}
 
-    ScoreEvent event;
-    event.points = totalPoints;
-    event.combo = comboMultiplier;
-    event.matchSize = matchedJewels;
-    event.timestamp = SDL_GetTicks();
+void JewelGame::restartGame() {
+    std::cout << "Restarting Game - Returning to Main Menu" << std::endl;
+    finishGame(REPLAY_QUIT);
+    flow.cancelAll();
 
-    scoreHistory.push_back(event);
+    engine.score = 0;
+    engine.combo = 0;
+    shuffleRemaining = 3;
+    memset(isAnimatingMatch, 0, sizeof(isAnimatingMatch));
+    scoreHistoryCount = 0;
 
-    if (scoreHistory.size() > 5) {
-        scoreHistory.erase(scoreHistory.begin());
-    }
+    initBoard(); // tạo lại bảng mới
 
-    score += totalPoints;
+    gameState = GameState::MainMenu; // Trở về Main Menu
+    isTimedMode = false;
+    isPracticeMode = false;
+    isEndlessMode = false;
+    undoStack.clear();
+    selectedTimedModeLevel = -1;
 
-    if (score > highScore) {
-        highScore = score;
-    }
+    Mix_ResumeMusic();
 }
 
-
-void JewelGame::swapJewels() {
-    std::swap(board[selectedY1][selectedX1], board[selectedY2][selectedX2]);
+// Pause Game
+void JewelGame::pauseGame() {
+    if (gameState == GameState::Playing) {
+        gameState = GameState::Paused;
+        Mix_PauseMusic();
+    } else if (gameState == GameState::Paused) {
+        gameState = GameState::Playing;
+        Mix_ResumeMusic();
+        flow.signal(FlowEvent::Resumed);
+    }
 }
 
-// hàm check và đánh đánh dấu các đá được ăn
-bool JewelGame::checkMatchesAndMarkMatched() {
-    memset(matched, 0, sizeof(matched));
-    bool hasMatches = false;
-
 
-    for (int y = 0; y < BOARD_SIZE; y++) {
-        for (int x = 0; x < BOARD_SIZE - 2; x++) {
-            if (board[y][x] != -1 &&
-                board[y][x] == board[y][x + 1] &&
-                board[y][x] == board[y][x + 2]) {
-
-                int endX = x + 2;
-                while (endX + 1 < BOARD_SIZE &&
-                       board[y][endX + 1] == board[y][x]) {
-                    endX++;
-                }
 
-                for (int i = x; i <= endX; i++) {
-                    matched[y][i] = true;
-                }
-                hasMatches = true;
-            }
-        }
+void JewelGame::saveGameState() {
+    ALLOCATION_SITE("sim/save");
+    if (isEndlessMode) {
+        return; // GameSnapshot chỉ chứa bàn 8x8, ván Endless không lưu để chơi tiếp
     }
+    // Việc ghi file do thread của AutoSaver làm
+    persistence.submitSave(captureSnapshot());
+    lastAutoSaveTime = SDL_GetTicks();
+}
 
 
-    for (int x = 0; x < BOARD_SIZE; x++) {
-        for (int y = 0; y < BOARD_SIZE - 2; y++) {
-            if (board[y][x] != -1 &&
-                board[y][x] == board[y + 1][x] &&
-                board[y][x] == board[y + 2][x]) {
-
-                int endY = y + 2;
-                while (endY + 1 < BOARD_SIZE &&
-                       board[endY + 1][x] == board[y][x]) {
-                    endY++;
-                }
 
-                for (int i = y; i <= endY; i++) {
-                    matched[i][x] = true;
-                }
-                hasMatches = true;
-            }
-        }
+bool JewelGame::loadGameState() {
+    GameSnapshot snapshot;
+    if (!persistence.loadSave(snapshot)) {
+        std::cerr << "No valid saved game state found." << std::endl;
+        return false;
     }
 
-    return hasMatches;
-}
-
-// Bỏ các đá được ăn
-void JewelGame::removeMatches() {
-     Mix_Chunk* matchSound = m_soundEffects["res/match.wav"];
-     if (matchSound) {
-        Mix_PlayChannel(-1, matchSound, 0);
-     }
+    // Level phải tồn tại trong timedModeLevels thì mới tiếp tục Timed Mode được
+    if ((snapshot.flags & SNAPSHOT_FLAG_TIMED) &&
+        (snapshot.timedModeLevel < 0 || snapshot.timedModeLevel >= (int)timedModeLevels.size() ||
+         snapshot.timeRemaining > timedModeLevels[snapshot.timedModeLevel].duration)) {
+        std::cerr << "Saved timed mode level is invalid." << std::endl;
+        return false;
+    }
 
-    for (int y = 0; y < BOARD_SIZE; y++) {
-        for (int x = 0; x < BOARD_SIZE; x++) {
-            if (matched[y][x]) {
-                matchedScale[y][x] = 1.0f;
-                isAnimatingMatch[y][x] = true;
-                board[y][x] = -1;
-            }
-        }
+    restoreSnapshot(snapshot);
+    undoStack.clear();
+    gameState = GameState::Playing;
+    if (isTimedMode) {
+        startTimedClock();
     }
+    startReplay(); // Keyframe đầu là bàn vừa nạp
+    return true;
 }
 
-// Thả đá lấp đầy
-void JewelGame::dropJewels() {
-    float columnDropDelay[BOARD_SIZE] = {0};
-
-    for (int x = 0; x < BOARD_SIZE; x++) {
-        int dropTo = BOARD_SIZE - 1;
-        columnDropDelay[x] = (rand() % 100) / 100.0f;
-
-        for (int y = BOARD_SIZE - 1; y >= 0; y--) {
-            if (board[y][x] != -1) {
-                board[dropTo][x] = board[y][x];
-
-                float baseOffset = -GRID_SIZE * (dropTo - y);
-                if (dropTo != y) {
-                    jewelOffsetY[dropTo][x] = baseOffset - (columnDropDelay[x] * GRID_SIZE);
-                    board[y][x] = -1;
-                    jewelOffsetY[y][x] = baseOffset - (columnDropDelay[x] * GRID_SIZE);
-                }
-                else {
-                    jewelOffsetY[dropTo][x] = 0.0f;
-                }
-
-                dropTo--;
-            } else {
-                jewelOffsetY[y][x] = 0.0f;
-            }
-        }
+GameSnapshot JewelGame::captureSnapshot() const {
+    GameSnapshot snapshot = {};
+    engine.capture(snapshot);
+    snapshot.playerMoney = playerMoney;
+    snapshot.timeRemaining = isTimedMode ? timeRemaining : 0;
+    snapshot.shuffleRemaining = shuffleRemaining;
+    snapshot.timedModeLevel = isTimedMode ? selectedTimedModeLevel : -1;
+    snapshot.flags = (isTimedMode ? SNAPSHOT_FLAG_TIMED : 0) | (isPracticeMode ? SNAPSHOT_FLAG_PRACTICE : 0);
+    return snapshot;
+}
 
-        while (dropTo >= 0) {
-            board[dropTo][x] = getRandomJewel(x, dropTo);
-            jewelOffsetY[dropTo][x] = -GRID_SIZE - (columnDropDelay[x] * GRID_SIZE);
-            dropTo--;
+void JewelGame::restoreSnapshot(const GameSnapshot& snapshot) {
+    engine.restore(snapshot);
+    playerMoney = snapshot.playerMoney;
+    shuffleRemaining = snapshot.shuffleRemaining;
+    isTimedMode = (snapshot.flags & SNAPSHOT_FLAG_TIMED) != 0;
+    isPracticeMode = (snapshot.flags & SNAPSHOT_FLAG_PRACTICE) != 0;
+    timeRemaining = snapshot.timeRemaining;
+    selectedTimedModeLevel = isTimedMode ? snapshot.timedModeLevel : -1;
+    highScore = std::max(highScore, engine.score);
+
+    // Bỏ các hoạt ảnh dở dang của trạng thái cũ
+    isSwapping = false;
+    isSelecting = false;
+    selectedScale = 1.0f;
+    selectedX1 = selectedY1 = selectedX2 = selectedY2 = -1;
+    memset(isAnimatingMatch, 0, sizeof(isAnimatingMatch));
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            matchedScale[y][x] = 1.0f;
+            jewelOffsetY[y][x] = 0.0f;
         }
     }
+}
 
-    Mix_Chunk* dropSound = m_soundEffects["res/drop.wav"];
-    if (dropSound) {
-        Mix_PlayChannel(-1, dropSound, 0);
+void JewelGame::undoMove() {
+    GameSnapshot previous;
+    if (undoStack.undo(captureSnapshot(), previous)) {
+        restoreSnapshot(previous);
+        replayRecorder.keyframe(KEYFRAME_RESTORE, SDL_GetTicks());
     }
-    processCascadeMatches();
 }
 
-// Hàm cho phép ăn các đá được match 1 cách liên tiếp
-void JewelGame::processCascadeMatches() {
-    bool hasMatches;
-
-    do {
-        hasMatches = checkMatchesAndMarkMatched();
-
-        if (hasMatches) {
-            calculateScore(countMatchedJewels(), combo + 1);
-            removeMatches();
-            dropJewels();
-        }
-
-         updateMatchAnimations(16.0f);
-
-    } while (hasMatches);
-
-    if (!hasMatches) {
-        combo = 0;
+void JewelGame::redoMove() {
+    GameSnapshot next;
+    if (undoStack.redo(captureSnapshot(), next)) {
+        restoreSnapshot(next);
+        replayRecorder.keyframe(KEYFRAME_RESTORE, SDL_GetTicks());
     }
 }
 
+void JewelGame::startReplay() {
+    finishReplay(REPLAY_QUIT); // Ván trước chưa kết thúc mà đã vào ván mới
 
-
-void JewelGame::restartGame() {
-    std::cout << "Restarting Game - Returning to Main Menu" << std::endl;
-
-    score = 0;
-    combo = 0;
-    shuffleRemaining = 3;
-    memset(matched, 0, sizeof(matched));
-    memset(isAnimatingMatch, 0, sizeof(isAnimatingMatch));
-    scoreHistory.clear();
-
-    initBoard(); // tạo lại bảng mới
-
-    gameState = GameState::MainMenu; // Trở về Main Menu
-    isTimedMode = false;
-    selectedTimedModeLevel = -1;
-
-    Mix_ResumeMusic();
+    ReplayHeader header;
+    header.version = REPLAY_VERSION;
+    header.mode = isTimedMode ? REPLAY_MODE_TIMED : (isPracticeMode ? REPLAY_MODE_PRACTICE : REPLAY_MODE_NORMAL);
+    header.timedLevel = (int8_t)(isTimedMode ? selectedTimedModeLevel : -1);
+    header.keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+    header.createdAt = (uint64_t)time(nullptr);
+    replayRecorder.begin(engine, header, SDL_GetTicks());
 }
 
-// Pause Game
-void JewelGame::pauseGame() {
-    if (gameState == GameState::Playing) {
-        gameState = GameState::Paused;
-        Mix_PauseMusic();
-    } else if (gameState == GameState::Paused) {
-        gameState = GameState::Playing;
-        Mix_ResumeMusic();
-    }
+void JewelGame::finishReplay(ReplayResult result) {
+    if (!replayRecorder.recording()) return;
+    replayRecorder.end(result, SDL_GetTicks());
+
+    ReplayHeader header;
+    replayFeed.header(header);
+    std::ostringstream name;
+    name << replayDirectory << "/" << header.createdAt << "-" << replayRecorder.moveCount() << ".jlrp";
+    std::string filePath = name.str();
+    std::vector<uint8_t> bytes = replayFeed.image(); // Vài KB; feed được dùng lại ngay cho ván sau
+
+    if (pendingReplayWrite.valid()) {
+        pendingReplayWrite.wait();
+    }
+    std::string directory = replayDirectory;
+    pendingReplayWrite = std::async(std::launch::async, [directory, filePath, bytes] {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        std::ofstream file(filePath, std::ios::binary);
+        if (!file || !file.write((const char*)bytes.data(), (std::streamsize)bytes.size())) {
+            std::cerr << "Failed to write replay " << filePath << std::endl;
+            return false;
+        }
+        std::cout << "Replay saved: " << filePath << " (" << bytes.size() << " bytes)" << std::endl;
+        return true;
+    });
 }
 
-
-
-void JewelGame::saveGameState() {
-    std::ofstream file(saveGameFile);
-    if (file.is_open()) {
-        file << score << std::endl;
-        file << highScore << std::endl;
-        file << combo << std::endl;
-        file << shuffleRemaining << std::endl;
-        file << playerMoney << std::endl;
-        file << isTimedMode << std::endl;
-        file << timeRemaining << std::endl;
-        file << selectedTimedModeLevel << std::endl;
-        file << timedModeStartTime << std::endl;
-
-
-        for (int y = 0; y < BOARD_SIZE; ++y) {
-            for (int x = 0; x < BOARD_SIZE; ++x) {
-                file << board[y][x] << " ";
-            }
-            file << std::endl;
+// Tìm hoặc tạo hồ sơ theo tên, tiền lấy từ hồ sơ. Không mở được kho thì vẫn chơi, chỉ không xếp hạng.
+void JewelGame::openProfile() {
+    if (!profiles.open(profileFile)) {
+        return;
+    }
+    profileId = profiles.findProfile(profileName);
+    if (profileId < 0) {
+        profileId = profiles.createProfile(profileName, playerMoney, (uint32_t)time(nullptr));
+        if (profileId < 0) {
+            std::cerr << "Unable to create profile " << profileName << std::endl;
+            return;
         }
-
-        file.close();
-    } else {
-        std::cerr << "Unable to open file for saving game state." << std::endl;
     }
-}
-
 
+    ProfileRecord record;
+    profiles.profile(profileId, record);
+    playerMoney = record.playerMoney;
+    std::cout << "Profile " << profileName << " (#" << profileId << " of " << profiles.profileCount()
+              << "), money " << playerMoney << std::endl;
+}
 
-bool JewelGame::loadGameState() {
-    std::ifstream file(saveGameFile);
-    if (file.is_open()) {
-        file >> score;
-        file >> highScore;
-        file >> combo;
-        file >> shuffleRemaining;
-        file >> playerMoney;
-        file >> isTimedMode;
-        file >> timeRemaining;
-        file >> selectedTimedModeLevel;
-        file >> timedModeStartTime;
-
-if(isTimedMode){
-          timedModeStartTime = SDL_GetTicks() - ((timedModeLevels[selectedTimedModeLevel].duration - timeRemaining)* 1000);
+void JewelGame::finishGame(ReplayResult result) {
+    if (!replayRecorder.recording()) return;
+
+    // Ván chưa đi nước nào (vào rồi thoát ngay) không tính
+    if (profileId >= 0 && replayRecorder.moveCount() > 0) {
+        ReplayHeader header;
+        replayFeed.header(header);
+        int board = BOARD_NORMAL;
+        if (header.mode == REPLAY_MODE_PRACTICE) {
+            board = BOARD_PRACTICE;
+        } else if (header.mode == REPLAY_MODE_TIMED) {
+            board = BOARD_TIMED_1 + header.timedLevel; // Level ngoài 3 level mặc định thì không có bảng
         }
-        for (int y = 0; y < BOARD_SIZE; ++y) {
-            for (int x = 0; x < BOARD_SIZE; ++x) {
-                file >> board[y][x];
-            }
+        if (board < NUM_LEADERBOARDS &&
+            profiles.recordGame(profileId, (LeaderboardId)board, engine.score, result == REPLAY_WON, playerMoney,
+                                (uint32_t)time(nullptr))) {
+            leaderboardRank = profiles.rank((LeaderboardId)board, profileId);
+            leaderboardSize = profiles.boardSize((LeaderboardId)board);
         }
-        gameState = GameState::Playing;
-        file.close();
-        return true;
-    } else {
-        std::cerr << "No saved game state found." << std::endl;
-        return false;
     }
+    finishReplay(result);
 }
 
 // Hàm khởi tạo
 bool JewelGame::init() {
+    if (headless) {
+        // Chạy kịch bản không cần màn hình/loa: driver dummy chỉ có renderer phần mềm
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
         std::cerr << "SDL init failed: " << SDL_GetError() << std::endl;
         return false;
@@ -670,16 +1001,30 @@ bool JewelGame::init() {
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, (headless || forceSoftware) ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED);
+    if (!renderer && !headless && !forceSoftware) {
+        // Máy không có GPU dùng được: renderer phần mềm, bàn đá đi đường SoftRenderer
+        std::cerr << "Accelerated renderer failed: " << SDL_GetError() << ", using software" << std::endl;
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    }
     if (!renderer) {
         std::cerr << "Renderer creation failed: " << SDL_GetError() << std::endl;
         return false;
     }
 
+    // Không có pack thì dùng file rời trong res/
+    if (!AssetPack::Instance()->open(assetPackFile)) {
+        std::cout << "No asset pack, loading loose files" << std::endl;
+    }
+
     if (!initFont()) {
         std::cerr << "Failed to init font!" << std::endl;
         return false;
     }
+    if (!buildUi()) {
+        std::cerr << "Failed to build UI!" << std::endl;
+        return false;
+    }
 
     // khởi tạo SDL_image
     int imgFlags = IMG_INIT_PNG;
@@ -694,41 +1039,120 @@ bool JewelGame::init() {
         return false;
     }
 
-    // chuyển sang texture
-    backgroundTexture = TextureManager::Instance()->loadTexture("res/background.png", renderer);
+    // Decode ảnh và sound effect trên worker pool, màn Loading vẫn được vẽ trong lúc chờ
+    assetLoader.addImage("res/background.png");
+    assetLoader.addImage("res/jewel_red.png");
+    assetLoader.addImage("res/jewel_green.png");
+    assetLoader.addImage("res/jewel_blue.png");
+    assetLoader.addImage("res/jewel_yellow.png");
+    assetLoader.addImage("res/jewel_purple.png");
+    assetLoader.addImage("res/jewel_cyan.png");
+    assetLoader.addImage("res/jewel_horizontal_red.png");
+    assetLoader.addImage("res/jewel_horizontal_green.png");
+    assetLoader.addImage("res/jewel_horizontal_blue.png");
+    assetLoader.addImage("res/jewel_horizontal_yellow.png");
+    assetLoader.addImage("res/jewel_horizontal_purple.png");
+    assetLoader.addImage("res/jewel_horizontal_cyan.png");
+    assetLoader.addImage("res/jewel_colorbomb.png");
+    assetLoader.addSound("res/swap.wav");
+    assetLoader.addSound("res/match.wav");
+    assetLoader.addSound("res/drop.wav");
+    assetLoader.start();
+
+    boardOffsetX = (SCREEN_WIDTH - BOARD_SIZE * GRID_SIZE) / 2;
+    boardOffsetY = (SCREEN_HEIGHT - BOARD_SIZE * GRID_SIZE) / 2;
+
+    // Có level pack thì thay bàn ngẫu nhiên tạo trong constructor bằng bàn chọn sẵn
+    if (levelPack.open(levelPackFile)) {
+        initBoard();
+    }
+
+    importLegacySave(legacySaveGameFile, saveGameFile);
+    persistence.start(saveGameFile, highScoreFile);
+    loadHighScore();
+    openProfile();
+
+    StartupTrace::mark("init done");
+    return true;
+}
+
+// Upload các surface đã decode lên GPU (phải chạy trên render thread)
+bool JewelGame::finishLoading() {
+    // Renderer phần mềm cần ảnh gốc để scale sẵn, giữ surface tới khi SoftRenderer build xong
+    bool buildSoftPath = softFastPath && SoftRenderer::isSoftware(renderer);
+    bool keepSurfaces = buildSoftPath || wallBoards > 0; // Tường cũng gói ảnh gốc vào atlas riêng
+    std::map<std::string, SDL_Surface*> decoded;
+    for (auto& asset : assetLoader.assets()) {
+        std::cout << "[startup] decoded " << asset.filePath << " in " << asset.decodeMs << " ms" << std::endl;
+
+        if (asset.type == AssetLoader::AssetType::Image && asset.surface) {
+            // Upload rồi trả ref ngay, texture nằm trong cache LRU cho tới khi được acquire bên dưới
+            TextureHandle handle = TextureManager::Instance()->acquireFromSurface(asset.filePath, asset.surface, renderer);
+            TextureManager::Instance()->release(handle);
+            if (keepSurfaces) {
+                decoded[asset.filePath] = asset.surface;
+            } else {
+                SDL_FreeSurface(asset.surface);
+            }
+            asset.surface = nullptr;
+        } else if (asset.type == AssetLoader::AssetType::Sound && asset.sound) {
+            m_soundEffects[asset.filePath] = asset.sound;
+            asset.sound = nullptr;
+        }
+    }
+    assetLoader.wait();
+
+    // Lấy lại từ cache của TextureManager
+    backgroundHandle = TextureManager::Instance()->acquire("res/background.png", renderer);
+    backgroundTexture = TextureManager::Instance()->get(backgroundHandle);
     if (!backgroundTexture) {
         std::cerr << "Failed to load background image!" << std::endl;
         return false;
     }
 
-    // tải các texture đá quý
-    jewelTextures[0] = TextureManager::Instance()->loadTexture("res/jewel_red.png", renderer);
-    jewelTextures[1] = TextureManager::Instance()->loadTexture("res/jewel_green.png", renderer);
-    jewelTextures[2] = TextureManager::Instance()->loadTexture("res/jewel_blue.png", renderer);
-    jewelTextures[3] = TextureManager::Instance()->loadTexture("res/jewel_yellow.png", renderer);
-    jewelTextures[4] = TextureManager::Instance()->loadTexture("res/jewel_purple.png", renderer);
-    jewelTextures[5] = TextureManager::Instance()->loadTexture("res/jewel_cyan.png", renderer);
-
-    for (int i = 0; i < NUM_JEWEL_TYPES; ++i) {
+    const char* jewelFiles[NUM_CELL_VALUES] = {
+        "res/jewel_red.png", "res/jewel_green.png", "res/jewel_blue.png",
+        "res/jewel_yellow.png", "res/jewel_purple.png", "res/jewel_cyan.png",
+        "res/jewel_horizontal_red.png", "res/jewel_horizontal_green.png", "res/jewel_horizontal_blue.png",
+        "res/jewel_horizontal_yellow.png", "res/jewel_horizontal_purple.png", "res/jewel_horizontal_cyan.png",
+        "res/jewel_colorbomb.png"
+    };
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        jewelHandles[i] = TextureManager::Instance()->acquire(jewelFiles[i], renderer);
+        jewelTextures[i] = TextureManager::Instance()->get(jewelHandles[i]);
         if (!jewelTextures[i]) {
             std::cerr << "Failed to load jewel texture at index: " << i << std::endl;
             return false;
         }
     }
+    TextureManager::Instance()->printStats();
 
-    //tải Sound Effect
-    loadSound("res/swap.wav");
-    loadSound("res/match.wav");
-    loadSound("res/drop.wav");
+    SDL_Surface* jewelSurfaces[NUM_CELL_VALUES];
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        jewelSurfaces[i] = keepSurfaces ? decoded[jewelFiles[i]] : nullptr;
+    }
+    if (wallBoards > 0 && !wallRenderer.build(renderer, jewelSurfaces, font)) {
+        std::cerr << "Attract wall unavailable, starting normally" << std::endl;
+    }
+    if (buildSoftPath) {
+        SDL_Rect layer = {boardOffsetX - GRID_SIZE / 2, 0, BOARD_SIZE * GRID_SIZE + GRID_SIZE, SCREEN_HEIGHT};
+        SDL_Rect frame = {boardOffsetX - 10, boardOffsetY - 10, BOARD_SIZE * GRID_SIZE + 20, BOARD_SIZE * GRID_SIZE + 20};
+        if (softRenderer.build(renderer, jewelSurfaces, decoded["res/background.png"], layer, frame, {100, 100, 100, 255})) {
+            softRenderer.prepare((int)(GRID_SIZE * 1.2f)); // Đá đang được chọn
+            if (softRenderer.background()) {
+                backgroundTexture = softRenderer.background();
+            }
+            std::cout << "Software renderer: board fast path with " << softRenderer.spriteCount() << " cached sprites"
+                      << std::endl;
+        }
+    }
+    for (auto& entry : decoded) {
+        SDL_FreeSurface(entry.second);
+    }
 
-    //tải Background Music
+    //tải Background Music (Mix_LoadMUS chỉ mở stream, không decode cả file)
     loadBackgroundMusic("res/background_music.mp3");
 
-    boardOffsetX = (SCREEN_WIDTH - BOARD_SIZE * GRID_SIZE) / 2;
-    boardOffsetY = (SCREEN_HEIGHT - BOARD_SIZE * GRID_SIZE) / 2;
-
-    loadHighScore();
-
     //bật background music
     if (m_backgroundMusic) {
         Mix_PlayMusic(m_backgroundMusic, -1);
@@ -739,60 +1163,45 @@ bool JewelGame::init() {
 
 
 bool JewelGame::loadHighScore() {
-    std::ifstream file(highScoreFile);
-    if (file.is_open()) {
-        file >> highScore;
-        file.close();
-        return true;
-    } else {
-        std::ofstream newFile(highScoreFile);
-        if (newFile.is_open()) {
-            newFile << 0;
-            newFile.close();
-            highScore = 0;
-            return true;
-        } else {
-            std::cerr << "Unable to create highscore file" << std::endl;
-            return false;
-        }
-    }
+    highScore = std::max(highScore, persistence.highScore());
+    return true;
 }
 
 
 
 bool JewelGame::saveHighScore() {
-    std::ofstream file(highScoreFile);
-    if (file.is_open()) {
-        file << highScore;
-        file.close();
-        return true;
-    } else {
-        std::cerr << "Unable to open highscore file for saving" << std::endl;
-        return false;
+    if (highScore <= persistence.highScore()) {
+        return true; // Không có gì mới để ghi
     }
+    return persistence.saveHighScore(highScore);
 }
 
 // Hàm tạo hoạt ảnh đổi đá
-void JewelGame::updateSwapAnimation(float deltaTime) {
-    if (!isSwapping) return;
+bool JewelGame::updateSwapAnimation(float deltaTime) {
+    if (!isSwapping) return false;
 
     swapProgress += deltaTime / swapDuration;
 
     if (swapProgress >= 1.0f) {
         swapProgress = 1.0f;
         isSwapping = false;
+        flow.signal(FlowEvent::SwapFinished);
     }
+    return isSwapping;
 }
 
 // Hàm tạo hoạt ảnh rơi
-void JewelGame::updateFallingAnimations(float deltaTime) {
+bool JewelGame::updateFallingAnimations(float deltaTime) {
+   bool falling = false;
    for (int y = 0; y < BOARD_SIZE; y++) {
         for (int x = 0; x < BOARD_SIZE; x++) {
-            if (jewelOffsetY[y][x] < 0 || board[y][x] == -1) {
+            if (jewelOffsetY[y][x] < 0 || engine.cells[y][x] == -1) {
                 updateJewelFall(x, y, deltaTime);
+                falling = falling || jewelOffsetY[y][x] < 0;
             }
         }
     }
+    return falling;
 }
 
 // Tạo các khoảng trống ảo cho phép đá rơi 1 cách lần lượt
@@ -805,7 +1214,8 @@ void JewelGame::updateJewelFall(int x, int y, float deltaTime) {
 }
 
 // tạo hoạt ảnh khi đá dược ăn
-void JewelGame::updateMatchAnimations(float deltaTime) {
+bool JewelGame::updateMatchAnimations(float deltaTime) {
+    bool animating = false;
     for (int y = 0; y < BOARD_SIZE; y++) {
         for (int x = 0; x < BOARD_SIZE; x++) {
             if (isAnimatingMatch[y][x]) {
@@ -813,19 +1223,80 @@ void JewelGame::updateMatchAnimations(float deltaTime) {
                 if (matchedScale[y][x] > 1.5f) {
                     matchedScale[y][x] = 1.0f;
                     isAnimatingMatch[y][x] = false;
+                } else {
+                    animating = true;
                 }
             }
         }
     }
+    return animating;
 }
 
 
-void JewelGame::drawButton(SDL_Rect rect, const std::string& text, SDL_Color color) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderFillRect(renderer, &rect);
+// Nút và chữ tĩnh của mọi màn, chỉ thêm một lần
+void JewelGame::layoutUi() {
+    SDL_Color buttonColor = {100, 100, 200, 255};
+    SDL_Color textColor = {255, 255, 255, 255};
+
+    mainMenuUi.addButton({SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 150, 200, 50}, "Start", buttonColor, UiAction::Start);
+    continueWidget = mainMenuUi.addButton({SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, 200, 50}, "Continue", buttonColor,
+                                          UiAction::Continue);
+    mainMenuUi.addButton({SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 + 50, 200, 50}, "Instructions", buttonColor,
+                         UiAction::Instructions);
+
+    instructionsUi.addLabel({SCREEN_WIDTH / 2 - 50, 100, 0, 0}, "Instructions:", textColor);
+    instructionsUi.addLabel({SCREEN_WIDTH / 2 - 200, 200, 0, 0}, "1. Click on two adjacent jewels to swap them.", textColor);
+    instructionsUi.addLabel({SCREEN_WIDTH / 2 - 200, 250, 0, 0}, "2. Match 3 or more jewels to score points.", textColor);
+    instructionsUi.addLabel({SCREEN_WIDTH / 2 - 200, 300, 0, 0}, "3. Try to get the highest score!", textColor);
+    instructionsUi.addButton({50, 50, 100, 40}, "Back", buttonColor, UiAction::Back);
+
+    modeSelectionUi.addButton({SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 - 200, 300, 50}, "Normal Mode", buttonColor,
+                              UiAction::NormalMode);
+    modeSelectionUi.addButton({SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 - 50, 300, 50}, "Practice Mode", buttonColor,
+                              UiAction::PracticeMode);
+    modeSelectionUi.addButton({SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 + 100, 300, 50}, "Timed Mode", buttonColor,
+                              UiAction::TimedMode);
+    modeSelectionUi.addButton({SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 + 200, 300, 50}, "Endless Mode", buttonColor,
+                              UiAction::EndlessMode);
+
+    int numLevels = timedModeLevels.size();
+    int startY = SCREEN_HEIGHT / 2 - (numLevels * 60) / 2; // Để các nút canh giữa màn hình
+    for (int i = 0; i < numLevels; ++i) {
+        timedLevelUi.addButton({SCREEN_WIDTH / 2 - 150, startY + i * 60, 300, 50}, timedModeLevels[i].name.c_str(), buttonColor,
+                               UiAction::TimedLevel, i);
+    }
+
+    shuffleWidget = gameUi.addButton({50, 500, 150, 40}, "Shuffle", buttonColor, UiAction::Shuffle);
+    gameUi.addButton({50, 20, 150, 40}, "Restart", {100, 200, 100, 255}, UiAction::Restart);
+    gameUi.addButton({SCREEN_WIDTH - 180, 550, 150, 40}, "Pause", {200, 100, 100, 255}, UiAction::Pause);
+    undoWidget = gameUi.addButton({50, 300, 70, 40}, "Undo", buttonColor, UiAction::Undo);
+    redoWidget = gameUi.addButton({130, 300, 70, 40}, "Redo", buttonColor, UiAction::Redo);
+    // Bấm vào dòng "Game Paused" để chơi tiếp
+    resumeWidget = gameUi.addLabel({SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, 200, 50}, "Game Paused", textColor,
+                                   UiAction::Resume);
+
+    gameOverUi.addButton({SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2 + 50, 300, 50}, "Back to Main Menu", buttonColor,
+                         UiAction::BackToMainMenu);
+
+    wallUi.addLabel({SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT - 28, 0, 0}, "Click anywhere to play", textColor);
+}
+
+// Đo chữ và tạo texture chữ cho mọi màn, trên render thread sau initFont()
+bool JewelGame::buildUi() {
+    UiScreen* screens[] = {&mainMenuUi, &instructionsUi, &modeSelectionUi, &timedLevelUi, &gameUi, &gameOverUi, &wallUi};
+    bool ok = true;
+    for (UiScreen* screen : screens) {
+        ok = screen->build(renderer, font) && ok;
+    }
+    return ok;
+}
 
-    SDL_Color textColor = {0, 0, 0, 255};
-    renderText(text, rect.x + rect.w / 2 - text.length() * 5, rect.y + rect.h / 2 - 9, textColor);
+// Undo/Redo chỉ có trong Practice Mode, dòng "Game Paused" chỉ hiện khi tạm dừng
+uint32_t JewelGame::gameUiHidden(bool practiceMode, bool paused) const {
+    uint32_t hidden = 0;
+    if (!practiceMode) hidden |= (1u << undoWidget) | (1u << redoWidget);
+    if (!paused) hidden |= 1u << resumeWidget;
+    return hidden;
 }
 
 //tải Sound Effect
@@ -834,7 +1305,10 @@ Mix_Chunk* JewelGame::loadSound(const std::string& filePath) {
         return m_soundEffects[filePath];
     }
 
-    Mix_Chunk* sound = Mix_LoadWAV(filePath.c_str());
+    Mix_Chunk* sound = AssetPack::Instance()->loadSound(filePath);
+    if (sound == nullptr) {
+        sound = Mix_LoadWAV(filePath.c_str());
+    }
     if (sound == nullptr) {
         std::cerr << "Failed to load sound: " << filePath << " Error: " << Mix_GetError() << std::endl;
         return nullptr;
@@ -846,7 +1320,13 @@ Mix_Chunk* JewelGame::loadSound(const std::string& filePath) {
 
 //tải Background Music
 bool JewelGame::loadBackgroundMusic(const std::string& filePath) {
-    m_backgroundMusic = Mix_LoadMUS(filePath.c_str());
+    // Mix_LoadMUS_RW stream thẳng từ vùng nhớ của pack
+    SDL_RWops* packedMusic = AssetPack::Instance()->openRW(filePath);
+    if (packedMusic != nullptr) {
+        m_backgroundMusic = Mix_LoadMUS_RW(packedMusic, 1);
+    } else {
+        m_backgroundMusic = Mix_LoadMUS(filePath.c_str());
+    }
     if (m_backgroundMusic == nullptr) {
         std::cerr << "Failed to load background music: " << filePath << " Error: " << Mix_GetError() << std::endl;
         return false;
@@ -854,26 +1334,30 @@ bool JewelGame::loadBackgroundMusic(const std::string& filePath) {
     return true;
 }
 
-// Vẽ Main Menu
-void JewelGame::renderMainMenu() {
-    std::cout << "Rendering Main Menu" << std::endl;  // DEBUG
-    SDL_RenderCopy(renderer, backgroundTexture, NULL, NULL);
+// Vẽ màn Loading
+void JewelGame::renderLoading() {
+    SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
+    SDL_RenderClear(renderer);
 
-    SDL_Color buttonColor = {100, 100, 200, 255};
-    SDL_Color disabledButtonColor = {150, 150, 150, 255};
+    renderText("Loading...", SCREEN_WIDTH / 2 - 40, SCREEN_HEIGHT / 2 - 40, {255, 255, 255, 255});
 
-    drawButton(startButtonRect, "Start", buttonColor);
+    SDL_Rect barRect = {SCREEN_WIDTH / 2 - 150, SCREEN_HEIGHT / 2, 300, 20};
+    SDL_SetRenderDrawColor(renderer, 80, 80, 80, 255);
+    SDL_RenderFillRect(renderer, &barRect);
 
-    std::ifstream file(saveGameFile);
-    if (file.is_open()){//In jewelgame.cpp
+    SDL_Rect fillRect = barRect;
+    fillRect.w = (int)(barRect.w * assetLoader.progress());
+    SDL_SetRenderDrawColor(renderer, 100, 100, 200, 255);
+    SDL_RenderFillRect(renderer, &fillRect);
+}
 
-        file.close();
-        drawButton(continueButtonRect, "Continue", buttonColor);
-    } else {
-        drawButton(continueButtonRect, "Continue", disabledButtonColor);
-    }
+// Vẽ Main Menu
+void JewelGame::renderMainMenu(const RenderState& view) {
+    std::cout << "Rendering Main Menu" << std::endl;  // DEBUG
+    SDL_RenderCopy(renderer, backgroundTexture, NULL, NULL);
 
-    drawButton(instructionsButtonRect, "Instructions", buttonColor);
+    // hasSave lấy từ cache của PersistenceService, không mở file mỗi frame
+    mainMenuUi.draw(renderer, 0, view.hasSave ? 0 : 1u << continueWidget);
 }
 
 // Vẽ Instructions
@@ -882,19 +1366,12 @@ void JewelGame::renderInstructions() {
     SDL_SetRenderDrawColor(renderer, backgroundColor.r, backgroundColor.g, backgroundColor.b, backgroundColor.a);
     SDL_RenderClear(renderer);
 
-    SDL_Color textColor = {255, 255, 255, 255};
-    renderText("Instructions:", SCREEN_WIDTH / 2 - 50, 100, textColor);
-
-    renderText("1. Click on two adjacent jewels to swap them.", SCREEN_WIDTH / 2 - 200, 200, textColor);
-    renderText("2. Match 3 or more jewels to score points.", SCREEN_WIDTH / 2 - 200, 250, textColor);
-    renderText("3. Try to get the highest score!", SCREEN_WIDTH / 2 - 200, 300, textColor);
-
-    SDL_Color buttonColor = {100, 100, 200, 255};
-    drawButton(backButtonRect, "Back", buttonColor);
+    instructionsUi.draw(renderer);
 }
 
 // Vẽ Scoreboard
-void JewelGame::renderScoreboard() {
+void JewelGame::renderScoreboard(const RenderState& view) {
+    ALLOCATION_SITE("render/scoreboard");
     SDL_Rect scoreboardRect = {
         SCREEN_WIDTH - 200,
         0,
@@ -904,71 +1381,74 @@ void JewelGame::renderScoreboard() {
     SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
     SDL_RenderFillRect(renderer, &scoreboardRect);
 
-    renderText("Score: " + std::to_string(score),
+    // Chuỗi tạm nằm trong frameArena, không cấp phát heap mỗi frame
+    renderText(frameArena.format("Score: %d", view.score),
                SCREEN_WIDTH - 180, 20, {255, 255, 255});
 
-    renderText("High Score: " + std::to_string(highScore),
+    renderText(frameArena.format(view.isEndlessMode ? "Endless Best: %d" : "High Score: %d", view.highScore),
                SCREEN_WIDTH - 180, 50, {255, 255, 0});
 
-    renderText("Combo: x" + std::to_string(combo),
+    renderText(frameArena.format("Combo: x%d", view.combo),
                SCREEN_WIDTH - 180, 80, {0, 255, 0});
 
-    std::stringstream moneyString;
-    moneyString << "Money: " << playerMoney;
-    renderText(moneyString.str(), SCREEN_WIDTH - 180, 110, {255, 255, 255});
+    renderText(frameArena.format("Money: %d", view.playerMoney), SCREEN_WIDTH - 180, 110, {255, 255, 255});
 
     int yOffset = 150;
     renderText("Score History:",
                SCREEN_WIDTH - 180, yOffset, {200, 200, 200});
 
-    for (const auto &event : scoreHistory) {
+    for (int i = 0; i < view.scoreHistoryCount; ++i) {
+        const ScoreEvent& event = view.scoreHistory[i];
         yOffset += 30;
-        std::string eventText =
-            "+" + std::to_string(event.points) +
-            " (Combo: x" + std::to_string(event.combo) + ")";
-
-        renderText(eventText,
+        renderText(frameArena.format("+%d (Combo: x%d)", event.points, event.combo),
                    SCREEN_WIDTH - 180, yOffset, {150, 255, 150});
     }
 
-    renderText("Shuffles remaining: " + std::to_string(shuffleRemaining),
+    renderText(frameArena.format("Shuffles remaining: %d", view.shuffleRemaining),
                50, 450, {255, 255, 0});
 
-    SDL_Color buttonColor = (shuffleRemaining > 0) ? SDL_Color{100, 100, 200, 255} : SDL_Color{150, 150, 150, 255};
-    drawButton(shuffleButtonRect, "Shuffle", buttonColor);
-    drawButton(restartButtonRect, "Restart", {100, 200, 100, 255});
-    drawButton(pauseButtonRect, "Pause", {200, 100, 100, 255});
+    uint32_t disabled = 0;
+    if (view.shuffleRemaining <= 0) disabled |= 1u << shuffleWidget;
+    if (view.undoCount <= 0) disabled |= 1u << undoWidget;
+    if (view.redoCount <= 0) disabled |= 1u << redoWidget;
+    gameUi.draw(renderer, gameUiHidden(view.isPracticeMode, view.gameState == GameState::Paused), disabled);
 }
 
 // Tạo bảng game 8x8
-void JewelGame::renderBoard() {
-    int boardOffsetX = (SCREEN_WIDTH - BOARD_SIZE * GRID_SIZE) / 2;
-    int boardOffsetY = (SCREEN_HEIGHT - BOARD_SIZE * GRID_SIZE) / 2;
+void JewelGame::renderBoard(const RenderState& view, const SDL_Point* origin) {
+    ALLOCATION_SITE("render/board");
+    int boardOffsetX = origin ? origin->x : (SCREEN_WIDTH - BOARD_SIZE * GRID_SIZE) / 2;
+    int boardOffsetY = origin ? origin->y : (SCREEN_HEIGHT - BOARD_SIZE * GRID_SIZE) / 2;
 
-    SDL_Rect boardRect = {boardOffsetX - 10, boardOffsetY - 10,
-                          BOARD_SIZE * GRID_SIZE + 20, BOARD_SIZE * GRID_SIZE + 20};
-    SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
-    SDL_RenderFillRect(renderer, &boardRect);
+    // Đường phần mềm: khung bàn đã nằm trong nền tĩnh của lớp, đá được blend vào lớp thay vì RenderCopy có scale.
+    // Lớp cố định ở giữa màn nên bàn đặt chỗ khác (tường) đi đường texture.
+    bool softPath = !origin && softRenderer.ready() && softRenderer.begin();
+    if (!softPath) {
+        SDL_Rect boardRect = {boardOffsetX - 10, boardOffsetY - 10,
+                              BOARD_SIZE * GRID_SIZE + 20, BOARD_SIZE * GRID_SIZE + 20};
+        SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
+        SDL_RenderFillRect(renderer, &boardRect);
+    }
 
     for (int y = 0; y < BOARD_SIZE; y++) {
         for (int x = 0; x < BOARD_SIZE; x++) {
-            if (board[y][x] != -1) {
+            if (view.cells[y][x] != -1) {
                 SDL_Rect jewelRect;
                 float jewelScale = 1.0f;
 
-                if(isSelecting && x == selectedX1 && y == selectedY1){
-                    jewelScale = selectedScale;
+                if(view.isSelecting && x == view.selectedX1 && y == view.selectedY1){
+                    jewelScale = view.selectedScale;
                 }
 
-                if (isSwapping && ((x == animStartX1 && y == animStartY1) || (x == animStartX2 && y == animStartY2))) {
+                if (view.isSwapping && ((x == view.animStartX1 && y == view.animStartY1) || (x == view.animStartX2 && y == view.animStartY2))) {
                     float animX, animY;
-                    if(x == animStartX1 && y == animStartY1){
-                        animX = boardOffsetX + x * GRID_SIZE + (boardOffsetX + animStartX2 * GRID_SIZE - (boardOffsetX + x * GRID_SIZE)) * swapProgress;
-                        animY = boardOffsetY + y * GRID_SIZE + (boardOffsetY + animStartY2 * GRID_SIZE - (boardOffsetY + y * GRID_SIZE)) * swapProgress;
+                    if(x == view.animStartX1 && y == view.animStartY1){
+                        animX = boardOffsetX + x * GRID_SIZE + (boardOffsetX + view.animStartX2 * GRID_SIZE - (boardOffsetX + x * GRID_SIZE)) * view.swapProgress;
+                        animY = boardOffsetY + y * GRID_SIZE + (boardOffsetY + view.animStartY2 * GRID_SIZE - (boardOffsetY + y * GRID_SIZE)) * view.swapProgress;
                     }
                     else {
-                         animX = boardOffsetX + x * GRID_SIZE + (boardOffsetX + animStartX1 * GRID_SIZE - (boardOffsetX + x * GRID_SIZE)) * swapProgress;
-                         animY = boardOffsetY + y * GRID_SIZE + (boardOffsetY + animStartY1 * GRID_SIZE - (boardOffsetY + y * GRID_SIZE)) * swapProgress;
+                         animX = boardOffsetX + x * GRID_SIZE + (boardOffsetX + view.animStartX1 * GRID_SIZE - (boardOffsetX + x * GRID_SIZE)) * view.swapProgress;
+                         animY = boardOffsetY + y * GRID_SIZE + (boardOffsetY + view.animStartY1 * GRID_SIZE - (boardOffsetY + y * GRID_SIZE)) * view.swapProgress;
                     }
 
                    jewelRect = {(int)animX, (int)animY, GRID_SIZE, GRID_SIZE};
@@ -980,8 +1460,8 @@ void JewelGame::renderBoard() {
                         GRID_SIZE, GRID_SIZE};
                 }
 
-                if(isAnimatingMatch[y][x]){
-                    int scaledSize = (int)(GRID_SIZE * matchedScale[y][x]);
+                if(view.isAnimatingMatch[y][x]){
+                    int scaledSize = (int)(GRID_SIZE * view.matchedScale[y][x]);
                      jewelRect = {
                         boardOffsetX + x * GRID_SIZE + (GRID_SIZE - scaledSize) / 2,
                         boardOffsetY + y * GRID_SIZE + (GRID_SIZE - scaledSize) / 2,
@@ -989,58 +1469,97 @@ void JewelGame::renderBoard() {
                 }
 
                 int scaledSize = (int)(GRID_SIZE * jewelScale);
-                int offsetY = (int)jewelOffsetY[y][x];
+                int offsetY = (int)view.jewelOffsetY[y][x];
 
                  jewelRect = {
                         boardOffsetX + x * GRID_SIZE + (GRID_SIZE - scaledSize) / 2,
                         boardOffsetY + y * GRID_SIZE + (GRID_SIZE - scaledSize) / 2 + offsetY,
                         scaledSize, scaledSize};
 
-                SDL_RenderCopy(renderer, jewelTextures[board[y][x]], NULL, &jewelRect);
+                if (softPath) {
+                    softRenderer.drawJewel(view.cells[y][x], jewelRect);
+                } else {
+                    SDL_RenderCopy(renderer, jewelTextures[view.cells[y][x]], NULL, &jewelRect);
+                }
+            }
+        }
+    }
+    if (softPath) {
+        softRenderer.end(renderer);
+    }
+
+    if (view.isEndlessMode) {
+        // Hàng chờ thu nhỏ phía trên bàn, thanh tiến độ hàng dưới cùng phía dưới bàn
+        const int previewSize = 24;
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            if (view.endlessPreview[x] == -1) continue;
+            SDL_Rect previewRect = {boardOffsetX + x * GRID_SIZE + (GRID_SIZE - previewSize) / 2, 6,
+                                    previewSize, previewSize};
+            SDL_RenderCopy(renderer, jewelTextures[view.endlessPreview[x]], NULL, &previewRect);
+        }
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            SDL_Rect progressRect = {boardOffsetX + x * GRID_SIZE + 4, boardOffsetY + BOARD_SIZE * GRID_SIZE + 14,
+                                     GRID_SIZE - 8, 12};
+            if (view.endlessCleared & (1u << x)) {
+                SDL_SetRenderDrawColor(renderer, 100, 200, 100, 255);
+            } else {
+                SDL_SetRenderDrawColor(renderer, 60, 60, 60, 255);
             }
+            SDL_RenderFillRect(renderer, &progressRect);
         }
     }
 }
 
+// Bàn đầu của tường vẽ bằng renderBoard thu nhỏ vào ô của nó, để màn chờ cũng đo đường vẽ bàn lúc chơi
+void JewelGame::renderWallFeature(const RenderState& view) {
+    SDL_FRect board;
+    if (view.wallCount <= 0 || !wallRenderer.boardRect(0, board)) {
+        return;
+    }
+    float scale = board.w / (BOARD_SIZE * GRID_SIZE);
+    SDL_Point origin = {(int)(board.x / scale), (int)(board.y / scale)};
+    SDL_RenderSetScale(renderer, scale, scale);
+    renderBoard(view, &origin);
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+}
+
 void JewelGame::renderModeSelection() {
      std::cout << "Rendering Mode Selection" << std::endl;  // DEBUG
     SDL_RenderCopy(renderer, backgroundTexture, NULL, NULL);
-    SDL_Color buttonColor = {100, 100, 200, 255};
-    drawButton(normalModeButtonRect, "Normal Mode", buttonColor);
-    drawButton(timedModeButtonRect, "Timed Mode", buttonColor);
+    modeSelectionUi.draw(renderer);
 }
 
 void JewelGame::renderTimedModeLevelSelection() {
     std::cout << "Rendering Timed Mode Level Selection" << std::endl;  // DEBUG
     SDL_RenderCopy(renderer, backgroundTexture, NULL, NULL);
-    SDL_Color buttonColor = {100, 100, 200, 255};
-
-    for (int i = 0; i < timedModeLevels.size(); ++i) {
-        drawButton(timedModeLevelButtonRects[i], timedModeLevels[i].name, buttonColor);
-    }
+    timedLevelUi.draw(renderer);
 }
 
-void JewelGame::renderGameOver(){
+void JewelGame::renderGameOver(const RenderState& view) {
     std::cout << "Rendering Game Over" << std::endl;  // DEBUG
     SDL_RenderCopy(renderer, backgroundTexture, NULL, NULL);
     SDL_Color textColor = {255, 255, 255, 255};
-    renderText(winLoseMessage, SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, textColor);
+    renderText(view.winLoseMessage, SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, textColor);
+    if (view.leaderboardRank > 0) {
+        renderText(frameArena.format("Rank %d of %d", view.leaderboardRank, view.leaderboardSize),
+                   SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 10, textColor);
+    }
 
-    SDL_Color buttonColor = {100, 100, 200, 255};
-    drawButton(backToMainMenuButtonRect, "Back to Main Menu", buttonColor);
+    gameOverUi.draw(renderer);
 }
 //  Main Menu Click
 void JewelGame::handleMainMenuClick(int x, int y) {
     std::cout << "Handling Main Menu Click" << std::endl;  // DEBUG
-    if (isButtonClicked(x, y, startButtonRect)) {
+    UiAction action = mainMenuUi.actionAt(x, y);
+    if (action == UiAction::Start) {
         gameState = GameState::ModeSelection; // Chuyển sang trang chọn chế độ
          std::cout << "Start button clicked" << std::endl;  // DEBUG
-    } else if (isButtonClicked(x, y, continueButtonRect)) {
+    } else if (action == UiAction::Continue) {
         if (loadGameState()) {
             gameState = GameState::Playing;
              std::cout << "Continue button clicked" << std::endl;  // DEBUG
         }
-    } else if (isButtonClicked(x, y, instructionsButtonRect)) {
+    } else if (action == UiAction::Instructions) {
         gameState = GameState::Instructions;
          std::cout << "Instructions button clicked" << std::endl;  // DEBUG
     }
@@ -1048,32 +1567,48 @@ void JewelGame::handleMainMenuClick(int x, int y) {
 
 void JewelGame::handleModeSelectionClick(int x, int y) {
      std::cout << "Handling Mode Selection Click" << std::endl;  // DEBUG
-    if (isButtonClicked(x, y, normalModeButtonRect)) {
+    UiAction action = modeSelectionUi.actionAt(x, y);
+    if (action == UiAction::NormalMode) {
         gameState = GameState::Playing; // Bắt đầu Normal Mode
+        isPracticeMode = false;
+        initBoard(LEVEL_BAND_NORMAL);
+        startReplay();
           std::cout << "Normal Mode button clicked" << std::endl;  // DEBUG
-    } else if (isButtonClicked(x, y, timedModeButtonRect)) {
+    } else if (action == UiAction::PracticeMode) {
+        gameState = GameState::Playing; // Practice Mode: Normal Mode có undo/redo
+        isPracticeMode = true;
+        undoStack.clear();
+        initBoard(LEVEL_BAND_EASY); // Practice để tập, lấy bàn nhiều nước đi
+        startReplay();
+          std::cout << "Practice Mode button clicked" << std::endl;  // DEBUG
+    } else if (action == UiAction::TimedMode) {
         gameState = GameState::TimedModeLevelSelection; // Chuyển sang trang chọn level Timed Mode
          std::cout << "Timed Mode button clicked" << std::endl;  // DEBUG
+    } else if (action == UiAction::EndlessMode) {
+        startEndlessMode();
     }
 }
 
 void JewelGame::handleTimedModeLevelSelectionClick(int x, int y) {
      std::cout << "Handling Timed Mode Level Selection Click" << std::endl;  // DEBUG
-    for (int i = 0; i < timedModeLevels.size(); ++i) {
-        if (isButtonClicked(x, y, timedModeLevelButtonRects[i])) {
-            selectedTimedModeLevel = i;
-            startTimedMode(selectedTimedModeLevel);
-             std::cout << "Timed Mode Level " << i + 1 << " clicked" << std::endl;  // DEBUG
-            break;
-        }
+    int level = -1;
+    if (timedLevelUi.actionAt(x, y, 0, &level) == UiAction::TimedLevel) {
+        selectedTimedModeLevel = level;
+        startTimedMode(selectedTimedModeLevel);
+         std::cout << "Timed Mode Level " << level + 1 << " clicked" << std::endl;  // DEBUG
     }
 }
 
 void JewelGame::handleGameOverClick(int x, int y){
      std::cout << "Handling Game Over Click" << std::endl;  // DEBUG
-     if (isButtonClicked(x, y, backToMainMenuButtonRect)) {
+     if (gameOverUi.actionAt(x, y) == UiAction::BackToMainMenu) {
         gameState = GameState::MainMenu;
-        score = 0;  // Reset điểm số
+        isPracticeMode = false;
+        isEndlessMode = false;
+        leaderboardRank = 0;
+        versus.reset(); // Ván versus đã xong, đóng socket
+        versusBot.reset();
+        engine.score = 0;  // Reset điểm số
         initBoard(); // Khởi tạo lại bảng
         std::cout << "Back to Main Menu clicked" << std::endl;  // DEBUG
     }
@@ -1092,6 +1627,7 @@ void JewelGame::startTimedMode(int levelIndex) {
     // Update trong tương lai
     if (playerMoney >= selectedLevel.price) {
         playerMoney -= selectedLevel.price;
+        profiles.setMoney(profileId, playerMoney);
     } else {
 
          std::cout << "Not enough money to start this level!" << std::endl;
@@ -1104,12 +1640,211 @@ void JewelGame::startTimedMode(int levelIndex) {
     timeRemaining = selectedLevel.duration; // Thời gian còn lại (giây)
     gameState = GameState::Playing;
     isTimedMode = true;
-    score = 0; // Reset điểm
+    engine.score = 0; // Reset điểm
     std::cout << "Score reset to 0" << std::endl;
 
-    // Cập nhật thời gian bắt đầu (để tính thời gian trôi qua)
-    timedModeStartTime = SDL_GetTicks();
+    // Level càng cao bàn càng ít nước đi
+    const LevelBand timedBands[] = {LEVEL_BAND_EASY, LEVEL_BAND_NORMAL, LEVEL_BAND_HARD};
+    initBoard(timedBands[std::min(levelIndex, 2)]);
+
+    startTimedClock();
+    startReplay();
+
+}
+
+// Đồng hồ mới bắt đầu đếm từ bây giờ; đồng hồ của ván trước (nếu có) bị hủy
+void JewelGame::startTimedClock() {
+    flow.cancel(FlowGroup::Timed);
+    flow.spawn(FlowGroup::Timed, timedClockFlow());
+}
+
+void JewelGame::finishTimedMode(bool won) {
+    if (won) {
+        // Thắng cuộc!
+        std::cout << "Congratulation! You won!" << std::endl;
+        winLoseMessage = "Congratulation! You won!";
+    } else {
+        // Thua cuộc!
+        std::cout << "You lose!" << std::endl;
+        winLoseMessage = "You lose!";
+    }
+    gameState = GameState::GameOver;
+    finishGame(won ? REPLAY_WON : REPLAY_LOST);
+    isTimedMode = false;
+    selectedTimedModeLevel = -1;
+    timeRemaining = 0;
+}
+
+// Mỗi giây trừ một; đang tạm dừng thì ngủ tới khi chơi tiếp thay vì đếm
+FlowTask JewelGame::timedClockFlow() {
+    while (isTimedMode) {
+        co_await flow.sleep(1000);
+        while (isTimedMode && gameState == GameState::Paused) {
+            co_await flow.event(FlowEvent::Resumed);
+        }
+        if (!isTimedMode || gameState != GameState::Playing) {
+            co_return;
+        }
+
+        timeRemaining--;
+        const TimedModeLevel& currentLevel = timedModeLevels[selectedTimedModeLevel];
+        std::cout << "Score: " << engine.score << ", Target: " << currentLevel.targetScore << ", Time: " << timeRemaining << std::endl;
+
+        if (engine.score >= currentLevel.targetScore) {
+            finishTimedMode(true);
+        } else if (timeRemaining <= 0) {
+            finishTimedMode(false);
+        }
+    }
+}
+
+// Sau một nước đi: chờ hoạt ảnh đổi chỗ, chờ bàn đứng yên rồi xét thắng ngay, không đợi tới nhịp đồng hồ sau
+FlowTask JewelGame::swapFlow() {
+    co_await flow.event(FlowEvent::SwapFinished);
+    co_await flow.event(FlowEvent::BoardSettled);
+    if (isTimedMode && gameState == GameState::Playing &&
+        engine.score >= timedModeLevels[selectedTimedModeLevel].targetScore) {
+        finishTimedMode(true);
+    }
+}
+
+// Endless Mode không ghi replay và không lên bảng xếp hạng: cả hai chỉ hiểu bàn 8x8 cố định
+void JewelGame::startEndlessMode() {
+    finishGame(REPLAY_QUIT);
+    endless.rng.seed(((uint64_t)engine.rng() << 32) | engine.rng());
+    endless.initBoard();
+    syncEndlessWindow();
+
+    isEndlessMode = true;
+    isPracticeMode = false;
+    shuffleRemaining = 3;
+    scoreHistoryCount = 0;
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            jewelOffsetY[y][x] = -GRID_SIZE;
+        }
+    }
+    gameState = GameState::Playing;
+}
+
+void JewelGame::syncEndlessWindow() {
+    endless.copyWindow(engine.cells);
+    engine.score = endless.score;
+    engine.combo = 1;
+}
+
+bool JewelGame::hostVersus(uint16_t port, const NetConditions& conditions, int inputDelay) {
+    VersusConfig config;
+    config.seed = ((uint64_t)std::random_device{}() << 32) | std::random_device{}();
+    config.targetScore = timedModeLevels[0].targetScore; // Cùng mục tiêu với Timed Mode level 1
+    config.inputDelay = inputDelay;
+    config.conditions = conditions;
+
+    versus.reset(new VersusPeer());
+    if (!versus->host(port, config)) {
+        versus.reset();
+        return false;
+    }
+    std::cout << "Versus: waiting for opponent on UDP port " << versus->localPort() << std::endl;
+    return true;
+}
+
+bool JewelGame::joinVersus(const std::string& host, uint16_t port, const NetConditions& conditions) {
+    versus.reset(new VersusPeer());
+    if (!versus->join(host, port, conditions)) {
+        versus.reset();
+        return false;
+    }
+    return true;
+}
+
+bool JewelGame::startVersusBot(const NetConditions& conditions, int inputDelay) {
+    if (!hostVersus(0, conditions, inputDelay)) {
+        return false;
+    }
+    versusBot.reset(new VersusPeer());
+    if (!versusBot->join("127.0.0.1", versus->localPort(), conditions)) {
+        versusBot.reset();
+        versus.reset();
+        return false;
+    }
+    versusBotRng.seed(((uint64_t)std::random_device{}() << 32) | std::random_device{}());
+    return true;
+}
+
+// Chạy cả khi đã GameOver: đối thủ có thể vẫn cần input của mình để chốt kết quả
+void JewelGame::updateVersus(Uint32 currentTime) {
+    ALLOCATION_SITE("sim/versus");
+    versus->update(currentTime);
+
+    if (versusBot) {
+        versusBot->update(currentTime);
+        RollbackSession* botSession = versusBot->session();
+        if (botSession && botSession->winner() < 0 && (Sint32)(currentTime - versusBotNextMove) >= 0) {
+            const BoardEngine& board = botSession->board(botSession->localPlayer());
+            Move moves[MAX_MOVES];
+            int count = board.listMoves(moves);
+            if (count > 0) {
+                botSession->setLocalInput((uint8_t)moveToAction(greedyMove(board, moves, count)));
+            }
+            versusBotNextMove = currentTime + AUTOPLAY_INTERVAL / 2 + versusBotRng.below(AUTOPLAY_INTERVAL);
+        }
+    }
+
+    RollbackSession* session = versus->session();
+    if (gameState != GameState::Versus || !session) {
+        return;
+    }
+    session->setListener(this); // Âm thanh và hoạt ảnh cho bàn của mình
+
+    if (versus->disconnected()) {
+        endVersus("Opponent disconnected");
+    } else if (session->resultConfirmed()) {
+        int winner = session->winner();
+        endVersus(winner == VERSUS_DRAW ? "Draw!" : (winner == session->localPlayer() ? "You won the race!" : "You lost the race!"));
+    }
+}
+
+void JewelGame::endVersus(const char* message) {
+    std::cout << message << std::endl;
+    winLoseMessage = message;
+    gameState = GameState::GameOver;
+    isSelecting = false;
+    selectedX1 = selectedY1 = -1;
+    versus->report(std::cout);
+}
+
+// Nước đi không chạy ngay mà thành input của frame sau inputDelay, máy đối thủ chạy đúng frame đó
+void JewelGame::handleVersusClick(int mouseX, int mouseY) {
+    RollbackSession* session = versus ? versus->session() : nullptr;
+    if (!session || session->winner() >= 0) {
+        return;
+    }
+
+    int x = (mouseX - boardOffsetX) / GRID_SIZE;
+    int y = (mouseY - boardOffsetY) / GRID_SIZE;
+    if (mouseX < boardOffsetX || mouseY < boardOffsetY || x >= BOARD_SIZE || y >= BOARD_SIZE) {
+        isSelecting = false;
+        selectedScale = 1.0f;
+        selectedX1 = selectedY1 = -1;
+        return;
+    }
+
+    if (!isSelecting) {
+        selectedX1 = x;
+        selectedY1 = y;
+        isSelecting = true;
+        selectedScale = 1.2f;
+        return;
+    }
 
+    if (session->board(session->localPlayer()).isAdjacent(selectedX1, selectedY1, x, y)) {
+        Move move = {(int8_t)selectedX1, (int8_t)selectedY1, (int8_t)x, (int8_t)y};
+        session->setLocalInput((uint8_t)moveToAction(move));
+    }
+    isSelecting = false;
+    selectedScale = 1.0f;
+    selectedX1 = selectedY1 = -1;
 }
 
 // Tạo phông arial
@@ -1121,7 +1856,12 @@ bool JewelGame::initFont() {
         return false;
     }
 
-    font = TTF_OpenFont("arial.ttf", 18);
+    SDL_RWops* packedFont = AssetPack::Instance()->openRW("arial.ttf");
+    if (packedFont != nullptr) {
+        font = TTF_OpenFontRW(packedFont, 1, 18);
+    } else {
+        font = TTF_OpenFont("arial.ttf", 18);
+    }
     if (!font) {
         std::cerr << "Failed to load font! SDL_ttf Error: "
                   << TTF_GetError()
@@ -1132,8 +1872,8 @@ bool JewelGame::initFont() {
 }
 
 // Khởi tạo chữ
-void JewelGame::renderText(const std::string &text, int x, int y, SDL_Color color) {
-    SDL_Surface *surfaceMessage = TTF_RenderText_Solid(font, text.c_str(), color);
+void JewelGame::renderText(const char* text, int x, int y, SDL_Color color) {
+    SDL_Surface *surfaceMessage = TTF_RenderText_Solid(font, text, color);
     SDL_Texture *message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
 
     SDL_Rect messageRect = {x, y, surfaceMessage->w, surfaceMessage->h};
@@ -1144,14 +1884,96 @@ void JewelGame::renderText(const std::string &text, int x, int y, SDL_Color colo
 }
 
 
-void JewelGame::render() {
+// Overlay F3: phân vị từng đoạn độ trễ và histogram input-to-photon
+void JewelGame::renderProfiler() {
+    const int panelX = 10, panelY = 10, panelW = 420, panelH = 260;
+    SDL_Rect panel = {panelX, panelY, panelW, panelH};
+    SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+    SDL_RenderFillRect(renderer, &panel);
+
+    SDL_Color textColor = {255, 255, 255, 255};
+    int y = panelY + 5;
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& h = latencyProfiler.histogram(stage);
+        const char* line = frameArena.format("%s: p50 %.1f p95 %.1f p99 %.1f ms (n=%llu)", latencyStageName(stage),
+                                             h.percentile(0.50), h.percentile(0.95), h.percentile(0.99),
+                                             (unsigned long long)h.count());
+        renderText(line, panelX + 5, y, stage == LATENCY_TOTAL ? SDL_Color{255, 255, 0, 255} : textColor);
+        y += 22;
+    }
+
+    // Số lần cấp phát chỉ có khi build Debug-Alloc
+    renderText(frameArena.format("arena %u/%u KB, allocs last frame: %s",
+                                 (unsigned)(frameArena.highWater() / 1024), (unsigned)(frameArena.capacity() / 1024),
+                                 AllocationTracker::ENABLED ? frameArena.format("%llu", (unsigned long long)AllocationTracker::lastFrameAllocations()) : "n/a"),
+               panelX + 5, y, textColor);
+
+    // Mỗi cột một bucket log, cao theo bucket đông nhất
+    const LatencyHistogram& total = latencyProfiler.histogram(LATENCY_TOTAL);
+    uint64_t tallest = 1;
+    for (int bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+        tallest = std::max(tallest, total.bucketCount(bucket));
+    }
+
+    const int chartH = 80, barW = (panelW - 10) / LatencyHistogram::BUCKET_COUNT;
+    int chartBottom = panelY + panelH - 10;
+    SDL_SetRenderDrawColor(renderer, 100, 200, 100, 255);
+    for (int bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+        int barH = (int)(chartH * total.bucketCount(bucket) / tallest);
+        SDL_Rect bar = {panelX + 5 + bucket * barW, chartBottom - barH, barW - 1, barH};
+        SDL_RenderFillRect(renderer, &bar);
+    }
+}
+
+// Bảng bên phải: điểm hai bên, mạng và chi phí rollback; bàn đối thủ thu nhỏ bên trái
+void JewelGame::renderVersus(const RenderState& view) {
+    ALLOCATION_SITE("render/versus");
+    SDL_Rect panel = {SCREEN_WIDTH - 200, 0, 200, SCREEN_HEIGHT};
+    SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
+    SDL_RenderFillRect(renderer, &panel);
+
+    if (!view.versusStarted) {
+        renderText("Waiting for opponent...", SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 10, {255, 255, 255});
+        return;
+    }
+
+    renderText("VERSUS", SCREEN_WIDTH - 180, 20, {255, 255, 0});
+    renderText(frameArena.format("You: %d", view.score), SCREEN_WIDTH - 180, 50, {255, 255, 255});
+    renderText(frameArena.format("Opponent: %d", view.opponentScore), SCREEN_WIDTH - 180, 80, {255, 150, 150});
+    renderText(frameArena.format("Target: %d", view.versusTarget), SCREEN_WIDTH - 180, 110, {200, 200, 200});
+    renderText(frameArena.format("RTT: %d ms", view.versusRoundTripMs), SCREEN_WIDTH - 180, 160, {200, 200, 200});
+    renderText(frameArena.format("Rollbacks: %llu", (unsigned long long)view.rollbackCount),
+               SCREEN_WIDTH - 180, 190, {200, 200, 200});
+    renderText(frameArena.format("Last: %d frames, %.2f ms", view.rollbackDepth, view.rollbackMs),
+               SCREEN_WIDTH - 180, 220, {200, 200, 200});
+
+    const int cellSize = 24, originX = 20, originY = 150;
+    renderText("Opponent", originX, originY - 30, {255, 150, 150});
+    SDL_Rect boardRect = {originX - 4, originY - 4, BOARD_SIZE * cellSize + 8, BOARD_SIZE * cellSize + 8};
+    SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
+    SDL_RenderFillRect(renderer, &boardRect);
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            if (view.opponentCells[y][x] != -1) {
+                SDL_Rect jewelRect = {originX + x * cellSize, originY + y * cellSize, cellSize, cellSize};
+                SDL_RenderCopy(renderer, jewelTextures[view.opponentCells[y][x]], NULL, &jewelRect);
+            }
+        }
+    }
+}
+
+void JewelGame::render(const RenderState& view) {
+    ALLOCATION_SITE("render");
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
 
-    std::cout << "Current GameState: " << static_cast<int>(gameState) << std::endl; // DEBUG
-    switch (gameState) {
+    std::cout << "Current GameState: " << static_cast<int>(view.gameState) << std::endl; // DEBUG
+    switch (view.gameState) {
+        case GameState::Loading:
+            renderLoading();
+            break;
         case GameState::MainMenu:
-            renderMainMenu();
+            renderMainMenu(view);
             break;
         case GameState::ModeSelection:
             renderModeSelection();
@@ -1161,91 +1983,45 @@ void JewelGame::render() {
             break;
         case GameState::Playing:
         case GameState::Paused: {
-            renderBoard();
-            renderScoreboard();
-
-            if (gameState == GameState::Paused) {
-                renderText("Game Paused", SCREEN_WIDTH / 2 - 50, SCREEN_HEIGHT / 2 - 10, {255, 255, 255});
-            }
+            renderBoard(view);
+            renderScoreboard(view);
 
             // Hiển thị thời gian còn lại trong Timed Mode
-            if (isTimedMode) {
-                std::stringstream timeString;
-                int minutes = timeRemaining / 60;
-                int seconds = timeRemaining % 60;
-                timeString << "Time Remaining: " << std::setw(2) << std::setfill('0') << minutes << ":" << std::setw(2) << std::setfill('0') << seconds;
-
-                renderText(timeString.str(), 50, 100, {255, 255, 255});
+            if (view.isTimedMode) {
+                int minutes = view.timeRemaining / 60;
+                int seconds = view.timeRemaining % 60;
+                renderText(frameArena.format("Time Remaining: %02d:%02d", minutes, seconds), 50, 100, {255, 255, 255});
+            }
+            if (view.isEndlessMode) {
+                renderText(frameArena.format("Rows cleared: %llu", (unsigned long long)view.endlessRows), 50, 100,
+                           {255, 255, 255});
             }
 
             break;
         }
+        case GameState::Versus:
+            if (view.versusStarted) {
+                renderBoard(view);
+            }
+            renderVersus(view);
+            break;
         case GameState::Instructions:
             renderInstructions();
             break;
+        case GameState::Wall:
+            wallRenderer.draw(renderer, view.wallBoards, view.wallCount, 0);
+            renderWallFeature(view);
+            wallUi.draw(renderer);
+            break;
         case GameState::GameOver:
              std::cout << "Rendering Game Over State" << std::endl;  // DEBUG
-             renderGameOver();
+             renderGameOver(view);
              break;
     }
 
-    SDL_RenderPresent(renderer);
-}
-
-// Tráo bài
-void JewelGame::shuffleBoard() {
-    std::vector<int> jewels;
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            if (board[y][x] != -1) {
-                jewels.push_back(board[y][x]);
-            }
-        }
-    }
-
-    std::shuffle(jewels.begin(), jewels.end(), rng);
-
-    int index = 0;
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            if (board[y][x] != -1) {
-                board[y][x] = jewels[index++];
-            }
-        }
-    }
-}
-
-void JewelGame::countJewelTypes(int counts[NUM_JEWEL_TYPES]) {
-    for (int i = 0; i < NUM_JEWEL_TYPES; ++i) {
-        counts[i] = 0;
-    }
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            if (board[y][x] != -1) {
-                counts[board[y][x]]++;
-            }
-        }
-    }
-}
-
-void JewelGame::restoreJewelTypes(int counts[NUM_JEWEL_TYPES]) {
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
-            board[y][x] = -1;
-        }
-    }
-
-    int index = 0;
-    for (int jewelType = 0; jewelType < NUM_JEWEL_TYPES; ++jewelType) {
-        for (int i = 0; i < counts[jewelType]; ++i) {
-            int x = index % BOARD_SIZE;
-            int y = index / BOARD_SIZE;
-            if (y < BOARD_SIZE && x < BOARD_SIZE){
-                board[y][x] = jewelType;
-                index++;
-            }
-        }
+    if (showProfiler) {
+        renderProfiler();
     }
 
-    shuffleBoard();
+    SDL_RenderPresent(renderer);
 }
@@ -12,87 +12,191 @@
 #include <algorithm>
 #include <fstream>
 #include <map>
-
-const int SCREEN_WIDTH = 1000;
-const int SCREEN_HEIGHT = 600;
-const int BOARD_SIZE = 8;
-const int GRID_SIZE = 64;
-const int NUM_JEWEL_TYPES = 6;
-const float JEWEL_FALL_SPEED = 0.5f; // Fall speed of jewels
-const float MATCH_ANIMATION_SPEED = 50.0f; // Speed of match animation
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "allocationtracker.h"
+#include "attractwall.h"
+#include "constants.h"
+#include "board.h"
+#include "bot.h"
+#include "endlessboard.h"
+#include "flowscheduler.h"
+#include "framearena.h"
+#include "gamesnapshot.h"
+#include "latencyprofiler.h"
+#include "levelpack.h"
+#include "levels.h"
+#include "undostack.h"
+#include "versuspeer.h"
+#include "assetloader.h"
+#include "texturemanager.h"
+#include "persistence.h"
+#include "profilestore.h"
+#include "replaystream.h"
+#include "softrender.h"
+#include "spscqueue.h"
+#include "triplebuffer.h"
+#include "uiscreen.h"
+
+const Uint32 AUTOSAVE_INTERVAL = 5000; // ms giữa hai lần autosave khi đang chơi
+const Uint32 AUTOPLAY_INTERVAL = 800;  // ms giữa hai nước của bot khi tự chơi
+const Uint32 SIM_TICK_MS = 4;          // Chu kỳ của sim thread
+const Uint32 FRAME_TIME_MS = 16;       // Chu kỳ vẽ của render thread
+const int MAX_SCORE_HISTORY = 5;
 
 
 enum class GameState {
+    Loading, // Đang decode asset trên worker thread
     MainMenu,
     Playing,
     Instructions,
     Paused,
     ModeSelection, // Trang sau khi chọn start
     TimedModeLevelSelection, // Trang chọn level của Timed Mode
+    Versus, // Đua điểm với người chơi khác qua mạng (--versus-host/--versus-join/--versus-bot)
+    Wall, // Màn hình chờ nhiều bàn bot tự chơi (--wall N), bấm để vào Main Menu
     GameOver
 };
 
-class TextureManager;
+// Input do render thread (main thread, nơi SDL cho phép poll event) bắt và gắn thời gian,
+// sim thread xử lý qua SpscQueue
+enum class InputType : Uint8 {
+    MouseDown,
+    KeyDown,
+    Quit
+};
 
+struct InputEvent {
+    InputType type;
+    int x, y;
+    SDL_Keycode key;
+    Uint32 timestamp; // SDL_GetTicks() lúc bắt được event
+    Uint64 captured;  // SDL_GetPerformanceCounter() lúc bắt được event, cho LatencyProfiler
+};
 
-struct ScoreEvent {
-    int points;
-    int combo;
-    int matchSize;
-    Uint32 timestamp;
+// Một bước của kịch bản chạy headless (--scenario): input giả lập tại atMs sau khi vào game
+struct ScenarioStep {
+    Uint32 atMs;
+    InputEvent input;
 };
 
-struct TimedModeLevel {
-    int level;
-    int duration;
-    int price;
-    std::string name;
-    int targetScore; // Điểm để thắng timed mode
+// Mọi thứ render cần trong một frame. Sim thread ghi, render thread chỉ đọc bản mới nhất (TripleBuffer).
+struct RenderState {
+    GameState gameState;
+    Uint32 simTime;
+
+    int8_t cells[BOARD_SIZE][BOARD_SIZE];
+    float jewelOffsetY[BOARD_SIZE][BOARD_SIZE];
+    float matchedScale[BOARD_SIZE][BOARD_SIZE];
+    bool isAnimatingMatch[BOARD_SIZE][BOARD_SIZE];
+
+    bool isSelecting;
+    int selectedX1, selectedY1;
+    float selectedScale;
+    bool isSwapping;
+    float swapProgress;
+    int animStartX1, animStartY1, animStartX2, animStartY2;
+
+    int score;
+    int highScore;
+    int combo;
+    int playerMoney;
+    int shuffleRemaining;
+    ScoreEvent scoreHistory[MAX_SCORE_HISTORY];
+    int scoreHistoryCount;
+
+    bool hasSave;
+    bool isPracticeMode;
+    int undoCount, redoCount;
+    bool isTimedMode;
+    int timeRemaining;
+    char winLoseMessage[64];
+    int leaderboardRank; // Hạng sau ván vừa xong, 0 nếu không có
+    int leaderboardSize;
+
+    LatencyStamps latency; // Nước đi gần nhất do người chơi bấm, render ghi nhận khi present
+
+    // Endless Mode: cells ở trên là cửa sổ 8 hàng
+    bool isEndlessMode;
+    int8_t endlessPreview[BOARD_SIZE]; // Hàng chờ sẽ lộ ra tiếp theo
+    uint8_t endlessCleared;            // Cột nào của hàng dưới cùng đã bị ăn
+    uint64_t endlessRows;
+
+    // Versus mode: cells/score ở trên là bàn của mình
+    bool versusStarted;
+    int8_t opponentCells[BOARD_SIZE][BOARD_SIZE];
+    int opponentScore;
+    int versusTarget;
+    int versusRoundTripMs;
+    int rollbackDepth;    // Số frame tua lại ở lần rollback gần nhất
+    float rollbackMs;     // Chi phí tua lại của lần đó
+    uint64_t rollbackCount;
+
+    // Attract wall: 0 khi không ở màn Wall
+    int wallCount;
+    WallBoardView wallBoards[MAX_WALL_BOARDS];
 };
 
-class JewelGame {
+
+class JewelGame : private BoardListener {
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     TTF_Font* font;
 
-    int board[BOARD_SIZE][BOARD_SIZE];
-    bool matched[BOARD_SIZE][BOARD_SIZE];
+    BoardEngine engine; // Bàn đá, điểm và RNG
 
     int selectedX1, selectedY1;
     int selectedX2, selectedY2;
     bool isSelecting;
     float selectedScale = 1.0f;
 
-    int score;
     int highScore;
-    int combo;
-    std::vector<ScoreEvent> scoreHistory;
-
-    std::mt19937 rng;
+    int endlessBest = 0; // Kỷ lục Endless trong lần chạy này, không lưu file
+    ScoreEvent scoreHistory[MAX_SCORE_HISTORY]; // Cũ nhất trước
+    int scoreHistoryCount = 0;
+    uint32_t scoreEventTotal = 0; // Tổng số sự kiện điểm đã ghi, kể cả cái đã bị đẩy khỏi mảng
+    // Versus: scoreEventTotal sau mỗi nước cục bộ còn hiệu lực (vòng), để tua lại chỉ xóa điểm bay lên của nước bị hủy
+    uint32_t versusMoveScoreEnd[VERSUS_RING];
+    uint32_t versusMovesApplied = 0;
 
     int boardOffsetX;
     int boardOffsetY;
 
     GameState gameState;
 
-    // Cụm tạo nút
-    SDL_Rect startButtonRect;
-    SDL_Rect instructionsButtonRect;
-    SDL_Rect backButtonRect;
-    SDL_Rect shuffleButtonRect;
-    SDL_Rect restartButtonRect;
-    SDL_Rect pauseButtonRect;
-    SDL_Rect continueButtonRect;
-    SDL_Rect continueButtonRect_pause;
+    // Nút của từng màn (uiscreen.h): layout trong constructor, build() sau khi có font.
+    // Render thread vẽ, sim thread hit-test; sau build() không ai sửa nên dùng chung được.
+    UiScreen mainMenuUi;
+    UiScreen instructionsUi;
+    UiScreen modeSelectionUi;
+    UiScreen timedLevelUi;
+    UiScreen gameUi; // Playing và Paused
+    UiScreen gameOverUi;
+    UiScreen wallUi;
+    int continueWidget;
+    int shuffleWidget;
+    int undoWidget;
+    int redoWidget;
+    int resumeWidget;
 
     int shuffleRemaining = 3;
 
+    // Handle giữ ref trong TextureManager, con trỏ chỉ hợp lệ khi còn giữ handle
+    TextureHandle backgroundHandle = INVALID_TEXTURE;
+    TextureHandle jewelHandles[NUM_CELL_VALUES];
     SDL_Texture* backgroundTexture;
-    SDL_Texture* jewelTextures[NUM_JEWEL_TYPES];
+    SDL_Texture* jewelTextures[NUM_CELL_VALUES]; // Theo giá trị ô: đá thường, đá sọc, bom màu
 
+    const std::string assetPackFile = "assets.pak";
     const std::string highScoreFile = "highscore.txt";
-    const std::string saveGameFile = "savegame.txt";
+    const std::string saveGameFile = "savegame.dat";
+    const std::string legacySaveGameFile = "savegame.txt"; // Save dạng chữ của bản cũ, chuyển sang .dat một lần
+    const std::string levelPackFile = "levels.pak";
+    LevelPack levelPack; // Bàn chọn sẵn (tools/levelgen), không có thì initBoard ngẫu nhiên
 
     // Biến Hoạt ảnh
     bool isSwapping = false;
@@ -107,81 +211,171 @@ private:
     std::map<std::string, Mix_Chunk*> m_soundEffects;
     Mix_Music* m_backgroundMusic = nullptr;
 
+    // Save/highscore được cache trong bộ nhớ, autosave chạy trên thread nền
+    PersistenceService persistence;
+    Uint32 lastAutoSaveTime = 0;
+
+    // Replay của ván đang chơi (delta mỗi nước đi), ghi vào replays/ trên thread riêng khi ván kết thúc
+    const std::string replayDirectory = "replays";
+    ReplayFeed replayFeed;
+    ReplayRecorder replayRecorder{replayFeed};
+    std::future<bool> pendingReplayWrite;
+
+    // Hồ sơ người chơi và bảng xếp hạng (profiles.db), chỉ sim thread ghi. highscore.txt vẫn giữ cho bản cũ.
+    const std::string profileFile = "profiles.db";
+    ProfileStore profiles;
+    std::string profileName = "Player";
+    int profileId = -1;
+    int leaderboardRank = 0;
+    int leaderboardSize = 0;
+
+    // Bot tự chơi (màn hình chờ ở kiosk), tìm nước trên thread riêng
+    bool autoplay = false;
+    std::unique_ptr<JewelBot> bot;
+    std::future<BotResult> pendingBotMove;
+    int8_t pendingBotCells[BOARD_SIZE][BOARD_SIZE]; // Bàn lúc bắt đầu tìm; bàn đã đổi (chơi lại, đổi mode, undo) thì bỏ kết quả
+    Uint32 lastAutoplayMove = 0;
+
+    // Sim thread: input, luật chơi, hoạt ảnh, timer. Render thread không bao giờ chờ sim và ngược lại.
+    std::thread simThread;
+    std::atomic<bool> simRunning{false};
+    SpscQueue<InputEvent, 256> inputQueue;
+    TripleBuffer<RenderState> renderStates;
+    Uint32 inputTimestamp = 0; // Thời điểm bắt input đang được xử lý
+    LatencyStamps inputLatency = {}; // Mốc của input đang xử lý (sim thread)
+    LatencyStamps swapLatency = {};  // Mốc của nước đi gần nhất, publish cùng RenderState
+
+    // Versus mode, chỉ sim thread dùng. versusBot là đối thủ bot trong cùng process, nối qua UDP loopback.
+    std::unique_ptr<VersusPeer> versus;
+    std::unique_ptr<VersusPeer> versusBot;
+    JewelRng versusBotRng;
+    Uint32 versusBotNextMove = 0;
+
+    // Profiler (F3) và kịch bản headless, chỉ render thread dùng
+    LatencyProfiler latencyProfiler;
+    FrameArena frameArena; // Chuỗi/mảng tạm của frame đang vẽ, reset sau mỗi present
+    bool showProfiler = false;
+    uint64_t lastPresentedInput = 0;
+    bool headless = false;
+    std::vector<ScenarioStep> scenario;
+    size_t scenarioNext = 0;
+    Uint32 scenarioStart = 0;
+
+    // Renderer phần mềm (không có GPU): bàn đá vẽ qua SoftRenderer, chỉ render thread dùng
+    SoftRenderer softRenderer;
+    bool forceSoftware = false;
+    bool softFastPath = true;
+
+    // Attract wall: wall chỉ sim thread dùng, wallRenderer chỉ render thread dùng
+    int wallBoards = 0;
+    AttractWall wall;
+    WallRenderer wallRenderer;
+
+    // Tải asset bất đồng bộ
+    AssetLoader assetLoader;
+    bool firstFrameRendered = false;
+
     // Biến thời gian
     bool isTimedMode = false;
     int timeRemaining; // Thời gian còn lại tính bằng giây
-    Uint32 timedModeStartTime; // Thời gian bắt đầu Timed Mode
+
+    // Luồng game viết bằng coroutine (đồng hồ Timed Mode, chuỗi sau mỗi nước đi), chỉ sim thread dùng
+    FlowScheduler flow;
+    bool boardSettled = true; // Để chỉ signal BoardSettled khi vừa chuyển sang đứng yên
 
     // Các biến tiền tệ (Update tương lai)
     int playerMoney = 10000;
 
+    // Practice Mode: có undo/redo
+    bool isPracticeMode = false;
+    UndoStack undoStack;
+
+    // Endless Mode: luật nằm trong EndlessBoard, cửa sổ được chép sang engine để phần vẽ và bot dùng chung
+    bool isEndlessMode = false;
+    EndlessBoard endless;
+
     std::vector<TimedModeLevel> timedModeLevels;
-    SDL_Rect timedModeButtonRect;
-    SDL_Rect normalModeButtonRect;
-    std::vector<SDL_Rect> timedModeLevelButtonRects;
     int selectedTimedModeLevel = -1; // Đặt giá trị khởi đầu là -1 để tính nó là chưa chọn
 
 
     std::string winLoseMessage;
-    SDL_Rect backToMainMenuButtonRect;
 
 
-    void drawButton(SDL_Rect rect, const std::string& text, SDL_Color color);
-    bool isButtonClicked(int x, int y, SDL_Rect rect);
+    void layoutUi();
+    bool buildUi();
+    uint32_t gameUiHidden(bool practiceMode, bool paused) const;
     Mix_Chunk* loadSound(const std::string& filePath);
     bool loadBackgroundMusic(const std::string& filePath);
     void updateJewelFall(int x, int y, float deltaTime);
 
 
-    void shuffleBoard();
-    void countJewelTypes(int counts[NUM_JEWEL_TYPES]);
-    void restoreJewelTypes(int counts[NUM_JEWEL_TYPES]);
-
-    // Biến Render
-    void renderMainMenu();
+    // Biến Render (chỉ đọc RenderState, chạy trên render thread)
+    void renderLoading();
+    void renderMainMenu(const RenderState& view);
     void renderInstructions();
-    void renderScoreboard();
-    void renderBoard();
+    void renderScoreboard(const RenderState& view);
+    void renderBoard(const RenderState& view, const SDL_Point* origin = nullptr); // origin: góc bàn, mặc định giữa màn
+    void renderWallFeature(const RenderState& view);
     void renderModeSelection();
     void renderTimedModeLevelSelection();
-    void renderGameOver();
+    void renderGameOver(const RenderState& view);
+    void renderProfiler();
+    void renderVersus(const RenderState& view);
 
     // Hàm handle điều khiển
     void handleMainMenuClick(int x, int y);
     void handleModeSelectionClick(int x, int y);
     void handleTimedModeLevelSelectionClick(int x, int y);
     void handleGameOverClick(int x, int y);
+    void handleVersusClick(int x, int y);
 
     // Save/Load
     bool loadHighScore();
     bool saveHighScore();
     void saveGameState();
     bool loadGameState();
-
-    // Game Logic
-    void initBoard();
-    int getRandomJewel(int x, int y);
-    bool isMatchAt(int x, int y, int jewel);
+    GameSnapshot captureSnapshot() const;
+    void restoreSnapshot(const GameSnapshot& snapshot);
+    void undoMove();
+    void redoMove();
+    void startReplay();
+    void finishReplay(ReplayResult result);
+    void openProfile();
+    void finishGame(ReplayResult result); // Ghi ván vào hồ sơ rồi lưu replay
+
+    // Game Logic (luật chơi nằm trong BoardEngine)
+    void initBoard(const LevelBand& band = LEVEL_BAND_ANY); // Lấy bàn trong dải độ khó từ level pack
     void handleMouseClick(int mouseX, int mouseY);
-    bool processSwappedJewels(int x, int y);
-    int countMatchedJewels();
-    void calculateScore(int matchedJewels, int comboMultiplier);
-    void swapJewels();
-    bool checkMatchesAndMarkMatched();
-    void removeMatches();
-    void dropJewels();
-    void processCascadeMatches();
+    void performSwap(int x1, int y1, int x2, int y2);
+    void updateAutoplay(Uint32 currentTime);
     void restartGame();
     void pauseGame();
     void startTimedMode(int levelIndex);
-
-    // Hàm update hoạt ảnh
-    void updateSwapAnimation(float deltaTime);
-    void updateFallingAnimations(float deltaTime);
-    void updateMatchAnimations(float deltaTime);
+    void startTimedClock();
+    void finishTimedMode(bool won);
+    FlowTask timedClockFlow();
+    FlowTask swapFlow();
+    void startEndlessMode();
+    void syncEndlessWindow(); // Chép cửa sổ và điểm của endless sang engine sau mỗi thao tác
+    void updateVersus(Uint32 currentTime);
+    void endVersus(const char* message);
+
+    // BoardListener
+    void onMatchesRemoved(const bool matched[BOARD_SIZE][BOARD_SIZE]) override;
+    void onSpecialSpawned(int cell, int value) override;
+    void onJewelsDropped(const int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]) override;
+    void onCascadeStep() override;
+    void onScore(const ScoreEvent& event) override;
+    void onMoveApplied() override;
+    void onMoveRolledBack() override;
+
+    // Hàm update hoạt ảnh, trả về true nếu còn hoạt ảnh đang chạy
+    bool updateSwapAnimation(float deltaTime);
+    bool updateFallingAnimations(float deltaTime);
+    bool updateMatchAnimations(float deltaTime);
 
     // Tạo chữ
-    void renderText(const std::string& text, int x, int y, SDL_Color color);
+    void renderText(const char* text, int x, int y, SDL_Color color);
 
 public:
 
@@ -189,14 +383,34 @@ public:
     ~JewelGame();
 
     void run();
+    void setAutoplay(bool enabled);
+    void setHeadless(bool enabled) { headless = enabled; } // Driver dummy, renderer phần mềm
+    void setSoftware(bool enabled) { forceSoftware = enabled; } // Renderer phần mềm có cửa sổ, như máy không có GPU
+    void setSoftFastPath(bool enabled) { softFastPath = enabled; } // false: renderer phần mềm vẽ qua SDL_RenderCopy như cũ
+    void setWall(int boards) { wallBoards = boards; } // Vào thẳng màn hình chờ nhiều bàn, gọi trước run()
+    bool loadScenario(const std::string& filePath);
+    void setProfile(const std::string& name) { profileName = name; } // Gọi trước run()
+
+    // Versus mode, gọi trước run(); mở socket ngay để báo lỗi sớm
+    bool hostVersus(uint16_t port, const NetConditions& conditions, int inputDelay);
+    bool joinVersus(const std::string& host, uint16_t port, const NetConditions& conditions);
+    bool startVersusBot(const NetConditions& conditions, int inputDelay); // Chủ + bot khách trên loopback
 
 private:
     // Hàm khởi động
     bool init();
     bool initFont();
+    bool finishLoading();
+
 
+    bool runLoading(); // Màn Loading trên main thread, false nếu người dùng thoát
+    void simulationLoop();
+    void handleInput(const InputEvent& input);
+    void updateSimulation(Uint32 currentTime, float deltaTime);
+    void publishRenderState(Uint32 currentTime);
+    void injectScenarioInputs(Uint32 currentTime);
 
-    void render();
+    void render(const RenderState& view);
     void cleanup();
 };
 
@@ -0,0 +1,251 @@
+#include "allocationtracker.h"
+
+#ifdef JEWEL_TRACK_ALLOCATIONS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+    const int MAX_SITES = 128;
+    const uint64_t REPORT_INTERVAL_FRAMES = 600; // ~10 giây ở 60 fps
+    const char* const UNTAGGED_SITE = "(untagged)";
+
+    // Bảng băm mở theo con trỏ nhãn, không cấp phát nên dùng được bên trong operator new.
+    // Chỉ thêm, không xóa: nhãn là chuỗi literal sống suốt chương trình.
+    struct SiteStats {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> bytes;
+        uint64_t reportedCount; // Chỉ render thread dùng, mốc của lần báo cáo trước
+        uint64_t reportedBytes;
+    };
+
+    SiteStats s_sites[MAX_SITES];
+    std::atomic<uint64_t> s_allocations(0);
+    std::atomic<uint64_t> s_frees(0);
+    thread_local const char* s_currentSite = nullptr;
+
+    // Thống kê theo frame, chỉ render thread dùng
+    uint64_t s_lastFrameTotal = 0;
+    uint64_t s_lastFrameAllocations = 0;
+    uint64_t s_intervalFrames = 0;
+    uint64_t s_intervalAllocations = 0;
+    uint64_t s_intervalMax = 0;
+    uint64_t s_intervalZeroFrames = 0;
+
+    SiteStats& findSite(const char* name) {
+        size_t start = ((uintptr_t)name >> 3) % MAX_SITES;
+        for (int probe = 0; probe < MAX_SITES; ++probe) {
+            SiteStats& site = s_sites[(start + probe) % MAX_SITES];
+            const char* current = site.name.load(std::memory_order_acquire);
+            if (current == name) return site;
+            if (current == nullptr) {
+                const char* expected = nullptr;
+                if (site.name.compare_exchange_strong(expected, name) || expected == name) {
+                    return site;
+                }
+            }
+        }
+        return s_sites[start]; // Bảng đầy: gộp vào ô đầu tiên
+    }
+
+    void recordAllocation(size_t size) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        SiteStats& site = findSite(s_currentSite ? s_currentSite : UNTAGGED_SITE);
+        site.count.fetch_add(1, std::memory_order_relaxed);
+        site.bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void recordFree(void* ptr) {
+        if (ptr) s_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Khối của new có std::align_val_t; mingw không có aligned_alloc nên dùng _aligned_malloc/_aligned_free
+    void* alignedMalloc(std::size_t size, std::align_val_t alignment) {
+        std::size_t align = std::max((std::size_t)alignment, sizeof(void*));
+#ifdef _WIN32
+        return _aligned_malloc(size ? size : 1, align);
+#else
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size ? size : 1) == 0 ? ptr : nullptr;
+#endif
+    }
+
+    void alignedFree(void* ptr) {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+AllocationTracker::SiteScope::SiteScope(const char* site) : m_previous(s_currentSite) {
+    s_currentSite = site;
+}
+
+AllocationTracker::SiteScope::~SiteScope() {
+    s_currentSite = m_previous;
+}
+
+void AllocationTracker::endFrame() {
+    uint64_t total = s_allocations.load(std::memory_order_relaxed);
+    s_lastFrameAllocations = total - s_lastFrameTotal;
+    s_lastFrameTotal = total;
+
+    ++s_intervalFrames;
+    s_intervalAllocations += s_lastFrameAllocations;
+    s_intervalMax = std::max(s_intervalMax, s_lastFrameAllocations);
+    if (s_lastFrameAllocations == 0) ++s_intervalZeroFrames;
+
+    if (s_intervalFrames >= REPORT_INTERVAL_FRAMES) {
+        report(std::cout);
+    }
+}
+
+uint64_t AllocationTracker::lastFrameAllocations() {
+    return s_lastFrameAllocations;
+}
+
+// In thống kê từ lần báo cáo trước rồi bắt đầu khoảng mới
+void AllocationTracker::report(std::ostream& out) {
+    if (s_intervalFrames == 0) return;
+
+    struct SiteDelta { const char* name; uint64_t count; uint64_t bytes; };
+    SiteDelta deltas[MAX_SITES];
+    int siteCount = 0;
+    for (SiteStats& site : s_sites) {
+        const char* name = site.name.load(std::memory_order_acquire);
+        if (!name) continue;
+        uint64_t count = site.count.load(std::memory_order_relaxed);
+        uint64_t bytes = site.bytes.load(std::memory_order_relaxed);
+        if (count > site.reportedCount) {
+            deltas[siteCount++] = {name, count - site.reportedCount, bytes - site.reportedBytes};
+        }
+        site.reportedCount = count;
+        site.reportedBytes = bytes;
+    }
+    std::sort(deltas, deltas + siteCount, [](const SiteDelta& a, const SiteDelta& b) { return a.count > b.count; });
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    out << "[alloc] " << s_intervalFrames << " frames: " << (double)s_intervalAllocations / s_intervalFrames
+        << " allocs/frame (target 0), max " << s_intervalMax << ", zero-alloc frames "
+        << 100.0 * s_intervalZeroFrames / s_intervalFrames << "%, live "
+        << (int64_t)(s_allocations.load() - s_frees.load()) << std::endl;
+    for (int i = 0; i < siteCount; ++i) {
+        out << "[alloc]   " << std::left << std::setw(28) << deltas[i].name << std::right
+            << std::setw(10) << (double)deltas[i].count / s_intervalFrames << " /frame"
+            << std::setw(12) << (double)deltas[i].bytes / s_intervalFrames << " B/frame" << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+
+    s_intervalFrames = 0;
+    s_intervalAllocations = 0;
+    s_intervalMax = 0;
+    s_intervalZeroFrames = 0;
+}
+
+// Thay global new/delete, cả bản có căn lề (std::align_val_t) lẫn bản có kích thước, để không cấp phát nào
+// lọt khỏi bộ đếm. Dùng malloc/free trực tiếp, không gọi gì có thể cấp phát lại.
+void* operator new(std::size_t size) {
+    recordAllocation(size);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    recordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    recordAllocation(size);
+    void* ptr = alignedMalloc(size, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    recordAllocation(size);
+    return alignedMalloc(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    recordFree(ptr);
+    alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+    operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(ptr, alignment);
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <cstdint>
+#include <ostream>
+
+// Chế độ debug đếm mọi lần gọi global new/delete, bật bằng -DJEWEL_TRACK_ALLOCATIONS (target Debug-Alloc).
+// Mục tiêu khi đang chơi ổn định: 0 lần cấp phát mỗi frame.
+// ALLOCATION_SITE("tên") gắn nhãn cho các cấp phát trong phạm vi hiện tại của thread đang chạy.
+namespace AllocationTracker {
+#ifdef JEWEL_TRACK_ALLOCATIONS
+    const bool ENABLED = true;
+
+    class SiteScope {
+    public:
+        explicit SiteScope(const char* site);
+        ~SiteScope();
+
+    private:
+        const char* m_previous;
+    };
+
+    // Render thread gọi sau mỗi frame, tự in báo cáo sau mỗi khoảng REPORT_INTERVAL_FRAMES
+    void endFrame();
+    uint64_t lastFrameAllocations();
+    void report(std::ostream& out);
+#else
+    const bool ENABLED = false;
+
+    inline void endFrame() {}
+    inline uint64_t lastFrameAllocations() { return 0; }
+    inline void report(std::ostream&) {}
+#endif
+}
+
+#ifdef JEWEL_TRACK_ALLOCATIONS
+#define ALLOCATION_SITE_CONCAT2(a, b) a##b
+#define ALLOCATION_SITE_CONCAT(a, b) ALLOCATION_SITE_CONCAT2(a, b)
+#define ALLOCATION_SITE(name) AllocationTracker::SiteScope ALLOCATION_SITE_CONCAT(allocationSite_, __LINE__)(name)
+#else
+#define ALLOCATION_SITE(name) ((void)0)
+#endif
+
+#endif
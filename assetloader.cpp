@@ -0,0 +1,98 @@
+#include "assetloader.h"
+#include "assetpack.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+AssetLoader::AssetLoader() : m_nextJob(0), m_doneJobs(0) {}
+
+AssetLoader::~AssetLoader() {
+    clear();
+}
+
+void AssetLoader::clear() {
+    wait();
+
+    // Giải phóng những asset chưa được lấy (ví dụ thoát game khi đang loading)
+    for (auto& asset : m_assets) {
+        if (asset.surface) {
+            SDL_FreeSurface(asset.surface);
+            asset.surface = nullptr;
+        }
+        if (asset.sound) {
+            Mix_FreeChunk(asset.sound);
+            asset.sound = nullptr;
+        }
+    }
+}
+
+void AssetLoader::addImage(const std::string& filePath) {
+    m_assets.push_back({filePath, AssetType::Image});
+}
+
+void AssetLoader::addSound(const std::string& filePath) {
+    m_assets.push_back({filePath, AssetType::Sound});
+}
+
+void AssetLoader::start(int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads = std::min<int>(numThreads, m_assets.size());
+
+    for (int i = 0; i < numThreads; ++i) {
+        m_workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+void AssetLoader::wait() {
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    m_workers.clear();
+}
+
+bool AssetLoader::isDone() const {
+    return m_doneJobs.load(std::memory_order_acquire) == (int)m_assets.size();
+}
+
+float AssetLoader::progress() const {
+    if (m_assets.empty()) return 1.0f;
+    return m_doneJobs.load(std::memory_order_acquire) / (float)m_assets.size();
+}
+
+// Mỗi worker lấy job tiếp theo qua một bộ đếm atomic
+void AssetLoader::workerLoop() {
+    int index;
+    while ((index = m_nextJob.fetch_add(1)) < (int)m_assets.size()) {
+        decode(m_assets[index]);
+        m_doneJobs.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void AssetLoader::decode(Asset& asset) {
+    auto begin = std::chrono::steady_clock::now();
+
+    // Ưu tiên assets.pak, không có mới đọc file rời
+    if (asset.type == AssetType::Image) {
+        asset.surface = AssetPack::Instance()->loadSurface(asset.filePath);
+        if (asset.surface == nullptr) {
+            asset.surface = IMG_Load(asset.filePath.c_str());
+        }
+        if (asset.surface == nullptr) {
+            std::cerr << "Failed to decode image: " << asset.filePath << " Error: " << IMG_GetError() << std::endl;
+        }
+    } else {
+        asset.sound = AssetPack::Instance()->loadSound(asset.filePath);
+        if (asset.sound == nullptr) {
+            asset.sound = Mix_LoadWAV(asset.filePath.c_str());
+        }
+        if (asset.sound == nullptr) {
+            std::cerr << "Failed to decode sound: " << asset.filePath << " Error: " << Mix_GetError() << std::endl;
+        }
+    }
+
+    asset.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
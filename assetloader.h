@@ -0,0 +1,52 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Giải mã PNG/WAV song song trên worker pool.
+// Upload texture vẫn phải làm trên render thread (xem JewelGame::finishLoading).
+class AssetLoader {
+public:
+    enum class AssetType { Image, Sound };
+
+    struct Asset {
+        std::string filePath;
+        AssetType type;
+        SDL_Surface* surface = nullptr; // Image: đã decode, chờ upload
+        Mix_Chunk* sound = nullptr;     // Sound: đã decode sang format của Mix_OpenAudio
+        double decodeMs = 0.0;
+    };
+
+    AssetLoader();
+    ~AssetLoader();
+
+    void addImage(const std::string& filePath);
+    void addSound(const std::string& filePath);
+
+    void start(int numThreads = 0); // 0 = số core
+    void wait();
+    void clear(); // Chờ worker rồi giải phóng các asset chưa được lấy
+    bool isDone() const;
+    float progress() const;
+
+    // Chỉ được gọi sau khi isDone(). Người gọi lấy surface/sound thì đặt lại nullptr.
+    std::vector<Asset>& assets() { return m_assets; }
+
+private:
+    void workerLoop();
+    void decode(Asset& asset);
+
+    std::vector<Asset> m_assets;
+    std::vector<std::thread> m_workers;
+    std::atomic<int> m_nextJob;
+    std::atomic<int> m_doneJobs;
+};
+
+#endif
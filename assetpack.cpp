@@ -0,0 +1,141 @@
+#include "assetpack.h"
+#include <SDL_image.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+AssetPack* AssetPack::s_pInstance = nullptr;
+
+AssetPack* AssetPack::Instance() {
+    if (s_pInstance == nullptr) {
+        s_pInstance = new AssetPack();
+    }
+    return s_pInstance;
+}
+
+AssetPack::AssetPack() : m_entries(nullptr), m_entryCount(0) {}
+
+bool AssetPack::open(const std::string& filePath) {
+    m_entries = nullptr;
+    m_entryCount = 0;
+
+    if (!m_file.open(filePath)) {
+        return false;
+    }
+
+    if (m_file.size() < sizeof(PackHeader)) {
+        std::cerr << "Asset pack too small: " << filePath << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    PackHeader header;
+    memcpy(&header, m_file.data(), sizeof(header));
+    uint64_t indexSize = (uint64_t)header.entryCount * sizeof(PackEntry);
+    if (header.magic != PACK_MAGIC || header.version != PACK_VERSION ||
+        header.indexOffset > m_file.size() || indexSize > m_file.size() - header.indexOffset) {
+        std::cerr << "Invalid asset pack: " << filePath << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    const PackEntry* entries = reinterpret_cast<const PackEntry*>(m_file.data() + header.indexOffset);
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        if (entries[i].offset > m_file.size() || entries[i].size > m_file.size() - entries[i].offset) {
+            std::cerr << "Corrupt asset pack entry: " << i << std::endl;
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_entries = entries;
+    m_entryCount = header.entryCount;
+    std::cout << "Asset pack " << filePath << ": " << m_entryCount << " entries" << std::endl;
+    return true;
+}
+
+// Tìm nhị phân, index đã được packer sắp xếp theo tên
+const PackEntry* AssetPack::find(const std::string& name) const {
+    uint32_t low = 0;
+    uint32_t high = m_entryCount;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        int cmp = strncmp(m_entries[mid].name, name.c_str(), PACK_NAME_LENGTH);
+        if (cmp == 0) {
+            return &m_entries[mid];
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+const unsigned char* AssetPack::entryData(const PackEntry* entry) const {
+    return m_file.data() + entry->offset;
+}
+
+// open() đã kiểm tra index, kiểm lại trước mỗi lần đọc để entry hỏng không bao giờ đọc ra ngoài vùng map
+bool AssetPack::entryInMapping(const PackEntry* entry) const {
+    return m_file.data() != nullptr && entry->offset <= m_file.size() &&
+           entry->size <= m_file.size() - entry->offset && entry->size <= (uint64_t)INT32_MAX;
+}
+
+SDL_RWops* AssetPack::openRW(const std::string& name) const {
+    const PackEntry* entry = find(name);
+    if (entry == nullptr || entry->type != (uint32_t)PackEntryType::Raw || !entryInMapping(entry)) {
+        return nullptr;
+    }
+    return SDL_RWFromConstMem(entryData(entry), (int)entry->size);
+}
+
+SDL_Surface* AssetPack::loadSurface(const std::string& name) const {
+    const PackEntry* entry = find(name);
+    if (entry == nullptr || !entryInMapping(entry)) {
+        return nullptr;
+    }
+
+    if (entry->type == (uint32_t)PackEntryType::RGBA32) {
+        // Kích thước khai trong index phải nằm gọn trong entry, nếu không thì để người gọi đọc file rời
+        uint64_t pixelBytes = (uint64_t)entry->width * entry->height * 4;
+        if (entry->width == 0 || entry->height == 0 || entry->width > (uint32_t)INT32_MAX / 4 ||
+            entry->height > (uint32_t)INT32_MAX || pixelBytes > entry->size) {
+            std::cerr << "Packed image size mismatch: " << name << std::endl;
+            return nullptr;
+        }
+        // Surface trỏ thẳng vào vùng map, không copy pixel
+        void* pixels = const_cast<unsigned char*>(entryData(entry));
+        return SDL_CreateRGBSurfaceWithFormatFrom(pixels, entry->width, entry->height, 32,
+                                                  entry->width * 4, SDL_PIXELFORMAT_RGBA32);
+    }
+    if (entry->type == (uint32_t)PackEntryType::Raw) {
+        return IMG_Load_RW(SDL_RWFromConstMem(entryData(entry), (int)entry->size), 1);
+    }
+    return nullptr;
+}
+
+Mix_Chunk* AssetPack::loadSound(const std::string& name) const {
+    const PackEntry* entry = find(name);
+    if (entry == nullptr || !entryInMapping(entry)) {
+        return nullptr;
+    }
+
+    if (entry->type == (uint32_t)PackEntryType::PCM) {
+        // PCM chỉ dùng được nếu khớp format của Mix_OpenAudio, nếu không thì bỏ qua entry
+        int frequency = 0;
+        Uint16 format = 0;
+        int channels = 0;
+        Mix_QuerySpec(&frequency, &format, &channels);
+        if ((int)entry->width == frequency && (int)entry->height == channels && format == AUDIO_S16SYS) {
+            Uint8* samples = const_cast<unsigned char*>(entryData(entry));
+            return Mix_QuickLoad_RAW(samples, (Uint32)entry->size);
+        }
+        std::cerr << "Packed PCM format mismatch: " << name << std::endl;
+        return nullptr;
+    }
+    if (entry->type == (uint32_t)PackEntryType::Raw) {
+        return Mix_LoadWAV_RW(SDL_RWFromConstMem(entryData(entry), (int)entry->size), 1);
+    }
+    return nullptr;
+}
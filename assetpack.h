@@ -0,0 +1,73 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include <cstdint>
+#include <string>
+
+#include "mappedfile.h"
+
+// Định dạng file assets.pak (little-endian):
+//   PackHeader | dữ liệu các entry (căn lề PACK_ALIGNMENT) | PackEntry[entryCount] (sắp theo tên)
+const uint32_t PACK_MAGIC = 0x4B41504A; // "JPAK"
+const uint32_t PACK_VERSION = 1;
+const uint32_t PACK_ALIGNMENT = 64;
+const int PACK_NAME_LENGTH = 48;
+
+enum class PackEntryType : uint32_t {
+    Raw = 0,    // Nguyên file gốc (png, wav, mp3, ttf)
+    RGBA32 = 1, // Ảnh đã decode: width x height x 4 byte
+    PCM = 2     // Âm thanh đã decode: width = tần số, height = số kênh, format AUDIO_S16SYS
+};
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t alignment;
+    uint64_t indexOffset;
+    uint64_t reserved;
+};
+
+struct PackEntry {
+    char name[PACK_NAME_LENGTH]; // Đường dẫn tương đối, ví dụ "res/jewel_red.png"
+    uint64_t offset;
+    uint64_t size;
+    uint32_t type;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(PackHeader) == 32, "PackHeader layout");
+static_assert(sizeof(PackEntry) == 80, "PackEntry layout");
+
+// Pack được map vào bộ nhớ; các entry đưa thẳng cho SDL qua SDL_RWFromConstMem, không copy
+class AssetPack {
+public:
+    static AssetPack* Instance();
+
+    bool open(const std::string& filePath);
+    bool isOpen() const { return m_entries != nullptr; }
+
+    const PackEntry* find(const std::string& name) const;
+    const unsigned char* entryData(const PackEntry* entry) const;
+
+    // Trả nullptr nếu không có trong pack, khi đó người gọi đọc file rời trong res/
+    SDL_RWops* openRW(const std::string& name) const;
+    SDL_Surface* loadSurface(const std::string& name) const;
+    Mix_Chunk* loadSound(const std::string& name) const;
+
+private:
+    AssetPack();
+    bool entryInMapping(const PackEntry* entry) const;
+
+    static AssetPack* s_pInstance;
+    MappedFile m_file;
+    const PackEntry* m_entries;
+    uint32_t m_entryCount;
+};
+
+#endif
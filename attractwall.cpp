@@ -0,0 +1,314 @@
+#include "attractwall.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "bot.h"
+
+namespace {
+    const int WALL_GAME_MOVES = 300;      // Sau chừng này nước bàn chơi lại từ đầu cho tường luôn mới
+    const Uint32 WALL_MOVE_MIN_MS = 400;  // Nhịp bot, lệch nhau để các bàn không đi cùng lúc
+    const Uint32 WALL_MOVE_SPREAD_MS = 600;
+    const int WALL_PARALLEL_MIN = 4;      // Ít bàn tới lượt hơn thì bước luôn trên sim thread
+    const int WALL_CAPTION_HEIGHT = 30;   // Dải dưới cùng cho dòng chữ của màn
+    const int ATLAS_PADDING = 2;          // Tránh lấy màu ô bên cạnh khi lọc tuyến tính
+
+    const int WALL_QUADS_PER_BOARD = 1 + BOARD_SIZE * BOARD_SIZE + WALL_SCORE_DIGITS;
+    const SDL_Color WHITE = {255, 255, 255, 255};
+    const SDL_Color TILE_COLOR = {60, 60, 60, 255};
+    const SDL_Color SCORE_COLOR = {255, 255, 0, 255};
+}
+
+AttractWall::AttractWall() : m_movesPlayed(0), m_lastStepMs(0.0) {}
+
+bool AttractWall::start(int boards, uint64_t seed) {
+    boards = std::max(MIN_WALL_BOARDS, std::min(MAX_WALL_BOARDS, boards));
+    if (!m_pool) {
+        m_pool.reset(new ThreadPool());
+    }
+
+    JewelRng seeder(seed);
+    Uint32 now = SDL_GetTicks();
+    m_boards.assign(boards, WallBoard());
+    for (WallBoard& board : m_boards) {
+        board.engine.rng.seed(((uint64_t)seeder() << 32) | seeder());
+        board.engine.listener = nullptr;
+        board.engine.initBoard();
+        board.botRng.seed(((uint64_t)seeder() << 32) | seeder());
+        board.nextMove = now + board.botRng.below(WALL_MOVE_MIN_MS + WALL_MOVE_SPREAD_MS);
+        board.moves = 0;
+    }
+    m_due.clear();
+    m_due.reserve(boards);
+    m_movesPlayed = 0;
+    std::cout << "Attract wall: " << boards << " boards on " << m_pool->size() << " workers" << std::endl;
+    return true;
+}
+
+void AttractWall::stop() {
+    m_boards.clear();
+    m_due.clear();
+}
+
+void AttractWall::stepBoard(WallBoard& board, Uint32 now) {
+    BoardEngine& engine = board.engine;
+    if (board.moves >= WALL_GAME_MOVES) {
+        engine.score = 0;
+        engine.combo = 0;
+        engine.initBoard();
+        board.moves = 0;
+    } else {
+        Move moves[MAX_MOVES];
+        int count = engine.listMoves(moves);
+        if (count == 0) {
+            engine.shuffle();
+        } else {
+            Move move = greedyMove(engine, moves, count);
+            engine.trySwap(move.x1, move.y1, move.x2, move.y2);
+            board.moves++;
+        }
+    }
+    board.nextMove = now + WALL_MOVE_MIN_MS + board.botRng.below(WALL_MOVE_SPREAD_MS);
+}
+
+void AttractWall::update(Uint32 now) {
+    m_due.clear();
+    for (int i = 0; i < (int)m_boards.size(); ++i) {
+        if ((Sint32)(now - m_boards[i].nextMove) >= 0) {
+            m_due.push_back(i);
+        }
+    }
+    if (m_due.empty()) {
+        return;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    int due = (int)m_due.size();
+    if (due < WALL_PARALLEL_MIN || m_pool->size() <= 1) {
+        for (int index : m_due) {
+            stepBoard(m_boards[index], now);
+        }
+    } else {
+        // Mỗi worker một phần, các bàn không dùng chung gì nên không cần khóa
+        int chunks = std::min(m_pool->size(), due);
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            m_pool->submit([this, chunk, chunks, now] {
+                for (int k = chunk; k < (int)m_due.size(); k += chunks) {
+                    stepBoard(m_boards[m_due[k]], now);
+                }
+            });
+        }
+        m_pool->wait();
+    }
+    m_movesPlayed += due;
+    m_lastStepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void AttractWall::capture(WallBoardView views[MAX_WALL_BOARDS]) const {
+    for (int i = 0; i < (int)m_boards.size(); ++i) {
+        memcpy(views[i].cells, m_boards[i].engine.cells, sizeof(views[i].cells));
+        views[i].score = m_boards[i].engine.score;
+    }
+}
+
+WallRenderer::WallRenderer()
+    : m_atlas(nullptr), m_whiteSource{0, 0, 0, 0}, m_digitAspect(0.5f), m_layoutCount(-1), m_columns(1),
+      m_tileSize(0.0f), m_originX(0.0f), m_originY(0.0f), m_quads(0) {}
+
+WallRenderer::~WallRenderer() {
+    release();
+}
+
+bool WallRenderer::build(SDL_Renderer* renderer, SDL_Surface* const jewels[NUM_CELL_VALUES], TTF_Font* font) {
+    release();
+
+    // Hàng trên: các viên đá; hàng dưới: chữ số 0-9 màu trắng (tô màu bằng màu đỉnh) rồi một ô trắng cho nền
+    SDL_Surface* digits[10] = {};
+    int jewelRowWidth = ATLAS_PADDING, jewelRowHeight = 0;
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        if (!jewels[i]) {
+            std::cerr << "Attract wall: missing jewel image " << i << std::endl;
+            return false;
+        }
+        jewelRowWidth += jewels[i]->w + ATLAS_PADDING;
+        jewelRowHeight = std::max(jewelRowHeight, jewels[i]->h);
+    }
+    int digitRowWidth = ATLAS_PADDING, digitRowHeight = 8;
+    for (int d = 0; d < 10; ++d) {
+        char text[2] = {(char)('0' + d), 0};
+        digits[d] = font ? TTF_RenderText_Blended(font, text, WHITE) : nullptr;
+        if (digits[d]) {
+            digitRowWidth += digits[d]->w + ATLAS_PADDING;
+            digitRowHeight = std::max(digitRowHeight, digits[d]->h);
+        }
+    }
+    digitRowWidth += 8 + ATLAS_PADDING;
+
+    int atlasWidth = std::max(jewelRowWidth, digitRowWidth);
+    int atlasHeight = ATLAS_PADDING * 3 + jewelRowHeight + digitRowHeight;
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (atlas) {
+        SDL_FillRect(atlas, nullptr, SDL_MapRGBA(atlas->format, 0, 0, 0, 0));
+        float u = 1.0f / atlasWidth, v = 1.0f / atlasHeight;
+
+        int x = ATLAS_PADDING, y = ATLAS_PADDING;
+        for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+            SDL_Rect target = {x, y, jewels[i]->w, jewels[i]->h};
+            SDL_SetSurfaceBlendMode(jewels[i], SDL_BLENDMODE_NONE); // Chép nguyên alpha
+            SDL_BlitSurface(jewels[i], nullptr, atlas, &target);
+            m_jewelSource[i] = {x * u, y * v, target.w * u, target.h * v};
+            x += target.w + ATLAS_PADDING;
+        }
+
+        x = ATLAS_PADDING;
+        y = ATLAS_PADDING * 2 + jewelRowHeight;
+        float digitWidth = 0.0f;
+        for (int d = 0; d < 10; ++d) {
+            if (!digits[d]) {
+                m_digitSource[d] = {0, 0, 0, 0};
+                continue;
+            }
+            SDL_Rect target = {x, y, digits[d]->w, digits[d]->h};
+            SDL_SetSurfaceBlendMode(digits[d], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(digits[d], nullptr, atlas, &target);
+            m_digitSource[d] = {x * u, y * v, target.w * u, target.h * v};
+            digitWidth = std::max(digitWidth, (float)target.w);
+            x += target.w + ATLAS_PADDING;
+        }
+        m_digitAspect = digitRowHeight > 0 && digitWidth > 0 ? digitWidth / digitRowHeight : 0.5f;
+
+        // Lấy mẫu giữa ô trắng 8x8 để lọc tuyến tính không chạm viền trong suốt
+        SDL_Rect white = {x, y, 8, 8};
+        SDL_FillRect(atlas, &white, SDL_MapRGBA(atlas->format, 255, 255, 255, 255));
+        m_whiteSource = {(x + 3) * u, (y + 3) * v, 2 * u, 2 * v};
+
+        m_atlas = SDL_CreateTextureFromSurface(renderer, atlas);
+        SDL_FreeSurface(atlas);
+    }
+    for (SDL_Surface* digit : digits) {
+        if (digit) SDL_FreeSurface(digit);
+    }
+    if (!m_atlas) {
+        std::cerr << "Attract wall: failed to build atlas: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_SetTextureBlendMode(m_atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(m_atlas, SDL_ScaleModeLinear); // Đá thu nhỏ nhiều lần, nearest bị răng cưa
+
+    // Mỗi quad 4 đỉnh, 6 chỉ số; chỉ số không đổi giữa các frame nên dựng một lần
+    int maxQuads = MAX_WALL_BOARDS * WALL_QUADS_PER_BOARD;
+    m_vertices.resize((size_t)maxQuads * 4);
+    m_indices.resize((size_t)maxQuads * 6);
+    for (int quad = 0; quad < maxQuads; ++quad) {
+        int* index = &m_indices[(size_t)quad * 6];
+        int base = quad * 4;
+        index[0] = base;
+        index[1] = base + 1;
+        index[2] = base + 2;
+        index[3] = base;
+        index[4] = base + 2;
+        index[5] = base + 3;
+    }
+    m_layoutCount = -1;
+    return true;
+}
+
+void WallRenderer::release() {
+    if (m_atlas) {
+        SDL_DestroyTexture(m_atlas);
+        m_atlas = nullptr;
+    }
+}
+
+// Số cột cho ô vuông lớn nhất vừa màn hình
+void WallRenderer::layout(int count) {
+    float width = (float)SCREEN_WIDTH;
+    float height = (float)(SCREEN_HEIGHT - WALL_CAPTION_HEIGHT);
+    m_tileSize = 0.0f;
+    for (int columns = 1; columns <= count; ++columns) {
+        int rows = (count + columns - 1) / columns;
+        float size = std::min(width / columns, height / rows);
+        if (size > m_tileSize) {
+            m_tileSize = size;
+            m_columns = columns;
+        }
+    }
+    int rows = (count + m_columns - 1) / m_columns;
+    m_originX = (width - m_tileSize * m_columns) / 2;
+    m_originY = (height - m_tileSize * rows) / 2;
+    m_layoutCount = count;
+}
+
+void WallRenderer::addQuad(const SDL_FRect& rect, const SDL_FRect& source, SDL_Color color) {
+    SDL_Vertex* vertex = &m_vertices[(size_t)m_quads * 4];
+    vertex[0] = {{rect.x, rect.y}, color, {source.x, source.y}};
+    vertex[1] = {{rect.x + rect.w, rect.y}, color, {source.x + source.w, source.y}};
+    vertex[2] = {{rect.x + rect.w, rect.y + rect.h}, color, {source.x + source.w, source.y + source.h}};
+    vertex[3] = {{rect.x, rect.y + rect.h}, color, {source.x, source.y + source.h}};
+    m_quads++;
+}
+
+// Ô của mỗi bàn: dải điểm phía trên, bàn 8x8 canh giữa bên dưới
+SDL_FRect WallRenderer::boardArea(int index) const {
+    float margin = m_tileSize * 0.04f;
+    float scoreHeight = m_tileSize * 0.12f;
+    float boardSize = m_tileSize - margin * 2 - scoreHeight;
+    float tileX = m_originX + (index % m_columns) * m_tileSize;
+    float tileY = m_originY + (index / m_columns) * m_tileSize;
+    return {tileX + (m_tileSize - boardSize) / 2, tileY + margin + scoreHeight, boardSize, boardSize};
+}
+
+bool WallRenderer::boardRect(int index, SDL_FRect& rect) const {
+    if (index < 0 || index >= m_layoutCount) return false;
+    rect = boardArea(index);
+    return true;
+}
+
+void WallRenderer::draw(SDL_Renderer* renderer, const WallBoardView* views, int count, int featured) {
+    if (!m_atlas || count <= 0) {
+        return;
+    }
+    count = std::min(count, MAX_WALL_BOARDS);
+    if (count != m_layoutCount) {
+        layout(count);
+    }
+
+    float margin = m_tileSize * 0.04f;
+    float scoreHeight = m_tileSize * 0.12f;
+    float cellSize = boardArea(0).w / BOARD_SIZE;
+    float digitHeight = scoreHeight * 0.9f;
+    float digitWidth = digitHeight * m_digitAspect;
+
+    m_quads = 0;
+    for (int i = 0; i < count; ++i) {
+        const WallBoardView& view = views[i];
+        float tileX = m_originX + (i % m_columns) * m_tileSize;
+        float tileY = m_originY + (i / m_columns) * m_tileSize;
+        SDL_FRect board = boardArea(i);
+
+        addQuad({tileX + margin, tileY + margin, m_tileSize - margin * 2, m_tileSize - margin * 2}, m_whiteSource, TILE_COLOR);
+        for (int y = 0; y < BOARD_SIZE && i != featured; ++y) {
+            for (int x = 0; x < BOARD_SIZE; ++x) {
+                int value = view.cells[y][x];
+                if (value < 0 || value >= NUM_CELL_VALUES) continue;
+                addQuad({board.x + x * cellSize, board.y + y * cellSize, cellSize, cellSize}, m_jewelSource[value], WHITE);
+            }
+        }
+
+        char text[16];
+        int length = snprintf(text, sizeof(text), "%d", view.score);
+        length = std::min(length, WALL_SCORE_DIGITS);
+        for (int d = 0; d < length; ++d) {
+            int digit = text[d] - '0';
+            if (digit < 0 || digit > 9) continue;
+            addQuad({tileX + margin * 2 + d * digitWidth, tileY + margin, digitWidth, digitHeight}, m_digitSource[digit],
+                    SCORE_COLOR);
+        }
+    }
+
+    // Cả tường trong một lệnh vẽ: nền, đá và điểm cùng một texture, thứ tự đỉnh giữ thứ tự vẽ
+    SDL_RenderGeometry(renderer, m_atlas, m_vertices.data(), m_quads * 4, m_indices.data(), m_quads * 6);
+}
@@ -0,0 +1,102 @@
+#ifndef ATTRACTWALL_H
+#define ATTRACTWALL_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "board.h"
+#include "constants.h"
+#include "threadpool.h"
+
+// Màn hình chờ cho điểm trưng bày (--wall N): N bàn độc lập, mỗi bàn một bot greedy tự chơi, thu nhỏ trên một màn.
+// Sim thread bước các bàn tới lượt song song trên ThreadPool; render thread vẽ cả tường bằng một SDL_RenderGeometry
+// từ một atlas (đá, chữ số, một ô trắng cho nền), nên số lệnh vẽ không tăng theo số bàn.
+// Riêng một bàn được JewelGame vẽ lại qua renderBoard thu nhỏ, để tường cũng chạy đường vẽ bàn của game.
+const int MIN_WALL_BOARDS = 16;
+const int MAX_WALL_BOARDS = 64;
+const int WALL_SCORE_DIGITS = 7;
+
+// Bản chụp một bàn cho render thread (nằm trong RenderState)
+struct WallBoardView {
+    int8_t cells[BOARD_SIZE][BOARD_SIZE];
+    int score;
+};
+
+// Phần sim: chỉ sim thread dùng
+class AttractWall {
+public:
+    AttractWall();
+
+    bool start(int boards, uint64_t seed); // boards được kẹp vào [MIN_WALL_BOARDS, MAX_WALL_BOARDS]
+    void stop();
+    bool active() const { return !m_boards.empty(); }
+
+    void update(Uint32 now); // Bước mọi bàn đã tới lượt
+    int boardCount() const { return (int)m_boards.size(); }
+    void capture(WallBoardView views[MAX_WALL_BOARDS]) const;
+
+    uint64_t movesPlayed() const { return m_movesPlayed; }
+    double lastStepMs() const { return m_lastStepMs; }
+
+private:
+    struct WallBoard {
+        BoardEngine engine;
+        JewelRng botRng;
+        Uint32 nextMove;
+        int moves;
+    };
+
+    void stepBoard(WallBoard& board, Uint32 now);
+
+    std::vector<WallBoard> m_boards;
+    std::vector<int> m_due; // Chỉ số bàn tới lượt trong tick này, cấp phát một lần trong start()
+    std::unique_ptr<ThreadPool> m_pool;
+    uint64_t m_movesPlayed;
+    double m_lastStepMs;
+};
+
+// Phần vẽ: chỉ render thread dùng
+class WallRenderer {
+public:
+    WallRenderer();
+    ~WallRenderer();
+
+    WallRenderer(const WallRenderer&) = delete;
+    WallRenderer& operator=(const WallRenderer&) = delete;
+
+    // Gói ảnh đá và chữ số vào một atlas; gọi khi surface đá còn sống
+    bool build(SDL_Renderer* renderer, SDL_Surface* const jewels[NUM_CELL_VALUES], TTF_Font* font);
+    void release();
+    bool ready() const { return m_atlas != nullptr; }
+
+    // featured: bàn không vẽ đá bằng atlas vì người gọi vẽ nó qua renderBoard (-1 nếu không có)
+    void draw(SDL_Renderer* renderer, const WallBoardView* views, int count, int featured = -1);
+    // Vùng đá của bàn index theo bố cục của lần draw gần nhất
+    bool boardRect(int index, SDL_FRect& rect) const;
+
+private:
+    void layout(int count);
+    SDL_FRect boardArea(int index) const;
+    void addQuad(const SDL_FRect& rect, const SDL_FRect& source, SDL_Color color);
+
+    SDL_Texture* m_atlas;
+    SDL_FRect m_jewelSource[NUM_CELL_VALUES]; // Toạ độ texture chuẩn hoá [0, 1]
+    SDL_FRect m_digitSource[10];
+    SDL_FRect m_whiteSource;
+    float m_digitAspect; // Rộng / cao của một chữ số
+
+    int m_layoutCount;
+    int m_columns;
+    float m_tileSize;
+    float m_originX, m_originY;
+
+    std::vector<SDL_Vertex> m_vertices; // Đủ cho MAX_WALL_BOARDS, không cấp phát lúc vẽ
+    std::vector<int> m_indices;
+    int m_quads;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "autosaver.h"
+
+AutoSaver::AutoSaver() : m_hasPending(false), m_stopping(false), m_savesWritten(0) {}
+
+AutoSaver::~AutoSaver() {
+    stop();
+}
+
+void AutoSaver::start(const std::string& filePath) {
+    if (m_thread.joinable()) return;
+
+    m_filePath = filePath;
+    m_stopping = false;
+    m_thread = std::thread(&AutoSaver::threadLoop, this);
+}
+
+void AutoSaver::submit(const GameSnapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = snapshot;
+        m_hasPending = true;
+    }
+    m_condition.notify_one();
+
+    // Chưa start (hoặc đã stop) thì ghi luôn để không mất bản lưu
+    if (!m_thread.joinable()) {
+        writeSaveFile(m_filePath, snapshot);
+        m_hasPending = false;
+        m_savesWritten++;
+    }
+}
+
+void AutoSaver::stop() {
+    if (!m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+void AutoSaver::threadLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [this] { return m_hasPending || m_stopping; });
+
+        if (m_hasPending) {
+            GameSnapshot snapshot = m_pending;
+            m_hasPending = false;
+
+            // Ghi và fsync ngoài lock, main thread vẫn submit được
+            lock.unlock();
+            writeSaveFile(m_filePath, snapshot);
+            m_savesWritten++;
+            lock.lock();
+        } else if (m_stopping) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "saveload.h"
+
+// Thread nền ghi savegame. Main thread chỉ copy GameSnapshot (56 byte) vào một ô chờ,
+// không bao giờ đợi I/O đĩa. Nếu nhiều bản gửi tới trong lúc đang ghi thì chỉ bản mới nhất được ghi.
+class AutoSaver {
+public:
+    AutoSaver();
+    ~AutoSaver();
+
+    void start(const std::string& filePath);
+    void submit(const GameSnapshot& snapshot);
+    void stop(); // Ghi nốt bản đang chờ rồi join thread
+
+    int savesWritten() const { return m_savesWritten.load(); }
+
+private:
+    void threadLoop();
+
+    std::string m_filePath;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    GameSnapshot m_pending;
+    bool m_hasPending;
+    bool m_stopping;
+    std::atomic<int> m_savesWritten;
+};
+
+#endif
@@ -0,0 +1,482 @@
+#include "board.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    inline uint64_t cellBit(int cell) {
+        return 1ULL << cell;
+    }
+}
+
+// Kiểm tra quanh (x, y) trong phạm vi 2 ô, giống luật cũ của processSwappedJewels
+bool hasMatchAroundCells(const int8_t cells[BOARD_SIZE][BOARD_SIZE], int x, int y) {
+    int startX = std::max(0, x - 2);
+    int endX = std::min(BOARD_SIZE - 1, x + 2);
+    for (int i = startX; i <= endX - 2; ++i) {
+        int color = jewelColor(cells[y][i]);
+        if (color != -1 && color == jewelColor(cells[y][i + 1]) && color == jewelColor(cells[y][i + 2])) {
+            return true;
+        }
+    }
+
+    int startY = std::max(0, y - 2);
+    int endY = std::min(BOARD_SIZE - 1, y + 2);
+    for (int i = startY; i <= endY - 2; ++i) {
+        int color = jewelColor(cells[i][x]);
+        if (color != -1 && color == jewelColor(cells[i + 1][x]) && color == jewelColor(cells[i + 2][x])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BoardEngine::BoardEngine() : score(0), combo(0), lastCascadeDepth(0), listener(nullptr), m_lastSwap{-1, -1, -1, -1} {
+    memset(cells, -1, sizeof(cells));
+    memset(matched, 0, sizeof(matched));
+}
+
+//Khởi tạo bảng 8x8 đá quý
+void BoardEngine::initBoard() {
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            cells[y][x] = getRandomJewel(x, y);
+        }
+    }
+
+    while (checkMatchesAndMarkMatched()) {
+        removeMatches();
+        dropJewels();
+        processCascadeMatches();
+    }
+}
+
+// Hàm tạo ngẫu nhiên đá, tránh tạo sẵn 3 viên liền bên trái hoặc phía trên
+int BoardEngine::getRandomJewel(int x, int y) {
+    int possibleJewels[NUM_JEWEL_TYPES];
+    int count = 0;
+    for (int jewel = 0; jewel < NUM_JEWEL_TYPES; ++jewel) {
+        if (!isMatchAt(x, y, jewel)) {
+            possibleJewels[count++] = jewel;
+        }
+    }
+
+    if (count == 0) {
+        return rng.below(NUM_JEWEL_TYPES);
+    }
+    return possibleJewels[rng.below(count)];
+}
+
+// Hàm check điều kiện ăn đá
+bool BoardEngine::isMatchAt(int x, int y, int jewel) const {
+    // ngang
+    if (x >= 2 &&
+        jewelColor(cells[y][x - 1]) == jewel &&
+        jewelColor(cells[y][x - 2]) == jewel) {
+        return true;
+    }
+
+    // dọc
+    if (y >= 2 &&
+        jewelColor(cells[y - 1][x]) == jewel &&
+        jewelColor(cells[y - 2][x]) == jewel) {
+        return true;
+    }
+
+    return false;
+}
+
+bool BoardEngine::hasMatchAround(int x, int y) const {
+    return hasMatchAroundCells(cells, x, y);
+}
+
+bool BoardEngine::isAdjacent(int x1, int y1, int x2, int y2) const {
+    return (abs(x1 - x2) == 1 && y1 == y2) ||
+           (abs(y1 - y2) == 1 && x1 == x2);
+}
+
+bool BoardEngine::trySwap(int x1, int y1, int x2, int y2) {
+    lastCascadeDepth = 0;
+    bool bombSwap = cells[y1][x1] == COLOR_BOMB || cells[y2][x2] == COLOR_BOMB;
+    std::swap(cells[y1][x1], cells[y2][x2]);
+
+    if (bombSwap) {
+        // Bom màu xóa mọi đá cùng màu với viên bị đổi, hai bom cạnh nhau thì xóa cả bàn
+        int cell1 = y1 * BOARD_SIZE + x1;
+        int cell2 = y2 * BOARD_SIZE + x2;
+        uint64_t bombs = (cells[y1][x1] == COLOR_BOMB ? cellBit(cell1) : 0) |
+                         (cells[y2][x2] == COLOR_BOMB ? cellBit(cell2) : 0);
+        uint64_t clearMask = bombs == (cellBit(cell1) | cellBit(cell2))
+            ? ~0ULL
+            : bombs | colorMask(jewelColor(cells[y1][x1] == COLOR_BOMB ? cells[y2][x2] : cells[y1][x1]));
+
+        resolveStep(clearMask, bombs, false);
+        processCascadeMatches();
+        return true;
+    }
+
+    if (!hasMatchAround(x1, y1) && !hasMatchAround(x2, y2)) {
+        std::swap(cells[y1][x1], cells[y2][x2]);
+        combo = 0;
+        return false;
+    }
+
+    m_lastSwap = {(int8_t)x1, (int8_t)y1, (int8_t)x2, (int8_t)y2};
+    processCascadeMatches();
+    return true;
+}
+
+int BoardEngine::listMoves(Move moves[MAX_MOVES]) const {
+    return listMovesOn(cells, moves);
+}
+
+int listMovesOn(const int8_t cells[BOARD_SIZE][BOARD_SIZE], Move moves[MAX_MOVES]) {
+    int8_t work[BOARD_SIZE][BOARD_SIZE];
+    memcpy(work, cells, sizeof(work));
+
+    int count = 0;
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            // Chỉ xét sang phải và xuống dưới để mỗi cặp được đếm một lần
+            for (int dir = 0; dir < 2; ++dir) {
+                int x2 = x + (dir == 0 ? 1 : 0);
+                int y2 = y + (dir == 1 ? 1 : 0);
+                if (x2 >= BOARD_SIZE || y2 >= BOARD_SIZE) continue;
+                if (work[y][x] == COLOR_BOMB || work[y2][x2] == COLOR_BOMB) {
+                    moves[count++] = {(int8_t)x, (int8_t)y, (int8_t)x2, (int8_t)y2};
+                    continue;
+                }
+                if (jewelColor(work[y][x]) == jewelColor(work[y2][x2])) continue;
+
+                std::swap(work[y][x], work[y2][x2]);
+                if (hasMatchAroundCells(work, x, y) || hasMatchAroundCells(work, x2, y2)) {
+                    moves[count++] = {(int8_t)x, (int8_t)y, (int8_t)x2, (int8_t)y2};
+                }
+                std::swap(work[y][x], work[y2][x2]);
+            }
+        }
+    }
+    return count;
+}
+
+int BoardEngine::countMatchedJewels() const {
+    int count = 0;
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            if (matched[y][x]) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void BoardEngine::calculateScore(int matchedJewels, int comboMultiplier) {
+    int basePoints = matchPoints(matchedJewels);
+
+    int comboBonus = std::max(1, comboMultiplier);
+    int totalPoints = basePoints * comboBonus;
+    score += totalPoints;
+
+    if (listener) {
+        ScoreEvent event;
+        event.points = totalPoints;
+        event.combo = comboMultiplier;
+        event.matchSize = matchedJewels;
+        event.timestamp = 0; // Listener tự gắn thời gian
+        listener->onScore(event);
+    }
+}
+
+// hàm check và đánh đánh dấu các đá được ăn
+bool BoardEngine::checkMatchesAndMarkMatched() {
+    memset(matched, 0, sizeof(matched));
+    bool hasMatches = false;
+
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE - 2; x++) {
+            int color = jewelColor(cells[y][x]);
+            if (color != -1 &&
+                color == jewelColor(cells[y][x + 1]) &&
+                color == jewelColor(cells[y][x + 2])) {
+
+                int endX = x + 2;
+                while (endX + 1 < BOARD_SIZE &&
+                       jewelColor(cells[y][endX + 1]) == color) {
+                    endX++;
+                }
+
+                for (int i = x; i <= endX; i++) {
+                    matched[y][i] = true;
+                }
+                hasMatches = true;
+            }
+        }
+    }
+
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        for (int y = 0; y < BOARD_SIZE - 2; y++) {
+            int color = jewelColor(cells[y][x]);
+            if (color != -1 &&
+                color == jewelColor(cells[y + 1][x]) &&
+                color == jewelColor(cells[y + 2][x])) {
+
+                int endY = y + 2;
+                while (endY + 1 < BOARD_SIZE &&
+                       jewelColor(cells[endY + 1][x]) == color) {
+                    endY++;
+                }
+
+                for (int i = y; i <= endY; i++) {
+                    matched[i][x] = true;
+                }
+                hasMatches = true;
+            }
+        }
+    }
+
+    return hasMatches;
+}
+
+// Bỏ các đá được ăn
+void BoardEngine::removeMatches() {
+    if (listener) {
+        listener->onMatchesRemoved(matched);
+    }
+
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            if (matched[y][x]) {
+                cells[y][x] = -1;
+            }
+        }
+    }
+}
+
+// Thả đá lấp đầy
+void BoardEngine::dropJewels() {
+    int8_t dropDistance[BOARD_SIZE][BOARD_SIZE] = {};
+
+    for (int x = 0; x < BOARD_SIZE; x++) {
+        int dropTo = BOARD_SIZE - 1;
+
+        for (int y = BOARD_SIZE - 1; y >= 0; y--) {
+            if (cells[y][x] != -1) {
+                cells[dropTo][x] = cells[y][x];
+                if (dropTo != y) {
+                    dropDistance[dropTo][x] = dropTo - y;
+                    cells[y][x] = -1;
+                }
+                dropTo--;
+            }
+        }
+
+        while (dropTo >= 0) {
+            cells[dropTo][x] = getRandomJewel(x, dropTo);
+            dropDistance[dropTo][x] = 1;
+            dropTo--;
+        }
+    }
+
+    if (listener) {
+        listener->onJewelsDropped(dropDistance);
+    }
+}
+
+// Các hàng >= 3 cùng màu, mỗi hàng đếm một lần (khác checkMatchesAndMarkMatched chỉ đánh dấu ô)
+int BoardEngine::collectRuns(MatchRun runs[MAX_RUNS]) const {
+    int count = 0;
+    for (int horizontal = 1; horizontal >= 0; --horizontal) {
+        for (int line = 0; line < BOARD_SIZE; ++line) {
+            int start = 0;
+            while (start < BOARD_SIZE) {
+                int color = horizontal ? jewelColor(cells[line][start]) : jewelColor(cells[start][line]);
+                int end = start;
+                while (color != -1 && end + 1 < BOARD_SIZE &&
+                       (horizontal ? jewelColor(cells[line][end + 1]) : jewelColor(cells[end + 1][line])) == color) {
+                    end++;
+                }
+                if (color != -1 && end - start + 1 >= 3) {
+                    runs[count++] = {(int8_t)(horizontal ? start : line), (int8_t)(horizontal ? line : start),
+                                     (int8_t)(end - start + 1), horizontal == 1};
+                }
+                start = end + 1;
+            }
+        }
+    }
+    return count;
+}
+
+// Ăn 4 sinh đá sọc, ăn 5 trở lên sinh bom màu. Đá mới nằm ở ô vừa đổi chỗ nếu ô đó thuộc hàng,
+// nếu không thì ở ô thứ hai của hàng. Hai hàng giao nhau (chữ L, T) dùng chung một ô, bom được ưu tiên.
+int BoardEngine::planSpecials(SpecialSpawn spawns[MAX_RUNS]) const {
+    MatchRun runs[MAX_RUNS];
+    int runCount = collectRuns(runs);
+    int spawnCount = 0;
+
+    for (int r = 0; r < runCount; ++r) {
+        const MatchRun& run = runs[r];
+        if (run.length < 4) continue;
+
+        int8_t value = run.length >= 5 ? COLOR_BOMB : (int8_t)(STRIPE_JEWEL_BASE + jewelColor(cells[run.y][run.x]));
+        int dx = run.horizontal ? 1 : 0;
+        int dy = run.horizontal ? 0 : 1;
+        int cell = (run.y + dy) * BOARD_SIZE + run.x + dx;
+        for (int i = 0; i < run.length; ++i) {
+            int x = run.x + dx * i;
+            int y = run.y + dy * i;
+            if ((x == m_lastSwap.x1 && y == m_lastSwap.y1) || (x == m_lastSwap.x2 && y == m_lastSwap.y2)) {
+                cell = y * BOARD_SIZE + x;
+                break;
+            }
+        }
+
+        int existing = 0;
+        while (existing < spawnCount && spawns[existing].cell != cell) existing++;
+        if (existing == spawnCount) {
+            spawns[spawnCount++] = {(int8_t)cell, value};
+        } else if (value == COLOR_BOMB) {
+            spawns[existing].value = value;
+        }
+    }
+    return spawnCount;
+}
+
+uint64_t BoardEngine::colorMask(int color) const {
+    uint64_t mask = 0;
+    if (color < 0) return mask;
+
+    const int8_t* flat = &cells[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        if (jewelColor(flat[i]) == color) mask |= cellBit(i);
+    }
+    return mask;
+}
+
+// Bom màu bị nổ lây (không phải do người chơi đổi) xóa màu còn nhiều nhất trên bàn
+int BoardEngine::mostCommonColor(uint64_t excludeMask) const {
+    int counts[NUM_JEWEL_TYPES] = {};
+    const int8_t* flat = &cells[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        int color = jewelColor(flat[i]);
+        if (color != -1 && !(excludeMask & cellBit(i))) counts[color]++;
+    }
+
+    int best = -1;
+    for (int color = 0; color < NUM_JEWEL_TYPES; ++color) {
+        if (counts[color] > 0 && (best == -1 || counts[color] > counts[best])) best = color;
+    }
+    return best;
+}
+
+// Nổ dây chuyền bằng hàng đợi cố định thay cho đệ quy. Mỗi ô nằm trong clearMask được xét đúng một lần
+// và mỗi đá đặc biệt nổ nhiều nhất một lần, nên vòng lặp có cận 64 lần nổ dù bom kích bom.
+uint64_t BoardEngine::detonateChain(uint64_t clearMask, uint64_t detonated) const {
+    const int8_t* flat = &cells[0][0];
+    int8_t queue[BOARD_SIZE * BOARD_SIZE];
+    int head = 0;
+    int tail = 0;
+    uint64_t pending = clearMask & ~detonated;
+
+    while (true) {
+        while (pending) {
+            int cell = __builtin_ctzll(pending);
+            pending &= pending - 1;
+            if (isSpecialJewel(flat[cell]) && !(detonated & cellBit(cell))) {
+                detonated |= cellBit(cell);
+                queue[tail++] = (int8_t)cell;
+            }
+        }
+        if (head == tail) break;
+
+        int cell = queue[head++];
+        uint64_t blast = flat[cell] == COLOR_BOMB
+            ? colorMask(mostCommonColor(clearMask))
+            : 0xFFULL << (cell / BOARD_SIZE * BOARD_SIZE); // Đá sọc ngang xóa cả hàng
+        pending = blast & ~clearMask;
+        clearMask |= blast;
+    }
+    return clearMask;
+}
+
+// Một lượt ăn: nổ dây chuyền, tính điểm, bỏ đá, đặt đá đặc biệt mới rồi thả đá
+void BoardEngine::resolveStep(uint64_t clearMask, uint64_t detonated, bool spawnSpecials) {
+    SpecialSpawn spawns[MAX_RUNS];
+    int spawnCount = spawnSpecials ? planSpecials(spawns) : 0;
+
+    clearMask = detonateChain(clearMask, detonated);
+    bool* flatMatched = &matched[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        flatMatched[i] = (clearMask & cellBit(i)) != 0;
+    }
+
+    calculateScore(countMatchedJewels(), combo + 1);
+    removeMatches();
+
+    int8_t* flat = &cells[0][0];
+    for (int i = 0; i < spawnCount; ++i) {
+        flat[spawns[i].cell] = spawns[i].value;
+        if (listener) {
+            listener->onSpecialSpawned(spawns[i].cell, spawns[i].value);
+        }
+    }
+
+    dropJewels();
+    lastCascadeDepth++;
+    m_lastSwap = {-1, -1, -1, -1};
+
+    if (listener) {
+        listener->onCascadeStep();
+    }
+}
+
+// Hàm cho phép ăn các đá được match 1 cách liên tiếp
+void BoardEngine::processCascadeMatches() {
+    while (checkMatchesAndMarkMatched()) {
+        uint64_t clearMask = 0;
+        const bool* flatMatched = &matched[0][0];
+        for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+            if (flatMatched[i]) clearMask |= cellBit(i);
+        }
+        resolveStep(clearMask, 0, true);
+    }
+
+    combo = 0;
+}
+
+// Tráo bài: giữ nguyên các viên đá (kể cả đá đặc biệt), xáo vị trí
+void BoardEngine::shuffle() {
+    int8_t jewels[BOARD_SIZE * BOARD_SIZE];
+    int total = 0;
+    const int8_t* current = &cells[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        if (current[i] != -1) {
+            jewels[total++] = current[i];
+        }
+    }
+
+    // Fisher-Yates bằng JewelRng để kết quả giống nhau trên mọi compiler
+    for (int i = total - 1; i > 0; --i) {
+        std::swap(jewels[i], jewels[rng.below(i + 1)]);
+    }
+
+    int8_t* flat = &cells[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        flat[i] = i < total ? jewels[i] : -1;
+    }
+}
+
+void BoardEngine::capture(GameSnapshot& snapshot) const {
+    snapshot.rngState = rng.state();
+    packCells(cells, snapshot.cells);
+    snapshot.score = score;
+    snapshot.combo = combo;
+}
+
+void BoardEngine::restore(const GameSnapshot& snapshot) {
+    rng.setState(snapshot.rngState);
+    unpackCells(snapshot.cells, cells);
+    score = snapshot.score;
+    combo = snapshot.combo;
+    lastCascadeDepth = 0;
+    m_lastSwap = {-1, -1, -1, -1};
+}
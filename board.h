@@ -0,0 +1,147 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstdint>
+
+#include "constants.h"
+#include "gamesnapshot.h"
+#include "rng.h"
+
+struct ScoreEvent {
+    int points;
+    int combo;
+    int matchSize;
+    uint32_t timestamp;
+};
+
+// Điểm gốc của một lượt ăn matchedJewels viên, trước khi nhân combo
+inline int matchPoints(int matchedJewels) {
+    switch (matchedJewels) {
+    case 3: return 10;
+    case 4: return 30;
+    case 5: return 60;
+    default: return matchedJewels * 10;
+    }
+}
+
+// Số nước đổi chỗ tối đa trên bàn 8x8: 7*8 ngang + 7*8 dọc
+const int MAX_MOVES = 2 * BOARD_SIZE * (BOARD_SIZE - 1);
+
+struct Move {
+    int8_t x1, y1, x2, y2;
+};
+
+// Số hàng ăn được tối đa trong một lượt: mỗi hàng/cột 8 ô có nhiều nhất 2 hàng >= 3
+const int MAX_RUNS = 4 * BOARD_SIZE;
+
+// Màu của ô: đá sọc cùng màu với đá thường, -1 cho ô trống và bom màu (không ghép hàng)
+inline int jewelColor(int value) {
+    if (value < 0 || value == COLOR_BOMB) return -1;
+    return value < STRIPE_JEWEL_BASE ? value : value - STRIPE_JEWEL_BASE;
+}
+
+inline bool isSpecialJewel(int value) {
+    return value >= STRIPE_JEWEL_BASE;
+}
+
+// Mã hóa nước đi thành số: (y * 8 + x) * 2 + dir, dir 0 = sang phải, 1 = xuống dưới.
+// Dùng chung cho jewelenv và dataset.
+const int NUM_ACTIONS = BOARD_SIZE * BOARD_SIZE * 2;
+
+inline int moveToAction(const Move& move) {
+    int x = move.x1 < move.x2 ? move.x1 : move.x2;
+    int y = move.y1 < move.y2 ? move.y1 : move.y2;
+    return (y * BOARD_SIZE + x) * 2 + (move.y1 != move.y2 ? 1 : 0);
+}
+
+inline bool actionToMove(int action, Move& move) {
+    if (action < 0 || action >= NUM_ACTIONS) return false;
+    int x = (action >> 1) % BOARD_SIZE;
+    int y = (action >> 1) / BOARD_SIZE;
+    int x2 = x + ((action & 1) == 0 ? 1 : 0);
+    int y2 = y + ((action & 1) == 1 ? 1 : 0);
+    if (x2 >= BOARD_SIZE || y2 >= BOARD_SIZE) return false;
+    move = {(int8_t)x, (int8_t)y, (int8_t)x2, (int8_t)y2};
+    return true;
+}
+
+// Có hàng >= 3 đi qua (x, y) trong phạm vi 2 ô; dùng chung cho BoardEngine và EndlessBoard
+bool hasMatchAroundCells(const int8_t cells[BOARD_SIZE][BOARD_SIZE], int x, int y);
+// Các nước đổi chỗ hợp lệ trên một bàn 8x8 bất kỳ
+int listMovesOn(const int8_t cells[BOARD_SIZE][BOARD_SIZE], Move moves[MAX_MOVES]);
+
+// Nhận sự kiện từ BoardEngine để phát âm thanh, chạy hoạt ảnh, ghi điểm.
+// Bot và các công cụ headless không cần listener.
+class BoardListener {
+public:
+    virtual ~BoardListener() {}
+    virtual void onMatchesRemoved(const bool matched[BOARD_SIZE][BOARD_SIZE]) {}
+    // Đá đặc biệt vừa đặt vào ô trống sau khi ăn, trước khi rơi; cell = y * BOARD_SIZE + x
+    virtual void onSpecialSpawned(int cell, int value) {}
+    // dropDistance: số ô mỗi viên vừa rơi (viên mới sinh tính là 1), 0 nếu đứng yên
+    virtual void onJewelsDropped(const int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]) {}
+    virtual void onCascadeStep() {}
+    virtual void onScore(const ScoreEvent& event) {}
+    // Versus: nước đi cục bộ vừa chạy và đã phát hết sự kiện của nó
+    virtual void onMoveApplied() {}
+    // Nước đi đã phát sự kiện bị hủy (versus tua lại), bàn đã quay về trạng thái trước nước đó.
+    // Chỉ các nước sau cùng bị hủy, báo theo thứ tự frame tăng dần.
+    virtual void onMoveRolledBack() {}
+};
+
+// Luật chơi thuần túy (không SDL): bàn đá, ăn đá, rơi, tính điểm.
+// Đủ nhỏ để copy từng trạng thái khi bot tìm kiếm.
+class BoardEngine {
+public:
+    int8_t cells[BOARD_SIZE][BOARD_SIZE]; // -1 là ô trống
+    bool matched[BOARD_SIZE][BOARD_SIZE];
+    JewelRng rng;
+    int score;
+    int combo;
+    int lastCascadeDepth; // Số lượt ăn của nước đi gần nhất
+    BoardListener* listener;
+
+    BoardEngine();
+
+    void initBoard();
+    bool isAdjacent(int x1, int y1, int x2, int y2) const;
+    bool trySwap(int x1, int y1, int x2, int y2); // false và hoàn tác nếu không tạo được match (bom màu luôn hợp lệ)
+    int listMoves(Move moves[MAX_MOVES]) const;  // Các nước đổi chỗ hợp lệ
+    void shuffle();
+
+    bool checkMatchesAndMarkMatched();
+    void processCascadeMatches();
+
+    void capture(GameSnapshot& snapshot) const; // Chỉ ghi cells, rngState, score, combo
+    void restore(const GameSnapshot& snapshot);
+
+private:
+    struct MatchRun {
+        int8_t x, y, length;
+        bool horizontal;
+    };
+
+    struct SpecialSpawn {
+        int8_t cell;  // y * BOARD_SIZE + x
+        int8_t value; // Đá sọc hoặc COLOR_BOMB
+    };
+
+    Move m_lastSwap; // Ô vừa đổi chỗ, đá đặc biệt ưu tiên sinh ở đây; -1 sau lượt ăn đầu tiên
+
+    int getRandomJewel(int x, int y);
+    bool isMatchAt(int x, int y, int jewel) const;
+    bool hasMatchAround(int x, int y) const;
+    int countMatchedJewels() const;
+    void calculateScore(int matchedJewels, int comboMultiplier);
+    void removeMatches();
+    void dropJewels();
+
+    int collectRuns(MatchRun runs[MAX_RUNS]) const;
+    int planSpecials(SpecialSpawn spawns[MAX_RUNS]) const;
+    uint64_t colorMask(int color) const;
+    int mostCommonColor(uint64_t excludeMask) const;
+    uint64_t detonateChain(uint64_t clearMask, uint64_t detonated) const;
+    void resolveStep(uint64_t clearMask, uint64_t detonated, bool spawnSpecials);
+};
+
+#endif
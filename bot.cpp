@@ -0,0 +1,217 @@
+#include "bot.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+    uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    struct ZobristKeys {
+        uint64_t cell[BOARD_SIZE * BOARD_SIZE][NUM_CELL_VALUES + 1];
+        uint64_t depth[64];
+
+        ZobristKeys() {
+            uint64_t state = 0x4A4557454C424F54ULL;
+            for (auto& keys : cell) {
+                for (auto& key : keys) {
+                    key = splitMix64(state);
+                }
+            }
+            for (auto& key : depth) {
+                key = splitMix64(state);
+            }
+        }
+    };
+
+    const ZobristKeys s_zobrist;
+
+    // Kiểm tra budget mỗi 1024 node để không gọi clock quá nhiều
+    const uint64_t BUDGET_CHECK_INTERVAL = 1024;
+}
+
+Move greedyMove(const BoardEngine& position, const Move* moves, int count) {
+    int best = 0;
+    int bestGain = -1;
+    for (int i = 0; i < count; ++i) {
+        BoardEngine trial = position;
+        trial.listener = nullptr;
+        uint64_t seed = position.rng.state() + i;
+        trial.rng.seed(splitMix64(seed));
+        trial.trySwap(moves[i].x1, moves[i].y1, moves[i].x2, moves[i].y2);
+        int gain = trial.score - position.score;
+        if (gain > bestGain) {
+            bestGain = gain;
+            best = i;
+        }
+    }
+    return moves[best];
+}
+
+JewelBot::JewelBot(const BotConfig& config)
+    : m_config(config), m_pool(config.threads),
+      m_table(new TableEntry[(size_t)1 << config.tableBits]),
+      m_tableMask(((uint64_t)1 << config.tableBits) - 1),
+      m_nodes(0), m_aborted(false) {
+    for (uint64_t i = 0; i <= m_tableMask; ++i) {
+        m_table[i].check = 0;
+        m_table[i].data = 0;
+    }
+}
+
+JewelBot::~JewelBot() {}
+
+uint64_t JewelBot::hashBoard(const int8_t cells[BOARD_SIZE][BOARD_SIZE]) {
+    uint64_t hash = 0;
+    const int8_t* flat = &cells[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        hash ^= s_zobrist.cell[i][flat[i] + 1];
+    }
+    return hash;
+}
+
+bool JewelBot::probe(uint64_t key, int depth, double& value) const {
+    const TableEntry& entry = m_table[key & m_tableMask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || (int)(data >> 32) != depth) {
+        return false;
+    }
+
+    uint32_t bits = (uint32_t)data;
+    float stored;
+    memcpy(&stored, &bits, sizeof(stored));
+    value = stored;
+    return true;
+}
+
+void JewelBot::store(uint64_t key, int depth, double value) {
+    float stored = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &stored, sizeof(bits));
+    uint64_t data = bits | ((uint64_t)depth << 32);
+
+    TableEntry& entry = m_table[key & m_tableMask];
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+bool JewelBot::outOfBudget(uint64_t localNodes) {
+    if (m_aborted.load(std::memory_order_relaxed)) return true;
+    if (localNodes % BUDGET_CHECK_INTERVAL != 0) return false;
+
+    uint64_t total = m_nodes.fetch_add(BUDGET_CHECK_INTERVAL, std::memory_order_relaxed) + BUDGET_CHECK_INTERVAL;
+    if ((m_config.nodeBudget > 0 && total >= m_config.nodeBudget) ||
+        (m_config.timeBudgetMs > 0 && std::chrono::steady_clock::now() >= m_deadline)) {
+        m_aborted = true;
+    }
+    return m_aborted;
+}
+
+// Chance node: một mẫu refill cho một nước đi
+double JewelBot::expandMove(const BoardEngine& position, uint64_t hash, const Move& move, int sample, int depth, uint64_t& nodes) {
+    BoardEngine child = position;
+    child.listener = nullptr;
+    uint64_t seedState = hash ^ ((uint64_t)(move.x1 + 8 * move.y1 + 64 * move.x2 + 512 * move.y2) << 16) ^ (uint64_t)sample;
+    child.rng.seed(splitMix64(seedState));
+    child.trySwap(move.x1, move.y1, move.x2, move.y2);
+
+    nodes++;
+    double gain = child.score - position.score;
+    if (depth <= 1 || outOfBudget(nodes)) {
+        return gain;
+    }
+    return gain + search(child, hashBoard(child.cells), depth - 1, nodes);
+}
+
+// Decision node: chọn nước có điểm kỳ vọng cao nhất
+double JewelBot::search(const BoardEngine& position, uint64_t hash, int depth, uint64_t& nodes) {
+    uint64_t key = hash ^ s_zobrist.depth[depth];
+    double cached;
+    if (probe(key, depth, cached)) {
+        return cached;
+    }
+
+    Move moves[MAX_MOVES];
+    int moveCount = position.listMoves(moves);
+
+    double best = 0.0;
+    for (int i = 0; i < moveCount && !m_aborted.load(std::memory_order_relaxed); ++i) {
+        double total = 0.0;
+        for (int sample = 0; sample < m_config.samples; ++sample) {
+            total += expandMove(position, hash, moves[i], sample, depth, nodes);
+        }
+        best = std::max(best, total / m_config.samples);
+    }
+
+    if (!m_aborted.load(std::memory_order_relaxed)) {
+        store(key, depth, best);
+    }
+    return best;
+}
+
+BotResult JewelBot::chooseMove(const BoardEngine& position) {
+    auto start = std::chrono::steady_clock::now();
+    m_deadline = start + std::chrono::milliseconds(m_config.timeBudgetMs);
+    m_nodes = 0;
+    m_aborted = false;
+
+    BotResult result = {};
+    Move moves[MAX_MOVES];
+    int moveCount = position.listMoves(moves);
+    if (moveCount == 0) {
+        return result;
+    }
+
+    result.found = true;
+    result.move = moves[0];
+    uint64_t hash = hashBoard(position.cells);
+    std::vector<double> values(moveCount * m_config.samples);
+
+    for (int depth = 1; depth <= m_config.maxDepth; ++depth) {
+        std::atomic<uint64_t> leftoverNodes(0);
+
+        for (int i = 0; i < moveCount; ++i) {
+            for (int sample = 0; sample < m_config.samples; ++sample) {
+                m_pool.submit([&, i, sample, depth] {
+                    uint64_t nodes = 0;
+                    values[i * m_config.samples + sample] = expandMove(position, hash, moves[i], sample, depth, nodes);
+                    leftoverNodes.fetch_add(nodes % BUDGET_CHECK_INTERVAL, std::memory_order_relaxed);
+                });
+            }
+        }
+        m_pool.wait();
+        m_nodes += leftoverNodes.load();
+
+        // Độ sâu bị cắt giữa chừng thì giữ kết quả của độ sâu trước
+        if (m_aborted && depth > 1) {
+            break;
+        }
+
+        int bestIndex = 0;
+        double bestValue = -1.0;
+        for (int i = 0; i < moveCount; ++i) {
+            double total = 0.0;
+            for (int sample = 0; sample < m_config.samples; ++sample) {
+                total += values[i * m_config.samples + sample];
+            }
+            double mean = total / m_config.samples;
+            if (mean > bestValue) {
+                bestValue = mean;
+                bestIndex = i;
+            }
+        }
+
+        result.move = moves[bestIndex];
+        result.expectedScore = bestValue;
+        result.depthReached = depth;
+        if (m_aborted) break;
+    }
+
+    result.nodes = m_nodes.load();
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,73 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "board.h"
+#include "threadpool.h"
+
+struct BotConfig {
+    int maxDepth = 3;        // Số nước nhìn trước (iterative deepening từ 1)
+    int samples = 4;         // Số mẫu refill ngẫu nhiên ở mỗi chance node
+    int timeBudgetMs = 100;  // 0 = không giới hạn thời gian
+    uint64_t nodeBudget = 0; // 0 = không giới hạn số node
+    int threads = 0;         // 0 = số core
+    int tableBits = 20;      // Transposition table có 2^tableBits ô
+};
+
+struct BotResult {
+    Move move;
+    bool found;           // false nếu không còn nước hợp lệ
+    // Giá trị tìm kiếm: tổng điểm của depthReached nước tới (không phải điểm của riêng nước này),
+    // lạc quan vì lấy max trên ít mẫu refill. Chỉ để so các nước với nhau.
+    double expectedScore;
+    int depthReached;     // Độ sâu cuối cùng tìm xong trọn vẹn
+    uint64_t nodes;
+    double elapsedMs;
+
+    double nodesPerSecond() const { return elapsedMs > 0 ? nodes * 1000.0 / elapsedMs : 0.0; }
+};
+
+// Bot 1 nước: chọn nước cho điểm ngay cao nhất. Thử trên bản copy với RNG khác
+// để không "nhìn trộm" đá sắp rơi xuống. Dùng cho mô phỏng và sinh dữ liệu số lượng lớn.
+Move greedyMove(const BoardEngine& position, const Move* moves, int count);
+
+// Bot expectimax: max ở các nước đổi chỗ, lấy trung bình ở các lần refill
+// (lấy mẫu bằng JewelRng với seed suy ra từ Zobrist hash nên kết quả tái lập được).
+// Các cặp (nước đi, mẫu) ở gốc được chia cho ThreadPool.
+class JewelBot {
+public:
+    explicit JewelBot(const BotConfig& config = BotConfig());
+    ~JewelBot();
+
+    BotResult chooseMove(const BoardEngine& position);
+    const BotConfig& config() const { return m_config; }
+
+    static uint64_t hashBoard(const int8_t cells[BOARD_SIZE][BOARD_SIZE]);
+
+private:
+    struct TableEntry {
+        std::atomic<uint64_t> check; // key ^ data, bỏ qua ô bị ghi dở (lockless)
+        std::atomic<uint64_t> data;  // float value | depth << 32
+    };
+
+    double search(const BoardEngine& position, uint64_t hash, int depth, uint64_t& nodes);
+    double expandMove(const BoardEngine& position, uint64_t hash, const Move& move, int sample, int depth, uint64_t& nodes);
+    bool probe(uint64_t key, int depth, double& value) const;
+    void store(uint64_t key, int depth, double value);
+    bool outOfBudget(uint64_t localNodes);
+
+    BotConfig m_config;
+    ThreadPool m_pool;
+    std::unique_ptr<TableEntry[]> m_table;
+    uint64_t m_tableMask;
+
+    std::atomic<uint64_t> m_nodes;
+    std::atomic<bool> m_aborted;
+    std::chrono::steady_clock::time_point m_deadline;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef CONSTANTS_H
+#define CONSTANTS_H
+
+// Hằng số dùng chung, không phụ thuộc SDL
+const int SCREEN_WIDTH = 1000;
+const int SCREEN_HEIGHT = 600;
+const int BOARD_SIZE = 8;
+const int GRID_SIZE = 64;
+const int NUM_JEWEL_TYPES = 6;
+// Giá trị một ô: 0..5 đá thường, 6..11 đá sọc ngang cùng màu (ăn 4), 12 bom màu (ăn 5), -1 ô trống
+const int STRIPE_JEWEL_BASE = NUM_JEWEL_TYPES;
+const int COLOR_BOMB = 2 * NUM_JEWEL_TYPES;
+const int NUM_CELL_VALUES = COLOR_BOMB + 1;
+const float JEWEL_FALL_SPEED = 0.5f; // Fall speed of jewels
+const float MATCH_ANIMATION_SPEED = 50.0f; // Speed of match animation
+
+#endif
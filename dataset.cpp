@@ -0,0 +1,455 @@
+#include "dataset.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "saveload.h"
+
+namespace {
+    const size_t FILE_HEADER_SIZE = 16;
+    const size_t TRAILER_SIZE = 16;
+    const size_t CHUNK_HEADER_SIZE = 8 + DATASET_COLUMN_COUNT * 12;
+    const size_t COLUMN_ALIGNMENT = 8;
+
+    enum ColumnEncoding : uint8_t {
+        ENCODING_BYTE = 1,
+        ENCODING_VARINT_DELTA = 2,
+        ENCODING_XOR_MASK = 3,
+        ENCODING_VARINT = 4
+    };
+
+    const uint8_t COLUMN_ENCODINGS[DATASET_COLUMN_COUNT] = {
+        ENCODING_VARINT_DELTA, ENCODING_XOR_MASK, ENCODING_BYTE, ENCODING_VARINT,
+        ENCODING_BYTE, ENCODING_VARINT_DELTA, ENCODING_VARINT, ENCODING_BYTE
+    };
+
+    void putU32(unsigned char* out, uint32_t value) {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+        out[2] = (value >> 16) & 0xFF;
+        out[3] = (value >> 24) & 0xFF;
+    }
+
+    uint32_t getU32(const unsigned char* in) {
+        return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    }
+
+    void putU64(unsigned char* out, uint64_t value) {
+        putU32(out, (uint32_t)value);
+        putU32(out + 4, (uint32_t)(value >> 32));
+    }
+
+    uint64_t getU64(const unsigned char* in) {
+        return getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+    }
+
+    uint64_t zigzag(int64_t value) {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value) {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    bool getVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && in < end; shift += 7) {
+            uint8_t byte = *in++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Giá trị số nguyên của cột (trừ STATE) để dùng chung code mã hóa
+    int64_t columnValue(const Transition& row, int column) {
+        switch (column) {
+        case COLUMN_EPISODE: return (int64_t)row.episode;
+        case COLUMN_ACTION: return row.action;
+        case COLUMN_REWARD: return row.reward;
+        case COLUMN_CASCADE: return row.cascadeDepth;
+        case COLUMN_SCORE: return row.score;
+        case COLUMN_MATCH_SIZE: return row.matchSize;
+        case COLUMN_COMBO: return row.combo;
+        default: return 0;
+        }
+    }
+
+    void setColumnValue(Transition& row, int column, int64_t value) {
+        switch (column) {
+        case COLUMN_EPISODE: row.episode = (uint64_t)value; break;
+        case COLUMN_ACTION: row.action = (uint8_t)value; break;
+        case COLUMN_REWARD: row.reward = (int32_t)value; break;
+        case COLUMN_CASCADE: row.cascadeDepth = (uint8_t)value; break;
+        case COLUMN_SCORE: row.score = (int32_t)value; break;
+        case COLUMN_MATCH_SIZE: row.matchSize = (int32_t)value; break;
+        case COLUMN_COMBO: row.combo = (uint8_t)value; break;
+        }
+    }
+
+    void encodeColumn(const std::vector<Transition>& rows, int column, std::vector<uint8_t>& out) {
+        out.clear();
+        uint8_t previousState[SNAPSHOT_CELL_BYTES] = {};
+        int64_t previous = 0;
+
+        for (const Transition& row : rows) {
+            switch (COLUMN_ENCODINGS[column]) {
+            case ENCODING_BYTE:
+                out.push_back((uint8_t)columnValue(row, column));
+                break;
+            case ENCODING_VARINT:
+                putVarint(out, zigzag(columnValue(row, column)));
+                break;
+            case ENCODING_VARINT_DELTA: {
+                int64_t value = columnValue(row, column);
+                putVarint(out, zigzag(value - previous));
+                previous = value;
+                break;
+            }
+            case ENCODING_XOR_MASK: {
+                // Giữa hai nước đi chỉ vài ô đổi nên phần lớn byte XOR bằng 0
+                uint32_t mask = 0;
+                for (int i = 0; i < SNAPSHOT_CELL_BYTES; ++i) {
+                    if (row.state[i] != previousState[i]) mask |= 1u << i;
+                }
+                size_t at = out.size();
+                out.resize(at + 4);
+                putU32(&out[at], mask);
+                for (int i = 0; i < SNAPSHOT_CELL_BYTES; ++i) {
+                    if (mask & (1u << i)) out.push_back(row.state[i] ^ previousState[i]);
+                }
+                memcpy(previousState, row.state, SNAPSHOT_CELL_BYTES);
+                break;
+            }
+            }
+        }
+    }
+
+    bool decodeColumn(const uint8_t* in, size_t size, uint8_t encoding, int column, std::vector<Transition>& rows) {
+        const uint8_t* end = in + size;
+        uint8_t previousState[SNAPSHOT_CELL_BYTES] = {};
+        int64_t previous = 0;
+
+        for (Transition& row : rows) {
+            uint64_t raw;
+            switch (encoding) {
+            case ENCODING_BYTE:
+                if (in >= end) return false;
+                setColumnValue(row, column, *in++);
+                break;
+            case ENCODING_VARINT:
+                if (!getVarint(in, end, raw)) return false;
+                setColumnValue(row, column, unzigzag(raw));
+                break;
+            case ENCODING_VARINT_DELTA:
+                if (!getVarint(in, end, raw)) return false;
+                previous += unzigzag(raw);
+                setColumnValue(row, column, previous);
+                break;
+            case ENCODING_XOR_MASK: {
+                if (end - in < 4) return false;
+                uint32_t mask = getU32(in);
+                in += 4;
+                for (int i = 0; i < SNAPSHOT_CELL_BYTES; ++i) {
+                    if (mask & (1u << i)) {
+                        if (in >= end) return false;
+                        previousState[i] ^= *in++;
+                    }
+                }
+                memcpy(row.state, previousState, SNAPSHOT_CELL_BYTES);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return in == end;
+    }
+}
+
+void TransitionRecorder::begin(const BoardEngine& engine, uint64_t episode, const Move& move) {
+    m_current = Transition();
+    m_current.episode = episode;
+    packCells(engine.cells, m_current.state);
+    m_current.action = (uint8_t)moveToAction(move);
+    m_scoreBefore = engine.score;
+}
+
+const Transition& TransitionRecorder::finish(const BoardEngine& engine) {
+    m_current.reward = engine.score - m_scoreBefore;
+    m_current.score = engine.score;
+    m_current.cascadeDepth = (uint8_t)engine.lastCascadeDepth;
+    return m_current;
+}
+
+void TransitionRecorder::onScore(const ScoreEvent& event) {
+    m_current.matchSize += event.matchSize;
+    if (event.combo > m_current.combo) {
+        m_current.combo = (uint8_t)event.combo;
+    }
+}
+
+DatasetWriter::DatasetWriter()
+    : m_file(nullptr), m_rowsPerChunk(0), m_active(0), m_hasPending(false), m_stopping(false),
+      m_failed(false), m_rowsWritten(0), m_fileOffset(0), m_stallMs(0.0) {}
+
+DatasetWriter::~DatasetWriter() {
+    close();
+}
+
+bool DatasetWriter::open(const std::string& filePath, uint32_t rowsPerChunk) {
+    if (m_file) return false;
+    if (rowsPerChunk == 0) {
+        std::cerr << "Dataset chunk size must be at least 1 row: " << filePath << std::endl;
+        return false;
+    }
+
+    m_file = fopen(filePath.c_str(), "wb");
+    if (!m_file) {
+        std::cerr << "Failed to create dataset file: " << filePath << std::endl;
+        return false;
+    }
+
+    m_rowsPerChunk = rowsPerChunk;
+    m_buffers[0].clear();
+    m_buffers[1].clear();
+    m_buffers[0].reserve(rowsPerChunk);
+    m_buffers[1].reserve(rowsPerChunk);
+    m_active = 0;
+    m_chunkOffsets.clear();
+    m_failed = false;
+    m_rowsWritten = 0;
+    m_fileOffset = 0;
+    m_stallMs = 0.0;
+
+    unsigned char header[FILE_HEADER_SIZE] = {};
+    putU32(header + 0, DATASET_MAGIC);
+    header[4] = DATASET_VERSION & 0xFF;
+    header[5] = DATASET_VERSION >> 8;
+    header[6] = DATASET_COLUMN_COUNT;
+    putU32(header + 8, rowsPerChunk);
+    writeBytes(header, sizeof(header));
+
+    m_hasPending = false;
+    m_stopping = false;
+    m_thread = std::thread(&DatasetWriter::threadLoop, this);
+    return true;
+}
+
+void DatasetWriter::append(const Transition& transition) {
+    std::vector<Transition>& buffer = m_buffers[m_active];
+    buffer.push_back(transition);
+    if (buffer.size() >= m_rowsPerChunk) {
+        handOff();
+    }
+}
+
+void DatasetWriter::handOff() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_hasPending) {
+        // Writer chưa xong buffer trước: chỉ xảy ra khi đĩa chậm hơn generator
+        auto start = std::chrono::steady_clock::now();
+        m_condition.wait(lock, [this] { return !m_hasPending; });
+        m_stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    m_hasPending = true;
+    m_active ^= 1;
+    m_buffers[m_active].clear();
+    lock.unlock();
+    m_condition.notify_all();
+}
+
+void DatasetWriter::threadLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [this] { return m_hasPending || m_stopping; });
+
+        if (m_hasPending) {
+            // Buffer chờ ghi là buffer không active; generator không đụng tới nó cho tới khi m_hasPending = false
+            const std::vector<Transition>& rows = m_buffers[m_active ^ 1];
+            lock.unlock();
+            writeChunk(rows);
+            lock.lock();
+            m_hasPending = false;
+            m_condition.notify_all();
+        } else if (m_stopping) {
+            break;
+        }
+    }
+}
+
+bool DatasetWriter::writeChunk(const std::vector<Transition>& rows) {
+    if (rows.empty()) return true;
+
+    unsigned char header[CHUNK_HEADER_SIZE] = {};
+    putU32(header + 0, DATASET_CHUNK_MAGIC);
+    putU32(header + 4, (uint32_t)rows.size());
+
+    for (int column = 0; column < DATASET_COLUMN_COUNT; ++column) {
+        encodeColumn(rows, column, m_columns[column]);
+        unsigned char* entry = header + 8 + column * 12;
+        entry[0] = COLUMN_ENCODINGS[column];
+        putU32(entry + 4, (uint32_t)m_columns[column].size());
+        putU32(entry + 8, crc32(m_columns[column].data(), m_columns[column].size()));
+    }
+
+    m_chunkOffsets.push_back(m_fileOffset);
+    bool ok = writeBytes(header, sizeof(header));
+
+    static const uint8_t padding[COLUMN_ALIGNMENT] = {};
+    for (int column = 0; column < DATASET_COLUMN_COUNT && ok; ++column) {
+        size_t size = m_columns[column].size();
+        ok = writeBytes(m_columns[column].data(), size) &&
+             writeBytes(padding, (COLUMN_ALIGNMENT - size % COLUMN_ALIGNMENT) % COLUMN_ALIGNMENT);
+    }
+
+    if (ok) {
+        m_rowsWritten += rows.size();
+    }
+    return ok;
+}
+
+bool DatasetWriter::writeBytes(const void* data, size_t size) {
+    if (m_failed) return false;
+    if (size > 0 && fwrite(data, 1, size, m_file) != size) {
+        std::cerr << "Failed to write dataset chunk" << std::endl;
+        m_failed = true;
+        return false;
+    }
+    m_fileOffset += size;
+    return true;
+}
+
+bool DatasetWriter::close() {
+    if (!m_file) return true;
+
+    if (!m_buffers[m_active].empty()) {
+        handOff();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+
+    // Chỉ mục chunk và trailer ở cuối file, reader đọc từ cuối lên
+    uint64_t indexOffset = m_fileOffset;
+    for (uint64_t offset : m_chunkOffsets) {
+        unsigned char entry[8];
+        putU64(entry, offset);
+        writeBytes(entry, sizeof(entry));
+    }
+
+    unsigned char trailer[TRAILER_SIZE];
+    putU64(trailer + 0, indexOffset);
+    putU32(trailer + 8, (uint32_t)m_chunkOffsets.size());
+    putU32(trailer + 12, DATASET_END_MAGIC);
+    writeBytes(trailer, sizeof(trailer));
+
+    bool ok = !m_failed && fflush(m_file) == 0;
+    fclose(m_file);
+    m_file = nullptr;
+    return ok;
+}
+
+bool DatasetReader::open(const std::string& filePath) {
+    close();
+    if (!m_file.open(filePath)) {
+        return false;
+    }
+
+    const unsigned char* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < FILE_HEADER_SIZE + TRAILER_SIZE ||
+        getU32(data) != DATASET_MAGIC ||
+        (data[4] | (data[5] << 8)) != DATASET_VERSION ||
+        data[6] != DATASET_COLUMN_COUNT ||
+        getU32(data + size - 4) != DATASET_END_MAGIC) {
+        std::cerr << "Invalid dataset file: " << filePath << std::endl;
+        close();
+        return false;
+    }
+
+    uint64_t indexOffset = getU64(data + size - TRAILER_SIZE);
+    uint32_t count = getU32(data + size - 8);
+    uint32_t rowsPerChunk = getU32(data + 8);
+    if (rowsPerChunk == 0 || indexOffset < FILE_HEADER_SIZE || indexOffset + (uint64_t)count * 8 != size - TRAILER_SIZE) {
+        std::cerr << "Corrupted dataset index: " << filePath << std::endl;
+        close();
+        return false;
+    }
+
+    // rowCount không có CRC: giới hạn bởi rowsPerChunk để file hỏng không làm readChunk cấp phát vô hạn
+    m_chunkOffsets.resize(count);
+    uint64_t chunkEnd = FILE_HEADER_SIZE;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t offset = getU64(data + indexOffset + i * 8);
+        if (offset < chunkEnd || offset + CHUNK_HEADER_SIZE > indexOffset ||
+            getU32(data + offset) != DATASET_CHUNK_MAGIC ||
+            getU32(data + offset + 4) == 0 || getU32(data + offset + 4) > rowsPerChunk) {
+            std::cerr << "Corrupted dataset chunk " << i << ": " << filePath << std::endl;
+            close();
+            return false;
+        }
+        m_chunkOffsets[i] = offset;
+        m_totalRows += getU32(data + offset + 4);
+        chunkEnd = offset + CHUNK_HEADER_SIZE; // Offset phải tăng ngặt, các chunk không chồng lên nhau
+    }
+    return true;
+}
+
+void DatasetReader::close() {
+    m_file.close();
+    m_chunkOffsets.clear();
+    m_totalRows = 0;
+}
+
+uint32_t DatasetReader::chunkRows(size_t chunk) const {
+    return getU32(m_file.data() + m_chunkOffsets[chunk] + 4);
+}
+
+bool DatasetReader::readChunk(size_t chunk, std::vector<Transition>& rows) const {
+    if (chunk >= m_chunkOffsets.size()) return false;
+
+    const unsigned char* header = m_file.data() + m_chunkOffsets[chunk];
+    uint64_t end = chunk + 1 < m_chunkOffsets.size() ? m_chunkOffsets[chunk + 1] : m_file.size() - TRAILER_SIZE - m_chunkOffsets.size() * 8;
+    uint64_t offset = m_chunkOffsets[chunk] + CHUNK_HEADER_SIZE;
+
+    // Cột 1 byte mỗi hàng cho biết số hàng thật; kiểm trước khi cấp phát. Các cột còn lại
+    // được decodeColumn kiểm: giải đủ số hàng phải dùng đúng hết dữ liệu cột.
+    uint32_t rowCount = chunkRows(chunk);
+    for (int column = 0; column < DATASET_COLUMN_COUNT; ++column) {
+        const unsigned char* entry = header + 8 + column * 12;
+        if (entry[0] != COLUMN_ENCODINGS[column] || (entry[0] == ENCODING_BYTE && getU32(entry + 4) != rowCount)) {
+            std::cerr << "Corrupted dataset chunk header " << chunk << std::endl;
+            return false;
+        }
+    }
+
+    rows.assign(rowCount, Transition());
+    for (int column = 0; column < DATASET_COLUMN_COUNT; ++column) {
+        const unsigned char* entry = header + 8 + column * 12;
+        uint32_t size = getU32(entry + 4);
+        if (offset + size > end) return false;
+
+        const uint8_t* columnData = m_file.data() + offset;
+        if (crc32(columnData, size) != getU32(entry + 8) ||
+            !decodeColumn(columnData, size, entry[0], column, rows)) {
+            std::cerr << "Corrupted dataset column " << column << " in chunk " << chunk << std::endl;
+            return false;
+        }
+        offset += size + (COLUMN_ALIGNMENT - size % COLUMN_ALIGNMENT) % COLUMN_ALIGNMENT;
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "mappedfile.h"
+
+// File dataset self-play "JLDS": chia chunk, mỗi chunk lưu theo cột, mỗi cột nén riêng.
+//   [FileHeader 16 byte] [chunk]... [chỉ mục offset các chunk, u64] [Trailer 16 byte]
+// Chunk: [ChunkHeader: magic, rowCount, rồi mỗi cột {encoding, size, crc32}] [dữ liệu cột, căn 8 byte]...
+// Mọi số nguyên là little-endian. Reader mmap cả file và chỉ giải nén chunk/cột cần dùng.
+const uint32_t DATASET_MAGIC = 0x53444C4A;  // "JLDS"
+const uint32_t DATASET_CHUNK_MAGIC = 0x4B434C4A; // "JLCK"
+const uint32_t DATASET_END_MAGIC = 0x45444C4A;   // "JLDE"
+const uint16_t DATASET_VERSION = 1;
+
+enum DatasetColumn {
+    COLUMN_EPISODE,      // varint delta
+    COLUMN_STATE,        // XOR với hàng trước + bitmap các byte khác 0
+    COLUMN_ACTION,       // 1 byte, moveToAction
+    COLUMN_REWARD,       // varint zigzag
+    COLUMN_CASCADE,      // 1 byte
+    COLUMN_SCORE,        // varint zigzag delta
+    COLUMN_MATCH_SIZE,   // varint zigzag
+    COLUMN_COMBO,        // 1 byte
+    DATASET_COLUMN_COUNT
+};
+
+// Một bước chơi: trạng thái trước nước đi, nước đi và kết quả
+struct Transition {
+    uint64_t episode;
+    uint8_t state[SNAPSHOT_CELL_BYTES]; // packCells của bàn trước khi đổi chỗ
+    uint8_t action;                     // moveToAction
+    uint8_t cascadeDepth;
+    uint8_t combo;                      // Hệ số combo lớn nhất trong các ScoreEvent
+    int32_t reward;                     // Tổng điểm của nước đi
+    int32_t score;                      // Điểm sau nước đi
+    int32_t matchSize;                  // Tổng số viên được ăn qua mọi lượt
+};
+
+// Gom các ScoreEvent của một nước đi. Gắn làm listener của BoardEngine khi sinh dữ liệu.
+class TransitionRecorder : public BoardListener {
+public:
+    // Gọi trước trySwap, ghi trạng thái hiện tại vào transition
+    void begin(const BoardEngine& engine, uint64_t episode, const Move& move);
+    // Gọi sau trySwap thành công
+    const Transition& finish(const BoardEngine& engine);
+
+    void onScore(const ScoreEvent& event) override;
+
+private:
+    Transition m_current;
+    int m_scoreBefore;
+};
+
+// Ghi dataset trên thread nền với hai buffer: thread sinh dữ liệu chỉ copy vào buffer đang mở,
+// thread nền nén và ghi buffer còn lại. Một writer dành cho một thread sinh dữ liệu;
+// nhiều generator thì mỗi cái một file.
+class DatasetWriter {
+public:
+    DatasetWriter();
+    ~DatasetWriter();
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    bool open(const std::string& filePath, uint32_t rowsPerChunk = 65536);
+    void append(const Transition& transition);
+    bool close(); // Ghi nốt buffer, chỉ mục và trailer. false nếu có lỗi I/O
+
+    uint64_t rowsWritten() const { return m_rowsWritten.load(); }
+    uint64_t bytesWritten() const { return m_fileOffset.load(); }
+    double stallMs() const { return m_stallMs; } // Thời gian thread sinh dữ liệu phải chờ writer
+
+private:
+    void handOff(); // Chuyển buffer đang mở cho thread nền
+    void threadLoop();
+    bool writeChunk(const std::vector<Transition>& rows);
+    bool writeBytes(const void* data, size_t size);
+
+    FILE* m_file;
+    uint32_t m_rowsPerChunk;
+    std::vector<Transition> m_buffers[2];
+    int m_active;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_hasPending;
+    bool m_stopping;
+
+    // Chỉ thread nền dùng
+    std::vector<uint8_t> m_columns[DATASET_COLUMN_COUNT];
+    std::vector<uint64_t> m_chunkOffsets;
+    bool m_failed;
+
+    std::atomic<uint64_t> m_rowsWritten;
+    std::atomic<uint64_t> m_fileOffset;
+    double m_stallMs;
+};
+
+// Đọc dataset qua mmap
+class DatasetReader {
+public:
+    bool open(const std::string& filePath);
+    void close();
+
+    size_t chunkCount() const { return m_chunkOffsets.size(); }
+    uint32_t chunkRows(size_t chunk) const;
+    uint64_t totalRows() const { return m_totalRows; }
+
+    // Giải nén một chunk, false nếu CRC sai hoặc dữ liệu hỏng
+    bool readChunk(size_t chunk, std::vector<Transition>& rows) const;
+
+private:
+    MappedFile m_file;
+    std::vector<uint64_t> m_chunkOffsets;
+    uint64_t m_totalRows = 0;
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "endlessboard.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+EndlessBoard::EndlessBoard() : score(0), lastCascadeDepth(0), listener(nullptr), m_base(0), m_bottomCleared(0) {
+    memset(m_rows, -1, sizeof(m_rows));
+}
+
+// Sinh từ dưới lên, trái sang phải: tránh sẵn 3 viên liền với hai ô bên trái hoặc hai ô bên dưới
+int8_t EndlessBoard::randomJewel(uint64_t row, int x) {
+    const int8_t* current = rowAt(row);
+    const int8_t* below1 = row >= m_base + 1 ? rowAt(row - 1) : nullptr;
+    const int8_t* below2 = row >= m_base + 2 ? rowAt(row - 2) : nullptr;
+
+    int possibleJewels[NUM_JEWEL_TYPES];
+    int count = 0;
+    for (int jewel = 0; jewel < NUM_JEWEL_TYPES; ++jewel) {
+        bool left = x >= 2 && jewelColor(current[x - 1]) == jewel && jewelColor(current[x - 2]) == jewel;
+        bool down = below2 && jewelColor(below1[x]) == jewel && jewelColor(below2[x]) == jewel;
+        if (!left && !down) {
+            possibleJewels[count++] = jewel;
+        }
+    }
+    return (int8_t)(count == 0 ? rng.below(NUM_JEWEL_TYPES) : possibleJewels[rng.below(count)]);
+}
+
+void EndlessBoard::initBoard() {
+    m_base = 0;
+    m_bottomCleared = 0;
+    score = 0;
+    lastCascadeDepth = 0;
+    memset(m_rows, -1, sizeof(m_rows));
+    for (uint64_t row = 0; row < ENDLESS_RING_ROWS; ++row) {
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            rowAt(row)[x] = randomJewel(row, x);
+        }
+    }
+}
+
+void EndlessBoard::copyWindow(int8_t cells[BOARD_SIZE][BOARD_SIZE]) const {
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        memcpy(cells[y], m_rows[ringRow(windowRow(y))], BOARD_SIZE);
+    }
+}
+
+void EndlessBoard::copyPreviewRow(int8_t row[BOARD_SIZE]) const {
+    memcpy(row, m_rows[ringRow(m_base + BOARD_SIZE)], BOARD_SIZE);
+}
+
+bool EndlessBoard::trySwap(int x1, int y1, int x2, int y2) {
+    lastCascadeDepth = 0;
+    if (x1 < 0 || x1 >= BOARD_SIZE || y1 < 0 || y1 >= BOARD_SIZE || x2 < 0 || x2 >= BOARD_SIZE || y2 < 0 ||
+        y2 >= BOARD_SIZE || abs(x1 - x2) + abs(y1 - y2) != 1) {
+        return false;
+    }
+
+    int8_t& first = rowAt(windowRow(y1))[x1];
+    int8_t& second = rowAt(windowRow(y2))[x2];
+    std::swap(first, second);
+
+    int8_t window[BOARD_SIZE][BOARD_SIZE];
+    copyWindow(window);
+    if (!hasMatchAroundCells(window, x1, y1) && !hasMatchAroundCells(window, x2, y2)) {
+        std::swap(first, second);
+        return false;
+    }
+
+    resolveCascade();
+    return true;
+}
+
+int EndlessBoard::listMoves(Move moves[MAX_MOVES]) const {
+    int8_t window[BOARD_SIZE][BOARD_SIZE];
+    copyWindow(window);
+    return listMovesOn(window, moves);
+}
+
+void EndlessBoard::shuffle() {
+    int8_t jewels[BOARD_SIZE * BOARD_SIZE];
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        memcpy(jewels + y * BOARD_SIZE, rowAt(windowRow(y)), BOARD_SIZE);
+    }
+    for (int i = BOARD_SIZE * BOARD_SIZE - 1; i > 0; --i) {
+        std::swap(jewels[i], jewels[rng.below(i + 1)]);
+    }
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        memcpy(rowAt(windowRow(y)), jewels + y * BOARD_SIZE, BOARD_SIZE);
+    }
+}
+
+// Như BoardEngine::checkMatchesAndMarkMatched, nhưng chỉ trên 8 hàng của cửa sổ
+bool EndlessBoard::markMatches(bool matched[BOARD_SIZE][BOARD_SIZE]) const {
+    const int8_t* rows[BOARD_SIZE];
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        rows[y] = m_rows[ringRow(windowRow(y))];
+    }
+    memset(matched, 0, sizeof(bool) * BOARD_SIZE * BOARD_SIZE);
+    bool hasMatches = false;
+
+    for (int y = 0; y < BOARD_SIZE; ++y) {
+        int start = 0;
+        while (start < BOARD_SIZE) {
+            int color = jewelColor(rows[y][start]);
+            int end = start;
+            while (color != -1 && end + 1 < BOARD_SIZE && jewelColor(rows[y][end + 1]) == color) end++;
+            if (color != -1 && end - start >= 2) {
+                for (int x = start; x <= end; ++x) matched[y][x] = true;
+                hasMatches = true;
+            }
+            start = end + 1;
+        }
+    }
+
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        int start = 0;
+        while (start < BOARD_SIZE) {
+            int color = jewelColor(rows[start][x]);
+            int end = start;
+            while (color != -1 && end + 1 < BOARD_SIZE && jewelColor(rows[end + 1][x]) == color) end++;
+            if (color != -1 && end - start >= 2) {
+                for (int y = start; y <= end; ++y) matched[y][x] = true;
+                hasMatches = true;
+            }
+            start = end + 1;
+        }
+    }
+    return hasMatches;
+}
+
+// Dồn từng cột xuống trong cửa sổ + hàng chờ, ô trống dồn lên đỉnh vòng thì sinh đá mới
+void EndlessBoard::dropColumns(int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]) {
+    memset(dropDistance, 0, BOARD_SIZE * BOARD_SIZE);
+    uint64_t top = m_base + ENDLESS_RING_ROWS;
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        uint64_t to = m_base;
+        for (uint64_t from = m_base; from < top; ++from) {
+            int8_t value = rowAt(from)[x];
+            if (value == -1) continue;
+            if (from != to) {
+                rowAt(to)[x] = value;
+                rowAt(from)[x] = -1;
+                if (to < m_base + BOARD_SIZE) {
+                    dropDistance[BOARD_SIZE - 1 - (to - m_base)][x] = (int8_t)std::min<uint64_t>(from - to, INT8_MAX);
+                }
+            }
+            ++to;
+        }
+        for (; to < top; ++to) {
+            rowAt(to)[x] = randomJewel(to, x);
+            if (to < m_base + BOARD_SIZE) {
+                dropDistance[BOARD_SIZE - 1 - (to - m_base)][x] = 1;
+            }
+        }
+    }
+}
+
+// Hàng dưới cùng trôi đi: chỗ của nó trong vòng thành hàng chờ mới trên cùng
+void EndlessBoard::scrollRow() {
+    ++m_base;
+    uint64_t newTop = m_base + ENDLESS_RING_ROWS - 1;
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        rowAt(newTop)[x] = randomJewel(newTop, x);
+    }
+    m_bottomCleared = 0;
+    score += ENDLESS_ROW_POINTS;
+
+    if (listener) {
+        ScoreEvent event = {ENDLESS_ROW_POINTS, 1, 0, 0};
+        listener->onScore(event);
+        // Cả cửa sổ tụt xuống một hàng
+        int8_t dropDistance[BOARD_SIZE][BOARD_SIZE];
+        memset(dropDistance, 1, sizeof(dropDistance));
+        listener->onJewelsDropped(dropDistance);
+    }
+}
+
+void EndlessBoard::resolveCascade() {
+    bool matched[BOARD_SIZE][BOARD_SIZE];
+    int8_t dropDistance[BOARD_SIZE][BOARD_SIZE];
+    while (markMatches(matched)) {
+        int count = 0;
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            for (int x = 0; x < BOARD_SIZE; ++x) {
+                if (!matched[y][x]) continue;
+                ++count;
+                rowAt(windowRow(y))[x] = -1;
+                if (y == BOARD_SIZE - 1) m_bottomCleared |= (uint8_t)(1 << x);
+            }
+        }
+
+        int points = matchPoints(count);
+        score += points;
+        if (listener) {
+            ScoreEvent event = {points, 1, count, 0};
+            listener->onScore(event);
+            listener->onMatchesRemoved(matched);
+        }
+
+        dropColumns(dropDistance);
+        if (listener) {
+            listener->onJewelsDropped(dropDistance);
+        }
+        lastCascadeDepth++;
+        if (listener) {
+            listener->onCascadeStep();
+        }
+
+        if (m_bottomCleared == ENDLESS_ROW_DONE) {
+            scrollRow(); // Hàng mới lộ ra ở trên có thể tạo hàng ăn, vòng lặp xử lý tiếp
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef ENDLESSBOARD_H
+#define ENDLESSBOARD_H
+
+#include <cstdint>
+
+#include "board.h"
+
+// Endless Mode: cột đá cao vô hạn, người chơi chỉ thấy cửa sổ 8 hàng dưới cùng.
+// Hàng dưới cùng được tính là xong khi cả 8 cột của nó đều từng bị ăn; lúc đó hàng trôi đi,
+// cả cửa sổ tụt xuống một hàng và hàng chờ thấp nhất lộ ra ở trên.
+//
+// Các hàng nằm trong vòng tròn ENDLESS_RING_ROWS hàng (cửa sổ + hàng chờ), đánh số tuyệt đối từ dưới lên.
+// Hàng trôi đi nhường chỗ trong vòng cho hàng mới sinh trên cùng, nên bộ nhớ và thời gian mỗi nước đi
+// không phụ thuộc ván đã dài bao lâu. Quét hàng ăn chỉ trên cửa sổ, rơi chỉ trên cửa sổ + hàng chờ.
+// Toạ độ (x, y) ở API giống BoardEngine: y = 0 là hàng trên cùng của cửa sổ.
+const int ENDLESS_MARGIN_ROWS = 8;  // Hàng chờ phía trên cửa sổ, đủ lấp một cột bị ăn hết
+const int ENDLESS_RING_ROWS = BOARD_SIZE + ENDLESS_MARGIN_ROWS;
+const int ENDLESS_ROW_POINTS = 100; // Thưởng mỗi hàng trôi đi
+const uint8_t ENDLESS_ROW_DONE = (1 << BOARD_SIZE) - 1;
+
+static_assert((ENDLESS_RING_ROWS & (ENDLESS_RING_ROWS - 1)) == 0, "ring index uses a mask");
+
+class EndlessBoard {
+public:
+    JewelRng rng;
+    int score;
+    int lastCascadeDepth;
+    BoardListener* listener; // Cùng sự kiện với BoardEngine, toạ độ trong cửa sổ
+
+    EndlessBoard();
+
+    void initBoard();
+    bool trySwap(int x1, int y1, int x2, int y2); // false và hoàn tác nếu không tạo được hàng
+    int listMoves(Move moves[MAX_MOVES]) const;
+    void shuffle(); // Chỉ xáo cửa sổ
+
+    int8_t at(int x, int y) const { return m_rows[ringRow(windowRow(y))][x]; }
+    void copyWindow(int8_t cells[BOARD_SIZE][BOARD_SIZE]) const;
+    void copyPreviewRow(int8_t row[BOARD_SIZE]) const; // Hàng chờ sẽ lộ ra tiếp theo
+
+    uint64_t rowsScrolled() const { return m_base; }
+    uint8_t bottomCleared() const { return m_bottomCleared; } // Bit x: cột x của hàng dưới cùng đã bị ăn
+
+private:
+    static int ringRow(uint64_t row) { return (int)(row & (ENDLESS_RING_ROWS - 1)); }
+    uint64_t windowRow(int y) const { return m_base + (BOARD_SIZE - 1 - y); }
+    int8_t* rowAt(uint64_t row) { return m_rows[ringRow(row)]; }
+
+    int8_t randomJewel(uint64_t row, int x);
+    bool markMatches(bool matched[BOARD_SIZE][BOARD_SIZE]) const;
+    void dropColumns(int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]);
+    void scrollRow();
+    void resolveCascade();
+
+    int8_t m_rows[ENDLESS_RING_ROWS][BOARD_SIZE];
+    uint64_t m_base;          // Số hiệu tuyệt đối của hàng dưới cùng cửa sổ = số hàng đã trôi đi
+    uint8_t m_bottomCleared;
+};
+
+#endif
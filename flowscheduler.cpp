@@ -0,0 +1,255 @@
+#include "flowscheduler.h"
+
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+namespace {
+
+// Frame của các luồng game đều nhỏ (vài biến cục bộ và awaiter); khối lớn hơn thì xin heap và đếm lại
+const size_t FLOW_FRAME_BLOCK = 512;
+const size_t FLOW_FRAMES_PER_CHUNK = 16;
+
+struct FreeFrame {
+    FreeFrame* next;
+};
+
+// Pool dùng chung cho mọi FlowScheduler; coroutine chỉ được tạo trên sim thread
+struct FramePool {
+    std::vector<void*> chunks;
+    FreeFrame* freeList = nullptr;
+    size_t inUse = 0;
+    uint64_t fallbacks = 0;
+
+    ~FramePool() {
+        for (void* chunk : chunks) {
+            ::operator delete(chunk);
+        }
+    }
+
+    void* allocate(size_t size) {
+        if (size > FLOW_FRAME_BLOCK) {
+            ++fallbacks;
+            return ::operator new(size);
+        }
+        if (!freeList) {
+            char* chunk = static_cast<char*>(::operator new(FLOW_FRAME_BLOCK * FLOW_FRAMES_PER_CHUNK));
+            chunks.push_back(chunk);
+            for (size_t i = 0; i < FLOW_FRAMES_PER_CHUNK; ++i) {
+                FreeFrame* frame = reinterpret_cast<FreeFrame*>(chunk + i * FLOW_FRAME_BLOCK);
+                frame->next = freeList;
+                freeList = frame;
+            }
+        }
+        FreeFrame* frame = freeList;
+        freeList = frame->next;
+        ++inUse;
+        return frame;
+    }
+
+    void release(void* block, size_t size) {
+        if (size > FLOW_FRAME_BLOCK) {
+            ::operator delete(block);
+            return;
+        }
+        FreeFrame* frame = static_cast<FreeFrame*>(block);
+        frame->next = freeList;
+        freeList = frame;
+        --inUse;
+    }
+};
+
+FramePool& framePool() {
+    static FramePool pool;
+    return pool;
+}
+
+double elapsedMs(FlowScheduler::Clock::time_point from, FlowScheduler::Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+void* FlowTask::promise_type::operator new(size_t size) {
+    return framePool().allocate(size);
+}
+
+void FlowTask::promise_type::operator delete(void* frame, size_t size) {
+    framePool().release(frame, size);
+}
+
+void FlowTask::promise_type::unhandled_exception() {
+    // Luồng game không được ném; để lọt ra thì trạng thái game đã hỏng, dừng luôn cho dễ thấy
+    std::cerr << "Unhandled exception in game flow" << std::endl;
+    std::terminate();
+}
+
+// Resume trễ từ 10 us tới khoảng 40 ms; sim tick 4 ms nên phần lớn rơi vào vài ms đầu
+FlowScheduler::FlowScheduler()
+    : m_timerOrder(0), m_waiting(0), m_live(0), m_spawned(0), m_completed(0), m_cancelled(0), m_resumes(0),
+      m_timerLatency(0.01) {
+    m_timers.reserve(16);
+    for (int i = 0; i < (int)FlowEvent::Count; ++i) {
+        m_waiters[i] = nullptr;
+    }
+    for (int i = 0; i < (int)FlowGroup::Count; ++i) {
+        m_cancelEpoch[i] = 0;
+    }
+}
+
+FlowScheduler::~FlowScheduler() {
+    cancelAll();
+}
+
+void FlowScheduler::spawn(FlowGroup group, FlowTask task) {
+    FlowTask::Handle handle = task.release();
+    if (!handle) return;
+    handle.promise().scheduler = this;
+    handle.promise().group = group;
+    ++m_live;
+    ++m_spawned;
+    resume(handle);
+}
+
+void FlowScheduler::resume(FlowTask::Handle handle) {
+    FlowTask::Handle outer = m_running; // signal() có thể được gọi từ trong một task khác
+    m_running = handle;
+    ++m_resumes;
+    handle.resume();
+    m_running = outer;
+    if (handle.done()) {
+        --m_live;
+        ++m_completed;
+        handle.destroy();
+    }
+}
+
+void FlowScheduler::destroy(FlowTask::Handle handle) {
+    --m_live;
+    ++m_cancelled;
+    handle.destroy();
+}
+
+void FlowScheduler::addTimer(FlowTask::Handle handle, uint32_t ms) {
+    Timer timer = {Clock::now() + std::chrono::milliseconds(ms), m_timerOrder++, handle};
+    m_timers.push_back(timer);
+    std::push_heap(m_timers.begin(), m_timers.end(), TimerLater());
+}
+
+void FlowScheduler::addWaiter(FlowTask::Handle handle, FlowEvent event) {
+    FlowTask::promise_type& promise = handle.promise();
+    promise.next = m_waiters[(int)event];
+    promise.cancelEpoch = m_cancelEpoch[(int)promise.group];
+    m_waiters[(int)event] = &promise;
+    ++m_waiting;
+}
+
+void FlowScheduler::signal(FlowEvent event) {
+    // Tách cả danh sách ra trước: task vừa thức mà chờ lại cùng sự kiện thì phải đợi lần signal sau
+    FlowTask::promise_type* waiter = m_waiters[(int)event];
+    if (!waiter) return;
+    m_waiters[(int)event] = nullptr;
+
+    // Danh sách móc theo thứ tự ngược; đảo lại để task chờ trước thức trước
+    FlowTask::promise_type* ordered = nullptr;
+    while (waiter) {
+        FlowTask::promise_type* next = waiter->next;
+        waiter->next = ordered;
+        ordered = waiter;
+        waiter = next;
+    }
+    while (ordered) {
+        FlowTask::promise_type* next = ordered->next;
+        ordered->next = nullptr;
+        --m_waiting;
+        // Task thức trước có thể đã hủy nhóm của task này; nó đã rời m_waiters nên cancel() không thấy
+        if (ordered->cancelEpoch != m_cancelEpoch[(int)ordered->group]) {
+            destroy(FlowTask::Handle::from_promise(*ordered));
+        } else {
+            resume(FlowTask::Handle::from_promise(*ordered));
+        }
+        ordered = next;
+    }
+}
+
+void FlowScheduler::update() {
+    if (m_timers.empty()) return;
+    Clock::time_point now = Clock::now();
+    while (!m_timers.empty() && m_timers.front().due <= now) {
+        std::pop_heap(m_timers.begin(), m_timers.end(), TimerLater());
+        Timer timer = m_timers.back();
+        m_timers.pop_back();
+        m_timerLatency.record(elapsedMs(timer.due, now));
+        resume(timer.handle); // Giờ hẹn mới luôn sau now nên vòng này không chạy mãi
+    }
+}
+
+void FlowScheduler::cancel(FlowGroup group) {
+    ++m_cancelEpoch[(int)group];
+    size_t kept = 0;
+    for (size_t i = 0; i < m_timers.size(); ++i) {
+        FlowTask::Handle handle = m_timers[i].handle;
+        if (handle.promise().group == group && handle != m_running) {
+            destroy(handle);
+        } else {
+            m_timers[kept++] = m_timers[i];
+        }
+    }
+    if (kept != m_timers.size()) {
+        m_timers.resize(kept);
+        std::make_heap(m_timers.begin(), m_timers.end(), TimerLater());
+    }
+
+    for (int i = 0; i < (int)FlowEvent::Count; ++i) {
+        FlowTask::promise_type** link = &m_waiters[i];
+        while (*link) {
+            FlowTask::promise_type* waiter = *link;
+            FlowTask::Handle handle = FlowTask::Handle::from_promise(*waiter);
+            if (waiter->group == group && handle != m_running) {
+                *link = waiter->next;
+                --m_waiting;
+                destroy(handle);
+            } else {
+                link = &waiter->next;
+            }
+        }
+    }
+}
+
+void FlowScheduler::cancelAll() {
+    for (int group = 0; group < (int)FlowGroup::Count; ++group) {
+        cancel((FlowGroup)group);
+    }
+}
+
+FlowStats FlowScheduler::stats() const {
+    FlowStats stats;
+    stats.live = m_live;
+    stats.sleeping = (int)m_timers.size();
+    stats.waiting = m_waiting;
+    stats.spawned = m_spawned;
+    stats.completed = m_completed;
+    stats.cancelled = m_cancelled;
+    stats.resumes = m_resumes;
+    stats.framesInUse = framePool().inUse;
+    stats.framePoolSize = framePool().chunks.size() * FLOW_FRAMES_PER_CHUNK;
+    stats.frameFallbacks = framePool().fallbacks;
+    return stats;
+}
+
+void FlowScheduler::report(std::ostream& out) const {
+    FlowStats s = stats();
+    out << std::fixed << std::setprecision(2) << "[flow] " << s.spawned << " spawned, " << s.completed << " done, "
+        << s.cancelled << " cancelled, " << s.live << " live (" << s.sleeping << " sleeping, " << s.waiting
+        << " waiting), " << s.resumes << " resumes, frames " << s.framesInUse << "/" << s.framePoolSize;
+    if (s.frameFallbacks > 0) {
+        out << " (" << s.frameFallbacks << " on heap)";
+    }
+    if (m_timerLatency.count() > 0) {
+        out << ", timer late p50 " << m_timerLatency.percentile(0.50) << " p99 " << m_timerLatency.percentile(0.99)
+            << " max " << m_timerLatency.max() << " ms";
+    }
+    out << std::endl;
+}
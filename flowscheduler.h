@@ -0,0 +1,157 @@
+#ifndef FLOWSCHEDULER_H
+#define FLOWSCHEDULER_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "latencyprofiler.h"
+
+// Luồng game viết thành coroutine C++20: "đổi chỗ, chờ hoạt ảnh, chờ đá rơi xong, xét thắng" là một hàm
+// thay vì các cờ bool được hỏi lại mỗi frame. Task đang chờ không tốn gì mỗi tick: chờ giờ nằm trong heap
+// theo thời điểm thức, chờ sự kiện nằm trong danh sách móc qua promise của sự kiện đó.
+// Frame coroutine lấy từ pool khối cố định, không đụng heap sau khi pool đã đủ lớn. Chỉ một thread dùng (sim thread).
+enum class FlowEvent : uint8_t {
+    SwapFinished, // Hoạt ảnh đổi chỗ xong
+    BoardSettled, // Hết đá rơi, hoạt ảnh ăn và đổi chỗ
+    Resumed,      // Hết tạm dừng
+    Count
+};
+
+// Nhóm để hủy cùng lúc (về Main Menu, chơi lại)
+enum class FlowGroup : uint8_t {
+    Game,
+    Timed,
+    Count
+};
+
+class FlowScheduler;
+
+class FlowTask {
+public:
+    struct promise_type {
+        FlowScheduler* scheduler = nullptr;
+        FlowGroup group = FlowGroup::Game;
+        promise_type* next = nullptr; // Danh sách chờ của một sự kiện
+        uint32_t cancelEpoch = 0;     // Lượt hủy của nhóm lúc bắt đầu chờ sự kiện
+
+        FlowTask get_return_object() { return FlowTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; } // spawn() chạy tới lần chờ đầu tiên
+        std::suspend_always final_suspend() noexcept { return {}; }   // Scheduler giải phóng frame
+        void return_void() {}
+        void unhandled_exception();
+
+        static void* operator new(size_t size);
+        static void operator delete(void* frame, size_t size);
+    };
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    FlowTask(FlowTask&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+    FlowTask(const FlowTask&) = delete;
+    FlowTask& operator=(const FlowTask&) = delete;
+    ~FlowTask() {
+        if (m_handle) m_handle.destroy(); // Chưa được spawn
+    }
+
+private:
+    friend class FlowScheduler;
+    explicit FlowTask(Handle handle) : m_handle(handle) {}
+    Handle release() {
+        Handle handle = m_handle;
+        m_handle = nullptr;
+        return handle;
+    }
+
+    Handle m_handle;
+};
+
+struct FlowStats {
+    int live;          // Task chưa xong
+    int sleeping;      // Đang chờ giờ
+    int waiting;       // Đang chờ sự kiện
+    uint64_t spawned;
+    uint64_t completed;
+    uint64_t cancelled;
+    uint64_t resumes;
+    size_t framesInUse;    // Khối trong pool đang giữ frame
+    size_t framePoolSize;  // Tổng số khối đã cấp cho pool
+    uint64_t frameFallbacks; // Frame lớn hơn một khối, phải xin heap
+};
+
+class FlowScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct SleepAwaiter {
+        FlowScheduler* scheduler;
+        uint32_t ms;
+        bool await_ready() const noexcept { return ms == 0; }
+        void await_suspend(FlowTask::Handle handle) { scheduler->addTimer(handle, ms); }
+        void await_resume() const noexcept {}
+    };
+
+    struct EventAwaiter {
+        FlowScheduler* scheduler;
+        FlowEvent event;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(FlowTask::Handle handle) { scheduler->addWaiter(handle, event); }
+        void await_resume() const noexcept {}
+    };
+
+    FlowScheduler();
+    ~FlowScheduler();
+
+    FlowScheduler(const FlowScheduler&) = delete;
+    FlowScheduler& operator=(const FlowScheduler&) = delete;
+
+    void spawn(FlowGroup group, FlowTask task); // Chạy ngay tới lần chờ đầu tiên
+    void cancel(FlowGroup group);              // Hủy các task đang chờ của nhóm; không gọi từ chính task trong nhóm
+    void cancelAll();
+
+    SleepAwaiter sleep(uint32_t ms) { return SleepAwaiter{this, ms}; }
+    EventAwaiter event(FlowEvent event) { return EventAwaiter{this, event}; }
+
+    // Thức các task chờ sự kiện ngay trong lời gọi, để task kịp chờ sự kiện sau trước khi nó xảy ra
+    void signal(FlowEvent event);
+    // Gọi mỗi tick: chỉ nhìn đỉnh heap nếu chưa tới giờ của ai
+    void update();
+
+    FlowStats stats() const;
+    const LatencyHistogram& timerLatency() const { return m_timerLatency; } // Trễ so với giờ hẹn
+    void report(std::ostream& out) const;
+
+private:
+    struct Timer {
+        Clock::time_point due;
+        uint64_t order; // Cùng giờ thì theo thứ tự hẹn
+        FlowTask::Handle handle;
+    };
+    struct TimerLater {
+        bool operator()(const Timer& a, const Timer& b) const {
+            return a.due != b.due ? a.due > b.due : a.order > b.order;
+        }
+    };
+
+    void addTimer(FlowTask::Handle handle, uint32_t ms);
+    void addWaiter(FlowTask::Handle handle, FlowEvent event);
+    void resume(FlowTask::Handle handle);
+    void destroy(FlowTask::Handle handle);
+
+    std::vector<Timer> m_timers; // Min-heap theo due
+    uint64_t m_timerOrder;
+    FlowTask::promise_type* m_waiters[(int)FlowEvent::Count];
+    int m_waiting;
+    FlowTask::Handle m_running;
+    uint32_t m_cancelEpoch[(int)FlowGroup::Count]; // Tăng mỗi lần cancel(group)
+
+    int m_live;
+    uint64_t m_spawned;
+    uint64_t m_completed;
+    uint64_t m_cancelled;
+    uint64_t m_resumes;
+    LatencyHistogram m_timerLatency;
+};
+
+#endif
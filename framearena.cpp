@@ -0,0 +1,46 @@
+#include "framearena.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+FrameArena::FrameArena(size_t capacity)
+    : m_buffer((unsigned char*)std::malloc(capacity)), m_capacity(m_buffer ? capacity : 0),
+      m_used(0), m_highWater(0), m_overflows(0) {}
+
+FrameArena::~FrameArena() {
+    std::free(m_buffer);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+    if (offset + size > m_capacity) {
+        ++m_overflows;
+        return nullptr;
+    }
+    m_used = offset + size;
+    return m_buffer + offset;
+}
+
+const char* FrameArena::format(const char* fmt, ...) {
+    // Ghi thẳng vào phần còn trống rồi chỉ giữ đúng số byte đã dùng
+    size_t available = m_capacity - m_used;
+    char* out = (char*)(m_buffer + m_used);
+
+    va_list args;
+    va_start(args, fmt);
+    int length = available > 0 ? vsnprintf(out, available, fmt, args) : -1;
+    va_end(args);
+
+    if (length < 0 || (size_t)length >= available) {
+        ++m_overflows;
+        return "";
+    }
+    m_used += length + 1;
+    return out;
+}
+
+void FrameArena::reset() {
+    m_highWater = std::max(m_highWater, m_used);
+    m_used = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Bộ cấp phát bump cho dữ liệu chỉ sống trong một frame (chuỗi hiển thị, mảng tạm).
+// reset() ở cuối frame trả lại toàn bộ, không có free từng phần. Chỉ một thread dùng (render thread).
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 64 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // nullptr nếu hết chỗ (được đếm trong overflowCount)
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // printf vào arena, hết chỗ thì trả chuỗi rỗng
+    const char* format(const char* fmt, ...);
+
+    void reset();
+
+    size_t used() const { return m_used; }
+    size_t highWater() const { return m_highWater; } // Lượng dùng lớn nhất trong một frame
+    size_t capacity() const { return m_capacity; }
+    uint64_t overflowCount() const { return m_overflows; }
+
+private:
+    unsigned char* m_buffer;
+    size_t m_capacity;
+    size_t m_used;
+    size_t m_highWater;
+    uint64_t m_overflows;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "gamesnapshot.h"
+
+void packCells(const int8_t board[BOARD_SIZE][BOARD_SIZE], uint8_t cells[SNAPSHOT_CELL_BYTES]) {
+    const int8_t* flat = &board[0][0];
+    for (int i = 0; i < SNAPSHOT_CELL_BYTES; ++i) {
+        cells[i] = (uint8_t)(((flat[2 * i] + 1) & 0x0F) | (((flat[2 * i + 1] + 1) & 0x0F) << 4));
+    }
+}
+
+void unpackCells(const uint8_t cells[SNAPSHOT_CELL_BYTES], int8_t board[BOARD_SIZE][BOARD_SIZE]) {
+    int8_t* flat = &board[0][0];
+    for (int i = 0; i < SNAPSHOT_CELL_BYTES; ++i) {
+        flat[2 * i] = (cells[i] & 0x0F) - 1;
+        flat[2 * i + 1] = (cells[i] >> 4) - 1;
+    }
+}
+
+bool cellsValid(const uint8_t cells[SNAPSHOT_CELL_BYTES]) {
+    for (int i = 0; i < SNAPSHOT_CELL_BYTES; ++i) {
+        if ((cells[i] & 0x0F) > NUM_CELL_VALUES || (cells[i] >> 4) > NUM_CELL_VALUES) {
+            return false;
+        }
+    }
+    return true;
+}
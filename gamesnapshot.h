@@ -0,0 +1,34 @@
+#ifndef GAMESNAPSHOT_H
+#define GAMESNAPSHOT_H
+
+#include <cstdint>
+
+#include "constants.h"
+
+const int SNAPSHOT_CELL_BYTES = BOARD_SIZE * BOARD_SIZE / 2;
+
+const uint8_t SNAPSHOT_FLAG_TIMED = 1;
+const uint8_t SNAPSHOT_FLAG_PRACTICE = 2;
+
+// Toàn bộ trạng thái ván chơi trong một khối POD cố định (56 byte cho bàn 8x8).
+// Save, undo/redo và các công cụ headless đều dùng chung struct này.
+struct GameSnapshot {
+    uint64_t rngState;
+    uint8_t cells[SNAPSHOT_CELL_BYTES]; // 4 bit mỗi ô, lưu (giá trị + 1), 0 là ô trống
+    int32_t score;
+    int32_t playerMoney;
+    int16_t timeRemaining;  // Giây, chỉ có nghĩa khi ở Timed Mode
+    uint8_t combo;
+    uint8_t shuffleRemaining;
+    int8_t timedModeLevel;  // -1 nếu không ở Timed Mode
+    uint8_t flags;          // SNAPSHOT_FLAG_*
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(GameSnapshot) <= 64, "GameSnapshot must stay within 64 bytes");
+
+void packCells(const int8_t board[BOARD_SIZE][BOARD_SIZE], uint8_t cells[SNAPSHOT_CELL_BYTES]);
+void unpackCells(const uint8_t cells[SNAPSHOT_CELL_BYTES], int8_t board[BOARD_SIZE][BOARD_SIZE]);
+bool cellsValid(const uint8_t cells[SNAPSHOT_CELL_BYTES]); // Mọi ô nằm trong [0, NUM_CELL_VALUES]
+
+#endif
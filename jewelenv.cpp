@@ -0,0 +1,123 @@
+#define JEWELENV_BUILD
+#include "jewelenv.h"
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "board.h"
+
+static_assert(NUM_ACTIONS == JEWEL_ENV_NUM_ACTIONS, "jewelenv action space must match board.h");
+
+struct JewelEnv {
+    std::vector<BoardEngine> boards;
+    std::vector<int> steps;
+    int maxSteps;
+};
+
+namespace {
+    // Mỗi bàn một luồng RNG riêng, suy ra từ seed chung
+    uint64_t boardSeed(uint64_t seed, int index) {
+        uint64_t x = seed + 0x9E3779B97F4A7C15ULL * (uint64_t)(index + 1);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    void resetBoard(BoardEngine& board, int& steps) {
+        board.score = 0;
+        board.combo = 0;
+        board.lastCascadeDepth = 0;
+        board.initBoard(); // RNG chạy tiếp nên mỗi ván mới khác ván trước
+        steps = 0;
+    }
+
+    bool hasMoves(const BoardEngine& board) {
+        Move moves[MAX_MOVES];
+        return board.listMoves(moves) > 0;
+    }
+}
+
+JewelEnv* jewel_env_create(int batchSize, uint64_t seed, int maxSteps) {
+    if (batchSize <= 0 || maxSteps < 0) {
+        return nullptr;
+    }
+
+    JewelEnv* env = new (std::nothrow) JewelEnv;
+    if (!env) {
+        return nullptr;
+    }
+    env->boards.resize(batchSize);
+    env->steps.assign(batchSize, 0);
+    env->maxSteps = maxSteps;
+
+    for (int i = 0; i < batchSize; ++i) {
+        env->boards[i].rng.seed(boardSeed(seed, i));
+        resetBoard(env->boards[i], env->steps[i]);
+    }
+    return env;
+}
+
+void jewel_env_destroy(JewelEnv* env) {
+    delete env;
+}
+
+int jewel_env_batch_size(const JewelEnv* env) {
+    return (int)env->boards.size();
+}
+
+void jewel_env_reset(JewelEnv* env, int8_t* observations) {
+    for (size_t i = 0; i < env->boards.size(); ++i) {
+        resetBoard(env->boards[i], env->steps[i]);
+        memcpy(observations + i * JEWEL_ENV_OBSERVATION_SIZE, env->boards[i].cells, JEWEL_ENV_OBSERVATION_SIZE);
+    }
+}
+
+int jewel_env_step(JewelEnv* env, const int32_t* actions, int8_t* observations,
+                   float* rewards, uint8_t* dones, int32_t* cascades) {
+    int finished = 0;
+    for (size_t i = 0; i < env->boards.size(); ++i) {
+        BoardEngine& board = env->boards[i];
+        int scoreBefore = board.score;
+        int cascadeDepth = 0;
+
+        Move move;
+        if (actionToMove(actions[i], move) && board.trySwap(move.x1, move.y1, move.x2, move.y2)) {
+            cascadeDepth = board.lastCascadeDepth;
+        }
+
+        rewards[i] = (float)(board.score - scoreBefore);
+        if (cascades) {
+            cascades[i] = cascadeDepth;
+        }
+
+        ++env->steps[i];
+        bool done = (env->maxSteps > 0 && env->steps[i] >= env->maxSteps) || !hasMoves(board);
+        dones[i] = done ? 1 : 0;
+        if (done) {
+            resetBoard(board, env->steps[i]);
+            ++finished;
+        }
+        memcpy(observations + i * JEWEL_ENV_OBSERVATION_SIZE, board.cells, JEWEL_ENV_OBSERVATION_SIZE);
+    }
+    return finished;
+}
+
+void jewel_env_action_masks(const JewelEnv* env, uint8_t* masks) {
+    memset(masks, 0, env->boards.size() * JEWEL_ENV_NUM_ACTIONS);
+
+    Move moves[MAX_MOVES];
+    for (size_t i = 0; i < env->boards.size(); ++i) {
+        uint8_t* mask = masks + i * JEWEL_ENV_NUM_ACTIONS;
+        int count = env->boards[i].listMoves(moves);
+        for (int m = 0; m < count; ++m) {
+            mask[moveToAction(moves[m])] = 1;
+        }
+    }
+}
+
+void jewel_env_scores(const JewelEnv* env, int32_t* scores) {
+    for (size_t i = 0; i < env->boards.size(); ++i) {
+        scores[i] = env->boards[i].score;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef JEWELENV_H
+#define JEWELENV_H
+
+/* C API chạy B bàn độc lập cùng lúc (lockstep) cho huấn luyện RL.
+ * Mọi buffer do bên gọi cấp phát, liền mạch theo thứ tự bàn; step không cấp phát bộ nhớ.
+ * Gọi được từ Python qua ctypes/cffi (chỉ dùng kiểu C thuần).
+ *
+ * Quan sát: mỗi bàn 64 int8 theo hàng (y * 8 + x): 0..5 đá thường, 6..11 đá sọc, 12 bom màu.
+ * Hành động: (y * 8 + x) * 2 + dir, dir 0 = đổi với ô bên phải, 1 = với ô bên dưới.
+ * Hành động không hợp lệ không làm đổi bàn và có reward 0.
+ * Khi done = 1 bàn đã được reset, quan sát trả về là của ván mới. */
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(JEWELENV_BUILD)
+#define JEWELENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define JEWELENV_API __declspec(dllimport)
+#else
+#define JEWELENV_API __attribute__((visibility("default")))
+#endif
+
+#define JEWEL_ENV_OBSERVATION_SIZE 64
+#define JEWEL_ENV_NUM_ACTIONS 128
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct JewelEnv JewelEnv;
+
+/* maxSteps: số nước tối đa mỗi ván (0 = chỉ kết thúc khi hết nước). NULL nếu tham số sai. */
+JEWELENV_API JewelEnv* jewel_env_create(int batchSize, uint64_t seed, int maxSteps);
+JEWELENV_API void jewel_env_destroy(JewelEnv* env);
+JEWELENV_API int jewel_env_batch_size(const JewelEnv* env);
+
+/* observations: batchSize * 64 */
+JEWELENV_API void jewel_env_reset(JewelEnv* env, int8_t* observations);
+
+/* actions: batchSize; observations: batchSize * 64; rewards, dones: batchSize.
+ * cascades (có thể NULL): số lượt ăn dây chuyền của nước vừa đi.
+ * Trả về số bàn vừa kết thúc ván. */
+JEWELENV_API int jewel_env_step(JewelEnv* env, const int32_t* actions, int8_t* observations,
+                                float* rewards, uint8_t* dones, int32_t* cascades);
+
+/* masks: batchSize * 128, 1 nếu hành động tạo được match */
+JEWELENV_API void jewel_env_action_masks(const JewelEnv* env, uint8_t* masks);
+
+/* scores: batchSize, tổng điểm ván hiện tại */
+JEWELENV_API void jewel_env_scores(const JewelEnv* env, int32_t* scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#include "latencyprofiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+    const int BUCKETS_PER_OCTAVE = 4;
+
+    const char* const STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+        "queue", "handle", "resolve", "present", "input->photon", "frame"
+    };
+}
+
+const char* latencyStageName(int stage) {
+    return stage >= 0 && stage < LATENCY_STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+void LatencyHistogram::record(double ms) {
+    int bucket = 0;
+    if (ms > m_minMs) {
+        bucket = std::min((int)(std::log2(ms / m_minMs) * BUCKETS_PER_OCTAVE), BUCKET_COUNT - 1);
+    }
+    ++m_buckets[bucket];
+    ++m_count;
+    m_sumMs += ms;
+    m_maxMs = std::max(m_maxMs, ms);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        m_buckets[bucket] += other.m_buckets[bucket];
+    }
+    m_count += other.m_count;
+    m_sumMs += other.m_sumMs;
+    m_maxMs = std::max(m_maxMs, other.m_maxMs);
+}
+
+void LatencyHistogram::reset() {
+    std::fill(m_buckets, m_buckets + BUCKET_COUNT, 0);
+    m_count = 0;
+    m_sumMs = 0.0;
+    m_maxMs = 0.0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (m_count == 0) return 0.0;
+
+    uint64_t rank = (uint64_t)std::ceil(p * m_count);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += m_buckets[bucket];
+        if (seen >= rank && seen > 0) {
+            // Bucket tràn không có cận trên, dùng max thật
+            return bucket == BUCKET_COUNT - 1 ? m_maxMs : std::min(bucketUpperMs(bucket), m_maxMs);
+        }
+    }
+    return m_maxMs;
+}
+
+double LatencyHistogram::bucketUpperMs(int bucket) const {
+    return m_minMs * std::exp2((double)(bucket + 1) / BUCKETS_PER_OCTAVE);
+}
+
+void LatencyProfiler::recordInput(const LatencyStamps& stamps, uint64_t presented) {
+    // Bỏ các đoạn chưa có mốc, tổng luôn tính được khi có captured
+    if (stamps.handled >= stamps.captured && stamps.handled != 0) {
+        m_histograms[LATENCY_QUEUE].record(ticksToMs(stamps.handled - stamps.captured));
+    }
+    if (stamps.swapStart >= stamps.handled && stamps.swapStart != 0) {
+        m_histograms[LATENCY_HANDLE].record(ticksToMs(stamps.swapStart - stamps.handled));
+    }
+    if (stamps.resolved >= stamps.swapStart && stamps.resolved != 0) {
+        m_histograms[LATENCY_RESOLVE].record(ticksToMs(stamps.resolved - stamps.swapStart));
+    }
+    if (presented >= stamps.resolved && stamps.resolved != 0) {
+        m_histograms[LATENCY_PRESENT].record(ticksToMs(presented - stamps.resolved));
+    }
+    if (presented >= stamps.captured) {
+        m_histograms[LATENCY_TOTAL].record(ticksToMs(presented - stamps.captured));
+    }
+}
+
+void LatencyProfiler::recordFrame(uint64_t start, uint64_t presented) {
+    if (presented >= start) {
+        m_histograms[LATENCY_FRAME].record(ticksToMs(presented - start));
+    }
+}
+
+void LatencyProfiler::reset() {
+    for (LatencyHistogram& histogram : m_histograms) {
+        histogram.reset();
+    }
+}
+
+void LatencyProfiler::report(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+
+    out << "[latency] stage              n      mean       p50       p95       p99       max (ms)" << std::endl;
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& h = m_histograms[stage];
+        out << "[latency] " << std::left << std::setw(14) << latencyStageName(stage) << std::right
+            << std::setw(7) << h.count()
+            << std::setw(10) << h.mean()
+            << std::setw(10) << h.percentile(0.50)
+            << std::setw(10) << h.percentile(0.95)
+            << std::setw(10) << h.percentile(0.99)
+            << std::setw(10) << h.max() << std::endl;
+    }
+
+    const LatencyHistogram& total = m_histograms[LATENCY_TOTAL];
+    if (total.count() > 0) {
+        out << "[latency] input->photon histogram:" << std::endl;
+        for (int bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+            if (total.bucketCount(bucket) == 0) continue;
+            bool overflow = bucket == LatencyHistogram::BUCKET_COUNT - 1;
+            out << "[latency]   " << (overflow ? " > " : "<= ")
+                << std::setw(8) << total.bucketUpperMs(overflow ? bucket - 1 : bucket) << " ms: "
+                << total.bucketCount(bucket) << std::endl;
+        }
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
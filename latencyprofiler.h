@@ -0,0 +1,78 @@
+#ifndef LATENCYPROFILER_H
+#define LATENCYPROFILER_H
+
+#include <cstdint>
+#include <ostream>
+
+// Mốc thời gian của một input, theo SDL_GetPerformanceCounter (0 = chưa tới mốc đó)
+struct LatencyStamps {
+    uint64_t captured;  // Render thread lấy event khỏi SDL
+    uint64_t handled;   // Sim thread lấy khỏi inputQueue
+    uint64_t swapStart; // performSwap bắt đầu
+    uint64_t resolved;  // trySwap (kể cả cascade) và save xong, sắp publish
+};
+
+// Các đoạn của đường input-to-photon, để biết lag nằm ở chờ, ở sim hay ở vẽ
+enum LatencyStage {
+    LATENCY_QUEUE,   // captured -> handled: chờ trong inputQueue, tick sim
+    LATENCY_HANDLE,  // handled -> swapStart: handleMouseClick
+    LATENCY_RESOLVE, // swapStart -> resolved: trySwap, cascade, save
+    LATENCY_PRESENT, // resolved -> present xong: chờ frame, vẽ, SDL_RenderPresent
+    LATENCY_TOTAL,   // captured -> present xong
+    LATENCY_FRAME,   // Thời gian vẽ + present của mỗi frame (không theo input)
+    LATENCY_STAGE_COUNT
+};
+
+const char* latencyStageName(int stage);
+
+// Histogram theo thang log: 4 bucket mỗi quãng tám, từ minMs (mặc định 0.1 ms), bucket cuối gom phần tràn
+class LatencyHistogram {
+public:
+    static const int BUCKET_COUNT = 48;
+
+    explicit LatencyHistogram(double minMs = 0.1) : m_minMs(minMs) { reset(); }
+
+    void record(double ms);
+    void merge(const LatencyHistogram& other); // Hai histogram phải cùng minMs
+    void reset();
+
+    uint64_t count() const { return m_count; }
+    uint64_t bucketCount(int bucket) const { return m_buckets[bucket]; }
+    double mean() const { return m_count ? m_sumMs / m_count : 0.0; }
+    double max() const { return m_maxMs; }
+    double percentile(double p) const; // Cận trên của bucket chứa phân vị p
+
+    double bucketUpperMs(int bucket) const;
+
+private:
+    double m_minMs;
+    uint64_t m_buckets[BUCKET_COUNT];
+    uint64_t m_count;
+    double m_sumMs;
+    double m_maxMs;
+};
+
+// Gom histogram cho từng đoạn. Chỉ render thread dùng nên không cần khóa.
+class LatencyProfiler {
+public:
+    explicit LatencyProfiler(uint64_t ticksPerSecond = 1000) : m_ticksPerSecond(ticksPerSecond) {}
+
+    void setFrequency(uint64_t ticksPerSecond) { m_ticksPerSecond = ticksPerSecond; }
+
+    // Gọi sau SDL_RenderPresent của frame đầu tiên hiển thị kết quả của input
+    void recordInput(const LatencyStamps& stamps, uint64_t presented);
+    void recordFrame(uint64_t start, uint64_t presented);
+    void reset();
+
+    const LatencyHistogram& histogram(int stage) const { return m_histograms[stage]; }
+    double ticksToMs(uint64_t ticks) const { return ticks * 1000.0 / m_ticksPerSecond; }
+
+    // Bảng p50/p95/p99/max từng đoạn, rồi histogram của LATENCY_TOTAL
+    void report(std::ostream& out) const;
+
+private:
+    uint64_t m_ticksPerSecond;
+    LatencyHistogram m_histograms[LATENCY_STAGE_COUNT];
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "levelpack.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Độ dài hàng/cột liên tiếp cùng màu đi qua ô (x, y)
+    int runLengthAt(const int8_t cells[BOARD_SIZE][BOARD_SIZE], int x, int y) {
+        int jewel = jewelColor(cells[y][x]);
+        if (jewel == -1) return 1;
+        int left = x, right = x, up = y, down = y;
+        while (left > 0 && jewelColor(cells[y][left - 1]) == jewel) --left;
+        while (right < BOARD_SIZE - 1 && jewelColor(cells[y][right + 1]) == jewel) ++right;
+        while (up > 0 && jewelColor(cells[up - 1][x]) == jewel) --up;
+        while (down < BOARD_SIZE - 1 && jewelColor(cells[down + 1][x]) == jewel) ++down;
+        return std::max(right - left + 1, down - up + 1);
+    }
+}
+
+void analyzeLevel(const BoardEngine& board, uint64_t refillSeed, LevelRecord& record) {
+    memset(&record, 0, sizeof(record));
+    record.refillSeed = refillSeed;
+    packCells(board.cells, record.cells);
+
+    Move moves[MAX_MOVES];
+    int count = board.listMoves(moves);
+    record.legalMoves = (uint8_t)count;
+
+    for (int i = 0; i < count; ++i) {
+        const Move& move = moves[i];
+
+        int8_t swapped[BOARD_SIZE][BOARD_SIZE];
+        memcpy(swapped, board.cells, sizeof(swapped));
+        std::swap(swapped[move.y1][move.x1], swapped[move.y2][move.x2]);
+        int longest = std::max(runLengthAt(swapped, move.x1, move.y1), runLengthAt(swapped, move.x2, move.y2));
+        record.longestMatch = (uint8_t)std::max<int>(record.longestMatch, longest);
+
+        // Chơi thử với đúng seed mà game sẽ dùng, nên số lượt dây chuyền là đạt được thật
+        BoardEngine trial = board;
+        trial.listener = nullptr;
+        trial.rng.seed(refillSeed);
+        if (trial.trySwap(move.x1, move.y1, move.x2, move.y2)) {
+            record.maxCascade = (uint8_t)std::max(record.maxCascade, (uint8_t)trial.lastCascadeDepth);
+        }
+    }
+}
+
+LevelPack::LevelPack() : m_bucketStart(nullptr), m_records(nullptr), m_count(0) {}
+
+bool LevelPack::open(const std::string& filePath) {
+    close();
+    if (!m_file.open(filePath)) {
+        return false;
+    }
+
+    size_t bucketBytes = (LEVEL_BUCKET_COUNT + 1) * sizeof(uint32_t);
+    if (m_file.size() < sizeof(LevelPackHeader) + bucketBytes) {
+        std::cerr << "Level pack too small: " << filePath << std::endl;
+        close();
+        return false;
+    }
+
+    LevelPackHeader header;
+    memcpy(&header, m_file.data(), sizeof(header));
+    uint64_t recordBytes = (uint64_t)header.recordCount * sizeof(LevelRecord);
+    if (header.magic != LEVEL_PACK_MAGIC || header.version != LEVEL_PACK_VERSION ||
+        header.recordSize != sizeof(LevelRecord) || header.recordOffset % 8 != 0 ||
+        header.recordOffset > m_file.size() || recordBytes > m_file.size() - header.recordOffset) {
+        std::cerr << "Invalid level pack: " << filePath << std::endl;
+        close();
+        return false;
+    }
+
+    const uint32_t* buckets = reinterpret_cast<const uint32_t*>(m_file.data() + sizeof(LevelPackHeader));
+    for (int i = 0; i < LEVEL_BUCKET_COUNT; ++i) {
+        if (buckets[i] > buckets[i + 1] || buckets[i + 1] > header.recordCount) {
+            std::cerr << "Corrupt level pack index: " << filePath << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    const LevelRecord* records = reinterpret_cast<const LevelRecord*>(m_file.data() + header.recordOffset);
+    for (uint32_t i = 0; i < header.recordCount; ++i) {
+        if (!cellsValid(records[i].cells)) {
+            std::cerr << "Corrupt level record: " << i << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    m_bucketStart = buckets;
+    m_records = records;
+    m_count = header.recordCount;
+    std::cout << "Level pack " << filePath << ": " << m_count << " levels" << std::endl;
+    return true;
+}
+
+void LevelPack::close() {
+    m_file.close();
+    m_bucketStart = nullptr;
+    m_records = nullptr;
+    m_count = 0;
+}
+
+bool LevelPack::sample(JewelRng& rng, int minMoves, int maxMoves, LevelRecord& out) const {
+    if (!isOpen()) return false;
+
+    minMoves = std::max(minMoves, 0);
+    maxMoves = std::min(maxMoves, LEVEL_BUCKET_COUNT - 1);
+    if (minMoves > maxMoves) return false;
+
+    uint32_t first = m_bucketStart[minMoves];
+    uint32_t last = m_bucketStart[maxMoves + 1];
+    if (first >= last) return false;
+
+    out = m_records[first + rng.below((int)(last - first))];
+    return true;
+}
+
+void LevelPack::apply(const LevelRecord& record, BoardEngine& engine) {
+    unpackCells(record.cells, engine.cells);
+    engine.rng.seed(record.refillSeed);
+}
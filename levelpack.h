@@ -0,0 +1,80 @@
+#ifndef LEVELPACK_H
+#define LEVELPACK_H
+
+#include <cstdint>
+#include <string>
+
+#include "board.h"
+#include "mappedfile.h"
+#include "rng.h"
+
+// Định dạng file levels.pak (little-endian), tạo bởi tools/levelgen:
+//   LevelPackHeader | bucketStart[LEVEL_BUCKET_COUNT + 1] | LevelRecord[recordCount] (căn 64 byte)
+// Record sắp theo số nước hợp lệ; bucketStart[n] là record đầu tiên có legalMoves >= n,
+// nên lấy mẫu theo độ khó chỉ cần tra bảng.
+const uint32_t LEVEL_PACK_MAGIC = 0x504C4C4A; // "JLLP"
+// 2: luật cascade có đá sọc và bom màu, maxCascade/longestMatch của pack cũ không còn đúng
+const uint32_t LEVEL_PACK_VERSION = 2;
+const int LEVEL_BUCKET_COUNT = MAX_MOVES + 1;
+
+// Dải độ khó theo số nước hợp lệ (ít nước = khó thấy nước đi). Với bàn ngẫu nhiên, mỗi đầu
+// (dễ, khó) chiếm khoảng một phần tư số bàn; các dải gối lên nhau để dải nào cũng đủ bàn.
+struct LevelBand {
+    int minMoves;
+    int maxMoves;
+};
+const LevelBand LEVEL_BAND_ANY = {0, MAX_MOVES};
+const LevelBand LEVEL_BAND_EASY = {16, MAX_MOVES};
+const LevelBand LEVEL_BAND_NORMAL = {10, 20};
+const LevelBand LEVEL_BAND_HARD = {1, 11};
+
+struct LevelPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t recordSize;
+    uint64_t recordOffset;
+    uint64_t generatorSeed;
+};
+
+struct LevelRecord {
+    uint64_t refillSeed;                // Seed RNG khi chơi: đá rơi xuống giống hệt lúc phân tích
+    uint8_t cells[SNAPSHOT_CELL_BYTES]; // Như GameSnapshot::cells
+    uint8_t legalMoves;
+    uint8_t maxCascade;                 // Số lượt ăn dây chuyền lớn nhất của một nước đầu tiên
+    uint8_t longestMatch;               // Hàng dài nhất tạo được bằng một nước (3, 4, 5+)
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(LevelPackHeader) == 32, "LevelPackHeader layout");
+static_assert(sizeof(LevelRecord) == 48, "LevelRecord layout");
+
+// Phân tích bàn (không có sẵn match) với seed refill cho trước, điền các thuộc tính vào record
+void analyzeLevel(const BoardEngine& board, uint64_t refillSeed, LevelRecord& record);
+
+// Level pack được map vào bộ nhớ, game lấy mẫu bàn thay cho BoardEngine::initBoard
+class LevelPack {
+public:
+    LevelPack();
+
+    bool open(const std::string& filePath);
+    void close();
+    bool isOpen() const { return m_records != nullptr; }
+
+    uint32_t count() const { return m_count; }
+    const LevelRecord& record(uint32_t index) const { return m_records[index]; }
+
+    // Chọn ngẫu nhiên một level có minMoves <= legalMoves <= maxMoves, false nếu không có
+    bool sample(JewelRng& rng, int minMoves, int maxMoves, LevelRecord& out) const;
+
+    // Nạp level vào engine: ô đá và seed refill (giống initBoard, không đụng tới điểm)
+    static void apply(const LevelRecord& record, BoardEngine& engine);
+
+private:
+    MappedFile m_file;
+    const uint32_t* m_bucketStart;
+    const LevelRecord* m_records;
+    uint32_t m_count;
+};
+
+#endif
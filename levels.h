@@ -0,0 +1,24 @@
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include <string>
+#include <vector>
+
+struct TimedModeLevel {
+    int level;
+    int duration;
+    int price;
+    std::string name;
+    int targetScore; // Điểm để thắng timed mode
+};
+
+// Dùng chung cho game và tools/balance (công cụ mô phỏng để chỉnh targetScore)
+inline std::vector<TimedModeLevel> defaultTimedModeLevels() {
+    return {
+        {1, 5 * 60, 1500, "Level 1 (5 Minutes - 1500)", 1500},   // Điểm số mục tiêu 1500
+        {2, 10 * 60, 3500, "Level 2 (10 Minutes - 3500)", 3500}, // Điểm số mục tiêu 3500
+        {3, 20 * 60, 8000, "Level 3 (20 Minutes - 8000)", 8000}  // Điểm số mục tiêu 8000
+    };
+}
+
+#endif
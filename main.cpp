@@ -2,6 +2,63 @@
 
 int SDL_main(int argc, char* argv[]) {
     JewelGame game;
+    std::string versusHost; // Rỗng: làm chủ (--versus-host) hoặc không chơi versus
+    int versusPort = -1;
+    bool versusBot = false;
+    NetConditions netConditions;
+    int inputDelay = 2;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--autoplay") {
+            game.setAutoplay(true); // Màn hình chờ: bot tự chơi ngay sau khi load
+        } else if (arg == "--headless") {
+            game.setHeadless(true);
+        } else if (arg == "--wall" && i + 1 < argc) {
+            game.setWall(atoi(argv[++i])); // Màn hình trưng bày: 16-64 bàn bot tự chơi
+        } else if (arg == "--software") {
+            game.setSoftware(true);
+        } else if (arg == "--no-fast-path") {
+            game.setSoftFastPath(false); // So sánh với đường SDL_RenderCopy trên renderer phần mềm
+        } else if (arg == "--scenario" && i + 1 < argc) {
+            // Chạy kịch bản input, in báo cáo độ trễ khi thoát
+            if (!game.loadScenario(argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--profile" && i + 1 < argc) {
+            game.setProfile(argv[++i]); // Hồ sơ người chơi trong profiles.db, mặc định "Player"
+        } else if (arg == "--versus-host" && i + 1 < argc) {
+            versusPort = atoi(argv[++i]);
+        } else if (arg == "--versus-join" && i + 1 < argc) {
+            // HOST:PORT
+            std::string target = argv[++i];
+            size_t colon = target.rfind(':');
+            versusHost = target.substr(0, colon);
+            versusPort = colon == std::string::npos ? -1 : atoi(target.c_str() + colon + 1);
+        } else if (arg == "--versus-bot") {
+            versusBot = true; // Đấu với bot qua UDP loopback, để thử netcode trên một máy
+        } else if (arg == "--netsim" && i + 1 < argc) {
+            // LATENCY,JITTER,LOSS% cho gói gửi đi
+            if (!parseNetConditions(argv[++i], netConditions)) {
+                std::cerr << "Invalid --netsim, expected LATENCY,JITTER,LOSS" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--input-delay" && i + 1 < argc) {
+            inputDelay = atoi(argv[++i]);
+        }
+    }
+
+    bool versusReady = true;
+    if (versusBot) {
+        versusReady = game.startVersusBot(netConditions, inputDelay);
+    } else if (!versusHost.empty()) {
+        versusReady = versusPort > 0 && game.joinVersus(versusHost, (uint16_t)versusPort, netConditions);
+    } else if (versusPort >= 0) {
+        versusReady = game.hostVersus((uint16_t)versusPort, netConditions, inputDelay);
+    }
+    if (!versusReady) {
+        std::cerr << "Failed to set up versus mode" << std::endl;
+        return 1;
+    }
     game.run();
     return 0;
 }
@@ -0,0 +1,239 @@
+#include "mappedfile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_fileHandle(nullptr), m_mappingHandle(nullptr) {}
+#else
+MappedFile::MappedFile() : m_data(nullptr), m_size(0) {}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& filePath) {
+    close();
+
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mappingHandle);
+        CloseHandle(m_fileHandle);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& filePath) {
+    close();
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // mmap giữ tham chiếu riêng tới file
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+#endif
+
+#ifdef _WIN32
+WritableMappedFile::WritableMappedFile() : m_data(nullptr), m_size(0), m_fileHandle(nullptr), m_mappingHandle(nullptr) {}
+#else
+WritableMappedFile::WritableMappedFile() : m_data(nullptr), m_size(0), m_fd(-1) {}
+#endif
+
+WritableMappedFile::~WritableMappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+bool WritableMappedFile::open(const std::string& filePath, size_t minSize) {
+    close();
+
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    m_fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        close();
+        return false;
+    }
+    size_t size = (size_t)fileSize.QuadPart;
+    if (!map(size < minSize ? minSize : size)) { // windows.h định nghĩa macro max
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool WritableMappedFile::map(size_t size) {
+    // Mapping lớn hơn file thì Windows tự nới file ra, phần mới là byte 0
+    LARGE_INTEGER mapSize;
+    mapSize.QuadPart = (LONGLONG)size;
+    HANDLE mapping = CreateFileMappingA(m_fileHandle, NULL, PAGE_READWRITE, mapSize.HighPart, mapSize.LowPart, NULL);
+    if (mapping == NULL) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_mappingHandle = mapping;
+    m_data = static_cast<unsigned char*>(view);
+    m_size = size;
+    return true;
+}
+
+void WritableMappedFile::unmap() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mappingHandle);
+    }
+    m_data = nullptr;
+    m_mappingHandle = nullptr;
+    m_size = 0;
+}
+
+void WritableMappedFile::close() {
+    unmap();
+    if (m_fileHandle) {
+        CloseHandle(m_fileHandle);
+    }
+    m_fileHandle = nullptr;
+}
+
+bool WritableMappedFile::flush(size_t offset, size_t length) {
+    if (!m_data || offset + length > m_size) return false;
+    return FlushViewOfFile(m_data + offset, length) && FlushFileBuffers(m_fileHandle);
+}
+#else
+bool WritableMappedFile::open(const std::string& filePath, size_t minSize) {
+    close();
+
+    m_fd = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || !map(std::max((size_t)st.st_size, minSize))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool WritableMappedFile::map(size_t size) {
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || ((size_t)st.st_size < size && ftruncate(m_fd, (off_t)size) != 0)) {
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<unsigned char*>(view);
+    m_size = size;
+    return true;
+}
+
+void WritableMappedFile::unmap() {
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void WritableMappedFile::close() {
+    unmap();
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+}
+
+bool WritableMappedFile::flush(size_t offset, size_t length) {
+    if (!m_data || offset + length > m_size) return false;
+    // msync cần địa chỉ căn theo trang
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset / page * page;
+    return msync(m_data + start, offset + length - start, MS_SYNC) == 0;
+}
+#endif
+
+bool WritableMappedFile::grow(size_t newSize) {
+    if (newSize <= m_size) return true;
+    unmap();
+    return map(newSize);
+}
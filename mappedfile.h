@@ -0,0 +1,65 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Ánh xạ file chỉ-đọc vào bộ nhớ (mmap / MapViewOfFile)
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filePath);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#endif
+};
+
+// Ánh xạ file đọc-ghi, tự tạo nếu chưa có. Dữ liệu ghi qua con trỏ chỉ chắc chắn nằm trên đĩa sau flush().
+// grow() ánh xạ lại nên mọi con trỏ cũ vào data() đều mất hiệu lực.
+class WritableMappedFile {
+public:
+    WritableMappedFile();
+    ~WritableMappedFile();
+
+    WritableMappedFile(const WritableMappedFile&) = delete;
+    WritableMappedFile& operator=(const WritableMappedFile&) = delete;
+
+    bool open(const std::string& filePath, size_t minSize); // File ngắn hơn minSize thì nối thêm byte 0
+    void close();
+    bool grow(size_t newSize);
+    bool flush(size_t offset, size_t length); // msync / FlushViewOfFile, đợi tới khi xuống đĩa
+
+    bool isOpen() const { return m_data != nullptr; }
+    unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    bool map(size_t size);
+    void unmap();
+
+    unsigned char* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#else
+    int m_fd;
+#endif
+};
+
+#endif
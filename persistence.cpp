@@ -0,0 +1,127 @@
+#include "persistence.h"
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+PersistenceService::PersistenceService() : m_hasSave(false), m_highScore(0), m_stopping(false), m_inotifyFd(-1) {}
+
+PersistenceService::~PersistenceService() {
+    stop();
+}
+
+void PersistenceService::start(const std::string& saveFile, const std::string& highScoreFile) {
+    m_saveFile = saveFile;
+    m_highScoreFile = highScoreFile;
+
+    refreshSave();
+    refreshHighScore();
+    m_autoSaver.start(m_saveFile);
+
+#ifdef __linux__
+    // Theo dõi thư mục hiện tại, vì file save được thay bằng rename chứ không ghi đè
+    m_inotifyFd = inotify_init1(IN_NONBLOCK);
+    if (m_inotifyFd >= 0 && inotify_add_watch(m_inotifyFd, ".", IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE) >= 0) {
+        m_stopping = false;
+        m_watchThread = std::thread(&PersistenceService::watchLoop, this);
+    } else if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+#endif
+}
+
+void PersistenceService::stop() {
+    m_autoSaver.stop();
+
+    m_stopping = true;
+    if (m_watchThread.joinable()) {
+        m_watchThread.join();
+    }
+#ifdef __linux__
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+#endif
+}
+
+void PersistenceService::submitSave(const GameSnapshot& snapshot) {
+    m_hasSave = true;
+    m_autoSaver.submit(snapshot);
+}
+
+bool PersistenceService::loadSave(GameSnapshot& snapshot) {
+    bool ok = readSaveFile(m_saveFile, snapshot);
+    if (!ok) {
+        m_hasSave = false; // File hỏng thì nút Continue bị tắt
+    }
+    return ok;
+}
+
+bool PersistenceService::saveHighScore(int value) {
+    m_highScore = value;
+
+    std::ofstream file(m_highScoreFile);
+    if (file.is_open()) {
+        file << value;
+        file.close();
+        return true;
+    } else {
+        std::cerr << "Unable to open highscore file for saving" << std::endl;
+        return false;
+    }
+}
+
+void PersistenceService::refreshSave() {
+    struct stat st;
+    m_hasSave = stat(m_saveFile.c_str(), &st) == 0 && st.st_size > 0;
+}
+
+void PersistenceService::refreshHighScore() {
+    std::ifstream file(m_highScoreFile);
+    if (file.is_open()) {
+        int value = 0;
+        file >> value;
+        m_highScore = value;
+    } else {
+        std::ofstream newFile(m_highScoreFile);
+        if (newFile.is_open()) {
+            newFile << 0;
+            m_highScore = 0;
+        } else {
+            std::cerr << "Unable to create highscore file" << std::endl;
+        }
+    }
+}
+
+void PersistenceService::watchLoop() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+
+    while (!m_stopping) {
+        struct pollfd pfd = {m_inotifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            if (event->len > 0) {
+                if (m_saveFile == event->name) {
+                    refreshSave();
+                } else if (m_highScoreFile == event->name && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+                    refreshHighScore();
+                }
+            }
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+#endif
+}
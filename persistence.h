@@ -0,0 +1,45 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "autosaver.h"
+#include "saveload.h"
+
+// Quản lý savegame và highscore. Trạng thái được giữ trong bộ nhớ nên
+// hasSave()/highScore() không đụng tới đĩa; cache chỉ đổi khi chính service ghi
+// hoặc khi inotify báo file bị sửa từ bên ngoài (Linux).
+class PersistenceService {
+public:
+    PersistenceService();
+    ~PersistenceService();
+
+    void start(const std::string& saveFile, const std::string& highScoreFile);
+    void stop();
+
+    bool hasSave() const { return m_hasSave.load(std::memory_order_relaxed); }
+    int highScore() const { return m_highScore.load(std::memory_order_relaxed); }
+
+    void submitSave(const GameSnapshot& snapshot); // Ghi trên thread của AutoSaver
+    bool loadSave(GameSnapshot& snapshot);
+    bool saveHighScore(int value);
+
+private:
+    void refreshSave();
+    void refreshHighScore();
+    void watchLoop();
+
+    std::string m_saveFile;
+    std::string m_highScoreFile;
+    AutoSaver m_autoSaver;
+    std::atomic<bool> m_hasSave;
+    std::atomic<int> m_highScore;
+
+    std::thread m_watchThread;
+    std::atomic<bool> m_stopping;
+    int m_inotifyFd;
+};
+
+#endif
@@ -0,0 +1,318 @@
+#include "profilestore.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "saveload.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+    const size_t RECORD_SIZE = sizeof(ProfileRecord);
+    const size_t RECORD_CRC_BYTES = offsetof(ProfileRecord, crc);
+    const uint32_t INITIAL_CAPACITY = 1024; // Record; file nhân đôi khi đầy
+    const uint32_t COMPACT_SLACK = 4096;    // Gộp khi số record cũ vượt số hồ sơ quá chừng này
+
+    uint64_t boardKey(int score, int profileId) {
+        return ((uint64_t)(uint32_t)(INT32_MAX - score) << 32) | (uint32_t)profileId;
+    }
+
+    // Header: u32 magic, u16 version, u16 kích thước record, rồi byte 0, CRC32 của 60 byte đầu ở cuối
+    void writeHeader(unsigned char* header) {
+        memset(header, 0, PROFILE_HEADER_SIZE);
+        uint32_t magic = PROFILE_FILE_MAGIC;
+        uint16_t version = PROFILE_FILE_VERSION;
+        uint16_t recordSize = (uint16_t)RECORD_SIZE;
+        memcpy(header, &magic, 4);
+        memcpy(header + 4, &version, 2);
+        memcpy(header + 6, &recordSize, 2);
+        uint32_t crc = crc32(header, PROFILE_HEADER_SIZE - 4);
+        memcpy(header + PROFILE_HEADER_SIZE - 4, &crc, 4);
+    }
+
+    bool headerValid(const unsigned char* header) {
+        unsigned char expected[PROFILE_HEADER_SIZE];
+        writeHeader(expected);
+        return memcmp(header, expected, PROFILE_HEADER_SIZE) == 0;
+    }
+
+    bool headerEmpty(const unsigned char* header) {
+        for (size_t i = 0; i < PROFILE_HEADER_SIZE; ++i) {
+            if (header[i] != 0) return false;
+        }
+        return true;
+    }
+
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+}
+
+ProfileStore::ProfileStore() : m_recordCount(0), m_nextSequence(1), m_discarded(0) {}
+
+bool ProfileStore::open(const std::string& filePath) {
+    close();
+    m_filePath = filePath;
+    if (!load()) {
+        return false;
+    }
+    if (m_recordCount > m_latest.size() + COMPACT_SLACK) {
+        compact(); // Lỗi thì vẫn dùng file cũ được
+    }
+    return isOpen();
+}
+
+bool ProfileStore::load() {
+    if (!m_file.open(m_filePath, PROFILE_HEADER_SIZE + INITIAL_CAPACITY * RECORD_SIZE)) {
+        std::cerr << "Unable to open profile store " << m_filePath << std::endl;
+        return false;
+    }
+
+    if (headerEmpty(m_file.data())) {
+        writeHeader(m_file.data());
+        m_file.flush(0, PROFILE_HEADER_SIZE);
+    } else if (!headerValid(m_file.data())) {
+        std::cerr << "Not a profile store (or unsupported version): " << m_filePath << std::endl;
+        m_file.close();
+        return false;
+    }
+    scan();
+    return true;
+}
+
+void ProfileStore::close() {
+    m_file.close();
+    m_recordCount = 0;
+    m_nextSequence = 1;
+    m_discarded = 0;
+    m_latest.clear();
+    m_byName.clear();
+    for (int board = 0; board < NUM_LEADERBOARDS; ++board) {
+        m_boards[board].clear();
+    }
+}
+
+const ProfileRecord* ProfileStore::slot(uint32_t index) const {
+    return reinterpret_cast<const ProfileRecord*>(m_file.data() + PROFILE_HEADER_SIZE + (size_t)index * RECORD_SIZE);
+}
+
+void ProfileStore::scan() {
+    uint32_t capacity = (uint32_t)((m_file.size() - PROFILE_HEADER_SIZE) / RECORD_SIZE);
+    uint32_t index = 0;
+    for (; index < capacity; ++index) {
+        const ProfileRecord* record = slot(index);
+        if (record->magic != PROFILE_RECORD_MAGIC || record->sequence != m_nextSequence ||
+            record->crc != crc32(record, RECORD_CRC_BYTES) || record->profileId > m_latest.size() ||
+            record->name[PROFILE_NAME_BYTES - 1] != '\0') {
+            break;
+        }
+
+        if (record->profileId == m_latest.size()) {
+            m_latest.push_back(index);
+            m_byName[record->name] = (int)record->profileId;
+        } else {
+            m_latest[record->profileId] = index;
+        }
+        ++m_nextSequence;
+    }
+    m_recordCount = index;
+
+    // Phần sau record hợp lệ cuối phải toàn byte 0; khác nghĩa là lần ghi trước bị ngắt giữa chừng
+    for (; index < capacity && slot(index)->magic != 0; ++index) {
+        ++m_discarded;
+    }
+    if (m_discarded > 0) {
+        // Xóa đi để lần nối sau không nằm cạnh rác
+        size_t offset = PROFILE_HEADER_SIZE + (size_t)m_recordCount * RECORD_SIZE;
+        memset(m_file.data() + offset, 0, (size_t)m_discarded * RECORD_SIZE);
+        m_file.flush(offset, (size_t)m_discarded * RECORD_SIZE);
+        std::cerr << "Profile store: dropped " << m_discarded << " torn record(s) after #" << m_recordCount << std::endl;
+    }
+
+    for (int profileId = 0; profileId < (int)m_latest.size(); ++profileId) {
+        const ProfileRecord* record = slot(m_latest[profileId]);
+        for (int board = 0; board < NUM_LEADERBOARDS; ++board) {
+            if (record->stats[board].played > 0) {
+                m_boards[board].push_back(boardKey(record->stats[board].bestScore, profileId));
+            }
+        }
+    }
+    for (int board = 0; board < NUM_LEADERBOARDS; ++board) {
+        std::sort(m_boards[board].begin(), m_boards[board].end());
+    }
+}
+
+bool ProfileStore::append(ProfileRecord& record) {
+    size_t offset = PROFILE_HEADER_SIZE + (size_t)m_recordCount * RECORD_SIZE;
+    if (offset + RECORD_SIZE > m_file.size() && !m_file.grow(PROFILE_HEADER_SIZE + (m_file.size() - PROFILE_HEADER_SIZE) * 2)) {
+        std::cerr << "Unable to grow profile store" << std::endl;
+        return false;
+    }
+
+    record.magic = PROFILE_RECORD_MAGIC;
+    record.sequence = m_nextSequence;
+    record.crc = crc32(&record, RECORD_CRC_BYTES);
+    memcpy(m_file.data() + offset, &record, RECORD_SIZE);
+    // Record chỉ tính là đã ghi khi xuống đĩa; mất điện trước đó thì lần mở sau thấy CRC sai và bỏ
+    if (!m_file.flush(offset, RECORD_SIZE)) {
+        std::cerr << "Unable to flush profile store" << std::endl;
+        return false;
+    }
+    ++m_recordCount;
+    ++m_nextSequence;
+    return true;
+}
+
+bool ProfileStore::compact() {
+    std::string tempPath = m_filePath + ".tmp";
+    remove(tempPath.c_str());
+    {
+        WritableMappedFile temp;
+        size_t size = PROFILE_HEADER_SIZE + std::max<size_t>(m_latest.size() * 2, INITIAL_CAPACITY) * RECORD_SIZE;
+        if (!temp.open(tempPath, size)) {
+            std::cerr << "Unable to create " << tempPath << std::endl;
+            return false;
+        }
+        writeHeader(temp.data());
+        for (uint32_t profileId = 0; profileId < m_latest.size(); ++profileId) {
+            ProfileRecord record = *slot(m_latest[profileId]);
+            record.sequence = profileId + 1;
+            record.crc = crc32(&record, RECORD_CRC_BYTES);
+            memcpy(temp.data() + PROFILE_HEADER_SIZE + profileId * RECORD_SIZE, &record, RECORD_SIZE);
+        }
+        if (!temp.flush(0, temp.size())) {
+            std::cerr << "Unable to flush " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    // Windows không đổi tên được file đang ánh xạ, nên đóng trước rồi mở lại bản nào còn lại
+    uint32_t before = m_recordCount;
+    std::string filePath = m_filePath;
+    close();
+    m_filePath = filePath;
+    bool replaced = replaceFile(tempPath, m_filePath);
+    if (!replaced) {
+        std::cerr << "Unable to replace profile store with compacted copy" << std::endl;
+        remove(tempPath.c_str());
+    }
+    if (!load()) {
+        return false;
+    }
+    if (replaced) {
+        std::cout << "Profile store compacted: " << before << " -> " << m_recordCount << " records" << std::endl;
+    }
+    return replaced;
+}
+
+int ProfileStore::findProfile(const std::string& name) const {
+    auto found = m_byName.find(name);
+    return found == m_byName.end() ? -1 : found->second;
+}
+
+int ProfileStore::createProfile(const std::string& name, int playerMoney, uint32_t now) {
+    if (!isOpen() || name.empty() || name.size() >= (size_t)PROFILE_NAME_BYTES || findProfile(name) >= 0 ||
+        (int)m_latest.size() >= MAX_PROFILES) {
+        return -1;
+    }
+
+    ProfileRecord record;
+    memset(&record, 0, sizeof(record));
+    record.profileId = (uint32_t)m_latest.size();
+    record.playerMoney = playerMoney;
+    memcpy(record.name, name.data(), name.size());
+    record.createdAt = now;
+    if (!append(record)) {
+        return -1;
+    }
+    m_latest.push_back(m_recordCount - 1);
+    m_byName[name] = (int)record.profileId;
+    return (int)record.profileId;
+}
+
+bool ProfileStore::profile(int profileId, ProfileRecord& record) const {
+    if (profileId < 0 || profileId >= (int)m_latest.size()) return false;
+    record = *slot(m_latest[profileId]);
+    return true;
+}
+
+bool ProfileStore::recordGame(int profileId, LeaderboardId board, int score, bool won, int playerMoney, uint32_t now) {
+    ProfileRecord record;
+    if (board >= NUM_LEADERBOARDS || !profile(profileId, record)) return false;
+
+    score = std::max(0, score);
+    ModeStats& stats = record.stats[board];
+    bool ranked = stats.played > 0;
+    int oldBest = stats.bestScore;
+    stats.bestScore = ranked ? std::max(stats.bestScore, (int32_t)score) : score;
+    ++stats.played;
+    if (won) ++stats.wins;
+
+    record.recentScores[record.recentNext] = score;
+    record.recentBoards[record.recentNext] = board;
+    record.recentNext = (uint8_t)((record.recentNext + 1) % PROFILE_HISTORY);
+    record.recentCount = (uint8_t)std::min(record.recentCount + 1, PROFILE_HISTORY);
+    record.playerMoney = playerMoney;
+    record.lastPlayedAt = now;
+
+    if (!append(record)) return false;
+    m_latest[profileId] = m_recordCount - 1;
+
+    if (!ranked || stats.bestScore != oldBest) {
+        updateBoard(board, profileId, ranked ? oldBest : -1, stats.bestScore);
+    }
+    return true;
+}
+
+bool ProfileStore::setMoney(int profileId, int playerMoney) {
+    ProfileRecord record;
+    if (!profile(profileId, record)) return false;
+    if (record.playerMoney == playerMoney) return true;
+    record.playerMoney = playerMoney;
+    if (!append(record)) return false;
+    m_latest[profileId] = m_recordCount - 1;
+    return true;
+}
+
+void ProfileStore::updateBoard(LeaderboardId board, int profileId, int oldBest, int newBest) {
+    // Mảng sắp xếp: tìm O(log n), chèn/xóa là một memmove, vài chục µs với hàng chục nghìn người chơi
+    std::vector<uint64_t>& entries = m_boards[board];
+    if (oldBest >= 0) {
+        auto old = std::lower_bound(entries.begin(), entries.end(), boardKey(oldBest, profileId));
+        if (old != entries.end() && *old == boardKey(oldBest, profileId)) {
+            entries.erase(old);
+        }
+    }
+    uint64_t key = boardKey(newBest, profileId);
+    entries.insert(std::lower_bound(entries.begin(), entries.end(), key), key);
+}
+
+int ProfileStore::rank(LeaderboardId board, int profileId) const {
+    if (board >= NUM_LEADERBOARDS || profileId < 0 || profileId >= (int)m_latest.size()) return 0;
+    const ModeStats& stats = slot(m_latest[profileId])->stats[board];
+    if (stats.played == 0) return 0;
+    const std::vector<uint64_t>& entries = m_boards[board];
+    return (int)(std::lower_bound(entries.begin(), entries.end(), boardKey(stats.bestScore, profileId)) - entries.begin()) + 1;
+}
+
+int ProfileStore::top(LeaderboardId board, LeaderboardEntry* entries, int count, int offset) const {
+    if (board >= NUM_LEADERBOARDS || offset < 0) return 0;
+    const std::vector<uint64_t>& keys = m_boards[board];
+    int total = std::max(0, std::min(count, (int)keys.size() - offset));
+    for (int i = 0; i < total; ++i) {
+        uint64_t key = keys[offset + i];
+        entries[i].profileId = (int)(key & 0xFFFFFFFFu);
+        entries[i].score = INT32_MAX - (int)(key >> 32);
+    }
+    return total;
+}
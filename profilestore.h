@@ -0,0 +1,109 @@
+#ifndef PROFILESTORE_H
+#define PROFILESTORE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mappedfile.h"
+
+// Hồ sơ người chơi và bảng xếp hạng của cả cụm kiosk, trong một file ánh xạ bộ nhớ.
+//
+// File: 64 byte header rồi các ProfileRecord 160 byte, chỉ nối thêm, không bao giờ ghi đè record đã commit.
+// Mỗi lần đổi hồ sơ (tạo mới, xong một ván, đổi tiền) là một record mới chứa toàn bộ hồ sơ, kèm sequence và CRC32.
+// Mở file thì quét tới record hỏng đầu tiên: record ghi dở lúc mất điện bị bỏ và bị ghi đè ở lần nối sau.
+// Chỉ mục (tên -> hồ sơ, hồ sơ -> record mới nhất) và bảng xếp hạng dựng lại trong bộ nhớ lúc mở.
+const uint32_t PROFILE_FILE_MAGIC = 0x46504C4A;   // "JLPF"
+const uint32_t PROFILE_RECORD_MAGIC = 0x52504C4A; // "JLPR"
+const uint16_t PROFILE_FILE_VERSION = 1;
+const size_t PROFILE_HEADER_SIZE = 64;
+const int PROFILE_NAME_BYTES = 24;  // Kể cả '\0'
+const int PROFILE_HISTORY = 8;      // Số điểm gần nhất giữ trong hồ sơ
+const int MAX_PROFILES = 1 << 20;
+
+// Mỗi chế độ và mỗi level Timed Mode có bảng riêng
+enum LeaderboardId : uint8_t {
+    BOARD_NORMAL = 0,
+    BOARD_PRACTICE,
+    BOARD_TIMED_1,
+    BOARD_TIMED_2,
+    BOARD_TIMED_3,
+    NUM_LEADERBOARDS
+};
+
+struct ModeStats {
+    int32_t bestScore;
+    uint32_t played;
+    uint32_t wins; // Chỉ Timed Mode có thắng/thua, thua = played - wins
+};
+
+struct ProfileRecord {
+    uint32_t magic;
+    uint32_t sequence;   // Tăng dần trong cả file, record sau của cùng hồ sơ thắng
+    uint32_t profileId;  // Thứ tự tạo, từ 0
+    int32_t playerMoney;
+    char name[PROFILE_NAME_BYTES];
+    uint32_t createdAt;  // Unix, giây
+    uint32_t lastPlayedAt;
+    ModeStats stats[NUM_LEADERBOARDS];
+    int32_t recentScores[PROFILE_HISTORY]; // Vòng tròn, recentNext là ô ghi tiếp
+    uint8_t recentBoards[PROFILE_HISTORY];
+    uint8_t recentNext;
+    uint8_t recentCount;
+    uint8_t reserved[6];
+    uint32_t crc;        // CRC32 của mọi byte phía trước
+};
+
+static_assert(sizeof(ProfileRecord) == 160, "ProfileRecord is a fixed on-disk record");
+
+struct LeaderboardEntry {
+    int profileId;
+    int score;
+};
+
+class ProfileStore {
+public:
+    ProfileStore();
+
+    bool open(const std::string& filePath); // Tự tạo file, tự gộp record cũ khi file phình quá
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    int profileCount() const { return (int)m_latest.size(); }
+    int findProfile(const std::string& name) const; // -1 nếu chưa có
+    int createProfile(const std::string& name, int playerMoney, uint32_t now); // -1 nếu lỗi hoặc tên đã có
+    bool profile(int profileId, ProfileRecord& record) const;
+
+    bool recordGame(int profileId, LeaderboardId board, int score, bool won, int playerMoney, uint32_t now);
+    bool setMoney(int profileId, int playerMoney);
+
+    // O(log n): hạng theo điểm cao nhất (1 là nhất, hòa điểm thì ai tạo hồ sơ trước đứng trên), 0 nếu chưa chơi bảng này
+    int rank(LeaderboardId board, int profileId) const;
+    int boardSize(LeaderboardId board) const { return (int)m_boards[board].size(); }
+    int top(LeaderboardId board, LeaderboardEntry* entries, int count, int offset = 0) const;
+
+    uint32_t recordCount() const { return m_recordCount; }
+    uint32_t discardedRecords() const { return m_discarded; } // Record hỏng ở đuôi file lúc mở
+
+private:
+    bool load();
+    void scan();
+    bool append(ProfileRecord& record);
+    bool compact();
+    const ProfileRecord* slot(uint32_t index) const;
+    void updateBoard(LeaderboardId board, int profileId, int oldBest, int newBest);
+
+    std::string m_filePath;
+    WritableMappedFile m_file;
+    uint32_t m_recordCount;  // Record hợp lệ nằm liền sau header
+    uint32_t m_nextSequence;
+    uint32_t m_discarded;
+
+    std::vector<uint32_t> m_latest; // profileId -> chỉ số record mới nhất
+    std::unordered_map<std::string, int> m_byName;
+    // Khóa tăng dần = điểm giảm dần: (INT32_MAX - điểm) << 32 | profileId
+    std::vector<uint64_t> m_boards[NUM_LEADERBOARDS];
+};
+
+#endif
@@ -0,0 +1,608 @@
+#include "replaystream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "sessionprotocol.h"
+
+namespace {
+    const size_t MAX_VARINT = 5;
+
+    size_t putVarint(uint8_t* out, uint32_t value) {
+        size_t size = 0;
+        while (value >= 0x80) {
+            out[size++] = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        out[size++] = (uint8_t)value;
+        return size;
+    }
+
+    bool getVarint(const uint8_t*& data, const uint8_t* end, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35 && data < end; shift += 7) {
+            uint8_t byte = *data++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    size_t varintSize(uint32_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    int gammaBits(uint32_t value) {
+        int length = 0;
+        while ((value >> length) > 1) ++length;
+        return 2 * length + 1;
+    }
+
+    int popCount(uint64_t mask) {
+        int count = 0;
+        for (; mask; mask &= mask - 1) ++count;
+        return count;
+    }
+
+    inline uint64_t cellBit(int cell) {
+        return 1ULL << cell;
+    }
+
+    struct BitReader {
+        const uint8_t* data;
+        size_t bitCount;
+        size_t position = 0;
+        bool failed = false;
+
+        BitReader(const uint8_t* data, size_t size) : data(data), bitCount(size * 8) {}
+
+        uint32_t read(int count) {
+            if (position + count > bitCount) {
+                failed = true;
+                return 0;
+            }
+            uint32_t value = 0;
+            for (int i = 0; i < count; ++i, ++position) {
+                value |= (uint32_t)((data[position >> 3] >> (position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+        // Elias gamma: (n bit 0) rồi giá trị n + 1 bit, bit cao nhất trước
+        uint32_t readGamma() {
+            int length = 0;
+            while (!failed && read(1) == 0) {
+                if (++length > 31) failed = true;
+            }
+            uint32_t value = 1;
+            for (int i = 0; i < length && !failed; ++i) {
+                value = (value << 1) | read(1);
+            }
+            return value;
+        }
+    };
+
+    // Dồn cột xuống như BoardEngine::dropJewels, trả về số ô trống trên cùng của mỗi cột
+    void compactColumns(int8_t cells[BOARD_SIZE][BOARD_SIZE], int empty[BOARD_SIZE]) {
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            int dropTo = BOARD_SIZE - 1;
+            for (int y = BOARD_SIZE - 1; y >= 0; --y) {
+                if (cells[y][x] != -1) {
+                    int8_t value = cells[y][x];
+                    cells[y][x] = -1;
+                    cells[dropTo--][x] = value;
+                }
+            }
+            empty[x] = dropTo + 1;
+        }
+    }
+}
+
+ReplayFeed::ReplayFeed() : m_writeOffset(0), m_committed(0), m_latestKeyframe(0) {
+}
+
+uint8_t* ReplayFeed::chunk(int index) {
+    if (!m_chunks[index]) {
+        m_chunks[index].reset(new uint8_t[REPLAY_CHUNK_SIZE]);
+    }
+    return m_chunks[index].get();
+}
+
+void ReplayFeed::reset(const ReplayHeader& header) {
+    uint8_t* out = chunk(0);
+    putU32(out, REPLAY_MAGIC);
+    out[4] = header.version;
+    out[5] = header.mode;
+    out[6] = (uint8_t)header.timedLevel;
+    out[7] = header.keyframeInterval;
+    putU64(out + 8, header.createdAt);
+    m_writeOffset = REPLAY_HEADER_SIZE;
+    m_latestKeyframe.store(0, std::memory_order_relaxed);
+    m_committed.store(REPLAY_HEADER_SIZE, std::memory_order_release);
+}
+
+uint8_t* ReplayFeed::reserve(size_t maxSize) {
+    size_t used = m_writeOffset % REPLAY_CHUNK_SIZE;
+    if (used + maxSize > REPLAY_CHUNK_SIZE) {
+        // Đánh dấu phần thừa rồi sang chunk mới; người đọc thấy PAD chỉ sau khi record kế tiếp được commit
+        if (used != 0) {
+            chunk(m_writeOffset / REPLAY_CHUNK_SIZE)[used] = REPLAY_PAD;
+        }
+        m_writeOffset += (uint32_t)(REPLAY_CHUNK_SIZE - used);
+    }
+    if (m_writeOffset / REPLAY_CHUNK_SIZE >= (uint32_t)MAX_REPLAY_CHUNKS) {
+        return nullptr;
+    }
+    return chunk(m_writeOffset / REPLAY_CHUNK_SIZE) + m_writeOffset % REPLAY_CHUNK_SIZE;
+}
+
+void ReplayFeed::commit(size_t size, bool keyframe) {
+    if (keyframe) {
+        m_latestKeyframe.store(m_writeOffset, std::memory_order_release);
+    }
+    m_writeOffset += (uint32_t)size;
+    m_committed.store(m_writeOffset, std::memory_order_release);
+}
+
+uint32_t ReplayFeed::latestKeyframe() const {
+    // Có thể thấy keyframe mà commit chưa tới; ReplayCursor chỉ đọc khi offset < committed() nên vẫn an toàn
+    return m_latestKeyframe.load(std::memory_order_acquire);
+}
+
+bool ReplayFeed::header(ReplayHeader& header) const {
+    if (committed() < REPLAY_HEADER_SIZE) return false;
+    const uint8_t* data = at(0);
+    if (getU32(data) != REPLAY_MAGIC) return false;
+    header.version = data[4];
+    header.mode = data[5];
+    header.timedLevel = (int8_t)data[6];
+    header.keyframeInterval = data[7];
+    header.createdAt = getU64(data + 8);
+    return true;
+}
+
+std::vector<uint8_t> ReplayFeed::image() const {
+    uint32_t end = committed();
+    std::vector<uint8_t> bytes(end);
+    for (uint32_t offset = 0; offset < end; offset += REPLAY_CHUNK_SIZE) {
+        memcpy(bytes.data() + offset, at(offset), std::min<size_t>(REPLAY_CHUNK_SIZE, end - offset));
+    }
+    return bytes;
+}
+
+bool ReplayFeed::load(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Failed to open replay " << filePath << std::endl;
+        return false;
+    }
+    std::streamoff size = file.tellg();
+    if (size < (std::streamoff)REPLAY_HEADER_SIZE || size > (std::streamoff)(REPLAY_CHUNK_SIZE * MAX_REPLAY_CHUNKS)) {
+        std::cerr << "Invalid replay size: " << filePath << std::endl;
+        return false;
+    }
+
+    file.seekg(0);
+    for (std::streamoff offset = 0; offset < size; offset += REPLAY_CHUNK_SIZE) {
+        std::streamsize length = (std::streamsize)std::min<std::streamoff>(REPLAY_CHUNK_SIZE, size - offset);
+        if (!file.read((char*)chunk((int)(offset / REPLAY_CHUNK_SIZE)), length)) {
+            std::cerr << "Failed to read replay " << filePath << std::endl;
+            return false;
+        }
+    }
+    if (getU32(at(0)) != REPLAY_MAGIC || at(0)[4] != REPLAY_VERSION) {
+        std::cerr << "Not a replay file (or unsupported version): " << filePath << std::endl;
+        return false;
+    }
+
+    m_writeOffset = (uint32_t)size;
+    m_committed.store(m_writeOffset, std::memory_order_release);
+
+    uint32_t keyframe = 0;
+    ReplayCursor cursor(*this);
+    ReplayRecord record;
+    while (cursor.next(record)) {
+        if (record.type == REPLAY_KEYFRAME) keyframe = record.offset;
+    }
+    m_latestKeyframe.store(keyframe, std::memory_order_relaxed);
+    return !cursor.corrupt();
+}
+
+bool ReplayCursor::next(ReplayRecord& record) {
+    uint32_t end = m_feed->committed();
+    while (!m_corrupt && m_offset < end) {
+        size_t room = std::min<size_t>(REPLAY_CHUNK_SIZE - m_offset % REPLAY_CHUNK_SIZE, end - m_offset);
+        const uint8_t* data = m_feed->at(m_offset);
+        if (data[0] == REPLAY_PAD) {
+            m_offset += (uint32_t)(REPLAY_CHUNK_SIZE - m_offset % REPLAY_CHUNK_SIZE);
+            continue;
+        }
+
+        const uint8_t* payload = data + 1;
+        uint32_t size;
+        if (!getVarint(payload, data + room, size) || size > (size_t)(data + room - payload)) {
+            m_corrupt = true; // Record luôn nằm gọn trong chunk, vắt qua nghĩa là dữ liệu hỏng
+            return false;
+        }
+        record.type = data[0];
+        record.payload = payload;
+        record.size = size;
+        record.offset = m_offset;
+        m_offset += (uint32_t)(payload - data) + size;
+        return true;
+    }
+    return false;
+}
+
+void ReplayRecorder::begin(const BoardEngine& engine, const ReplayHeader& header, uint32_t now) {
+    m_feed.reset(header);
+    m_engine = &engine;
+    m_startTime = now;
+    m_lastTime = 0;
+    m_moves = 0;
+    m_inMove = false;
+    writeKeyframe(KEYFRAME_START);
+}
+
+void ReplayRecorder::beginMove(const Move& move, uint32_t now) {
+    if (!recording()) return;
+    m_inMove = true;
+    m_overflow = false;
+    m_moveTime = now - m_startTime;
+    m_bitCount = 0;
+    memset(m_bits, 0, sizeof(m_bits));
+    writeBits((uint32_t)moveToAction(move), 7);
+}
+
+void ReplayRecorder::endMove(bool accepted) {
+    if (!m_inMove) return;
+    m_inMove = false;
+    if (!accepted) return;
+
+    writeBits(0, 1);
+    ++m_moves;
+    if (m_overflow) {
+        m_lastTime = m_moveTime;
+        writeKeyframe(KEYFRAME_OVERFLOW);
+        return;
+    }
+
+    uint32_t dt = m_moveTime - m_lastTime;
+    size_t bytes = (m_bitCount + 7) / 8;
+    size_t payloadSize = varintSize(dt) + bytes;
+    uint8_t* out = m_feed.reserve(1 + MAX_VARINT + payloadSize);
+    if (!out) return; // Feed đầy, phần còn lại của ván không được ghi
+
+    size_t size = 0;
+    out[size++] = REPLAY_MOVE;
+    size += putVarint(out + size, (uint32_t)payloadSize);
+    size += putVarint(out + size, dt);
+    memcpy(out + size, m_bits, bytes);
+    size += bytes;
+    m_feed.commit(size, false);
+    m_lastTime = m_moveTime;
+
+    if (++m_movesSinceKeyframe >= REPLAY_KEYFRAME_INTERVAL) {
+        writeKeyframe(KEYFRAME_PERIODIC);
+    }
+}
+
+void ReplayRecorder::keyframe(KeyframeReason reason, uint32_t now) {
+    if (!recording() || m_inMove) return;
+    m_lastTime = now - m_startTime;
+    writeKeyframe(reason);
+}
+
+void ReplayRecorder::end(ReplayResult result, uint32_t now) {
+    if (!recording()) return;
+    m_inMove = false;
+
+    uint32_t time = now - m_startTime;
+    uint8_t payload[1 + 2 * MAX_VARINT];
+    size_t payloadSize = putVarint(payload, time - m_lastTime);
+    payload[payloadSize++] = result;
+    payloadSize += putVarint(payload + payloadSize, (uint32_t)std::max(0, m_engine->score));
+
+    uint8_t* out = m_feed.reserve(1 + MAX_VARINT + payloadSize);
+    if (out) {
+        size_t size = 0;
+        out[size++] = REPLAY_END;
+        size += putVarint(out + size, (uint32_t)payloadSize);
+        memcpy(out + size, payload, payloadSize);
+        m_feed.commit(size + payloadSize, false);
+    }
+    m_lastTime = time;
+    m_engine = nullptr;
+}
+
+void ReplayRecorder::writeKeyframe(KeyframeReason reason) {
+    uint8_t payload[3 * MAX_VARINT + 1 + SNAPSHOT_CELL_BYTES];
+    size_t payloadSize = putVarint(payload, m_moves);
+    payloadSize += putVarint(payload + payloadSize, m_lastTime);
+    payload[payloadSize++] = reason;
+    packCells(m_engine->cells, payload + payloadSize);
+    payloadSize += SNAPSHOT_CELL_BYTES;
+    payloadSize += putVarint(payload + payloadSize, (uint32_t)std::max(0, m_engine->score));
+
+    uint8_t* out = m_feed.reserve(1 + MAX_VARINT + payloadSize);
+    if (!out) return;
+    size_t size = 0;
+    out[size++] = REPLAY_KEYFRAME;
+    size += putVarint(out + size, (uint32_t)payloadSize);
+    memcpy(out + size, payload, payloadSize);
+    m_feed.commit(size + payloadSize, true);
+    m_movesSinceKeyframe = 0;
+}
+
+void ReplayRecorder::writeBits(uint32_t value, int count) {
+    if (m_bitCount + count > sizeof(m_bits) * 8) {
+        m_overflow = true;
+        return;
+    }
+    for (int i = 0; i < count; ++i, ++m_bitCount) {
+        if ((value >> i) & 1) {
+            m_bits[m_bitCount >> 3] |= (uint8_t)(1 << (m_bitCount & 7));
+        }
+    }
+}
+
+void ReplayRecorder::writeGamma(uint32_t value) {
+    int length = 0;
+    while ((value >> length) > 1) ++length;
+    writeBits(0, length);
+    for (int i = length; i >= 0; --i) {
+        writeBits((value >> i) & 1, 1);
+    }
+}
+
+void ReplayRecorder::onScore(const ScoreEvent& event) {
+    if (!m_inMove) return;
+    m_stepPoints = event.points;
+    m_stepMask = 0;
+    m_specialCount = 0;
+}
+
+void ReplayRecorder::onMatchesRemoved(const bool matched[BOARD_SIZE][BOARD_SIZE]) {
+    if (!m_inMove) return;
+    const bool* flat = &matched[0][0];
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+        if (flat[i]) m_stepMask |= cellBit(i);
+    }
+}
+
+void ReplayRecorder::onSpecialSpawned(int cell, int value) {
+    if (!m_inMove || m_specialCount == MAX_RUNS) return;
+    m_specials[m_specialCount][0] = (int8_t)cell;
+    m_specials[m_specialCount][1] = (int8_t)value;
+    ++m_specialCount;
+}
+
+void ReplayRecorder::onJewelsDropped(const int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]) {
+    if (m_inMove) flushStep();
+}
+
+void ReplayRecorder::flushStep() {
+    writeBits(1, 1);
+
+    // Ô bị ăn hầu hết là hàng 3-5 thẳng, nên tách thành đoạn; bom màu ăn rải rác thì mặt nạ thô rẻ hơn
+    int8_t segments[BOARD_SIZE * BOARD_SIZE][3];
+    int segmentCount = 0;
+    uint64_t remaining = m_stepMask;
+    while (remaining) {
+        int cell = 0;
+        while (!(remaining & cellBit(cell))) ++cell;
+        int x = cell % BOARD_SIZE, y = cell / BOARD_SIZE;
+        int across = 1, down = 1;
+        while (x + across < BOARD_SIZE && (remaining & cellBit(cell + across))) ++across;
+        while (y + down < BOARD_SIZE && (remaining & cellBit(cell + down * BOARD_SIZE))) ++down;
+        bool vertical = down > across;
+        int length = vertical ? down : across;
+        for (int i = 0; i < length; ++i) {
+            remaining &= ~cellBit(cell + i * (vertical ? BOARD_SIZE : 1));
+        }
+        segments[segmentCount][0] = (int8_t)cell;
+        segments[segmentCount][1] = vertical ? 1 : 0;
+        segments[segmentCount][2] = (int8_t)length;
+        ++segmentCount;
+    }
+
+    if (segmentCount == 0 || gammaBits(segmentCount) + 10 * segmentCount >= 64) {
+        writeBits(1, 1);
+        writeBits((uint32_t)m_stepMask, 32);
+        writeBits((uint32_t)(m_stepMask >> 32), 32);
+    } else {
+        writeBits(0, 1);
+        writeGamma(segmentCount);
+        for (int i = 0; i < segmentCount; ++i) {
+            writeBits(segments[i][0], 6);
+            writeBits(segments[i][1], 1);
+            writeBits(segments[i][2] - 1, 3);
+        }
+    }
+
+    uint64_t spawnedInCleared = 0;
+    writeBits(m_specialCount > 0 ? 1 : 0, 1);
+    if (m_specialCount > 0) {
+        writeGamma(m_specialCount);
+        for (int i = 0; i < m_specialCount; ++i) {
+            writeBits(m_specials[i][0], 6);
+            writeBits(m_specials[i][1], 4);
+            spawnedInCleared |= cellBit(m_specials[i][0]) & m_stepMask;
+        }
+    }
+
+    if (m_stepPoints == matchPoints(popCount(m_stepMask))) {
+        writeBits(0, 1);
+    } else {
+        writeBits(1, 1);
+        writeGamma((uint32_t)std::max(0, m_stepPoints) + 1);
+    }
+
+    // Số viên mới mỗi cột = số ô trống sau khi ăn và đặt đá đặc biệt; người xem tự đếm được
+    uint32_t group = 0, scale = 1;
+    int grouped = 0;
+    uint64_t empty = m_stepMask & ~spawnedInCleared;
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        int refills = 0;
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            if (empty & cellBit(y * BOARD_SIZE + x)) ++refills;
+        }
+        for (int y = 0; y < refills; ++y) {
+            int value = m_engine->cells[y][x];
+            if (value < 0 || value >= NUM_JEWEL_TYPES) {
+                m_overflow = true; // Đá mới rơi xuống luôn là đá thường; khác thì ghi keyframe cho chắc
+                value = 0;
+            }
+            group += value * scale;
+            scale *= NUM_JEWEL_TYPES;
+            if (++grouped == 3) {
+                writeBits(group, 8);
+                group = 0;
+                scale = 1;
+                grouped = 0;
+            }
+        }
+    }
+    if (grouped > 0) {
+        writeBits(group, grouped == 1 ? 3 : 6);
+    }
+}
+
+ReplayPlayer::ReplayPlayer() {
+    memset(cells, -1, sizeof(cells));
+}
+
+bool ReplayPlayer::apply(const ReplayRecord& record) {
+    const uint8_t* data = record.payload;
+    const uint8_t* end = data + record.size;
+    uint32_t value;
+
+    if (record.type == REPLAY_KEYFRAME) {
+        uint32_t index, time;
+        if (!getVarint(data, end, index) || !getVarint(data, end, time) || end - data < 1 + SNAPSHOT_CELL_BYTES) {
+            return false;
+        }
+        uint8_t reason = data[0];
+        const uint8_t* packed = data + 1;
+        data += 1 + SNAPSHOT_CELL_BYTES;
+        if (!cellsValid(packed) || !getVarint(data, end, value)) {
+            return false;
+        }
+
+        int8_t keyCells[BOARD_SIZE][BOARD_SIZE];
+        unpackCells(packed, keyCells);
+        // Chỉ keyframe định kỳ phải trùng bàn đang có; tráo, undo... thì bàn đổi thật
+        if (synced && reason == KEYFRAME_PERIODIC && (memcmp(keyCells, cells, sizeof(cells)) != 0 || score != (int)value)) {
+            ++keyframeMismatches;
+        }
+        memcpy(cells, keyCells, sizeof(cells));
+        score = (int)value;
+        moveIndex = index;
+        timeMs = time;
+        lastAction = -1;
+        lastCascadeDepth = 0;
+        synced = true;
+        return true;
+    }
+
+    if (record.type == REPLAY_MOVE) {
+        if (!getVarint(data, end, value)) return false;
+        timeMs += value;
+        ++moveIndex;
+        if (!synced) return true; // Chưa có keyframe, chưa dựng được bàn
+        return applyMove(data, end - data);
+    }
+
+    if (record.type == REPLAY_END) {
+        if (!getVarint(data, end, value) || data == end) return false;
+        timeMs += value;
+        result = *data++;
+        if (!getVarint(data, end, value)) return false;
+        if (synced && score != (int)value) {
+            ++keyframeMismatches;
+        }
+        score = (int)value;
+        ended = true;
+        return true;
+    }
+
+    return true; // Kiểu record mới hơn bản này: bỏ qua
+}
+
+bool ReplayPlayer::applyMove(const uint8_t* payload, size_t size) {
+    BitReader bits(payload, size);
+    lastAction = (int)bits.read(7);
+    lastCascadeDepth = 0;
+
+    Move move;
+    if (!actionToMove(lastAction, move)) return false;
+    std::swap(cells[move.y1][move.x1], cells[move.y2][move.x2]);
+
+    int8_t* flat = &cells[0][0];
+    while (!bits.failed && bits.read(1)) {
+        uint64_t mask = 0;
+        if (bits.read(1)) {
+            mask = bits.read(32);
+            mask |= (uint64_t)bits.read(32) << 32;
+        } else {
+            uint32_t segmentCount = bits.readGamma();
+            for (uint32_t i = 0; i < segmentCount && !bits.failed; ++i) {
+                int cell = (int)bits.read(6);
+                bool vertical = bits.read(1) != 0;
+                int length = (int)bits.read(3) + 1;
+                int last = vertical ? cell / BOARD_SIZE + length - 1 : cell % BOARD_SIZE + length - 1;
+                if (last >= BOARD_SIZE) return false;
+                for (int j = 0; j < length; ++j) {
+                    mask |= cellBit(cell + j * (vertical ? BOARD_SIZE : 1));
+                }
+            }
+        }
+
+        for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; ++i) {
+            if (mask & cellBit(i)) flat[i] = -1;
+        }
+
+        if (bits.read(1)) {
+            uint32_t specialCount = bits.readGamma();
+            for (uint32_t i = 0; i < specialCount && !bits.failed; ++i) {
+                int cell = (int)bits.read(6);
+                int value = (int)bits.read(4);
+                if (value >= NUM_CELL_VALUES) return false;
+                flat[cell] = (int8_t)value;
+            }
+        }
+
+        score += bits.read(1) ? (int)bits.readGamma() - 1 : matchPoints(popCount(mask));
+
+        int empty[BOARD_SIZE];
+        compactColumns(cells, empty);
+        int8_t refills[BOARD_SIZE * BOARD_SIZE];
+        int total = 0;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            total += empty[x];
+        }
+        for (int i = 0; i < total; i += 3) {
+            int grouped = std::min(3, total - i);
+            uint32_t group = bits.read(grouped == 3 ? 8 : (grouped == 2 ? 6 : 3));
+            for (int j = 0; j < grouped; ++j) {
+                refills[i + j] = (int8_t)(group % NUM_JEWEL_TYPES);
+                group /= NUM_JEWEL_TYPES;
+            }
+        }
+        int next = 0;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            for (int y = 0; y < empty[x]; ++y) {
+                cells[y][x] = refills[next++];
+            }
+        }
+        ++lastCascadeDepth;
+    }
+    return !bits.failed;
+}
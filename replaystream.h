@@ -0,0 +1,197 @@
+#ifndef REPLAYSTREAM_H
+#define REPLAYSTREAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "board.h"
+
+// Luồng replay/spectator "JLRP": mỗi nước đi là một delta nhỏ, bàn đầy đủ chỉ có ở keyframe.
+// File .jlrp chính là ảnh byte của ReplayFeed: 16 byte header rồi các record, chia thành chunk 4 KB,
+// record không bao giờ vắt qua hai chunk (phần thừa cuối chunk bắt đầu bằng REPLAY_PAD).
+//
+// Header: u32 magic, u8 version, u8 mode (ReplayMode), i8 timedLevel, u8 keyframeInterval, u64 thời điểm tạo (unix, giây)
+// Record: [u8 kiểu][varint độ dài payload][payload]
+//   KEYFRAME varint moveIndex, varint timeMs (từ đầu ván), u8 reason, 32 byte packCells, varint score
+//   MOVE     varint dtMs (từ record trước), rồi chuỗi bit (LSB trước):
+//            7 bit action (moveToAction), sau đó mỗi lượt ăn của cascade:
+//              1 bit "còn lượt", 1 bit kiểu ô bị ăn: 0 = danh sách đoạn thẳng, 1 = mặt nạ 64 bit
+//                đoạn: gamma(số đoạn), mỗi đoạn 6 bit ô đầu, 1 bit dọc, 3 bit (độ dài - 1)
+//              1 bit có đá đặc biệt: gamma(số viên), mỗi viên 6 bit ô, 4 bit giá trị
+//              1 bit điểm khác matchPoints(số ô ăn): gamma(điểm + 1)
+//              đá mới rơi vào: số viên mỗi cột suy ra từ số ô trống, giá trị 0..5 gói 3 viên vào 8 bit (cơ số 6),
+//              theo cột tăng dần, trong cột từ trên xuống
+//            rồi 1 bit 0 kết thúc
+//   END      varint dtMs, u8 result (ReplayResult), varint score
+// Người xem áp một lượt ăn: xóa ô theo mặt nạ, đặt đá đặc biệt, dồn từng cột xuống, lấp ô trống trên cùng.
+const uint32_t REPLAY_MAGIC = 0x50524C4A; // "JLRP"
+const uint8_t REPLAY_VERSION = 1;
+const size_t REPLAY_HEADER_SIZE = 16;
+const size_t REPLAY_CHUNK_SIZE = 4096;
+const int MAX_REPLAY_CHUNKS = 1024;     // 4 MB mỗi feed, một ván 20 phút chỉ dùng vài KB
+const size_t MAX_REPLAY_RECORD = 1024;  // Nước đi dài hơn (cascade cực sâu) được ghi thành keyframe
+const int REPLAY_KEYFRAME_INTERVAL = 64; // Nước đi giữa hai keyframe định kỳ, người xem vào giữa chừng chờ tối đa chừng này
+
+enum ReplayRecordType : uint8_t {
+    REPLAY_PAD = 0, // Bỏ qua tới đầu chunk kế tiếp
+    REPLAY_KEYFRAME = 1,
+    REPLAY_MOVE = 2,
+    REPLAY_END = 3
+};
+
+enum ReplayMode : uint8_t {
+    REPLAY_MODE_NORMAL = 0,
+    REPLAY_MODE_PRACTICE = 1,
+    REPLAY_MODE_TIMED = 2
+};
+
+enum KeyframeReason : uint8_t {
+    KEYFRAME_START = 0,
+    KEYFRAME_PERIODIC = 1,
+    KEYFRAME_SHUFFLE = 2, // Tráo dùng rng của bàn, người xem không tự tính lại được
+    KEYFRAME_RESTORE = 3, // Undo/redo/load save
+    KEYFRAME_OVERFLOW = 4 // Nước đi không vừa MAX_REPLAY_RECORD
+};
+
+enum ReplayResult : uint8_t {
+    REPLAY_QUIT = 0,
+    REPLAY_WON = 1,
+    REPLAY_LOST = 2
+};
+
+struct ReplayHeader {
+    uint8_t version;
+    uint8_t mode;
+    int8_t timedLevel;
+    uint8_t keyframeInterval;
+    uint64_t createdAt;
+};
+
+// Bộ đệm chung một ghi, nhiều đọc, chỉ nối thêm. Người đọc lấy offset đã commit (acquire) rồi đọc thẳng
+// trong chunk, không copy và không khóa; chunk không bao giờ bị dời hay giải phóng khi còn người đọc.
+class ReplayFeed {
+public:
+    ReplayFeed();
+
+    ReplayFeed(const ReplayFeed&) = delete;
+    ReplayFeed& operator=(const ReplayFeed&) = delete;
+
+    // Thread ghi
+    void reset(const ReplayHeader& header); // Chỉ gọi khi không còn ai đọc
+    uint8_t* reserve(size_t maxSize);       // Vùng ghi liền trong một chunk, nullptr nếu feed đầy
+    void commit(size_t size, bool keyframe);
+
+    // Thread đọc
+    uint32_t committed() const { return m_committed.load(std::memory_order_acquire); }
+    const uint8_t* at(uint32_t offset) const { return m_chunks[offset / REPLAY_CHUNK_SIZE].get() + offset % REPLAY_CHUNK_SIZE; }
+    uint32_t latestKeyframe() const; // Offset keyframe mới nhất, 0 nếu chưa có
+    bool header(ReplayHeader& header) const;
+
+    std::vector<uint8_t> image() const; // Ảnh file .jlrp tới offset đã commit
+    bool load(const std::string& filePath);
+
+private:
+    uint8_t* chunk(int index);
+
+    std::unique_ptr<uint8_t[]> m_chunks[MAX_REPLAY_CHUNKS];
+    uint32_t m_writeOffset; // Chỉ thread ghi dùng
+    std::atomic<uint32_t> m_committed;
+    std::atomic<uint32_t> m_latestKeyframe;
+};
+
+struct ReplayRecord {
+    uint8_t type;
+    const uint8_t* payload; // Trỏ thẳng vào chunk của feed
+    size_t size;
+    uint32_t offset;
+};
+
+// Vị trí đọc của một người xem: chỉ là offset, nên một core theo được rất nhiều người xem
+class ReplayCursor {
+public:
+    explicit ReplayCursor(const ReplayFeed& feed, uint32_t offset = REPLAY_HEADER_SIZE) : m_feed(&feed), m_offset(offset) {}
+
+    bool next(ReplayRecord& record); // false nếu chưa có record mới hoặc dữ liệu hỏng
+    void seek(uint32_t offset) { m_offset = offset; }
+    uint32_t offset() const { return m_offset; }
+    bool corrupt() const { return m_corrupt; }
+
+private:
+    const ReplayFeed* m_feed;
+    uint32_t m_offset;
+    bool m_corrupt = false;
+};
+
+// Ghi một ván vào feed. JewelGame chuyển tiếp sự kiện của BoardEngine sang đây giữa beginMove/endMove.
+class ReplayRecorder : public BoardListener {
+public:
+    explicit ReplayRecorder(ReplayFeed& feed) : m_feed(feed) {}
+
+    void begin(const BoardEngine& engine, const ReplayHeader& header, uint32_t now);
+    bool recording() const { return m_engine != nullptr; }
+
+    void beginMove(const Move& move, uint32_t now);
+    void endMove(bool accepted); // Nước đi không hợp lệ thì bỏ
+    void keyframe(KeyframeReason reason, uint32_t now);
+    void end(ReplayResult result, uint32_t now);
+
+    uint32_t moveCount() const { return m_moves; }
+
+    void onMatchesRemoved(const bool matched[BOARD_SIZE][BOARD_SIZE]) override;
+    void onSpecialSpawned(int cell, int value) override;
+    void onJewelsDropped(const int8_t dropDistance[BOARD_SIZE][BOARD_SIZE]) override;
+    void onScore(const ScoreEvent& event) override;
+
+private:
+    void writeKeyframe(KeyframeReason reason);
+    void writeBits(uint32_t value, int count);
+    void writeGamma(uint32_t value);
+    void flushStep();
+
+    ReplayFeed& m_feed;
+    const BoardEngine* m_engine = nullptr;
+    uint32_t m_startTime = 0;
+    uint32_t m_lastTime = 0;  // ms từ đầu ván của record trước
+    uint32_t m_moves = 0;
+    uint32_t m_movesSinceKeyframe = 0;
+
+    // Nước đi đang ghi: chuỗi bit trong bộ đệm riêng, chỉ vào feed khi endMove
+    bool m_inMove = false;
+    bool m_overflow = false;
+    uint32_t m_moveTime = 0;
+    uint8_t m_bits[MAX_REPLAY_RECORD];
+    size_t m_bitCount = 0;
+
+    // Lượt ăn đang ghi (giữa onScore và onJewelsDropped)
+    int m_stepPoints = 0;
+    uint64_t m_stepMask = 0;
+    int m_specialCount = 0;
+    int8_t m_specials[MAX_RUNS][2];
+};
+
+// Dựng lại bàn từ các record. Người xem vào giữa chừng bỏ qua MOVE cho tới keyframe đầu tiên.
+class ReplayPlayer {
+public:
+    int8_t cells[BOARD_SIZE][BOARD_SIZE];
+    int score = 0;
+    uint32_t timeMs = 0;
+    uint32_t moveIndex = 0;
+    bool synced = false;
+    bool ended = false;
+    uint8_t result = REPLAY_QUIT;
+    int lastAction = -1;     // Nước đi vừa áp dụng, để vẽ hoạt ảnh
+    int lastCascadeDepth = 0;
+    int keyframeMismatches = 0; // Keyframe định kỳ khác bàn đã dựng lại: luồng hỏng hoặc engine đổi luật
+
+    ReplayPlayer();
+    bool apply(const ReplayRecord& record); // false nếu record hỏng
+
+private:
+    bool applyMove(const uint8_t* payload, size_t size);
+};
+
+#endif
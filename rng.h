@@ -0,0 +1,42 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// PCG32 (XSH RR). Trạng thái chỉ 8 byte nên chụp/khôi phục cùng GameSnapshot được,
+// và cho kết quả giống nhau trên mọi compiler (khác std::uniform_int_distribution).
+class JewelRng {
+public:
+    typedef uint32_t result_type;
+
+    explicit JewelRng(uint64_t seedValue = 0x853C49E6748FEA9BULL) { seed(seedValue); }
+
+    void seed(uint64_t seedValue) {
+        m_state = 0;
+        (*this)();
+        m_state += seedValue;
+        (*this)();
+    }
+
+    uint32_t operator()() {
+        uint64_t old = m_state;
+        m_state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // Số nguyên trong [0, n)
+    int below(int n) { return (int)(((uint64_t)(*this)() * (uint32_t)n) >> 32); }
+
+    uint64_t state() const { return m_state; }
+    void setState(uint64_t state) { m_state = state; }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+private:
+    uint64_t m_state;
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "rollback.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+VersusMatch::VersusMatch(uint64_t seed, int targetScore) : targetScore(targetScore), winner(-1), winnerFrame(0) {
+    // Cùng seed nên hai bàn giống hệt nhau lúc đầu
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        boards[player].rng.seed(seed);
+        boards[player].initBoard();
+    }
+}
+
+unsigned VersusMatch::step(const uint8_t inputs[VERSUS_PLAYERS], uint32_t frame) {
+    if (winner >= 0) return 0; // Ván đã xong, trạng thái đứng yên
+
+    unsigned applied = 0;
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        Move move;
+        if (inputs[player] == VERSUS_NO_INPUT || !actionToMove(inputs[player], move)) continue;
+
+        BoardEngine& board = boards[player];
+        if (board.trySwap(move.x1, move.y1, move.x2, move.y2)) {
+            applied |= 1u << player;
+            // Không có nút shuffle trong versus: hết nước thì tráo ngay, vẫn tất định vì dùng rng của bàn
+            Move moves[MAX_MOVES];
+            while (board.listMoves(moves) == 0) {
+                board.shuffle();
+            }
+        }
+    }
+
+    bool reached[VERSUS_PLAYERS];
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        reached[player] = boards[player].score >= targetScore;
+    }
+    if (reached[0] && reached[1]) {
+        winner = boards[0].score == boards[1].score ? VERSUS_DRAW : (boards[0].score > boards[1].score ? 0 : 1);
+    } else if (reached[0] || reached[1]) {
+        winner = reached[0] ? 0 : 1;
+    }
+    if (winner >= 0) {
+        winnerFrame = frame;
+    }
+    return applied;
+}
+
+void VersusMatch::save(VersusFrameState& state) const {
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        boards[player].capture(state.boards[player]);
+    }
+    state.winner = winner;
+    state.winnerFrame = winnerFrame;
+}
+
+void VersusMatch::load(const VersusFrameState& state) {
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        boards[player].restore(state.boards[player]);
+    }
+    winner = state.winner;
+    winnerFrame = state.winnerFrame;
+}
+
+RollbackSession::RollbackSession(uint64_t seed, int targetScore, int localPlayer, int inputDelay)
+    : m_match(seed, targetScore), m_localPlayer(localPlayer),
+      m_inputDelay((uint32_t)std::max(0, std::min(inputDelay, MAX_INPUT_DELAY))), m_listener(nullptr),
+      m_frame(0), m_remoteConfirmed(0), m_rollbackFrom(0), m_pendingLocal(VERSUS_NO_INPUT) {
+    memset(m_inputs, VERSUS_NO_INPUT, sizeof(m_inputs));
+    memset(m_localIssued, 0, sizeof(m_localIssued));
+    memset(m_states, 0, sizeof(m_states));
+}
+
+void RollbackSession::addRemoteInput(uint32_t frame, uint8_t action) {
+    // Không ghi đè slot của frame còn có thể phải tua lại
+    if (frame != m_remoteConfirmed || frame >= m_frame + VERSUS_RING - ROLLBACK_WINDOW) return;
+
+    m_inputs[1 - m_localPlayer][frame % VERSUS_RING] = action;
+    ++m_remoteConfirmed;
+    // Đã đoán "không làm gì" cho frame này: chỉ sai khi đối thủ thực sự đi
+    if (frame < m_frame && action != VERSUS_NO_INPUT) {
+        m_rollbackFrom = std::min(m_rollbackFrom, frame);
+    }
+}
+
+bool RollbackSession::canAdvance() const {
+    return m_frame < m_remoteConfirmed + ROLLBACK_WINDOW;
+}
+
+uint8_t RollbackSession::inputFor(int player, uint32_t frame) const {
+    if (player != m_localPlayer && frame >= m_remoteConfirmed) {
+        return VERSUS_NO_INPUT; // Dự đoán
+    }
+    return m_inputs[player][frame % VERSUS_RING];
+}
+
+void RollbackSession::simulate(uint32_t frame, bool resimulating) {
+    m_match.save(m_states[frame % VERSUS_RING]);
+
+    uint8_t inputs[VERSUS_PLAYERS];
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        inputs[player] = inputFor(player, frame);
+    }
+
+    // Nước đi cục bộ vẫn có thể bị tua lại mất: đối thủ thực ra đã thắng ở frame trước nên ván dừng sớm hơn.
+    // Sự kiện (âm thanh, hoạt ảnh) của mỗi frame chỉ phát một lần; tua lại mà nước đó không còn thì báo
+    // onMoveRolledBack để bỏ hiệu ứng, còn nước mới xuất hiện khi tua lại thì phát lúc đó.
+    bool& issued = m_localIssued[frame % VERSUS_RING];
+    if (!resimulating) {
+        issued = false;
+    }
+    BoardEngine& local = m_match.boards[m_localPlayer];
+    local.listener = issued ? nullptr : m_listener;
+    bool applied = (m_match.step(inputs, frame) >> m_localPlayer) & 1;
+    local.listener = nullptr;
+
+    if (m_listener && issued != applied) {
+        if (applied) {
+            m_listener->onMoveApplied();
+        } else {
+            m_listener->onMoveRolledBack();
+        }
+    }
+    issued = applied;
+}
+
+bool RollbackSession::advance() {
+    if (!canAdvance()) {
+        ++m_stats.stalls;
+        return false;
+    }
+
+    int depth = (int)(m_frame - m_rollbackFrom);
+    if (depth > 0) {
+        auto start = std::chrono::steady_clock::now();
+        m_match.load(m_states[m_rollbackFrom % VERSUS_RING]);
+        for (uint32_t frame = m_rollbackFrom; frame < m_frame; ++frame) {
+            simulate(frame, true);
+        }
+        m_stats.lastResimMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        m_stats.lastDepth = depth;
+        ++m_stats.rollbacks;
+        m_stats.framesResimulated += depth;
+        m_stats.maxDepth = std::max(m_stats.maxDepth, depth);
+        ++m_stats.depthCounts[std::min(depth, ROLLBACK_WINDOW)];
+        m_stats.resimMs.record(m_stats.lastResimMs);
+    }
+
+    // Chốt input cục bộ cho frame + inputDelay, từ đây nó được gửi đi và không đổi nữa
+    m_inputs[m_localPlayer][(m_frame + m_inputDelay) % VERSUS_RING] = m_pendingLocal;
+    m_pendingLocal = VERSUS_NO_INPUT;
+
+    simulate(m_frame, false);
+    ++m_frame;
+    m_rollbackFrom = m_frame;
+    ++m_stats.framesSimulated;
+    return true;
+}
+
+void RollbackSession::report(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "[rollback] frames " << m_stats.framesSimulated << ", rollbacks " << m_stats.rollbacks
+        << ", resimulated " << m_stats.framesResimulated << " frames, stalls " << m_stats.stalls << std::endl;
+    if (m_stats.rollbacks > 0) {
+        out << "[rollback] depth mean " << (double)m_stats.framesResimulated / m_stats.rollbacks
+            << " max " << m_stats.maxDepth << " frames; resim cost p50 " << m_stats.resimMs.percentile(0.50)
+            << " ms p99 " << m_stats.resimMs.percentile(0.99) << " ms max " << m_stats.resimMs.max() << " ms" << std::endl;
+        out << "[rollback] depth:";
+        for (int depth = 1; depth <= ROLLBACK_WINDOW; ++depth) {
+            if (m_stats.depthCounts[depth] > 0) {
+                out << " " << depth << "x" << m_stats.depthCounts[depth];
+            }
+        }
+        out << std::endl;
+    }
+    out.flags(flags);
+}
@@ -0,0 +1,108 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "board.h"
+#include "gamesnapshot.h"
+#include "latencyprofiler.h"
+
+// Versus mode: hai bàn cùng seed, ai đạt targetScore trước thì thắng.
+// Mỗi frame mỗi người chơi có tối đa một input (action của moveToAction hoặc VERSUS_NO_INPUT).
+const int VERSUS_PLAYERS = 2;
+const uint8_t VERSUS_NO_INPUT = 0xFF;
+const int VERSUS_RING = 128;        // Số frame giữ input và trạng thái
+const int ROLLBACK_WINDOW = 32;     // Đi trước input xác nhận của đối thủ tối đa bấy nhiêu frame rồi dừng chờ
+const int MAX_INPUT_DELAY = 8;
+const int VERSUS_DRAW = VERSUS_PLAYERS; // Giá trị winner khi cả hai cùng đạt mục tiêu trong một frame, bằng điểm
+
+// Trạng thái đầu frame: đủ để tua lại. 2 GameSnapshot + vài byte, copy bằng memcpy.
+struct VersusFrameState {
+    GameSnapshot boards[VERSUS_PLAYERS];
+    int32_t winner;      // -1 khi chưa ai thắng
+    uint32_t winnerFrame;
+};
+
+// Luật của một ván đấu, tất định: cùng seed và cùng chuỗi input cho ra cùng kết quả trên mọi máy
+class VersusMatch {
+public:
+    VersusMatch(uint64_t seed, int targetScore);
+
+    // Trả về mặt nạ bit các người chơi có nước đi được áp dụng trong frame
+    unsigned step(const uint8_t inputs[VERSUS_PLAYERS], uint32_t frame);
+    void save(VersusFrameState& state) const;
+    void load(const VersusFrameState& state);
+
+    BoardEngine boards[VERSUS_PLAYERS];
+    int targetScore;
+    int winner;
+    uint32_t winnerFrame;
+};
+
+struct RollbackStats {
+    uint64_t framesSimulated = 0;
+    uint64_t framesResimulated = 0;
+    uint64_t rollbacks = 0;
+    uint64_t stalls = 0;          // Lần advance bị từ chối vì đối thủ tụt quá ROLLBACK_WINDOW
+    int maxDepth = 0;
+    int lastDepth = 0;            // Số frame tua lại ở lần rollback gần nhất
+    double lastResimMs = 0.0;     // Chi phí của lần đó
+    LatencyHistogram resimMs{0.001}; // Chi phí tua lại mỗi frame có rollback
+    uint64_t depthCounts[ROLLBACK_WINDOW + 1] = {}; // Số lần rollback theo số frame tua lại
+};
+
+// Rollback netcode cho một phía: đoán input đối thủ là "không làm gì" (nước đi của game xếp đá là sự kiện
+// đơn lẻ, lặp lại input cũ như game đối kháng sẽ luôn sai), giữ vòng trạng thái, tua lại khi input thật khác.
+// Không tự gửi/nhận mạng: VersusPeer đưa input vào và lấy input cục bộ ra để gửi.
+class RollbackSession {
+public:
+    RollbackSession(uint64_t seed, int targetScore, int localPlayer, int inputDelay);
+
+    // Nước đi của người chơi cục bộ, áp vào frame hiện tại + inputDelay (một nước mỗi frame, nước sau đè nước trước)
+    void setLocalInput(uint8_t action) { m_pendingLocal = action; }
+    // Input đối thủ cho frame; chỉ nhận theo thứ tự liền mạch, gói tới sớm bỏ qua vì sẽ được gửi lại
+    void addRemoteInput(uint32_t frame, uint8_t action);
+
+    bool canAdvance() const;
+    bool advance(); // Tua lại nếu cần rồi chạy một frame; false nếu phải chờ đối thủ
+
+    uint32_t frame() const { return m_frame; }                    // Frame sắp chạy
+    uint32_t localInputEnd() const { return m_frame + m_inputDelay; } // Input cục bộ đã chốt cho [0, localInputEnd)
+    uint8_t localInput(uint32_t frame) const { return m_inputs[m_localPlayer][frame % VERSUS_RING]; }
+    uint32_t remoteConfirmed() const { return m_remoteConfirmed; } // Đã có input thật của đối thủ cho [0, remoteConfirmed)
+
+    int localPlayer() const { return m_localPlayer; }
+    const BoardEngine& board(int player) const { return m_match.boards[player]; }
+    int targetScore() const { return m_match.targetScore; }
+    int winner() const { return m_match.winner; }
+    // Kết quả chỉ chắc chắn khi mọi input tới frame thắng đã xác nhận và không còn rollback đang chờ
+    bool resultConfirmed() const {
+        return m_match.winner >= 0 && m_match.winnerFrame < m_remoteConfirmed && m_rollbackFrom == m_frame;
+    }
+
+    void setListener(BoardListener* listener) { m_listener = listener; }
+    const RollbackStats& stats() const { return m_stats; }
+    void report(std::ostream& out) const;
+
+private:
+    uint8_t inputFor(int player, uint32_t frame) const;
+    void simulate(uint32_t frame, bool resimulating);
+
+    VersusMatch m_match;
+    int m_localPlayer;
+    uint32_t m_inputDelay;
+    BoardListener* m_listener;
+
+    uint8_t m_inputs[VERSUS_PLAYERS][VERSUS_RING];
+    bool m_localIssued[VERSUS_RING]; // Đã phát sự kiện cho nước đi cục bộ của frame này
+    VersusFrameState m_states[VERSUS_RING]; // m_states[f % VERSUS_RING]: trạng thái đầu frame f
+    uint32_t m_frame;
+    uint32_t m_remoteConfirmed;
+    uint32_t m_rollbackFrom; // Frame sớm nhất đoán sai, m_frame nếu không có
+    uint8_t m_pendingLocal;
+
+    RollbackStats m_stats;
+};
+
+#endif
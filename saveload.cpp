@@ -0,0 +1,252 @@
+#include "saveload.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const size_t HEADER_SIZE = 12;
+    const size_t PAYLOAD_SIZE = 8 + SNAPSHOT_CELL_BYTES + 4 + 4 + 2 + 4;
+
+    void putU32(unsigned char* out, uint32_t value) {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+        out[2] = (value >> 16) & 0xFF;
+        out[3] = (value >> 24) & 0xFF;
+    }
+
+    uint32_t getU32(const unsigned char* in) {
+        return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    }
+
+    void putU16(unsigned char* out, uint16_t value) {
+        out[0] = value & 0xFF;
+        out[1] = (value >> 8) & 0xFF;
+    }
+
+    uint16_t getU16(const unsigned char* in) {
+        return in[0] | (in[1] << 8);
+    }
+
+    void putU64(unsigned char* out, uint64_t value) {
+        putU32(out, (uint32_t)value);
+        putU32(out + 4, (uint32_t)(value >> 32));
+    }
+
+    uint64_t getU64(const unsigned char* in) {
+        return getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+    }
+
+    std::array<uint32_t, 256> makeCrcTable() {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }
+
+#ifndef _WIN32
+    // rename chỉ bền khi chính thư mục chứa file đã xuống đĩa
+    bool syncDirectory(const std::string& filePath) {
+        size_t slash = filePath.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : filePath.substr(0, slash));
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = fsync(fd) == 0;
+        close(fd);
+        return ok;
+    }
+#endif
+}
+
+// CRC-32 (IEEE). Gọi từ nhiều thread (AutoSaver, ghi dataset, ProfileStore) nên bảng dựng trong
+// khởi tạo static cục bộ, C++11 bảo đảm chỉ một thread dựng và các thread khác chờ
+uint32_t crc32(const void* data, size_t length) {
+    static const std::array<uint32_t, 256> table = makeCrcTable();
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool writeSaveFile(const std::string& filePath, const GameSnapshot& snapshot) {
+    unsigned char buffer[HEADER_SIZE + PAYLOAD_SIZE] = {};
+    unsigned char* payload = buffer + HEADER_SIZE;
+
+    // Ghi từng trường little-endian để file không phụ thuộc padding của struct
+    putU64(payload + 0, snapshot.rngState);
+    memcpy(payload + 8, snapshot.cells, SNAPSHOT_CELL_BYTES);
+    unsigned char* tail = payload + 8 + SNAPSHOT_CELL_BYTES;
+    putU32(tail + 0, snapshot.score);
+    putU32(tail + 4, snapshot.playerMoney);
+    putU16(tail + 8, snapshot.timeRemaining);
+    tail[10] = snapshot.combo;
+    tail[11] = snapshot.shuffleRemaining;
+    tail[12] = (uint8_t)snapshot.timedModeLevel;
+    tail[13] = snapshot.flags;
+
+    putU32(buffer + 0, SAVE_MAGIC);
+    putU16(buffer + 4, SAVE_VERSION);
+    putU16(buffer + 6, PAYLOAD_SIZE);
+    putU32(buffer + 8, crc32(payload, PAYLOAD_SIZE));
+
+    std::string tempPath = filePath + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Unable to open file for saving game state." << std::endl;
+        return false;
+    }
+
+    bool ok = fwrite(buffer, 1, sizeof(buffer), file) == sizeof(buffer) && fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) {
+        std::cerr << "Failed to write save file." << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    ok = MoveFileExA(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = rename(tempPath.c_str(), filePath.c_str()) == 0;
+#endif
+    if (!ok) {
+        std::cerr << "Failed to replace save file." << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+#ifndef _WIN32
+    // File mới đã thay chỗ; chỉ là chưa chắc còn sau khi mất điện, nên báo mà không coi là lỗi
+    if (!syncDirectory(filePath)) {
+        std::cerr << "Failed to sync save directory." << std::endl;
+    }
+#endif
+    return true;
+}
+
+bool readSaveFile(const std::string& filePath, GameSnapshot& snapshot) {
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    unsigned char buffer[HEADER_SIZE + PAYLOAD_SIZE + 1];
+    size_t length = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+
+    const unsigned char* payload = buffer + HEADER_SIZE;
+    if (length != HEADER_SIZE + PAYLOAD_SIZE ||
+        getU32(buffer + 0) != SAVE_MAGIC ||
+        getU16(buffer + 4) != SAVE_VERSION ||
+        getU16(buffer + 6) != PAYLOAD_SIZE ||
+        getU32(buffer + 8) != crc32(payload, PAYLOAD_SIZE)) {
+        std::cerr << "Save file is corrupt or from another version." << std::endl;
+        return false;
+    }
+
+    GameSnapshot loaded = {};
+    loaded.rngState = getU64(payload + 0);
+    memcpy(loaded.cells, payload + 8, SNAPSHOT_CELL_BYTES);
+    const unsigned char* tail = payload + 8 + SNAPSHOT_CELL_BYTES;
+    loaded.score = (int32_t)getU32(tail + 0);
+    loaded.playerMoney = (int32_t)getU32(tail + 4);
+    loaded.timeRemaining = (int16_t)getU16(tail + 8);
+    loaded.combo = tail[10];
+    loaded.shuffleRemaining = tail[11];
+    loaded.timedModeLevel = (int8_t)tail[12];
+    loaded.flags = tail[13];
+
+    if (!cellsValid(loaded.cells)) {
+        std::cerr << "Save file has an invalid jewel." << std::endl;
+        return false;
+    }
+
+    if (loaded.score < 0 || loaded.timeRemaining < 0 || loaded.shuffleRemaining > 3) {
+        std::cerr << "Save file has out-of-range values." << std::endl;
+        return false;
+    }
+
+    snapshot = loaded;
+    return true;
+}
+
+bool importLegacySave(const std::string& textPath, const std::string& filePath) {
+    FILE* existing = fopen(filePath.c_str(), "rb");
+    if (existing != nullptr) {
+        fclose(existing);
+        return false;
+    }
+    std::ifstream file(textPath);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Thứ tự của saveGameState bản cũ: điểm, high score, combo, shuffle, tiền, timed, thời gian còn, level,
+    // mốc bắt đầu timed, rồi 64 ô theo hàng. High score đã có file riêng, mốc thời gian tính lại khi tải.
+    int score, highScore, combo, shuffleRemaining, playerMoney, isTimedMode, timeRemaining, timedModeLevel;
+    long long timedModeStartTime;
+    file >> score >> highScore >> combo >> shuffleRemaining >> playerMoney >> isTimedMode >> timeRemaining >>
+        timedModeLevel >> timedModeStartTime;
+    int8_t board[BOARD_SIZE][BOARD_SIZE];
+    bool valid = (bool)file;
+    for (int y = 0; y < BOARD_SIZE && valid; ++y) {
+        for (int x = 0; x < BOARD_SIZE && valid; ++x) {
+            int value;
+            valid = (bool)(file >> value) && value >= -1 && value < NUM_CELL_VALUES;
+            board[y][x] = (int8_t)value;
+        }
+    }
+    if (!valid || score < 0 || playerMoney < 0 || combo < 0 || combo > 255 || shuffleRemaining < 0 ||
+        shuffleRemaining > 3 || timeRemaining < 0 || timeRemaining > INT16_MAX || timedModeLevel < -1 ||
+        timedModeLevel > INT8_MAX) {
+        std::cerr << "Legacy save " << textPath << " is corrupt, not imported." << std::endl;
+        return false;
+    }
+
+    GameSnapshot snapshot = {};
+    snapshot.rngState = ((uint64_t)std::random_device{}() << 32) | std::random_device{}(); // Bản cũ không lưu RNG
+    packCells(board, snapshot.cells);
+    snapshot.score = score;
+    snapshot.playerMoney = playerMoney;
+    snapshot.timeRemaining = isTimedMode ? (int16_t)timeRemaining : 0;
+    snapshot.combo = (uint8_t)combo;
+    snapshot.shuffleRemaining = (uint8_t)shuffleRemaining;
+    snapshot.timedModeLevel = isTimedMode ? (int8_t)timedModeLevel : -1;
+    snapshot.flags = isTimedMode ? SNAPSHOT_FLAG_TIMED : 0;
+    file.close();
+
+    if (!writeSaveFile(filePath, snapshot)) {
+        return false;
+    }
+    std::string importedPath = textPath + ".imported";
+    if (rename(textPath.c_str(), importedPath.c_str()) != 0) {
+        std::cerr << "Imported " << textPath << " but could not rename it." << std::endl;
+    }
+    std::cout << "Imported legacy save " << textPath << " into " << filePath << std::endl;
+    return true;
+}
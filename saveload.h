@@ -0,0 +1,22 @@
+#ifndef SAVELOAD_H
+#define SAVELOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "gamesnapshot.h"
+
+// File nhị phân: header (magic, version, kích thước, CRC32) + GameSnapshot (ô đá nén 4 bit).
+// Ghi ra file tạm rồi rename (và fsync thư mục) để file cũ luôn còn nguyên nếu mất điện giữa chừng.
+const uint32_t SAVE_MAGIC = 0x56534C4A; // "JLSV"
+const uint16_t SAVE_VERSION = 2;
+
+uint32_t crc32(const void* data, size_t length);
+bool writeSaveFile(const std::string& filePath, const GameSnapshot& snapshot);
+bool readSaveFile(const std::string& filePath, GameSnapshot& snapshot); // false nếu thiếu file hoặc hỏng
+// Chuyển save dạng chữ của bản cũ sang filePath một lần: chỉ khi filePath chưa có, xong thì đổi tên file cũ
+// thành textPath + ".imported". True nếu đã chuyển.
+bool importLegacySave(const std::string& textPath, const std::string& filePath);
+
+#endif
@@ -0,0 +1,42 @@
+#include "sessionprotocol.h"
+
+size_t encodeCellDelta(const int8_t before[BOARD_SIZE][BOARD_SIZE], const int8_t after[BOARD_SIZE][BOARD_SIZE],
+                       uint8_t* out) {
+    const int8_t* oldCells = &before[0][0];
+    const int8_t* newCells = &after[0][0];
+
+    uint64_t mask = 0;
+    size_t nibbles = 0;
+    uint8_t* values = out + 8;
+    for (int cell = 0; cell < BOARD_SIZE * BOARD_SIZE; ++cell) {
+        if (oldCells[cell] == newCells[cell]) continue;
+        mask |= 1ULL << cell;
+        uint8_t value = (uint8_t)(newCells[cell] + 1);
+        if (nibbles & 1) {
+            values[nibbles / 2] |= value << 4;
+        } else {
+            values[nibbles / 2] = value;
+        }
+        ++nibbles;
+    }
+
+    putU64(out, mask);
+    return 8 + (nibbles + 1) / 2;
+}
+
+size_t applyCellDelta(const uint8_t* in, size_t size, int8_t cells[BOARD_SIZE][BOARD_SIZE]) {
+    if (size < 8) return 0;
+    uint64_t mask = getU64(in);
+    size_t nibbles = __builtin_popcountll(mask);
+    size_t total = 8 + (nibbles + 1) / 2;
+    if (size < total) return 0;
+
+    int8_t* flat = &cells[0][0];
+    const uint8_t* values = in + 8;
+    for (size_t i = 0; mask != 0; ++i, mask &= mask - 1) {
+        int value = (values[i / 2] >> ((i & 1) * 4)) & 0xF;
+        if (value > NUM_CELL_VALUES) return 0;
+        flat[__builtin_ctzll(mask)] = (int8_t)(value - 1);
+    }
+    return total;
+}
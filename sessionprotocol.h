@@ -0,0 +1,99 @@
+#ifndef SESSIONPROTOCOL_H
+#define SESSIONPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "constants.h"
+
+// Giao thức nhị phân giữa jewelserver và client (little-endian).
+// Mỗi message: [u16 độ dài payload][u8 kiểu][payload]. Server trả lời theo đúng thứ tự nhận trên mỗi kết nối.
+//
+// Client -> server:
+//   START   u32 tag, u8 mode, u8 timedLevel, u64 seed (0 = server tự chọn)
+//   SWAP    u32 session, u8 action (moveToAction)
+//   SHUFFLE u32 session
+//   END     u32 session
+// Server -> client:
+//   STARTED u32 tag, u32 session, u8 status, u8 shuffles, u16 timeLimit (giây, 0 = không giới hạn), 32 byte packCells
+//   DELTA   u32 session, u8 status, u8 flags, u8 cascadeDepth, u8 shuffles, i32 score, u64 mặt nạ ô đổi,
+//           rồi giá trị mới của các ô đổi (4 bit mỗi ô, như packCells, theo thứ tự bit)
+//   ENDED   u32 session, u8 status, u8 won, i32 score, u32 moves
+const size_t MESSAGE_HEADER_SIZE = 3;
+const size_t MAX_MESSAGE_PAYLOAD = 64;
+const size_t DELTA_HEADER_SIZE = 4 + 4 + 4;                         // u32 session, 4 x u8 (status..shuffles), i32 score
+const size_t MAX_CELL_DELTA_SIZE = 8 + BOARD_SIZE * BOARD_SIZE / 2;  // Mặt nạ u64 + mọi ô đổi, 4 bit mỗi ô
+const size_t MAX_DELTA_PAYLOAD = DELTA_HEADER_SIZE + MAX_CELL_DELTA_SIZE;
+const size_t MAX_SERVER_MESSAGE = MESSAGE_HEADER_SIZE + MAX_DELTA_PAYLOAD;
+
+enum MessageType : uint8_t {
+    MSG_START = 1,
+    MSG_SWAP = 2,
+    MSG_SHUFFLE = 3,
+    MSG_END = 4,
+
+    MSG_STARTED = 0x81,
+    MSG_DELTA = 0x82,
+    MSG_ENDED = 0x83
+};
+
+enum SessionMode : uint8_t {
+    SESSION_NORMAL = 0,
+    SESSION_TIMED = 1 // timedLevel là chỉ số trong defaultTimedModeLevels()
+};
+
+enum SessionStatus : uint8_t {
+    STATUS_OK = 0,
+    STATUS_INVALID_MOVE,  // Nước đi không tạo được match, bàn không đổi
+    STATUS_NO_SHUFFLES,
+    STATUS_TIME_UP,       // Timed mode hết giờ, server gửi ENDED ngay sau
+    STATUS_NO_SESSION,    // Sai id hoặc session thuộc kết nối khác
+    STATUS_SERVER_FULL,
+    STATUS_BAD_REQUEST
+};
+
+const uint8_t DELTA_FLAG_NO_MOVES = 1; // Bàn sau nước đi không còn nước hợp lệ, cần SHUFFLE hoặc END
+
+inline void putU16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+inline void putU32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+inline void putU64(uint8_t* out, uint64_t value) {
+    putU32(out, (uint32_t)value);
+    putU32(out + 4, (uint32_t)(value >> 32));
+}
+
+inline uint16_t getU16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+inline uint64_t getU64(const uint8_t* in) {
+    return getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+}
+
+// Ghi header, trả về con trỏ tới payload
+inline uint8_t* beginMessage(uint8_t* out, MessageType type, size_t payloadSize) {
+    putU16(out, (uint16_t)payloadSize);
+    out[2] = type;
+    return out + MESSAGE_HEADER_SIZE;
+}
+
+// Mã hóa các ô khác nhau giữa before và after: u64 mặt nạ + 4 bit mỗi ô. Trả về số byte đã ghi.
+size_t encodeCellDelta(const int8_t before[BOARD_SIZE][BOARD_SIZE], const int8_t after[BOARD_SIZE][BOARD_SIZE],
+                       uint8_t* out);
+// Áp delta lên cells. Trả về số byte đã đọc, 0 nếu dữ liệu thiếu hoặc giá trị ô sai.
+size_t applyCellDelta(const uint8_t* in, size_t size, int8_t cells[BOARD_SIZE][BOARD_SIZE]);
+
+#endif
@@ -0,0 +1,284 @@
+#include "softrender.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTRENDER_SSE2 1
+#endif
+
+namespace {
+    // x / 255 làm tròn, x <= 255 * 255
+    inline uint32_t div255(uint32_t x) {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    inline uint32_t blendPixel(uint32_t dst, uint32_t src) {
+        uint32_t inv = 255 - (src >> 24);
+        // Hai kênh một lần: mỗi kênh nằm trong 16 bit riêng nên không tràn sang nhau
+        uint32_t rb = (dst & 0x00FF00FF) * inv + 0x00800080;
+        rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        uint32_t ag = ((dst >> 8) & 0x00FF00FF) * inv + 0x00800080;
+        ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+        return src + (rb | ag);
+    }
+
+    uint32_t premultiply(uint32_t pixel) {
+        uint32_t a = pixel >> 24;
+        uint32_t r = div255(((pixel >> 16) & 0xFF) * a);
+        uint32_t g = div255(((pixel >> 8) & 0xFF) * a);
+        uint32_t b = div255((pixel & 0xFF) * a);
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    }
+
+    uint32_t packColor(SDL_Color color) {
+        return 0xFF000000u | ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
+    }
+
+    // Scale kiểu nearest như SDL_RenderCopy trên renderer phần mềm, trả về ARGB8888 chưa premultiply
+    bool scaleSurface(SDL_Surface* source, int width, int height, std::vector<uint32_t>& pixels) {
+        SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!scaled) {
+            return false;
+        }
+        bool ok = SDL_BlitScaled(source, nullptr, scaled, nullptr) == 0 && SDL_LockSurface(scaled) == 0;
+        if (ok) {
+            pixels.resize((size_t)width * height);
+            for (int y = 0; y < height; ++y) {
+                memcpy(&pixels[(size_t)y * width], (const uint8_t*)scaled->pixels + (size_t)y * scaled->pitch,
+                       (size_t)width * sizeof(uint32_t));
+            }
+            SDL_UnlockSurface(scaled);
+        }
+        SDL_FreeSurface(scaled);
+        return ok;
+    }
+}
+
+void blendPremultiplied(uint32_t* dst, const uint32_t* src, int count) {
+    int i = 0;
+#ifdef SOFTRENDER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi32(255);
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i alpha = _mm_srli_epi32(s, 24);
+        int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, full));
+        if (opaque == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF) {
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i inv = _mm_sub_epi32(full, alpha);
+        inv = _mm_or_si128(inv, _mm_slli_epi32(inv, 16)); // 255 - a ở cả hai nửa 16 bit
+        __m128i invLo = _mm_unpacklo_epi32(inv, inv);
+        __m128i invHi = _mm_unpackhi_epi32(inv, inv);
+
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), invLo), half);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), invHi), half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        // Premultiplied nên src + phần còn lại của dst không vượt 255
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi8(s, _mm_packus_epi16(lo, hi)));
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t s = src[i];
+        if ((s >> 24) == 255) {
+            dst[i] = s;
+        } else if (s != 0) {
+            dst[i] = blendPixel(dst[i], s);
+        }
+    }
+}
+
+SoftRenderer::SoftRenderer() : m_spriteCount(0), m_background(nullptr), m_layer(nullptr), m_layerRect{0, 0, 0, 0},
+                               m_pixels(nullptr), m_pitch(0) {
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        m_sources[i] = nullptr;
+    }
+}
+
+SoftRenderer::~SoftRenderer() {
+    release();
+}
+
+bool SoftRenderer::isSoftware(SDL_Renderer* renderer) {
+    SDL_RendererInfo info;
+    return renderer && SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_SOFTWARE) != 0;
+}
+
+bool SoftRenderer::build(SDL_Renderer* renderer, SDL_Surface* const jewels[NUM_CELL_VALUES], SDL_Surface* background,
+                         SDL_Rect layer, SDL_Rect frame, SDL_Color frameColor) {
+    release();
+
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        m_sources[i] = jewels[i] ? SDL_ConvertSurfaceFormat(jewels[i], SDL_PIXELFORMAT_ARGB8888, 0) : nullptr;
+        if (!m_sources[i]) {
+            std::cerr << "Software path: cannot convert jewel " << i << ": " << SDL_GetError() << std::endl;
+            release();
+            return false;
+        }
+        SDL_SetSurfaceBlendMode(m_sources[i], SDL_BLENDMODE_NONE); // Scale giữ nguyên alpha
+    }
+
+    // Nền menu: scale một lần và trộn sẵn lên nền đen như SDL_RenderClear rồi RenderCopy
+    if (background) {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(background, SDL_PIXELFORMAT_ARGB8888, 0);
+        std::vector<uint32_t> pixels;
+        if (converted) {
+            SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+            if (scaleSurface(converted, SCREEN_WIDTH, SCREEN_HEIGHT, pixels)) {
+                for (uint32_t& pixel : pixels) {
+                    pixel = premultiply(pixel) | 0xFF000000u;
+                }
+                m_background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                                 SCREEN_WIDTH, SCREEN_HEIGHT);
+            }
+            SDL_FreeSurface(converted);
+        }
+        if (m_background) {
+            SDL_UpdateTexture(m_background, nullptr, pixels.data(), SCREEN_WIDTH * (int)sizeof(uint32_t));
+            SDL_SetTextureBlendMode(m_background, SDL_BLENDMODE_NONE);
+        }
+    }
+
+    m_layerRect = layer;
+    m_static.assign((size_t)layer.w * layer.h, 0xFF000000u);
+    SDL_Rect visible;
+    if (SDL_IntersectRect(&frame, &layer, &visible)) {
+        uint32_t color = packColor(frameColor);
+        for (int y = visible.y; y < visible.y + visible.h; ++y) {
+            uint32_t* row = &m_static[(size_t)(y - layer.y) * layer.w + (visible.x - layer.x)];
+            std::fill(row, row + visible.w, color);
+        }
+    }
+
+    m_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, layer.w, layer.h);
+    if (!m_layer) {
+        std::cerr << "Software path: cannot create board layer: " << SDL_GetError() << std::endl;
+        release();
+        return false;
+    }
+    SDL_SetTextureBlendMode(m_layer, SDL_BLENDMODE_NONE); // Lớp phủ kín vùng của nó
+
+    prepare(GRID_SIZE);
+    return true;
+}
+
+void SoftRenderer::prepare(int size) {
+    for (int value = 0; value < NUM_CELL_VALUES; ++value) {
+        sprite(value, size);
+    }
+}
+
+void SoftRenderer::release() {
+    for (int i = 0; i < NUM_CELL_VALUES; ++i) {
+        if (m_sources[i]) {
+            SDL_FreeSurface(m_sources[i]);
+            m_sources[i] = nullptr;
+        }
+        for (auto& variant : m_sprites[i]) {
+            variant.reset();
+        }
+    }
+    m_spriteCount = 0;
+    if (m_background) {
+        SDL_DestroyTexture(m_background);
+        m_background = nullptr;
+    }
+    if (m_layer) {
+        SDL_DestroyTexture(m_layer);
+        m_layer = nullptr;
+    }
+    m_static.clear();
+    m_pixels = nullptr;
+}
+
+const SoftRenderer::Sprite* SoftRenderer::sprite(int value, int size) {
+    if (value < 0 || value >= NUM_CELL_VALUES || !m_sources[value]) {
+        return nullptr;
+    }
+    size = std::max(SOFT_MIN_SPRITE, std::min(SOFT_MAX_SPRITE, size));
+    std::unique_ptr<Sprite>& slot = m_sprites[value][size - SOFT_MIN_SPRITE];
+    if (slot) {
+        return slot.get();
+    }
+
+    std::unique_ptr<Sprite> variant(new Sprite());
+    variant->size = size;
+    if (!scaleSurface(m_sources[value], size, size, variant->pixels)) {
+        std::cerr << "Software path: cannot scale jewel " << value << " to " << size << ": " << SDL_GetError() << std::endl;
+        return nullptr;
+    }
+    variant->spans.resize((size_t)size * 2);
+    for (int y = 0; y < size; ++y) {
+        uint32_t* row = &variant->pixels[(size_t)y * size];
+        int begin = size, end = 0;
+        for (int x = 0; x < size; ++x) {
+            row[x] = premultiply(row[x]);
+            if (row[x] >> 24) {
+                begin = std::min(begin, x);
+                end = x + 1;
+            }
+        }
+        variant->spans[y * 2] = (uint16_t)std::min(begin, end);
+        variant->spans[y * 2 + 1] = (uint16_t)end;
+    }
+
+    slot = std::move(variant);
+    ++m_spriteCount;
+    return slot.get();
+}
+
+bool SoftRenderer::begin() {
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (!m_layer || SDL_LockTexture(m_layer, nullptr, &pixels, &pitch) != 0) {
+        return false;
+    }
+    m_pixels = (uint32_t*)pixels;
+    m_pitch = pitch / (int)sizeof(uint32_t);
+    for (int y = 0; y < m_layerRect.h; ++y) {
+        memcpy(m_pixels + (size_t)y * m_pitch, &m_static[(size_t)y * m_layerRect.w], (size_t)m_layerRect.w * sizeof(uint32_t));
+    }
+    return true;
+}
+
+void SoftRenderer::drawJewel(int value, const SDL_Rect& rect) {
+    const Sprite* image = sprite(value, rect.w);
+    if (!m_pixels || !image) {
+        return;
+    }
+
+    // Kích thước ngoài khoảng cache bị kẹp lại, giữ tâm như rect gốc
+    int left = rect.x + (rect.w - image->size) / 2 - m_layerRect.x;
+    int top = rect.y + (rect.h - image->size) / 2 - m_layerRect.y;
+    int firstRow = std::max(0, -top);
+    int lastRow = std::min(image->size, m_layerRect.h - top);
+    for (int y = firstRow; y < lastRow; ++y) {
+        int begin = std::max<int>(image->spans[y * 2], -left);
+        int end = std::min<int>(image->spans[y * 2 + 1], m_layerRect.w - left);
+        if (begin >= end) continue;
+        blendPremultiplied(m_pixels + (size_t)(top + y) * m_pitch + left + begin,
+                           &image->pixels[(size_t)y * image->size + begin], end - begin);
+    }
+}
+
+void SoftRenderer::end(SDL_Renderer* renderer) {
+    if (!m_pixels) {
+        return;
+    }
+    SDL_UnlockTexture(m_layer);
+    m_pixels = nullptr;
+    SDL_RenderCopy(renderer, m_layer, nullptr, &m_layerRect);
+}
@@ -0,0 +1,69 @@
+#ifndef SOFTRENDER_H
+#define SOFTRENDER_H
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "constants.h"
+
+// Đường vẽ bàn đá cho renderer phần mềm (máy không có GPU, --headless, --software).
+// Trên renderer phần mềm mỗi SDL_RenderCopy có scale là một SDL_BlitScaled kèm blend từng pixel. Ở đây sprite
+// được scale sẵn một lần cho mỗi kích thước hoạt ảnh gặp tới, lưu ARGB premultiplied và blend bằng SSE2.
+// Cả dải màn hình chứa bàn được ghép trong một texture streaming: chép nền tĩnh, blend đá, một RenderCopy không scale.
+const int SOFT_MIN_SPRITE = GRID_SIZE / 2;
+const int SOFT_MAX_SPRITE = GRID_SIZE * 2;
+
+// dst = src + dst * (255 - src.a) / 255 trên ARGB8888 premultiplied, làm tròn giống nhau ở SSE2 và bản thường
+void blendPremultiplied(uint32_t* dst, const uint32_t* src, int count);
+
+class SoftRenderer {
+public:
+    SoftRenderer();
+    ~SoftRenderer();
+
+    SoftRenderer(const SoftRenderer&) = delete;
+    SoftRenderer& operator=(const SoftRenderer&) = delete;
+
+    static bool isSoftware(SDL_Renderer* renderer);
+
+    // Gọi trên render thread khi surface vừa decode còn sống; không giữ surface của người gọi.
+    // layer là vùng màn hình lớp này phủ kín mỗi frame, frame là khung nền của bàn (toạ độ màn hình).
+    bool build(SDL_Renderer* renderer, SDL_Surface* const jewels[NUM_CELL_VALUES], SDL_Surface* background,
+               SDL_Rect layer, SDL_Rect frame, SDL_Color frameColor);
+    void prepare(int size); // Scale sẵn mọi loại đá ở kích thước này để lúc chơi không phải tạo
+    void release();
+    bool ready() const { return m_layer != nullptr; }
+
+    SDL_Texture* background() const { return m_background; } // Nền menu đúng kích thước màn hình, không blend
+
+    bool begin();                                     // Lock texture và chép nền tĩnh
+    void drawJewel(int value, const SDL_Rect& rect);  // rect như của SDL_RenderCopy
+    void end(SDL_Renderer* renderer);                 // Unlock và copy lên màn hình
+
+    int spriteCount() const { return m_spriteCount; }
+
+private:
+    struct Sprite {
+        int size;
+        std::vector<uint32_t> pixels; // size * size
+        std::vector<uint16_t> spans;  // Mỗi hàng hai số [đầu, cuối) của phần không trong suốt
+    };
+
+    const Sprite* sprite(int value, int size);
+
+    SDL_Surface* m_sources[NUM_CELL_VALUES]; // Ảnh gốc đã đổi sang ARGB8888
+    std::unique_ptr<Sprite> m_sprites[NUM_CELL_VALUES][SOFT_MAX_SPRITE - SOFT_MIN_SPRITE + 1];
+    int m_spriteCount;
+
+    SDL_Texture* m_background;
+    SDL_Texture* m_layer;
+    SDL_Rect m_layerRect;
+    std::vector<uint32_t> m_static; // Nền tĩnh của lớp bàn
+    uint32_t* m_pixels;             // Chỉ hợp lệ giữa begin() và end()
+    int m_pitch;                    // Tính bằng pixel
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Hàng đợi vòng không khóa cho đúng một thread đẩy và một thread lấy, dung lượng cố định (lũy thừa của 2)
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool push(const T& item) { // false nếu đầy
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) { // false nếu rỗng
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T m_items[Capacity];
+    alignas(64) std::atomic<size_t> m_head; // Thread lấy
+    alignas(64) std::atomic<size_t> m_tail; // Thread đẩy
+};
+
+#endif
@@ -0,0 +1,16 @@
+#include "startuptrace.h"
+#include <chrono>
+#include <iostream>
+
+namespace {
+    // Khởi tạo tĩnh, chạy trước cả SDL_main
+    const std::chrono::steady_clock::time_point s_processStart = std::chrono::steady_clock::now();
+}
+
+double StartupTrace::elapsedMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s_processStart).count();
+}
+
+void StartupTrace::mark(const std::string& label) {
+    std::cout << "[startup] " << label << ": " << elapsedMs() << " ms" << std::endl;
+}
@@ -0,0 +1,12 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <string>
+
+// Đo thời gian khởi động, tính từ lúc tiến trình bắt đầu
+namespace StartupTrace {
+    double elapsedMs();
+    void mark(const std::string& label); // In "[startup] label: X ms" ra console
+}
+
+#endif
@@ -1,7 +1,11 @@
 #include "texturemanager.h"
+#include "assetpack.h"
 
 TextureManager* TextureManager::s_pInstance = nullptr; //Initialize, singleton
 
+// Đủ cho thiết bị 512 MB, đổi bằng setBudget
+const size_t DEFAULT_TEXTURE_BUDGET = 64 * 1024 * 1024;
+
 TextureManager* TextureManager::Instance() {
     if(s_pInstance == nullptr) {
         s_pInstance = new TextureManager();
@@ -9,33 +13,197 @@ TextureManager* TextureManager::Instance() {
     return s_pInstance;
 }
 
-TextureManager::TextureManager() {} //Private, singleton
+TextureManager::TextureManager() : m_lruHead(INVALID_TEXTURE), m_lruTail(INVALID_TEXTURE),
+                                   m_budget(DEFAULT_TEXTURE_BUDGET), m_memoryUsed(0) {} //Private, singleton
 TextureManager::~TextureManager() {
     clear(); // Giải phóng tất cả textures khi TextureManager bị hủy
 }
 
-SDL_Texture* TextureManager::loadTexture(const std::string& filePath, SDL_Renderer* renderer) {
-    // Check if the texture is already loaded
-    if (m_textureMap.find(filePath) != m_textureMap.end()) {
-        return m_textureMap[filePath]; // Texture đã được load rồi, lấy từ cache
+// Mỗi đường dẫn chỉ có một handle duy nhất
+TextureHandle TextureManager::intern(const std::string& filePath, SDL_Renderer* renderer) {
+    auto it = m_handleMap.find(filePath);
+    if (it != m_handleMap.end()) {
+        return it->second;
     }
 
-    SDL_Texture* texture = IMG_LoadTexture(renderer, filePath.c_str());
-    if (texture == nullptr) {
-        std::cerr << "Failed to load texture: " << filePath << " Error: " << IMG_GetError() << std::endl;
+    m_textures.push_back({filePath, nullptr, renderer, 0, 0, INVALID_TEXTURE, INVALID_TEXTURE, false});
+    TextureHandle handle = (TextureHandle)m_textures.size();
+    m_handleMap.emplace(filePath, handle);
+    return handle;
+}
+
+TextureHandle TextureManager::acquire(const std::string& filePath, SDL_Renderer* renderer) {
+    TextureHandle handle = intern(filePath, renderer);
+    TextureEntry& texEntry = entry(handle);
+
+    if (texEntry.texture == nullptr && !reload(texEntry)) {
+        return INVALID_TEXTURE;
+    }
+
+    if (texEntry.inLru) {
+        lruRemove(handle);
+    }
+    texEntry.refCount++;
+    return handle;
+}
+
+TextureHandle TextureManager::acquireFromSurface(const std::string& filePath, SDL_Surface* surface, SDL_Renderer* renderer) {
+    TextureHandle handle = intern(filePath, renderer);
+    TextureEntry& texEntry = entry(handle);
+
+    if (texEntry.texture == nullptr) {
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        if (texture == nullptr) {
+            std::cerr << "Failed to upload texture: " << filePath << " Error: " << SDL_GetError() << std::endl;
+            return INVALID_TEXTURE;
+        }
+        upload(texEntry, texture);
+    }
+
+    if (texEntry.inLru) {
+        lruRemove(handle);
+    }
+    texEntry.refCount++;
+    return handle;
+}
+
+void TextureManager::release(TextureHandle handle) {
+    if (handle == INVALID_TEXTURE || handle > m_textures.size()) return;
+
+    TextureEntry& texEntry = entry(handle);
+    if (texEntry.refCount <= 0) return;
+
+    texEntry.refCount--;
+    if (texEntry.refCount == 0 && texEntry.texture != nullptr) {
+        lruPushBack(handle);
+        evictToBudget();
+    }
+}
+
+SDL_Texture* TextureManager::get(TextureHandle handle) {
+    if (handle == INVALID_TEXTURE || handle > m_textures.size()) return nullptr;
+
+    // Texture không ai giữ nằm trong LRU, upload() kế tiếp có thể destroy nó nên con trỏ trả ra sẽ treo
+    TextureEntry& texEntry = entry(handle);
+    if (texEntry.refCount <= 0) {
+        std::cerr << "Texture get() without acquire: " << texEntry.filePath << std::endl;
         return nullptr;
     }
+    return texEntry.texture; // Đang được giữ thì không bị evict
+}
+
+void TextureManager::upload(TextureEntry& texEntry, SDL_Texture* texture) {
+    int w = 0, h = 0;
+    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+
+    texEntry.texture = texture;
+    texEntry.bytes = (size_t)w * h * 4;
+    m_memoryUsed += texEntry.bytes;
+
+    evictToBudget();
+    if (m_memoryUsed > m_budget) {
+        std::cerr << "Texture budget exceeded by referenced textures: " << m_memoryUsed << " / " << m_budget << " bytes" << std::endl;
+    }
+}
+
+bool TextureManager::reload(TextureEntry& texEntry) {
+    // Tìm trong assets.pak trước
+    SDL_Texture* texture = nullptr;
+    SDL_Surface* packedSurface = AssetPack::Instance()->loadSurface(texEntry.filePath);
+    if (packedSurface != nullptr) {
+        texture = SDL_CreateTextureFromSurface(texEntry.renderer, packedSurface);
+        SDL_FreeSurface(packedSurface);
+    } else {
+        texture = IMG_LoadTexture(texEntry.renderer, texEntry.filePath.c_str());
+    }
+
+    if (texture == nullptr) {
+        std::cerr << "Failed to load texture: " << texEntry.filePath << " Error: " << IMG_GetError() << std::endl;
+        return false;
+    }
+    upload(texEntry, texture);
+    return true;
+}
 
-    m_textureMap[filePath] = texture; // Cache texture vừa load
-    return texture;
+void TextureManager::unload(TextureEntry& texEntry) {
+    if (texEntry.texture != nullptr) {
+        SDL_DestroyTexture(texEntry.texture);
+        m_memoryUsed -= texEntry.bytes;
+    }
+    texEntry.texture = nullptr;
+    texEntry.bytes = 0;
+}
+
+void TextureManager::lruPushBack(TextureHandle handle) {
+    TextureEntry& texEntry = entry(handle);
+    texEntry.lruPrev = m_lruTail;
+    texEntry.lruNext = INVALID_TEXTURE;
+    texEntry.inLru = true;
+
+    if (m_lruTail != INVALID_TEXTURE) {
+        entry(m_lruTail).lruNext = handle;
+    } else {
+        m_lruHead = handle;
+    }
+    m_lruTail = handle;
+}
+
+void TextureManager::lruRemove(TextureHandle handle) {
+    TextureEntry& texEntry = entry(handle);
+
+    if (texEntry.lruPrev != INVALID_TEXTURE) {
+        entry(texEntry.lruPrev).lruNext = texEntry.lruNext;
+    } else {
+        m_lruHead = texEntry.lruNext;
+    }
+    if (texEntry.lruNext != INVALID_TEXTURE) {
+        entry(texEntry.lruNext).lruPrev = texEntry.lruPrev;
+    } else {
+        m_lruTail = texEntry.lruPrev;
+    }
+
+    texEntry.lruPrev = texEntry.lruNext = INVALID_TEXTURE;
+    texEntry.inLru = false;
+}
+
+// Chỉ evict texture không còn ai giữ, cũ nhất trước
+void TextureManager::evictToBudget() {
+    while (m_memoryUsed > m_budget && m_lruHead != INVALID_TEXTURE) {
+        TextureHandle victim = m_lruHead;
+        lruRemove(victim);
+        unload(entry(victim));
+    }
+}
+
+void TextureManager::setBudget(size_t bytes) {
+    m_budget = bytes;
+    evictToBudget();
+}
+
+std::vector<TextureStats> TextureManager::stats() const {
+    std::vector<TextureStats> result;
+    result.reserve(m_textures.size());
+    for (const auto& texEntry : m_textures) {
+        result.push_back({texEntry.filePath, texEntry.refCount, texEntry.bytes, texEntry.texture != nullptr});
+    }
+    return result;
+}
+
+void TextureManager::printStats() const {
+    std::cout << "Textures: " << m_textures.size() << ", VRAM " << m_memoryUsed / 1024 << " / " << m_budget / 1024 << " KB" << std::endl;
+    for (const auto& texStats : stats()) {
+        std::cout << "  " << texStats.filePath << " refs=" << texStats.refCount
+                  << " " << texStats.bytes / 1024 << " KB" << (texStats.resident ? "" : " (evicted)") << std::endl;
+    }
 }
 
 void TextureManager::clear() {
     // Destroy all textures and clear the cache
-    for (auto const& [key, val] : m_textureMap) {
-        if(val != nullptr){
-            SDL_DestroyTexture(val);
-        }
+    for (auto& texEntry : m_textures) {
+        unload(texEntry);
     }
-    m_textureMap.clear();
+    m_textures.clear();
+    m_handleMap.clear();
+    m_lruHead = m_lruTail = INVALID_TEXTURE;
+    m_memoryUsed = 0;
 }
@@ -4,22 +4,73 @@
 #include <SDL.h>
 #include <SDL_image.h>
 
+#include <cstdint>
 #include <iostream>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+// Handle số nguyên thay cho chuỗi đường dẫn, 0 là handle rỗng
+typedef uint32_t TextureHandle;
+const TextureHandle INVALID_TEXTURE = 0;
+
+struct TextureStats {
+    std::string filePath;
+    int refCount;
+    size_t bytes;   // Ước lượng VRAM (w * h * 4), 0 nếu đã bị evict
+    bool resident;
+};
 
 class TextureManager {
 public:
     static TextureManager* Instance();
-    SDL_Texture* loadTexture(const std::string& filePath, SDL_Renderer* renderer);
+
+    // acquire tăng ref count, release giảm. Texture có ref = 0 vẫn ở cache
+    // cho tới khi vượt budget thì bị evict theo LRU.
+    TextureHandle acquire(const std::string& filePath, SDL_Renderer* renderer);
+    TextureHandle acquireFromSurface(const std::string& filePath, SDL_Surface* surface, SDL_Renderer* renderer); // Surface đã decode sẵn (AssetLoader)
+    void release(TextureHandle handle);
+    SDL_Texture* get(TextureHandle handle); // Chỉ cho handle đang acquire; con trỏ sống tới khi release
+
+    void setBudget(size_t bytes);
+    size_t budget() const { return m_budget; }
+    size_t memoryUsed() const { return m_memoryUsed; }
+    std::vector<TextureStats> stats() const;
+    void printStats() const;
+
     void clear();
 
 private:
     TextureManager();
     ~TextureManager();
 
+    struct TextureEntry {
+        std::string filePath;
+        SDL_Texture* texture;
+        SDL_Renderer* renderer;
+        size_t bytes;
+        int refCount;
+        TextureHandle lruPrev; // Danh sách LRU các texture không còn ai giữ
+        TextureHandle lruNext;
+        bool inLru;
+    };
+
+    TextureHandle intern(const std::string& filePath, SDL_Renderer* renderer);
+    TextureEntry& entry(TextureHandle handle) { return m_textures[handle - 1]; }
+    void upload(TextureEntry& texEntry, SDL_Texture* texture);
+    bool reload(TextureEntry& texEntry);
+    void unload(TextureEntry& texEntry);
+    void lruPushBack(TextureHandle handle);
+    void lruRemove(TextureHandle handle);
+    void evictToBudget();
+
     static TextureManager* s_pInstance;
-    std::map<std::string, SDL_Texture*> m_textureMap; // Tải texture
+    std::vector<TextureEntry> m_textures; // m_textures[handle - 1]
+    std::unordered_map<std::string, TextureHandle> m_handleMap;
+    TextureHandle m_lruHead; // Cũ nhất, bị evict trước
+    TextureHandle m_lruTail;
+    size_t m_budget;
+    size_t m_memoryUsed;
 
 };
 
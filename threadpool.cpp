@@ -0,0 +1,121 @@
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    thread_local int t_workerIndex = -1;
+}
+
+ThreadPool::ThreadPool(int numThreads) : m_pending(0), m_nextQueue(0), m_stopping(false) {
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < numThreads; ++i) {
+        m_queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_sleepCondition.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+int ThreadPool::currentWorker() {
+    return t_workerIndex;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Task sinh ra trong worker được đẩy vào deque của chính worker đó
+    int index = t_workerIndex;
+    if (index < 0 || index >= (int)m_queues.size()) {
+        index = m_nextQueue.fetch_add(1) % m_queues.size();
+    }
+
+    m_pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepCondition.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::function<void()> task;
+    while (m_pending.load() > 0) {
+        if (stealTask(-1, task)) {
+            runTask(task);
+        } else {
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_doneCondition.wait_for(lock, std::chrono::milliseconds(1), [this] { return m_pending.load() == 0; });
+        }
+    }
+}
+
+bool ThreadPool::popTask(int index, std::function<void()>& task) {
+    WorkQueue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::stealTask(int thief, std::function<void()>& task) {
+    int count = (int)m_queues.size();
+    int start = thief < 0 ? 0 : thief + 1;
+    for (int i = 0; i < count; ++i) {
+        int victim = (start + i) % count;
+        if (victim == thief) continue;
+
+        WorkQueue& queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(std::function<void()>& task) {
+    task();
+    task = nullptr;
+    if (m_pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_doneCondition.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(int index) {
+    t_workerIndex = index;
+    std::function<void()> task;
+
+    while (true) {
+        if (popTask(index, task) || stealTask(index, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stopping) break;
+        // Timeout ngắn phòng trường hợp bỏ lỡ notify khi task được đẩy vào giữa chừng
+        m_sleepCondition.wait_for(lock, std::chrono::milliseconds(2));
+        if (m_stopping) break;
+    }
+}
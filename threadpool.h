@@ -0,0 +1,51 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool work-stealing: mỗi worker có deque riêng, lấy việc của mình từ cuối (LIFO)
+// và lấy trộm từ đầu deque của worker khác (FIFO) khi hết việc.
+class ThreadPool {
+public:
+    explicit ThreadPool(int numThreads = 0); // 0 = số core
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait(); // Thread gọi cũng tham gia làm việc cho tới khi hết task
+    int size() const { return (int)m_threads.size(); }
+
+    // Số thứ tự worker của thread hiện tại, -1 nếu không phải worker
+    static int currentWorker();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popTask(int index, std::function<void()>& task);
+    bool stealTask(int thief, std::function<void()>& task);
+    void runTask(std::function<void()>& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_pending;
+    std::atomic<unsigned> m_nextQueue;
+    std::atomic<bool> m_stopping;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+    std::condition_variable m_doneCondition;
+};
+
+#endif
@@ -0,0 +1,232 @@
+// Mô phỏng Monte Carlo để chỉnh targetScore của timed mode
+// Cách dùng: balance [--games N] [--bot greedy|random|expectimax] [--think MS] [--cascade MS]
+//                    [--win-rate P] [--level N] [--seed N] [--threads N]
+//
+// Mỗi ván: bot chọn nước, đồng hồ giả lập cộng thời gian suy nghĩ (phân phối mũ quanh --think)
+// cộng thời gian hoạt ảnh đổi chỗ và mỗi lượt ăn dây chuyền. Không cần SDL.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../board.h"
+#include "../bot.h"
+#include "../levels.h"
+#include "../threadpool.h"
+
+enum class BotKind { Random, Greedy, Expectimax };
+
+struct BalanceConfig {
+    int games = 2000;
+    BotKind bot = BotKind::Greedy;
+    double thinkMs = 1500.0;   // Thời gian suy nghĩ trung bình mỗi nước
+    double minThinkMs = 400.0; // Người chơi không bấm nhanh hơn mức này
+    double swapMs = 200.0;     // Bằng swapDuration trong JewelGame
+    double cascadeMs = 350.0;  // Hoạt ảnh ăn + rơi cho mỗi lượt ăn
+    double winRate = 0.5;      // Tỉ lệ thắng mong muốn khi gợi ý target
+    int onlyLevel = 0;         // 0 = chạy mọi level
+    uint64_t seed = 1;
+    int threads = 0;
+};
+
+const int CHECKPOINT_SECONDS = 60;
+const int GAMES_PER_TASK = 32;
+const int START_SHUFFLES = 3; // Bằng shuffleRemaining khi bắt đầu ván
+
+static uint64_t mixSeed(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Chơi một ván, ghi điểm tại mỗi mốc CHECKPOINT_SECONDS (mốc cuối là lúc hết giờ)
+static void playGame(const BalanceConfig& config, const TimedModeLevel& level, uint64_t seed,
+                     JewelBot* bot, int* checkpoints, int numCheckpoints) {
+    BoardEngine engine;
+    engine.rng.seed(seed);
+    engine.initBoard();
+
+    JewelRng timing(mixSeed(seed));
+    double durationMs = level.duration * 1000.0;
+    double clockMs = 0.0;
+    int shuffles = START_SHUFFLES;
+    int next = 0;
+    Move moves[MAX_MOVES];
+
+    while (clockMs < durationMs) {
+        int count = engine.listMoves(moves);
+        if (count == 0) {
+            if (shuffles == 0) break; // Kẹt: chỉ còn chờ hết giờ
+            --shuffles;
+            engine.shuffle();
+            clockMs += config.minThinkMs;
+            continue;
+        }
+
+        Move move;
+        if (config.bot == BotKind::Random) {
+            move = moves[timing.below(count)];
+        } else if (config.bot == BotKind::Greedy) {
+            move = greedyMove(engine, moves, count);
+        } else {
+            move = bot->chooseMove(engine).move;
+        }
+
+        double u = (timing() + 0.5) / 4294967296.0;
+        clockMs += config.minThinkMs - std::log(u) * std::max(0.0, config.thinkMs - config.minThinkMs);
+        while (next < numCheckpoints && next * CHECKPOINT_SECONDS * 1000.0 <= std::min(clockMs, durationMs)) {
+            checkpoints[next++] = engine.score;
+        }
+        if (clockMs >= durationMs) break;
+
+        engine.trySwap(move.x1, move.y1, move.x2, move.y2);
+        clockMs += config.swapMs + engine.lastCascadeDepth * config.cascadeMs;
+    }
+
+    while (next < numCheckpoints) {
+        checkpoints[next++] = engine.score;
+    }
+}
+
+static int percentile(std::vector<int>& values, double p) {
+    size_t index = (size_t)(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Khoảng tin cậy Wilson 95% cho tỉ lệ thắng
+static void wilsonInterval(int wins, int total, double& low, double& high) {
+    const double z = 1.96;
+    double p = (double)wins / total;
+    double denom = 1.0 + z * z / total;
+    double center = (p + z * z / (2.0 * total)) / denom;
+    double half = z * std::sqrt(p * (1.0 - p) / total + z * z / (4.0 * total * total)) / denom;
+    low = std::max(0.0, center - half);
+    high = std::min(1.0, center + half);
+}
+
+static bool parseArgs(int argc, char* argv[], BalanceConfig& config) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--games") == 0) config.games = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--think") == 0) config.thinkMs = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--cascade") == 0) config.cascadeMs = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--win-rate") == 0) config.winRate = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--level") == 0) config.onlyLevel = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) config.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--threads") == 0) config.threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--bot") == 0) {
+            if (strcmp(argv[i + 1], "random") == 0) config.bot = BotKind::Random;
+            else if (strcmp(argv[i + 1], "greedy") == 0) config.bot = BotKind::Greedy;
+            else if (strcmp(argv[i + 1], "expectimax") == 0) config.bot = BotKind::Expectimax;
+            else {
+                std::cerr << "Unknown bot: " << argv[i + 1] << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    if (config.games <= 0 || config.winRate <= 0.0 || config.winRate >= 1.0 || config.minThinkMs > config.thinkMs) {
+        std::cerr << "Invalid options" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BalanceConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        return 1;
+    }
+
+    ThreadPool pool(config.threads);
+
+    // Bot expectimax chạy đơn luồng, mỗi worker một con (+1 cho thread gọi wait())
+    std::vector<std::unique_ptr<JewelBot>> bots;
+    if (config.bot == BotKind::Expectimax) {
+        BotConfig botConfig;
+        botConfig.maxDepth = 2;
+        botConfig.samples = 2;
+        botConfig.timeBudgetMs = 0; // Chỉ giới hạn node để kết quả tái lập được
+        botConfig.nodeBudget = 20000;
+        botConfig.threads = 1;
+        botConfig.tableBits = 16;
+        for (int i = 0; i <= pool.size(); ++i) {
+            bots.emplace_back(new JewelBot(botConfig));
+        }
+    }
+
+    std::vector<TimedModeLevel> levels = defaultTimedModeLevels();
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const TimedModeLevel& level = levels[l];
+        if (config.onlyLevel != 0 && config.onlyLevel != level.level) continue;
+
+        int numCheckpoints = level.duration / CHECKPOINT_SECONDS + 1;
+        std::vector<int> checkpoints((size_t)config.games * numCheckpoints);
+        auto start = std::chrono::steady_clock::now();
+
+        for (int first = 0; first < config.games; first += GAMES_PER_TASK) {
+            pool.submit([&, first] {
+                int worker = ThreadPool::currentWorker();
+                JewelBot* bot = bots.empty() ? nullptr : bots[worker < 0 ? pool.size() : worker].get();
+                int last = std::min(first + GAMES_PER_TASK, config.games);
+                for (int game = first; game < last; ++game) {
+                    uint64_t seed = mixSeed(config.seed ^ ((uint64_t)level.level << 40) ^ (uint64_t)game);
+                    playGame(config, level, seed, bot, &checkpoints[(size_t)game * numCheckpoints], numCheckpoints);
+                }
+            });
+        }
+        pool.wait();
+
+        double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double simulatedMinutes = config.games * level.duration / 60.0;
+
+        std::cout << "== " << level.name << ": " << config.games << " games, "
+                  << simulatedMinutes << " simulated minutes in " << wallSeconds << " s ("
+                  << simulatedMinutes * 3600.0 / std::max(wallSeconds, 1e-9) / 1e6 << "M minutes/hour)" << std::endl;
+
+        std::vector<int> column(config.games);
+        std::cout << "  time      p10      p50      p90" << std::endl;
+        for (int c = 0; c < numCheckpoints; ++c) {
+            for (int game = 0; game < config.games; ++game) {
+                column[game] = checkpoints[(size_t)game * numCheckpoints + c];
+            }
+            std::cout << std::setw(5) << c * CHECKPOINT_SECONDS << "s"
+                      << std::setw(9) << percentile(column, 0.1)
+                      << std::setw(9) << percentile(column, 0.5)
+                      << std::setw(9) << percentile(column, 0.9) << std::endl;
+        }
+
+        // Cột cuối là điểm lúc hết giờ: thắng nếu đạt targetScore
+        int wins = 0;
+        for (int game = 0; game < config.games; ++game) {
+            column[game] = checkpoints[(size_t)game * numCheckpoints + numCheckpoints - 1];
+            if (column[game] >= level.targetScore) ++wins;
+        }
+        double low, high;
+        wilsonInterval(wins, config.games, low, high);
+        std::cout << "  target " << level.targetScore << ": win " << 100.0 * wins / config.games
+                  << "% (95% CI " << 100.0 * low << "-" << 100.0 * high << "%)" << std::endl;
+
+        int suggested = percentile(column, 1.0 - config.winRate) / 50 * 50;
+        int suggestedWins = 0;
+        for (int game = 0; game < config.games; ++game) {
+            if (column[game] >= suggested) ++suggestedWins;
+        }
+        wilsonInterval(suggestedWins, config.games, low, high);
+        std::cout << "  suggested target for " << 100.0 * config.winRate << "% win rate: " << suggested
+                  << " (win " << 100.0 * suggestedWins / config.games << "%, 95% CI "
+                  << 100.0 * low << "-" << 100.0 * high << "%)" << std::endl;
+    }
+    return 0;
+}
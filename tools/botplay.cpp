@@ -0,0 +1,59 @@
+// Cho bot tự chơi headless và in tốc độ tìm kiếm
+// Cách dùng: botplay [--seed N] [--moves N] [--time MS] [--nodes N] [--depth N] [--samples N] [--threads N]
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../bot.h"
+
+int main(int argc, char* argv[]) {
+    BotConfig config;
+    uint64_t seed = 1;
+    int maxMoves = 50;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--moves") == 0) maxMoves = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--time") == 0) config.timeBudgetMs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--nodes") == 0) config.nodeBudget = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--depth") == 0) config.maxDepth = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--samples") == 0) config.samples = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) config.threads = atoi(argv[i + 1]);
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    JewelBot bot(config);
+    BoardEngine engine;
+    engine.rng.seed(seed);
+    engine.initBoard();
+
+    uint64_t totalNodes = 0;
+    double totalMs = 0.0;
+    int moves = 0;
+    for (; moves < maxMoves; ++moves) {
+        BotResult result = bot.chooseMove(engine);
+        if (!result.found) {
+            std::cout << "No legal moves left" << std::endl;
+            break;
+        }
+
+        int scoreBefore = engine.score;
+        engine.trySwap(result.move.x1, result.move.y1, result.move.x2, result.move.y2);
+        totalNodes += result.nodes;
+        totalMs += result.elapsedMs;
+
+        std::cout << "Move " << moves + 1 << ": (" << (int)result.move.x1 << "," << (int)result.move.y1 << ")-("
+                  << (int)result.move.x2 << "," << (int)result.move.y2 << ") depth " << result.depthReached
+                  << " gain " << engine.score - scoreBefore << " (search value " << result.expectedScore
+                  << " over " << result.depthReached << " moves) score " << engine.score
+                  << " cascades " << engine.lastCascadeDepth << " nodes " << result.nodes << std::endl;
+    }
+
+    std::cout << "Final score: " << engine.score << " after " << moves << " moves" << std::endl;
+    std::cout << "Nodes: " << totalNodes << " in " << totalMs << " ms ("
+              << (totalMs > 0 ? totalNodes * 1000.0 / totalMs : 0.0) << " nodes/sec)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Soak test cho Endless Mode (endlessboard.h): bot chơi liên tục nhiều giờ (giờ giả lập theo nhịp người),
+// in thời gian mỗi nước đi theo từng giờ và số lần cấp phát heap để thấy bộ nhớ và frame time không trôi.
+// Cách dùng: endlesssoak [--hours N] [--pace MS] [--seed N]
+//
+// Bot ưu tiên nước đi thấp nhất trên bàn để hàng dưới cùng trôi đi đều, như người chơi Endless thật.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "../endlessboard.h"
+
+// Đếm cấp phát của cả process; vòng soak phải giữ con số này bằng 0
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    void* block = malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+struct HourStats {
+    uint32_t moves = 0;
+    uint32_t shuffles = 0;
+    uint64_t rowsAtEnd = 0;
+    int scoreAtEnd = 0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+int main(int argc, char* argv[]) {
+    int hours = 8;
+    int paceMs = 1500; // Một nước mỗi 1.5 giây, nhanh hơn người chơi thật
+    uint64_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--hours") == 0) hours = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--pace") == 0) paceMs = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[i + 1], nullptr, 10);
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    uint32_t movesPerHour = 3600u * 1000u / (uint32_t)paceMs;
+    std::vector<double> samples(movesPerHour);
+    std::vector<HourStats> report(hours);
+
+    EndlessBoard board;
+    board.rng.seed(seed);
+    board.initBoard();
+    JewelRng bot(seed * 31 + 7);
+
+    uint64_t allocationsBefore = g_allocations.load();
+    for (int hour = 0; hour < hours; ++hour) {
+        HourStats& stats = report[hour];
+        for (uint32_t i = 0; i < movesPerHour; ++i) {
+            auto begin = std::chrono::steady_clock::now();
+
+            Move moves[MAX_MOVES];
+            int count = board.listMoves(moves);
+            if (count == 0) {
+                board.shuffle();
+                ++stats.shuffles;
+            } else {
+                // Nước thấp nhất, hòa thì chọn ngẫu nhiên
+                int lowest = 0;
+                for (int m = 0; m < count; ++m) lowest = std::max(lowest, (int)std::max(moves[m].y1, moves[m].y2));
+                int candidates = 0;
+                for (int m = 0; m < count; ++m) {
+                    if (std::max(moves[m].y1, moves[m].y2) == lowest) moves[candidates++] = moves[m];
+                }
+                const Move& move = moves[bot.below(candidates)];
+                board.trySwap(move.x1, move.y1, move.x2, move.y2);
+                ++stats.moves;
+            }
+
+            samples[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        }
+
+        std::sort(samples.begin(), samples.end());
+        stats.p50Us = samples[samples.size() / 2];
+        stats.p99Us = samples[samples.size() * 99 / 100];
+        stats.maxUs = samples.back();
+        stats.rowsAtEnd = board.rowsScrolled();
+        stats.scoreAtEnd = board.score;
+    }
+    uint64_t allocations = g_allocations.load() - allocationsBefore;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Endless soak: " << hours << " h at one move per " << paceMs << " ms, board state "
+              << sizeof(EndlessBoard) << " bytes (ring of " << ENDLESS_RING_ROWS << " rows)" << std::endl;
+    std::cout << " hour   moves  shuffles    rows     score    p50 us    p99 us    max us" << std::endl;
+    for (int hour = 0; hour < hours; ++hour) {
+        const HourStats& stats = report[hour];
+        std::cout << std::setw(5) << hour + 1 << std::setw(8) << stats.moves << std::setw(10) << stats.shuffles
+                  << std::setw(8) << stats.rowsAtEnd << std::setw(10) << stats.scoreAtEnd << std::setw(10) << stats.p50Us
+                  << std::setw(10) << stats.p99Us << std::setw(10) << stats.maxUs << std::endl;
+    }
+
+    // Hàng trôi đi phải đều theo giờ và p99 giờ cuối không được lớn hơn hẳn giờ đầu
+    double drift = report.back().p99Us / std::max(report.front().p99Us, 0.01);
+    std::cout << "Heap allocations during soak: " << allocations << "; last/first hour p99 ratio " << drift << std::endl;
+    bool ok = allocations == 0 && report.back().rowsAtEnd > 0;
+    std::cout << (ok ? "Constant memory, rows keep scrolling" : "SOAK FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Soak test cho FlowScheduler (flowscheduler.h): tạo và hủy hàng loạt luồng game như lúc chơi lại liên tục,
+// kiểm tra các điều pool frame hứa: pool đã ấm thì spawn không cấp phát heap, cancelAll không để sót frame.
+// Cách dùng: flowsoak [--rounds N] [--tasks N]
+//
+// Mỗi vòng: spawn task chờ sự kiện (nhóm Game) và task ngủ/chờ tạm dừng (nhóm Timed), signal cho một nửa chạy
+// xong, rồi cancelAll như về Main Menu. Thêm một ca task đang được signal hủy nhóm khác cùng danh sách chờ.
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "../flowscheduler.h"
+
+// Đếm cấp phát của cả process; sau vòng làm ấm con số này phải đứng yên
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    void* block = malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+static uint64_t g_finished = 0;
+static uint64_t g_timedWakes = 0;
+
+// Như swapFlow: chờ đổi chỗ xong rồi chờ bàn đứng yên
+static FlowTask moveFlow(FlowScheduler& flow) {
+    co_await flow.event(FlowEvent::SwapFinished);
+    co_await flow.event(FlowEvent::BoardSettled);
+    ++g_finished;
+}
+
+// Như timedClockFlow: đếm giây, chờ hết tạm dừng
+static FlowTask clockFlow(FlowScheduler& flow) {
+    for (;;) {
+        co_await flow.sleep(60000);
+        co_await flow.event(FlowEvent::Resumed);
+    }
+}
+
+static FlowTask resumedFlow(FlowScheduler& flow) {
+    co_await flow.event(FlowEvent::Resumed);
+    ++g_timedWakes;
+}
+
+// Thức cùng lúc với các task Timed và hủy cả nhóm trước khi tới lượt chúng
+static FlowTask cancelTimedFlow(FlowScheduler& flow) {
+    co_await flow.event(FlowEvent::Resumed);
+    flow.cancel(FlowGroup::Timed);
+}
+
+static bool runRound(FlowScheduler& flow, int tasks) {
+    for (int i = 0; i < tasks; ++i) {
+        flow.spawn(FlowGroup::Game, moveFlow(flow));
+        flow.spawn(FlowGroup::Timed, clockFlow(flow));
+    }
+    // Nửa số task Game đi hết luồng, nửa còn lại bị hủy giữa chừng
+    flow.signal(FlowEvent::SwapFinished);
+    for (int i = 0; i < tasks; ++i) {
+        flow.spawn(FlowGroup::Game, moveFlow(flow));
+    }
+    flow.signal(FlowEvent::BoardSettled);
+    flow.cancelAll();
+    return flow.stats().live == 0 && flow.stats().framesInUse == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = 10000;
+    int tasks = 32;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for option: " << argv[i] << std::endl;
+            return 1;
+        }
+        if (strcmp(argv[i], "--rounds") == 0) rounds = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--tasks") == 0) tasks = std::max(1, atoi(argv[i + 1]));
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    FlowScheduler flow;
+    bool ok = runRound(flow, tasks); // Làm ấm: pool và heap timer lớn tới kích thước cần
+    FlowStats warm = flow.stats();
+
+    uint64_t allocationsBefore = g_allocations.load();
+    uint64_t finishedBefore = g_finished;
+    int leaks = 0;
+    for (int round = 0; round < rounds; ++round) {
+        if (!runRound(flow, tasks)) ++leaks;
+    }
+    uint64_t allocations = g_allocations.load() - allocationsBefore;
+    uint64_t finished = g_finished - finishedBefore;
+    FlowStats stats = flow.stats();
+
+    // Task Game thức trước hủy nhóm Timed: các task Timed sau nó trong cùng danh sách chờ không được chạy
+    flow.spawn(FlowGroup::Game, cancelTimedFlow(flow));
+    for (int i = 0; i < tasks; ++i) {
+        flow.spawn(FlowGroup::Timed, resumedFlow(flow));
+    }
+    flow.signal(FlowEvent::Resumed);
+    bool cancelHonoured = g_timedWakes == 0 && flow.stats().live == 0 && flow.stats().framesInUse == 0;
+
+    flow.report(std::cout);
+    std::cout << "Flow soak: " << rounds << " rounds of " << tasks * 3 << " tasks, frame pool " << warm.framePoolSize
+              << " blocks after warm-up, " << stats.framePoolSize << " at end, " << stats.frameFallbacks
+              << " frames on heap" << std::endl;
+    std::cout << "Heap allocations after warm-up: " << allocations << "; rounds leaving frames in use: " << leaks
+              << "; flows finished " << finished << "/" << (uint64_t)rounds * tasks << std::endl;
+    std::cout << "Timed tasks resumed after cancel(Timed): " << g_timedWakes << std::endl;
+
+    ok = ok && allocations == 0 && leaks == 0 && stats.frameFallbacks == 0 && finished == (uint64_t)rounds * tasks &&
+         cancelHonoured;
+    std::cout << (ok ? "Warm pool spawns without heap, cancelAll frees every frame" : "SOAK FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
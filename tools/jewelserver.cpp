@@ -0,0 +1,806 @@
+// Server headless chạy hàng nghìn session trên BoardEngine, giao thức trong sessionprotocol.h. Chỉ chạy trên Linux (epoll).
+// Cách dùng: jewelserver [--port N] [--bind ADDR] [--unix PATH] [--stats-port N]
+//                        [--workers N] [--max-connections N] [--max-sessions N]
+//
+// Mỗi worker (mặc định một mỗi core) có epoll loop riêng và cùng chờ trên các socket listen (EPOLLEXCLUSIVE),
+// nên kết nối tự chia đều. Một kết nối và mọi session của nó thuộc trọn một worker, không cần khóa.
+// Buffer kết nối và bảng session cấp phát sẵn; xử lý message không cấp phát bộ nhớ.
+// Thống kê: curl http://127.0.0.1:STATS_PORT/ (session, kết nối, moves/sec, p50/p99 thời gian xử lý nước đi).
+#ifndef __linux__
+#error "jewelserver needs Linux (epoll)"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../latencyprofiler.h"
+#include "../levels.h"
+#include "../sessionprotocol.h"
+
+struct ServerConfig {
+    std::string bindAddress = "127.0.0.1";
+    int port = 7777;           // 0 = tắt TCP
+    std::string unixPath;      // Rỗng = tắt Unix socket
+    int statsPort = 7778;      // 0 = tắt
+    int workers = 0;           // 0 = số core
+    int maxConnections = 1024; // Mỗi worker
+    int maxSessions = 16384;   // Mỗi worker
+};
+
+const size_t INPUT_BUFFER_SIZE = 4096;
+const size_t OUTPUT_BUFFER_SIZE = 16384;
+const int MAX_EPOLL_EVENTS = 256;
+const int ACCEPT_BATCH = 16;
+const int EPOLL_TIMEOUT_MS = 100;
+const double LATENCY_MIN_MS = 0.001; // Histogram của server bắt đầu từ 1 µs
+const int SHUFFLES_PER_GAME = 3;     // Bằng shuffleRemaining khi bắt đầu ván trong game
+const int SESSION_SLOT_BITS = 20;    // id = generation << 20 | slot
+const uint64_t LISTEN_TAG = 1ULL << 32;
+
+static std::atomic<bool> g_stopping(false);
+
+static void onSignal(int) {
+    g_stopping = true;
+}
+
+struct Session {
+    BoardEngine engine;
+    uint32_t generation = 0;
+    int connection = -1; // -1 nếu ô trống
+    int prev = -1, next = -1; // Danh sách session của cùng kết nối
+    uint8_t mode = SESSION_NORMAL;
+    uint8_t shuffles = 0;
+    uint32_t moves = 0;
+    int targetScore = 0;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+struct Connection {
+    int fd = -1;
+    bool tcp = false;
+    std::unique_ptr<uint8_t[]> input;  // Cấp phát ở lần dùng đầu, giữ lại cho kết nối sau
+    std::unique_ptr<uint8_t[]> output;
+    size_t inputUsed = 0;
+    size_t outputStart = 0, outputEnd = 0;
+    int firstSession = -1;
+    uint32_t events = 0; // Mặt nạ đang đăng ký với epoll
+};
+
+// Đọc từ thread lấy mẫu; worker chỉ ghi
+struct WorkerStats {
+    std::atomic<uint64_t> moves{0};
+    std::atomic<int> sessions{0};
+    std::atomic<int> connections{0};
+    std::atomic<uint64_t> rejected{0};
+    std::mutex latencyMutex;
+    LatencyHistogram latency{LATENCY_MIN_MS}; // Worker gộp vào mỗi EPOLL_TIMEOUT_MS, thread lấy mẫu lấy ra mỗi giây
+};
+
+class Worker {
+public:
+    Worker(int index, const ServerConfig& config, const std::vector<int>& listenFds, const std::vector<bool>& listenTcp);
+    ~Worker();
+
+    bool start();
+    void join();
+
+    WorkerStats stats;
+
+private:
+    void run();
+    void acceptConnections(int listener);
+    void closeConnection(int index);
+    void onReadable(int index);
+    void onWritable(int index);
+    bool processInput(int index);
+    bool flush(int index);
+    void updateInterest(int index);
+    void publishLatency();
+
+    bool handleMessage(int index, uint8_t type, const uint8_t* payload, size_t size);
+    void handleStart(int index, const uint8_t* payload);
+    void handleSwap(int index, uint32_t id, int action);
+    void handleShuffle(int index, uint32_t id);
+    void handleEnd(int index, uint32_t id);
+    bool endIfTimeUp(Connection& conn, uint32_t id, Session* session);
+    void writeDelta(Connection& conn, uint32_t id, uint8_t status, const Session* session,
+                    const int8_t before[BOARD_SIZE][BOARD_SIZE]);
+    void writeEnded(Connection& conn, uint32_t id, uint8_t status, const Session* session);
+
+    Session* findSession(int connection, uint32_t id);
+    int allocateSession(int connection);
+    void releaseSession(int slot);
+
+    int m_index;
+    const ServerConfig& m_config;
+    std::vector<int> m_listenFds;
+    std::vector<bool> m_listenTcp;
+    std::vector<TimedModeLevel> m_levels;
+    int m_epoll;
+    std::thread m_thread;
+
+    std::vector<Connection> m_connections;
+    std::vector<int> m_freeConnections;
+    std::vector<Session> m_sessions;
+    std::vector<int> m_freeSessions;
+
+    LatencyHistogram m_latency{LATENCY_MIN_MS};
+    JewelRng m_seedRng;
+};
+
+Worker::Worker(int index, const ServerConfig& config, const std::vector<int>& listenFds, const std::vector<bool>& listenTcp)
+    : m_index(index), m_config(config), m_listenFds(listenFds), m_listenTcp(listenTcp),
+      m_levels(defaultTimedModeLevels()), m_epoll(-1),
+      m_connections(config.maxConnections), m_sessions(config.maxSessions),
+      m_seedRng(0x9E3779B97F4A7C15ULL * (index + 1) ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count()) {
+    for (int i = config.maxConnections - 1; i >= 0; --i) m_freeConnections.push_back(i);
+    for (int i = config.maxSessions - 1; i >= 0; --i) m_freeSessions.push_back(i);
+}
+
+Worker::~Worker() {
+    if (m_epoll >= 0) close(m_epoll);
+}
+
+bool Worker::start() {
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0) {
+        std::cerr << "epoll_create1 failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < m_listenFds.size(); ++i) {
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLEXCLUSIVE; // Mỗi kết nối mới chỉ đánh thức một worker
+        event.data.u64 = LISTEN_TAG | i;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listenFds[i], &event) < 0) {
+            std::cerr << "epoll_ctl(listen) failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    m_thread = std::thread(&Worker::run, this);
+    return true;
+}
+
+void Worker::join() {
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void Worker::run() {
+    epoll_event events[MAX_EPOLL_EVENTS];
+    auto lastPublish = std::chrono::steady_clock::now();
+
+    while (!g_stopping) {
+        int count = epoll_wait(m_epoll, events, MAX_EPOLL_EVENTS, EPOLL_TIMEOUT_MS);
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag & LISTEN_TAG) {
+                acceptConnections((int)(tag & 0xFFFFFFFF));
+                continue;
+            }
+
+            int index = (int)tag;
+            int fd = m_connections[index].fd;
+            if (fd < 0) continue;
+            if ((events[i].events & (EPOLLERR | EPOLLHUP)) && !(events[i].events & EPOLLIN)) {
+                closeConnection(index);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) onReadable(index);
+            if ((events[i].events & EPOLLOUT) && m_connections[index].fd == fd) onWritable(index);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPublish >= std::chrono::milliseconds(EPOLL_TIMEOUT_MS)) {
+            publishLatency();
+            lastPublish = now;
+        }
+    }
+
+    for (size_t i = 0; i < m_connections.size(); ++i) {
+        if (m_connections[i].fd >= 0) closeConnection((int)i);
+    }
+}
+
+void Worker::acceptConnections(int listener) {
+    for (int n = 0; n < ACCEPT_BATCH; ++n) {
+        int fd = accept4(m_listenFds[listener], nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN: worker khác đã nhận, hoặc hết kết nối chờ
+
+        if (m_freeConnections.empty()) {
+            stats.rejected++;
+            close(fd);
+            continue;
+        }
+
+        int index = m_freeConnections.back();
+        m_freeConnections.pop_back();
+
+        Connection& conn = m_connections[index];
+        if (!conn.input) {
+            conn.input.reset(new uint8_t[INPUT_BUFFER_SIZE]);
+            conn.output.reset(new uint8_t[OUTPUT_BUFFER_SIZE]);
+        }
+        conn.fd = fd;
+        conn.tcp = m_listenTcp[listener];
+        conn.inputUsed = conn.outputStart = conn.outputEnd = 0;
+        conn.firstSession = -1;
+        conn.events = EPOLLIN;
+
+        if (conn.tcp) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        epoll_event event = {};
+        event.events = conn.events;
+        event.data.u64 = (uint64_t)index;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            std::cerr << "epoll_ctl(add) failed: " << strerror(errno) << std::endl;
+            close(fd);
+            conn.fd = -1;
+            m_freeConnections.push_back(index);
+            continue;
+        }
+        stats.connections++;
+    }
+}
+
+void Worker::closeConnection(int index) {
+    Connection& conn = m_connections[index];
+    while (conn.firstSession >= 0) {
+        releaseSession(conn.firstSession);
+    }
+    close(conn.fd); // close tự gỡ fd khỏi epoll
+    conn.fd = -1;
+    m_freeConnections.push_back(index);
+    stats.connections--;
+}
+
+void Worker::onReadable(int index) {
+    Connection& conn = m_connections[index];
+    if (conn.inputUsed < INPUT_BUFFER_SIZE) {
+        ssize_t received = recv(conn.fd, conn.input.get() + conn.inputUsed, INPUT_BUFFER_SIZE - conn.inputUsed, 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            closeConnection(index);
+            return;
+        }
+        if (received > 0) conn.inputUsed += received;
+    }
+
+    if (!processInput(index) || !flush(index)) {
+        closeConnection(index);
+        return;
+    }
+    updateInterest(index);
+}
+
+void Worker::onWritable(int index) {
+    // Có chỗ trống trong buffer ghi thì xử lý tiếp phần input đang bị giữ lại
+    if (!flush(index) || !processInput(index) || !flush(index)) {
+        closeConnection(index);
+        return;
+    }
+    updateInterest(index);
+}
+
+// Xử lý mọi message đã nhận đủ, dừng khi buffer ghi không còn chỗ cho một câu trả lời. false nếu message sai.
+bool Worker::processInput(int index) {
+    Connection& conn = m_connections[index];
+    const uint8_t* input = conn.input.get();
+    size_t offset = 0;
+
+    while (conn.inputUsed - offset >= MESSAGE_HEADER_SIZE) {
+        size_t payloadSize = getU16(input + offset);
+        if (payloadSize > MAX_MESSAGE_PAYLOAD) return false;
+        if (conn.inputUsed - offset < MESSAGE_HEADER_SIZE + payloadSize) break;
+
+        // Câu trả lời dài nhất là DELTA + ENDED (khi hết giờ)
+        if (OUTPUT_BUFFER_SIZE - conn.outputEnd < 2 * MAX_SERVER_MESSAGE) {
+            if (conn.outputStart > 0) {
+                memmove(conn.output.get(), conn.output.get() + conn.outputStart, conn.outputEnd - conn.outputStart);
+                conn.outputEnd -= conn.outputStart;
+                conn.outputStart = 0;
+            }
+            if (OUTPUT_BUFFER_SIZE - conn.outputEnd < 2 * MAX_SERVER_MESSAGE) break;
+        }
+
+        if (!handleMessage(index, input[offset + 2], input + offset + MESSAGE_HEADER_SIZE, payloadSize)) {
+            return false;
+        }
+        offset += MESSAGE_HEADER_SIZE + payloadSize;
+    }
+
+    if (offset > 0) {
+        memmove(conn.input.get(), input + offset, conn.inputUsed - offset);
+        conn.inputUsed -= offset;
+    }
+    return true;
+}
+
+bool Worker::flush(int index) {
+    Connection& conn = m_connections[index];
+    while (conn.outputStart < conn.outputEnd) {
+        ssize_t sent = send(conn.fd, conn.output.get() + conn.outputStart, conn.outputEnd - conn.outputStart, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK; // Chờ EPOLLOUT
+        }
+        conn.outputStart += sent;
+    }
+    conn.outputStart = conn.outputEnd = 0;
+    return true;
+}
+
+void Worker::updateInterest(int index) {
+    Connection& conn = m_connections[index];
+    uint32_t wanted = 0;
+    if (conn.inputUsed < INPUT_BUFFER_SIZE) wanted |= EPOLLIN; // Buffer đọc đầy: ngừng đọc cho tới khi gửi bớt
+    if (conn.outputStart < conn.outputEnd) wanted |= EPOLLOUT;
+    if (wanted == conn.events) return;
+
+    epoll_event event = {};
+    event.events = wanted;
+    event.data.u64 = (uint64_t)index;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, conn.fd, &event);
+    conn.events = wanted;
+}
+
+void Worker::publishLatency() {
+    if (m_latency.count() == 0) return;
+    std::lock_guard<std::mutex> lock(stats.latencyMutex);
+    stats.latency.merge(m_latency);
+    m_latency.reset();
+}
+
+bool Worker::handleMessage(int index, uint8_t type, const uint8_t* payload, size_t size) {
+    switch (type) {
+        case MSG_START:
+            if (size < 14) return false;
+            handleStart(index, payload);
+            return true;
+        case MSG_SWAP:
+        case MSG_SHUFFLE: {
+            if (size < (type == MSG_SWAP ? 5u : 4u)) return false;
+            auto start = std::chrono::steady_clock::now();
+            if (type == MSG_SWAP) {
+                handleSwap(index, getU32(payload), payload[4]);
+            } else {
+                handleShuffle(index, getU32(payload));
+            }
+            m_latency.record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            return true;
+        }
+        case MSG_END:
+            if (size < 4) return false;
+            handleEnd(index, getU32(payload));
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Worker::handleStart(int index, const uint8_t* payload) {
+    Connection& conn = m_connections[index];
+    uint32_t tag = getU32(payload);
+    uint8_t mode = payload[4];
+    uint8_t level = payload[5];
+    uint64_t seed = getU64(payload + 6);
+
+    uint8_t status = STATUS_OK;
+    int slot = -1;
+    if (mode > SESSION_TIMED || (mode == SESSION_TIMED && level >= m_levels.size())) {
+        status = STATUS_BAD_REQUEST;
+    } else if ((slot = allocateSession(index)) < 0) {
+        status = STATUS_SERVER_FULL;
+    }
+
+    uint8_t* out = beginMessage(conn.output.get() + conn.outputEnd, MSG_STARTED, 12 + SNAPSHOT_CELL_BYTES);
+    putU32(out, tag);
+    uint16_t timeLimit = 0;
+    if (slot >= 0) {
+        Session& session = m_sessions[slot];
+        session.engine = BoardEngine();
+        session.engine.rng.seed(seed != 0 ? seed : ((uint64_t)m_seedRng() << 32 | m_seedRng()));
+        session.engine.initBoard();
+        session.mode = mode;
+        session.shuffles = SHUFFLES_PER_GAME;
+        session.moves = 0;
+        session.targetScore = 0;
+        if (mode == SESSION_TIMED) {
+            timeLimit = (uint16_t)m_levels[level].duration;
+            session.targetScore = m_levels[level].targetScore;
+            session.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeLimit);
+        }
+        putU32(out + 4, session.generation << SESSION_SLOT_BITS | (uint32_t)slot);
+        packCells(session.engine.cells, out + 12);
+    } else {
+        putU32(out + 4, 0);
+        memset(out + 12, 0, SNAPSHOT_CELL_BYTES);
+    }
+    out[8] = status;
+    out[9] = slot >= 0 ? SHUFFLES_PER_GAME : 0;
+    putU16(out + 10, timeLimit);
+    conn.outputEnd += MESSAGE_HEADER_SIZE + 12 + SNAPSHOT_CELL_BYTES;
+}
+
+void Worker::handleSwap(int index, uint32_t id, int action) {
+    Connection& conn = m_connections[index];
+    Session* session = findSession(index, id);
+    if (!session) {
+        writeDelta(conn, id, STATUS_NO_SESSION, nullptr, nullptr);
+        return;
+    }
+    if (endIfTimeUp(conn, id, session)) {
+        return;
+    }
+
+    int8_t before[BOARD_SIZE][BOARD_SIZE];
+    memcpy(before, session->engine.cells, sizeof(before));
+
+    Move move;
+    if (!actionToMove(action, move) || !session->engine.trySwap(move.x1, move.y1, move.x2, move.y2)) {
+        writeDelta(conn, id, STATUS_INVALID_MOVE, session, before);
+        return;
+    }
+    session->moves++;
+    stats.moves.fetch_add(1, std::memory_order_relaxed);
+    writeDelta(conn, id, STATUS_OK, session, before);
+}
+
+void Worker::handleShuffle(int index, uint32_t id) {
+    Connection& conn = m_connections[index];
+    Session* session = findSession(index, id);
+    if (!session) {
+        writeDelta(conn, id, STATUS_NO_SESSION, nullptr, nullptr);
+        return;
+    }
+    if (endIfTimeUp(conn, id, session)) {
+        return;
+    }
+    if (session->shuffles == 0) {
+        writeDelta(conn, id, STATUS_NO_SHUFFLES, session, session->engine.cells);
+        return;
+    }
+
+    int8_t before[BOARD_SIZE][BOARD_SIZE];
+    memcpy(before, session->engine.cells, sizeof(before));
+    session->engine.shuffle();
+    session->shuffles--;
+    writeDelta(conn, id, STATUS_OK, session, before);
+}
+
+// Mọi lệnh thay đổi bàn của ván timed đều phải qua đây: hết giờ thì trả TIME_UP, ENDED rồi giải phóng session
+bool Worker::endIfTimeUp(Connection& conn, uint32_t id, Session* session) {
+    if (session->mode != SESSION_TIMED || std::chrono::steady_clock::now() < session->deadline) {
+        return false;
+    }
+    writeDelta(conn, id, STATUS_TIME_UP, session, session->engine.cells);
+    writeEnded(conn, id, STATUS_TIME_UP, session);
+    releaseSession(id & ((1u << SESSION_SLOT_BITS) - 1));
+    return true;
+}
+
+void Worker::handleEnd(int index, uint32_t id) {
+    Connection& conn = m_connections[index];
+    Session* session = findSession(index, id);
+    writeEnded(conn, id, session ? STATUS_OK : STATUS_NO_SESSION, session);
+    if (session) {
+        releaseSession(id & ((1u << SESSION_SLOT_BITS) - 1));
+    }
+}
+
+// before == nullptr: không có session, gửi delta rỗng
+void Worker::writeDelta(Connection& conn, uint32_t id, uint8_t status, const Session* session,
+                        const int8_t before[BOARD_SIZE][BOARD_SIZE]) {
+    uint8_t* message = conn.output.get() + conn.outputEnd;
+    uint8_t* out = message + MESSAGE_HEADER_SIZE;
+    putU32(out, id);
+    out[4] = status;
+    out[5] = 0;
+    out[6] = 0;
+    out[7] = 0;
+    putU32(out + 8, 0);
+
+    size_t deltaSize;
+    if (session) {
+        Move moves[MAX_MOVES];
+        if (session->engine.listMoves(moves) == 0) out[5] |= DELTA_FLAG_NO_MOVES;
+        out[6] = status == STATUS_OK ? (uint8_t)session->engine.lastCascadeDepth : 0;
+        out[7] = session->shuffles;
+        putU32(out + 8, (uint32_t)session->engine.score);
+        deltaSize = encodeCellDelta(before, session->engine.cells, out + DELTA_HEADER_SIZE);
+    } else {
+        putU64(out + DELTA_HEADER_SIZE, 0);
+        deltaSize = 8;
+    }
+
+    beginMessage(message, MSG_DELTA, DELTA_HEADER_SIZE + deltaSize);
+    conn.outputEnd += MESSAGE_HEADER_SIZE + DELTA_HEADER_SIZE + deltaSize;
+}
+
+void Worker::writeEnded(Connection& conn, uint32_t id, uint8_t status, const Session* session) {
+    uint8_t* out = beginMessage(conn.output.get() + conn.outputEnd, MSG_ENDED, 14);
+    putU32(out, id);
+    out[4] = status;
+    out[5] = session && session->mode == SESSION_TIMED && session->engine.score >= session->targetScore ? 1 : 0;
+    putU32(out + 6, session ? (uint32_t)session->engine.score : 0);
+    putU32(out + 10, session ? session->moves : 0);
+    conn.outputEnd += MESSAGE_HEADER_SIZE + 14;
+}
+
+Session* Worker::findSession(int connection, uint32_t id) {
+    uint32_t slot = id & ((1u << SESSION_SLOT_BITS) - 1);
+    if (slot >= m_sessions.size()) return nullptr;
+    Session& session = m_sessions[slot];
+    if (session.connection != connection || session.generation != id >> SESSION_SLOT_BITS) return nullptr;
+    return &session;
+}
+
+int Worker::allocateSession(int connection) {
+    if (m_freeSessions.empty()) return -1;
+    int slot = m_freeSessions.back();
+    m_freeSessions.pop_back();
+
+    Session& session = m_sessions[slot];
+    Connection& conn = m_connections[connection];
+    session.connection = connection;
+    session.prev = -1;
+    session.next = conn.firstSession;
+    if (conn.firstSession >= 0) m_sessions[conn.firstSession].prev = slot;
+    conn.firstSession = slot;
+    stats.sessions++;
+    return slot;
+}
+
+void Worker::releaseSession(int slot) {
+    Session& session = m_sessions[slot];
+    Connection& conn = m_connections[session.connection];
+    if (session.prev >= 0) m_sessions[session.prev].next = session.next;
+    else conn.firstSession = session.next;
+    if (session.next >= 0) m_sessions[session.next].prev = session.prev;
+
+    session.connection = -1;
+    session.generation = (session.generation + 1) & ((1u << (32 - SESSION_SLOT_BITS)) - 1); // id cũ không dùng lại được
+    m_freeSessions.push_back(slot);
+    stats.sessions--;
+}
+
+struct StatsSnapshot {
+    int sessions = 0;
+    int connections = 0;
+    uint64_t moves = 0;
+    uint64_t rejected = 0;
+    double movesPerSecond = 0.0;
+    double p50 = 0.0, p99 = 0.0, maxMs = 0.0; // Cửa sổ 1 giây gần nhất
+};
+
+static std::mutex g_statsMutex;
+static StatsSnapshot g_stats;
+
+static int listenTcp(const std::string& address, int port) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Invalid bind address: " << address << std::endl;
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on " << address << ":" << port << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenUnix(const std::string& path) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Unix socket path too long: " << path << std::endl;
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on " << path << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Trả lời mọi request bằng một trang text/plain, đủ cho curl và script giám sát
+static void serveStats(int listenFd) {
+    while (!g_stopping) {
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+
+        char request[1024];
+        pollfd client = {fd, POLLIN, 0};
+        if (poll(&client, 1, 100) > 0) {
+            recv(fd, request, sizeof(request), 0);
+        }
+
+        StatsSnapshot snapshot;
+        {
+            std::lock_guard<std::mutex> lock(g_statsMutex);
+            snapshot = g_stats;
+        }
+
+        char body[512];
+        int bodySize = snprintf(body, sizeof(body),
+            "sessions %d\nconnections %d\nrejected_connections %llu\nmoves_total %llu\n"
+            "moves_per_sec %.1f\nmove_latency_p50_ms %.4f\nmove_latency_p99_ms %.4f\nmove_latency_max_ms %.4f\n",
+            snapshot.sessions, snapshot.connections, (unsigned long long)snapshot.rejected,
+            (unsigned long long)snapshot.moves, snapshot.movesPerSecond, snapshot.p50, snapshot.p99, snapshot.maxMs);
+
+        char response[768];
+        int size = snprintf(response, sizeof(response),
+            "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %d\r\n\r\n%s", bodySize, body);
+        send(fd, response, size, MSG_NOSIGNAL);
+        close(fd);
+    }
+}
+
+static bool parseArgs(int argc, char* argv[], ServerConfig& config) {
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for option: " << argv[i] << std::endl;
+            return false;
+        }
+        if (strcmp(argv[i], "--port") == 0) config.port = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--bind") == 0) config.bindAddress = argv[i + 1];
+        else if (strcmp(argv[i], "--unix") == 0) config.unixPath = argv[i + 1];
+        else if (strcmp(argv[i], "--stats-port") == 0) config.statsPort = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--workers") == 0) config.workers = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--max-connections") == 0) config.maxConnections = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--max-sessions") == 0) config.maxSessions = atoi(argv[i + 1]);
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    // Slot nằm trong SESSION_SLOT_BITS bit thấp của id; nhiều hơn thì findSession trỏ nhầm phiên
+    if (config.maxSessions > (1 << SESSION_SLOT_BITS)) {
+        std::cerr << "--max-sessions must be at most " << (1 << SESSION_SLOT_BITS) << std::endl;
+        return false;
+    }
+    if (config.maxConnections <= 0 || config.maxSessions <= 0 ||
+        (config.port == 0 && config.unixPath.empty())) {
+        std::cerr << "Invalid options" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<int> listenFds;
+    std::vector<bool> listenTcpFlags;
+    if (config.port != 0) {
+        int fd = listenTcp(config.bindAddress, config.port);
+        if (fd < 0) return 1;
+        listenFds.push_back(fd);
+        listenTcpFlags.push_back(true);
+    }
+    if (!config.unixPath.empty()) {
+        int fd = listenUnix(config.unixPath);
+        if (fd < 0) return 1;
+        listenFds.push_back(fd);
+        listenTcpFlags.push_back(false);
+    }
+
+    int statsFd = -1;
+    std::thread statsThread;
+    if (config.statsPort != 0) {
+        statsFd = listenTcp("127.0.0.1", config.statsPort); // Thống kê chỉ nghe local
+        if (statsFd < 0) return 1;
+        statsThread = std::thread(serveStats, statsFd);
+    }
+
+    int workerCount = config.workers > 0 ? config.workers : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(new Worker(i, config, listenFds, listenTcpFlags));
+        if (!workers.back()->start()) {
+            g_stopping = true;
+            break;
+        }
+    }
+
+    std::cout << "jewelserver: " << workerCount << " workers, " << config.maxSessions * workerCount << " sessions max";
+    if (config.port != 0) std::cout << ", tcp " << config.bindAddress << ":" << config.port;
+    if (!config.unixPath.empty()) std::cout << ", unix " << config.unixPath;
+    if (config.statsPort != 0) std::cout << ", stats 127.0.0.1:" << config.statsPort;
+    std::cout << std::endl;
+
+    // Lấy mẫu mỗi giây: gộp số liệu các worker cho stats endpoint
+    uint64_t lastMoves = 0;
+    auto lastSample = std::chrono::steady_clock::now();
+    while (!g_stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastSample).count();
+        if (elapsed < 1.0) continue;
+
+        StatsSnapshot snapshot;
+        LatencyHistogram window(LATENCY_MIN_MS);
+        for (auto& worker : workers) {
+            snapshot.sessions += worker->stats.sessions.load();
+            snapshot.connections += worker->stats.connections.load();
+            snapshot.moves += worker->stats.moves.load();
+            snapshot.rejected += worker->stats.rejected.load();
+            std::lock_guard<std::mutex> lock(worker->stats.latencyMutex);
+            window.merge(worker->stats.latency);
+            worker->stats.latency.reset();
+        }
+        snapshot.movesPerSecond = (snapshot.moves - lastMoves) / elapsed;
+        snapshot.p50 = window.percentile(0.50);
+        snapshot.p99 = window.percentile(0.99);
+        snapshot.maxMs = window.max();
+        lastMoves = snapshot.moves;
+        lastSample = now;
+
+        std::lock_guard<std::mutex> lock(g_statsMutex);
+        g_stats = snapshot;
+    }
+
+    uint64_t totalMoves = 0;
+    for (auto& worker : workers) {
+        worker->join();
+        totalMoves += worker->stats.moves.load();
+    }
+    if (statsThread.joinable()) statsThread.join();
+    if (statsFd >= 0) close(statsFd);
+    for (int fd : listenFds) close(fd);
+    if (!config.unixPath.empty()) unlink(config.unixPath.c_str());
+
+    std::cout << "jewelserver: " << totalMoves << " moves served" << std::endl;
+    return 0;
+}
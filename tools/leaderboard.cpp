@@ -0,0 +1,177 @@
+// Công cụ cho kho hồ sơ profiles.db (profilestore.h).
+// Cách dùng: leaderboard [--db FILE] [--board N] [--top N]           in bảng xếp hạng (N: 0 Normal, 1 Practice, 2-4 Timed level 1-3)
+//            leaderboard --bench PLAYERS [--games N] [--db FILE]      tạo kho giả lập cả cụm kiosk rồi đo mở file, ghi ván, hỏi hạng
+//            leaderboard --torn [--db FILE]                           mô phỏng mất điện giữa lúc ghi rồi kiểm tra lần mở sau
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../profilestore.h"
+#include "../rng.h"
+
+struct ToolConfig {
+    std::string dbFile = "profiles.db";
+    int board = BOARD_NORMAL;
+    int top = 10;
+    int benchPlayers = 0;
+    int games = 0; // 0 = 5 ván mỗi người chơi
+    bool torn = false;
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+static const char* boardName(int board) {
+    static const char* names[NUM_LEADERBOARDS] = {"Normal", "Practice", "Timed 1", "Timed 2", "Timed 3"};
+    return board >= 0 && board < NUM_LEADERBOARDS ? names[board] : "?";
+}
+
+static int runTop(const ToolConfig& config) {
+    ProfileStore store;
+    if (!store.open(config.dbFile)) return 1;
+    LeaderboardId board = (LeaderboardId)config.board;
+    std::vector<LeaderboardEntry> entries(config.top);
+    int count = store.top(board, entries.data(), config.top);
+    std::cout << boardName(config.board) << ": " << store.boardSize(board) << " ranked of " << store.profileCount()
+              << " profiles, " << store.recordCount() << " records" << std::endl;
+    for (int i = 0; i < count; ++i) {
+        ProfileRecord record;
+        store.profile(entries[i].profileId, record);
+        const ModeStats& stats = record.stats[config.board];
+        std::cout << std::setw(4) << i + 1 << "  " << std::left << std::setw(PROFILE_NAME_BYTES) << record.name << std::right
+                  << std::setw(8) << entries[i].score << "  " << stats.played << " played, " << stats.wins << " won, money "
+                  << record.playerMoney << std::endl;
+    }
+    return 0;
+}
+
+static int runBench(const ToolConfig& config) {
+    remove(config.dbFile.c_str());
+    int games = config.games > 0 ? config.games : config.benchPlayers * 5;
+    JewelRng rng(1);
+
+    ProfileStore store;
+    if (!store.open(config.dbFile)) return 1;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.benchPlayers; ++i) {
+        if (store.createProfile("player" + std::to_string(i), 10000, 1700000000u + i) < 0) {
+            std::cerr << "Failed to create profile " << i << std::endl;
+            return 1;
+        }
+    }
+    double createMs = elapsedMs(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < games; ++i) {
+        int profileId = (int)rng.below(config.benchPlayers);
+        LeaderboardId board = (LeaderboardId)rng.below(NUM_LEADERBOARDS);
+        int score = (int)rng.below(20000);
+        store.recordGame(profileId, board, score, score > 10000, 10000 + score, 1700100000u + i);
+    }
+    double gameMs = elapsedMs(begin);
+    uint32_t records = store.recordCount();
+    store.close();
+
+    begin = std::chrono::steady_clock::now();
+    if (!store.open(config.dbFile)) return 1;
+    double openMs = elapsedMs(begin);
+
+    // Đối chiếu rank() với một lần đếm tuyến tính trên top()
+    std::vector<LeaderboardEntry> all(store.boardSize(BOARD_NORMAL));
+    int ranked = store.top(BOARD_NORMAL, all.data(), (int)all.size());
+    int wrong = 0;
+    for (int i = 0; i < ranked; ++i) {
+        if (store.rank(BOARD_NORMAL, all[i].profileId) != i + 1) ++wrong;
+        if (i > 0 && all[i].score > all[i - 1].score) ++wrong;
+    }
+
+    const int queries = 1000000;
+    long long checksum = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; ++i) {
+        checksum += store.rank((LeaderboardId)(i % NUM_LEADERBOARDS), (int)rng.below(config.benchPlayers));
+    }
+    double rankNs = elapsedMs(begin) * 1e6 / queries;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << config.benchPlayers << " profiles created in " << createMs << " ms ("
+              << createMs * 1000.0 / config.benchPlayers << " us each, flushed)" << std::endl;
+    std::cout << games << " games recorded in " << gameMs << " ms (" << gameMs * 1000.0 / games << " us each, flushed)" << std::endl;
+    std::cout << "Reopen: " << openMs << " ms for " << records << " records -> " << store.recordCount()
+              << " after compaction" << std::endl;
+    std::cout << "rank(): " << rankNs << " ns per query (checksum " << checksum << ")" << std::endl;
+    std::cout << (wrong == 0 ? "Ranks match the sorted leaderboard" : "MISMATCHED ranks: " + std::to_string(wrong)) << std::endl;
+    return wrong == 0 ? 0 : 1;
+}
+
+// Viết nửa record cuối bằng rác như khi mất điện giữa chừng, rồi mở lại
+static int runTorn(const ToolConfig& config) {
+    remove(config.dbFile.c_str());
+    ProfileStore store;
+    if (!store.open(config.dbFile)) return 1;
+    int first = store.createProfile("alice", 10000, 1);
+    int second = store.createProfile("bob", 10000, 2);
+    store.recordGame(first, BOARD_TIMED_1, 1200, true, 9500, 3);
+    store.recordGame(second, BOARD_TIMED_1, 800, false, 9000, 4);
+    store.recordGame(first, BOARD_TIMED_1, 1500, true, 9800, 5);
+    uint32_t records = store.recordCount();
+    store.close();
+
+    {
+        std::fstream file(config.dbFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(PROFILE_HEADER_SIZE + (std::streamoff)(records - 1) * sizeof(ProfileRecord) + 40);
+        const char garbage[60] = "torn write";
+        file.write(garbage, sizeof(garbage));
+        // Record sau đó mới ghi được vài byte đầu
+        file.seekp(PROFILE_HEADER_SIZE + (std::streamoff)records * sizeof(ProfileRecord));
+        uint32_t magic = PROFILE_RECORD_MAGIC;
+        file.write((const char*)&magic, sizeof(magic));
+    }
+
+    if (!store.open(config.dbFile)) return 1;
+    ProfileRecord record;
+    store.profile(first, record);
+    bool ok = store.recordCount() == records - 1 && store.discardedRecords() == 2 &&
+              record.stats[BOARD_TIMED_1].bestScore == 1200 && store.rank(BOARD_TIMED_1, first) == 1 &&
+              store.rank(BOARD_TIMED_1, second) == 2;
+
+    // Lần ghi tiếp theo nằm ngay sau record hợp lệ cuối và vẫn mở lại được
+    store.recordGame(first, BOARD_TIMED_1, 1500, true, 9800, 6);
+    store.close();
+    store.open(config.dbFile);
+    store.profile(first, record);
+    ok = ok && store.recordCount() == records && store.discardedRecords() == 0 && record.stats[BOARD_TIMED_1].bestScore == 1500;
+
+    std::cout << (ok ? "Torn tail dropped, earlier records intact, appends resume cleanly" : "TORN WRITE RECOVERY FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    ToolConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--db" && hasValue) config.dbFile = argv[++i];
+        else if (arg == "--board" && hasValue) config.board = std::max(0, std::min(atoi(argv[++i]), NUM_LEADERBOARDS - 1));
+        else if (arg == "--top" && hasValue) config.top = std::max(1, atoi(argv[++i]));
+        else if (arg == "--bench" && hasValue) config.benchPlayers = std::max(1, atoi(argv[++i]));
+        else if (arg == "--games" && hasValue) config.games = atoi(argv[++i]);
+        else if (arg == "--torn") config.torn = true;
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (config.torn) return runTorn(config);
+    if (config.benchPlayers > 0) return runBench(config);
+    return runTop(config);
+}
@@ -0,0 +1,147 @@
+// Sinh bàn chơi song song, lọc theo thuộc tính rồi ghi ra level pack (levels.pak)
+// Cách dùng: levelgen [--out FILE] [--candidates N] [--min-moves N] [--max-moves N]
+//                     [--min-cascade N] [--min-match 3|4|5] [--limit N] [--seed N] [--threads N]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../levelpack.h"
+#include "../threadpool.h"
+
+struct GeneratorConfig {
+    std::string outFile = "levels.pak";
+    uint64_t candidates = 100000;
+    int minMoves = 1;
+    int maxMoves = MAX_MOVES;
+    int minCascade = 1;  // Lượt ăn dây chuyền tối thiểu của nước tốt nhất (1 = chỉ ăn một lượt)
+    int minMatch = 3;    // 4 hoặc 5: bắt buộc có nước tạo hàng 4/5
+    uint32_t limit = 0;  // 0 = giữ mọi bàn đạt yêu cầu
+    uint64_t seed = 1;
+    int threads = 0;
+};
+
+const uint64_t CANDIDATES_PER_TASK = 1024;
+
+static uint64_t mixSeed(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static bool passesFilters(const GeneratorConfig& config, const LevelRecord& record) {
+    return record.legalMoves >= config.minMoves && record.legalMoves <= config.maxMoves &&
+           record.maxCascade >= config.minCascade && record.longestMatch >= config.minMatch;
+}
+
+static bool writeLevelPack(const GeneratorConfig& config, const std::vector<LevelRecord>& records) {
+    LevelPackHeader header = {};
+    header.magic = LEVEL_PACK_MAGIC;
+    header.version = LEVEL_PACK_VERSION;
+    header.recordCount = (uint32_t)records.size();
+    header.recordSize = sizeof(LevelRecord);
+    header.recordOffset = (sizeof(LevelPackHeader) + (LEVEL_BUCKET_COUNT + 1) * sizeof(uint32_t) + 63) / 64 * 64;
+    header.generatorSeed = config.seed;
+
+    // records đã sắp theo legalMoves nên bucketStart[n] là record đầu tiên có legalMoves >= n
+    std::vector<uint32_t> bucketStart(LEVEL_BUCKET_COUNT + 1);
+    for (int n = 0; n <= LEVEL_BUCKET_COUNT; ++n) {
+        bucketStart[n] = (uint32_t)(std::lower_bound(records.begin(), records.end(), n,
+            [](const LevelRecord& record, int moves) { return record.legalMoves < moves; }) - records.begin());
+    }
+
+    FILE* file = fopen(config.outFile.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create level pack: " << config.outFile << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> prefix(header.recordOffset, 0);
+    memcpy(prefix.data(), &header, sizeof(header));
+    memcpy(prefix.data() + sizeof(header), bucketStart.data(), bucketStart.size() * sizeof(uint32_t));
+
+    bool ok = fwrite(prefix.data(), 1, prefix.size(), file) == prefix.size() &&
+              (records.empty() || fwrite(records.data(), sizeof(LevelRecord), records.size(), file) == records.size());
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write level pack: " << config.outFile << std::endl;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--out") == 0) config.outFile = argv[i + 1];
+        else if (strcmp(argv[i], "--candidates") == 0) config.candidates = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--min-moves") == 0) config.minMoves = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--max-moves") == 0) config.maxMoves = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--min-cascade") == 0) config.minCascade = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--min-match") == 0) config.minMatch = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--limit") == 0) config.limit = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--seed") == 0) config.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--threads") == 0) config.threads = atoi(argv[i + 1]);
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    ThreadPool pool(config.threads);
+    uint64_t taskCount = (config.candidates + CANDIDATES_PER_TASK - 1) / CANDIDATES_PER_TASK;
+    std::vector<std::vector<LevelRecord>> survivors(taskCount);
+    auto start = std::chrono::steady_clock::now();
+
+    // Mỗi task ghi vào vector riêng, không cần lock; candidate i luôn dùng seed i nên kết quả tái lập được
+    for (uint64_t task = 0; task < taskCount; ++task) {
+        pool.submit([&, task] {
+            uint64_t first = task * CANDIDATES_PER_TASK;
+            uint64_t last = std::min(first + CANDIDATES_PER_TASK, config.candidates);
+            BoardEngine board;
+            LevelRecord record;
+            for (uint64_t candidate = first; candidate < last; ++candidate) {
+                uint64_t boardSeed = mixSeed(config.seed ^ (candidate << 1));
+                board.rng.seed(boardSeed);
+                board.initBoard();
+                analyzeLevel(board, mixSeed(boardSeed), record);
+                if (passesFilters(config, record)) {
+                    survivors[task].push_back(record);
+                }
+            }
+        });
+    }
+    pool.wait();
+
+    std::vector<LevelRecord> records;
+    for (const auto& part : survivors) {
+        records.insert(records.end(), part.begin(), part.end());
+    }
+    if (config.limit > 0 && records.size() > config.limit) {
+        records.resize(config.limit);
+    }
+    std::stable_sort(records.begin(), records.end(), [](const LevelRecord& a, const LevelRecord& b) {
+        return a.legalMoves < b.legalMoves;
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << config.candidates << " candidates, " << records.size() << " kept ("
+              << (config.candidates ? 100.0 * records.size() / config.candidates : 0.0) << "%) in "
+              << seconds << " s, " << config.candidates / std::max(seconds, 1e-9) << " boards/sec" << std::endl;
+
+    int cascadeHistogram[8] = {};
+    for (const LevelRecord& record : records) {
+        cascadeHistogram[std::min<int>(record.maxCascade, 7)]++;
+    }
+    std::cout << "Max cascade:";
+    for (int depth = 1; depth < 8; ++depth) {
+        std::cout << " " << depth << (depth == 7 ? "+" : "") << "=" << cascadeHistogram[depth];
+    }
+    std::cout << std::endl;
+
+    return writeLevelPack(config, records) ? 0 : 1;
+}
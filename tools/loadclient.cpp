@@ -0,0 +1,426 @@
+// Giả lập nhiều client cho jewelserver để load test. Chỉ chạy trên Linux (epoll).
+// Cách dùng: loadclient [--host ADDR] [--port N | --unix PATH] [--connections N] [--sessions N]
+//                       [--threads N] [--seconds N] [--timed LEVEL] [--seed N] [--stats-port N]
+//
+// Mỗi session giữ một bản sao bàn đá, dựng lại từ STARTED và các DELTA, rồi chọn ngẫu nhiên một nước
+// hợp lệ trên bản sao đó. Server báo INVALID_MOVE nghĩa là delta đã làm lệch bản sao ("desync", phải bằng 0).
+#ifndef __linux__
+#error "loadclient needs Linux (epoll)"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../board.h"
+#include "../gamesnapshot.h"
+#include "../latencyprofiler.h"
+#include "../sessionprotocol.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct ClientConfig {
+    std::string host = "127.0.0.1";
+    int port = 7777;
+    std::string unixPath;
+    int connections = 64;
+    int sessionsPerConnection = 16;
+    int threads = 4;
+    int seconds = 10;
+    int timedLevel = -1; // -1 = normal mode
+    uint64_t seed = 1;
+    int statsPort = 0;   // Khác 0: in thống kê của server khi xong
+};
+
+const size_t CLIENT_BUFFER_SIZE = 65536;
+const double RTT_MIN_MS = 0.05; // Histogram từ 50 µs tới ~200 ms: nhiều session cùng chờ thì round trip lớn
+
+struct ClientSession {
+    uint32_t id = 0;
+    bool active = false;
+    BoardEngine mirror;
+    uint8_t shuffles = 0;
+    Clock::time_point sentAt;
+};
+
+struct ClientConnection {
+    int fd = -1;
+    std::unique_ptr<uint8_t[]> input{new uint8_t[CLIENT_BUFFER_SIZE]};
+    std::unique_ptr<uint8_t[]> output{new uint8_t[CLIENT_BUFFER_SIZE]};
+    size_t inputUsed = 0;
+    size_t outputStart = 0, outputEnd = 0;
+    bool wantWrite = false;
+    std::vector<ClientSession> sessions;
+};
+
+struct ClientStats {
+    uint64_t moves = 0;
+    uint64_t shuffles = 0;
+    uint64_t games = 0;
+    uint64_t desyncs = 0;
+    uint64_t errors = 0;
+    LatencyHistogram rtt{RTT_MIN_MS};
+};
+
+static int connectToServer(const ClientConfig& config) {
+    int fd;
+    if (!config.unixPath.empty()) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, config.unixPath.c_str(), sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)config.port);
+        inet_pton(AF_INET, config.host.c_str(), &addr.sin_addr);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+        int one = 1;
+        if (fd >= 0) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    if (fd < 0) {
+        std::cerr << "Failed to connect: " << strerror(errno) << std::endl;
+    }
+    return fd;
+}
+
+class ClientThread {
+public:
+    ClientThread(const ClientConfig& config, int index, int firstConnection, int lastConnection)
+        : m_config(config), m_rng(config.seed * 0x9E3779B97F4A7C15ULL + index),
+          m_firstConnection(firstConnection), m_lastConnection(lastConnection) {}
+
+    void run();
+
+    ClientStats stats;
+    bool ok = true;
+
+private:
+    void sendStart(ClientConnection& conn, int slot);
+    void sendNext(ClientConnection& conn, int slot);
+    bool handleMessage(ClientConnection& conn, uint8_t type, const uint8_t* payload, size_t size);
+    bool flush(ClientConnection& conn);
+    uint8_t* reserve(ClientConnection& conn, size_t size);
+
+    const ClientConfig& m_config;
+    JewelRng m_rng;
+    int m_firstConnection, m_lastConnection;
+    bool m_running = true;
+};
+
+uint8_t* ClientThread::reserve(ClientConnection& conn, size_t size) {
+    if (CLIENT_BUFFER_SIZE - conn.outputEnd < size) {
+        memmove(conn.output.get(), conn.output.get() + conn.outputStart, conn.outputEnd - conn.outputStart);
+        conn.outputEnd -= conn.outputStart;
+        conn.outputStart = 0;
+    }
+    uint8_t* out = conn.output.get() + conn.outputEnd;
+    conn.outputEnd += size;
+    return out;
+}
+
+void ClientThread::sendStart(ClientConnection& conn, int slot) {
+    uint8_t* out = beginMessage(reserve(conn, MESSAGE_HEADER_SIZE + 14), MSG_START, 14);
+    putU32(out, (uint32_t)slot);
+    out[4] = m_config.timedLevel >= 0 ? SESSION_TIMED : SESSION_NORMAL;
+    out[5] = (uint8_t)std::max(0, m_config.timedLevel);
+    putU64(out + 6, ((uint64_t)m_rng() << 32 | m_rng()) | 1);
+    conn.sessions[slot].sentAt = Clock::now();
+}
+
+// Chọn nước trên bản sao; hết nước thì shuffle, hết lượt shuffle thì kết thúc ván
+void ClientThread::sendNext(ClientConnection& conn, int slot) {
+    ClientSession& session = conn.sessions[slot];
+    if (!m_running) {
+        session.active = false;
+        return;
+    }
+
+    Move moves[MAX_MOVES];
+    int count = session.mirror.listMoves(moves);
+    uint8_t* out;
+    if (count > 0) {
+        out = beginMessage(reserve(conn, MESSAGE_HEADER_SIZE + 5), MSG_SWAP, 5);
+        putU32(out, session.id);
+        out[4] = (uint8_t)moveToAction(moves[m_rng.below(count)]);
+    } else if (session.shuffles > 0) {
+        out = beginMessage(reserve(conn, MESSAGE_HEADER_SIZE + 4), MSG_SHUFFLE, 4);
+        putU32(out, session.id);
+    } else {
+        out = beginMessage(reserve(conn, MESSAGE_HEADER_SIZE + 4), MSG_END, 4);
+        putU32(out, session.id);
+    }
+    session.sentAt = Clock::now();
+}
+
+bool ClientThread::handleMessage(ClientConnection& conn, uint8_t type, const uint8_t* payload, size_t size) {
+    if (type == MSG_STARTED) {
+        if (size < 12 + (size_t)SNAPSHOT_CELL_BYTES) return false;
+        uint32_t slot = getU32(payload);
+        if (slot >= conn.sessions.size()) return false;
+        ClientSession& session = conn.sessions[slot];
+        if (payload[8] != STATUS_OK) {
+            stats.errors++;
+            session.active = false;
+            return true;
+        }
+        session.id = getU32(payload + 4);
+        session.shuffles = payload[9];
+        session.active = true;
+        unpackCells(payload + 12, session.mirror.cells);
+        sendNext(conn, (int)slot);
+        return true;
+    }
+
+    if (size < 4) return false;
+    uint32_t id = getU32(payload);
+    int slot = -1;
+    for (size_t i = 0; i < conn.sessions.size(); ++i) {
+        if (conn.sessions[i].active && conn.sessions[i].id == id) {
+            slot = (int)i;
+            break;
+        }
+    }
+    if (slot < 0) return false;
+    ClientSession& session = conn.sessions[slot];
+
+    if (type == MSG_DELTA) {
+        if (size < DELTA_HEADER_SIZE) return false;
+        uint8_t status = payload[4];
+        if (status == STATUS_TIME_UP) return true; // ENDED theo ngay sau
+
+        stats.rtt.record(std::chrono::duration<double, std::milli>(Clock::now() - session.sentAt).count());
+        if (status == STATUS_OK) {
+            if (applyCellDelta(payload + DELTA_HEADER_SIZE, size - DELTA_HEADER_SIZE, session.mirror.cells) == 0) return false;
+            if (session.shuffles != payload[7]) stats.shuffles++;
+            else stats.moves++;
+            session.shuffles = payload[7];
+            sendNext(conn, slot);
+        } else if (status == STATUS_INVALID_MOVE) {
+            // Bản sao đã lệch: xóa bàn để sendNext gửi END rồi bắt đầu ván mới
+            stats.desyncs++;
+            session.shuffles = 0;
+            memset(session.mirror.cells, -1, sizeof(session.mirror.cells));
+            sendNext(conn, slot);
+        } else {
+            stats.errors++;
+            session.active = false;
+        }
+        return true;
+    }
+
+    if (type == MSG_ENDED) {
+        stats.games++;
+        session.active = false;
+        if (m_running) sendStart(conn, slot);
+        return true;
+    }
+    return false;
+}
+
+bool ClientThread::flush(ClientConnection& conn) {
+    while (conn.outputStart < conn.outputEnd) {
+        ssize_t sent = send(conn.fd, conn.output.get() + conn.outputStart, conn.outputEnd - conn.outputStart, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        conn.outputStart += sent;
+    }
+    conn.outputStart = conn.outputEnd = 0;
+    return true;
+}
+
+void ClientThread::run() {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<ClientConnection> connections(m_lastConnection - m_firstConnection);
+
+    for (size_t i = 0; i < connections.size(); ++i) {
+        ClientConnection& conn = connections[i];
+        conn.fd = connectToServer(m_config);
+        if (conn.fd < 0) {
+            ok = false;
+            break;
+        }
+        fcntl(conn.fd, F_SETFL, fcntl(conn.fd, F_GETFL) | O_NONBLOCK);
+
+        conn.sessions.resize(m_config.sessionsPerConnection);
+        for (int slot = 0; slot < m_config.sessionsPerConnection; ++slot) {
+            sendStart(conn, slot);
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, conn.fd, &event);
+    }
+
+    auto deadline = Clock::now() + std::chrono::seconds(m_config.seconds);
+    epoll_event events[256];
+    while (ok) {
+        if (m_running && Clock::now() >= deadline) m_running = false;
+
+        // Gửi các yêu cầu đang chờ; send bị EAGAIN thì chờ EPOLLOUT
+        bool pending = false;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            ClientConnection& conn = connections[i];
+            if (!flush(conn)) {
+                ok = false;
+                break;
+            }
+            bool wantWrite = conn.outputStart < conn.outputEnd;
+            if (wantWrite != conn.wantWrite) {
+                epoll_event event = {};
+                event.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+                event.data.u64 = i;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+                conn.wantWrite = wantWrite;
+            }
+            for (const ClientSession& session : conn.sessions) {
+                pending = pending || session.active;
+            }
+        }
+        if (!m_running && !pending) break;
+
+        int count = epoll_wait(epollFd, events, 256, 100);
+        for (int e = 0; e < count && ok; ++e) {
+            ClientConnection& conn = connections[events[e].data.u64];
+            if (!(events[e].events & EPOLLIN)) continue;
+
+            ssize_t received = recv(conn.fd, conn.input.get() + conn.inputUsed, CLIENT_BUFFER_SIZE - conn.inputUsed, MSG_DONTWAIT);
+            if (received <= 0) {
+                if (received < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                std::cerr << "Server closed connection" << std::endl;
+                ok = false;
+                break;
+            }
+            conn.inputUsed += received;
+
+            size_t offset = 0;
+            while (conn.inputUsed - offset >= MESSAGE_HEADER_SIZE) {
+                size_t payloadSize = getU16(conn.input.get() + offset);
+                if (conn.inputUsed - offset < MESSAGE_HEADER_SIZE + payloadSize) break;
+                if (!handleMessage(conn, conn.input[offset + 2], conn.input.get() + offset + MESSAGE_HEADER_SIZE, payloadSize)) {
+                    std::cerr << "Malformed message from server" << std::endl;
+                    ok = false;
+                    break;
+                }
+                offset += MESSAGE_HEADER_SIZE + payloadSize;
+            }
+            memmove(conn.input.get(), conn.input.get() + offset, conn.inputUsed - offset);
+            conn.inputUsed -= offset;
+        }
+    }
+
+    for (ClientConnection& conn : connections) {
+        if (conn.fd >= 0) close(conn.fd);
+    }
+    close(epollFd);
+}
+
+static void printServerStats(const ClientConfig& config) {
+    ClientConfig statsConfig = config;
+    statsConfig.unixPath.clear();
+    statsConfig.port = config.statsPort;
+    int fd = connectToServer(statsConfig);
+    if (fd < 0) return;
+
+    const char request[] = "GET / HTTP/1.0\r\n\r\n";
+    send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL);
+    std::string response;
+    char buffer[1024];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, received);
+    }
+    close(fd);
+
+    size_t body = response.find("\r\n\r\n");
+    std::cout << "Server stats:" << std::endl << (body == std::string::npos ? response : response.substr(body + 4));
+}
+
+int main(int argc, char* argv[]) {
+    ClientConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--host") == 0) config.host = argv[i + 1];
+        else if (strcmp(argv[i], "--port") == 0) config.port = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--unix") == 0) config.unixPath = argv[i + 1];
+        else if (strcmp(argv[i], "--connections") == 0) config.connections = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--sessions") == 0) config.sessionsPerConnection = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) config.threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seconds") == 0) config.seconds = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--timed") == 0) config.timedLevel = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) config.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--stats-port") == 0) config.statsPort = atoi(argv[i + 1]);
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    config.threads = std::max(1, std::min(config.threads, config.connections));
+
+    std::vector<std::unique_ptr<ClientThread>> clients;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.threads; ++i) {
+        int first = (int)((int64_t)config.connections * i / config.threads);
+        int last = (int)((int64_t)config.connections * (i + 1) / config.threads);
+        clients.emplace_back(new ClientThread(config, i, first, last));
+        threads.emplace_back(&ClientThread::run, clients.back().get());
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    ClientStats total;
+    bool ok = true;
+    for (const auto& client : clients) {
+        total.moves += client->stats.moves;
+        total.shuffles += client->stats.shuffles;
+        total.games += client->stats.games;
+        total.desyncs += client->stats.desyncs;
+        total.errors += client->stats.errors;
+        total.rtt.merge(client->stats.rtt);
+        ok = ok && client->ok;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << config.connections * config.sessionsPerConnection << " sessions on " << config.connections
+              << " connections: " << total.moves << " moves (" << total.moves / (double)config.seconds
+              << " moves/sec), " << total.shuffles << " shuffles, " << total.games << " games finished" << std::endl;
+    std::cout << "Round trip: p50 " << total.rtt.percentile(0.50) << " ms, p99 " << total.rtt.percentile(0.99)
+              << " ms, max " << total.rtt.max() << " ms" << std::endl;
+    std::cout << "Desyncs " << total.desyncs << ", errors " << total.errors << std::endl;
+
+    if (config.statsPort != 0) {
+        printServerStats(config);
+    }
+    return ok && total.desyncs == 0 ? 0 : 1;
+}
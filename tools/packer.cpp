@@ -0,0 +1,186 @@
+// Đóng gói res/ và arial.ttf thành assets.pak
+// Cách dùng (chạy trong thư mục game): packer [--decode] [output.pak]
+//   --decode: lưu sẵn ảnh dạng RGBA32 và WAV dạng PCM 44100Hz/16-bit/stereo
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../assetpack.h"
+
+namespace fs = std::filesystem;
+
+struct PackItem {
+    PackEntry entry;
+    std::vector<unsigned char> bytes;
+};
+
+static bool readFile(const std::string& filePath, std::vector<unsigned char>& bytes) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool decodeImage(const std::string& filePath, PackItem& item) {
+    SDL_Surface* loaded = IMG_Load(filePath.c_str());
+    if (loaded == nullptr) {
+        std::cerr << "Failed to decode " << filePath << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (rgba == nullptr) {
+        return false;
+    }
+
+    item.entry.type = (uint32_t)PackEntryType::RGBA32;
+    item.entry.width = rgba->w;
+    item.entry.height = rgba->h;
+    item.bytes.resize((size_t)rgba->w * rgba->h * 4);
+    for (int y = 0; y < rgba->h; ++y) {
+        memcpy(&item.bytes[(size_t)y * rgba->w * 4], (unsigned char*)rgba->pixels + (size_t)y * rgba->pitch, rgba->w * 4);
+    }
+    SDL_FreeSurface(rgba);
+    return true;
+}
+
+// Chuyển về đúng format mà JewelGame::init truyền cho Mix_OpenAudio
+static bool decodeWav(const std::string& filePath, PackItem& item) {
+    const int frequency = 44100;
+    const int channels = 2;
+
+    SDL_AudioSpec spec;
+    Uint8* buffer = nullptr;
+    Uint32 length = 0;
+    if (SDL_LoadWAV(filePath.c_str(), &spec, &buffer, &length) == nullptr) {
+        std::cerr << "Failed to decode " << filePath << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    SDL_AudioCVT cvt;
+    SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_S16SYS, channels, frequency);
+    std::vector<unsigned char> work((size_t)length * std::max(1, cvt.len_mult));
+    memcpy(work.data(), buffer, length);
+    SDL_FreeWAV(buffer);
+
+    cvt.buf = work.data();
+    cvt.len = length;
+    if (cvt.needed && SDL_ConvertAudio(&cvt) != 0) {
+        std::cerr << "Failed to convert " << filePath << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    item.entry.type = (uint32_t)PackEntryType::PCM;
+    item.entry.width = frequency;
+    item.entry.height = channels;
+    item.bytes.assign(work.begin(), work.begin() + (cvt.needed ? cvt.len_cvt : length));
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool decode = false;
+    std::string outputPath = "assets.pak";
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--decode") == 0) {
+            decode = true;
+        } else {
+            outputPath = argv[i];
+        }
+    }
+
+    if (SDL_Init(0) < 0 || !(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        std::cerr << "SDL init failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> files = {"arial.ttf"};
+    for (const auto& dirEntry : fs::directory_iterator("res")) {
+        if (dirEntry.is_regular_file()) {
+            files.push_back("res/" + dirEntry.path().filename().string());
+        }
+    }
+    std::sort(files.begin(), files.end()); // AssetPack::find tìm nhị phân
+
+    std::vector<PackItem> items;
+    for (const auto& filePath : files) {
+        if (filePath.size() >= (size_t)PACK_NAME_LENGTH) {
+            std::cerr << "Name too long, skipped: " << filePath << std::endl;
+            continue;
+        }
+
+        PackItem item = {};
+        strncpy(item.entry.name, filePath.c_str(), PACK_NAME_LENGTH - 1);
+
+        std::string extension = fs::path(filePath).extension().string();
+        bool decoded = false;
+        if (decode && extension == ".png") {
+            decoded = decodeImage(filePath, item);
+        } else if (decode && extension == ".wav") {
+            decoded = decodeWav(filePath, item);
+        }
+
+        if (!decoded) {
+            item.entry.type = (uint32_t)PackEntryType::Raw;
+            if (!readFile(filePath, item.bytes)) {
+                std::cerr << "Failed to read " << filePath << std::endl;
+                return 1;
+            }
+        }
+        items.push_back(std::move(item));
+    }
+
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open " << outputPath << std::endl;
+        return 1;
+    }
+
+    uint64_t offset = sizeof(PackHeader);
+    auto align = [](uint64_t value) { return (value + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT; };
+
+    PackHeader header = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const char padding[PACK_ALIGNMENT] = {};
+    for (auto& item : items) {
+        uint64_t aligned = align(offset);
+        out.write(padding, aligned - offset);
+        item.entry.offset = aligned;
+        item.entry.size = item.bytes.size();
+        out.write(reinterpret_cast<const char*>(item.bytes.data()), item.bytes.size());
+        offset = aligned + item.bytes.size();
+
+        std::cout << item.entry.name << " (" << (item.entry.type == (uint32_t)PackEntryType::Raw ? "raw" : "decoded")
+                  << ", " << item.entry.size << " bytes)" << std::endl;
+    }
+
+    uint64_t indexOffset = align(offset);
+    out.write(padding, indexOffset - offset);
+    for (const auto& item : items) {
+        out.write(reinterpret_cast<const char*>(&item.entry), sizeof(PackEntry));
+    }
+
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.entryCount = items.size();
+    header.alignment = PACK_ALIGNMENT;
+    header.indexOffset = indexOffset;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+
+    std::cout << "Wrote " << outputPath << ": " << items.size() << " entries" << std::endl;
+
+    IMG_Quit();
+    SDL_Quit();
+    return 0;
+}
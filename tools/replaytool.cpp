@@ -0,0 +1,273 @@
+// Công cụ cho luồng replay .jlrp (replaystream.h).
+// Cách dùng: replaytool [--minutes N] [--level N] [--seed N] [--out FILE]   ghi một ván Timed Mode do bot chơi nhịp người
+//            replaytool --verify FILE                                      dựng lại ván, so với mọi keyframe
+//            replaytool --fanout VIEWERS [--threads N] [--minutes N]       nhiều người xem đọc chung một feed đang ghi
+//
+// Bot đi ngẫu nhiên mỗi 1.5-3.5 giây và chơi hết thời gian của level (không dừng khi đạt mục tiêu),
+// để đo kích thước của cả một phiên dài nhất.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../board.h"
+#include "../levels.h"
+#include "../replaystream.h"
+
+struct ToolConfig {
+    int minutes = 0; // 0 = theo thời lượng của level
+    int level = 2;   // Chỉ số trong defaultTimedModeLevels(), mặc định level 20 phút
+    uint64_t seed = 1;
+    std::string outFile;
+    std::string verifyFile;
+    int viewers = 0;
+    int threads = 0;
+};
+
+struct SessionStats {
+    uint32_t moves = 0;
+    uint32_t shuffles = 0;
+    uint32_t durationMs = 0;
+    int score = 0;
+    int targetScore = 0;
+};
+
+// Ghi một ván vào feed; engine giữ trạng thái cuối để so với người xem
+static SessionStats recordSession(const ToolConfig& config, ReplayFeed& feed, BoardEngine& engine) {
+    std::vector<TimedModeLevel> levels = defaultTimedModeLevels();
+    const TimedModeLevel& level = levels[std::max(0, std::min(config.level, (int)levels.size() - 1))];
+    uint32_t limitMs = (uint32_t)(config.minutes > 0 ? config.minutes * 60 : level.duration) * 1000;
+
+    ReplayRecorder recorder(feed);
+    engine.rng.seed(config.seed);
+    engine.initBoard();
+    engine.score = 0;
+    engine.listener = &recorder;
+
+    ReplayHeader header;
+    header.version = REPLAY_VERSION;
+    header.mode = REPLAY_MODE_TIMED;
+    header.timedLevel = (int8_t)config.level;
+    header.keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+    header.createdAt = 0;
+    recorder.begin(engine, header, 0);
+
+    SessionStats stats;
+    stats.targetScore = level.targetScore;
+    JewelRng bot(config.seed * 31 + 7);
+    uint32_t now = 0;
+    for (;;) {
+        now += 1500 + bot.below(2001);
+        if (now >= limitMs) break;
+
+        Move moves[MAX_MOVES];
+        int count = engine.listMoves(moves);
+        if (count == 0) {
+            engine.shuffle();
+            recorder.keyframe(KEYFRAME_SHUFFLE, now);
+            ++stats.shuffles;
+            continue;
+        }
+        const Move& move = moves[bot.below(count)];
+        recorder.beginMove(move, now);
+        recorder.endMove(engine.trySwap(move.x1, move.y1, move.x2, move.y2));
+    }
+
+    recorder.end(engine.score >= level.targetScore ? REPLAY_WON : REPLAY_LOST, limitMs);
+    engine.listener = nullptr;
+    stats.moves = recorder.moveCount();
+    stats.durationMs = limitMs;
+    stats.score = engine.score;
+    return stats;
+}
+
+// Số keyframe lệch (hoặc -1 nếu luồng hỏng); expected khác nullptr thì so cả bàn cuối
+static int replayFeed(const ReplayFeed& feed, const BoardEngine* expected, bool verbose) {
+    ReplayCursor cursor(feed);
+    ReplayPlayer player;
+    ReplayRecord record;
+    uint32_t counts[4] = {0, 0, 0, 0};
+    size_t bytes[4] = {0, 0, 0, 0};
+    int maxDepth = 0;
+    while (cursor.next(record)) {
+        if (!player.apply(record)) {
+            std::cerr << "Corrupt record at offset " << record.offset << std::endl;
+            return -1;
+        }
+        if (record.type < 4) {
+            ++counts[record.type];
+            bytes[record.type] += record.size + 2;
+        }
+        maxDepth = std::max(maxDepth, player.lastCascadeDepth);
+    }
+    if (cursor.corrupt() || !player.ended) {
+        std::cerr << (cursor.corrupt() ? "Corrupt stream" : "Stream has no END record") << std::endl;
+        return -1;
+    }
+
+    int mismatches = player.keyframeMismatches;
+    if (expected && (memcmp(player.cells, expected->cells, sizeof(player.cells)) != 0 || player.score != expected->score)) {
+        ++mismatches;
+    }
+    if (verbose) {
+        ReplayHeader header;
+        feed.header(header);
+        std::cout << "Replay: mode " << (int)header.mode << ", level " << (int)header.timedLevel << ", "
+                  << feed.committed() << " bytes, " << player.moveIndex << " moves over " << player.timeMs / 1000
+                  << " s, final score " << player.score << ", result " << (int)player.result << std::endl;
+        std::cout << "Records: " << counts[REPLAY_MOVE] << " moves (" << bytes[REPLAY_MOVE] << " bytes, "
+                  << std::fixed << std::setprecision(2)
+                  << (counts[REPLAY_MOVE] ? (double)bytes[REPLAY_MOVE] / counts[REPLAY_MOVE] : 0.0) << " per move), "
+                  << counts[REPLAY_KEYFRAME] << " keyframes (" << bytes[REPLAY_KEYFRAME] << " bytes), deepest cascade "
+                  << maxDepth << std::endl;
+        std::cout << (mismatches == 0 ? "All keyframes match the reconstructed board"
+                                      : "MISMATCHED keyframes: " + std::to_string(mismatches)) << std::endl;
+    }
+    return mismatches;
+}
+
+static int runRecord(const ToolConfig& config) {
+    std::unique_ptr<ReplayFeed> feed(new ReplayFeed());
+    BoardEngine engine;
+    SessionStats stats = recordSession(config, *feed, engine);
+    std::cout << "Recorded " << stats.durationMs / 60000 << " min session: " << stats.moves << " moves, "
+              << stats.shuffles << " shuffles, score " << stats.score << " (target " << stats.targetScore << ")" << std::endl;
+    std::cout << "Stream size " << feed->committed() << " bytes; a snapshot per move would be "
+              << (size_t)(stats.moves + 1) * sizeof(GameSnapshot) << " bytes" << std::endl;
+
+    if (!config.outFile.empty()) {
+        std::vector<uint8_t> bytes = feed->image();
+        std::ofstream file(config.outFile, std::ios::binary);
+        if (!file || !file.write((const char*)bytes.data(), (std::streamsize)bytes.size())) {
+            std::cerr << "Failed to write " << config.outFile << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << config.outFile << std::endl;
+    }
+    return replayFeed(*feed, &engine, true) == 0 ? 0 : 1;
+}
+
+static int runVerify(const ToolConfig& config) {
+    std::unique_ptr<ReplayFeed> feed(new ReplayFeed());
+    if (!feed->load(config.verifyFile)) {
+        return 1;
+    }
+    return replayFeed(*feed, nullptr, true) == 0 ? 0 : 1;
+}
+
+// Mọi người xem bám theo feed trong lúc bot còn đang ghi; mỗi người xem chỉ có cursor và bàn dựng lại
+static int runFanout(const ToolConfig& config) {
+    int threads = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, config.viewers);
+    std::unique_ptr<ReplayFeed> feed(new ReplayFeed());
+    BoardEngine engine;
+
+    std::vector<ReplayCursor> cursors(config.viewers, ReplayCursor(*feed));
+    std::vector<ReplayPlayer> players(config.viewers);
+
+    std::atomic<uint64_t> records{0};
+    std::atomic<int> corrupt{0};
+    std::vector<std::thread> workers;
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            // Mỗi thread một dải liền, tránh hai thread ghi chung cache line
+            int first = (int)((int64_t)config.viewers * t / threads);
+            int last = (int)((int64_t)config.viewers * (t + 1) / threads);
+            uint64_t decoded = 0;
+            int remaining = last - first;
+            while (remaining > 0) {
+                bool progressed = false;
+                for (int i = first; i < last; ++i) {
+                    ReplayPlayer& player = players[i];
+                    if (player.ended) continue;
+                    ReplayRecord record;
+                    while (cursors[i].next(record)) {
+                        progressed = true;
+                        ++decoded;
+                        if (!player.apply(record)) {
+                            ++corrupt;
+                            player.ended = true;
+                        }
+                        if (player.ended) {
+                            --remaining;
+                            break;
+                        }
+                    }
+                    if (cursors[i].corrupt() && !player.ended) {
+                        ++corrupt;
+                        player.ended = true;
+                        --remaining;
+                    }
+                }
+                if (!progressed) std::this_thread::yield();
+            }
+            records += decoded;
+        });
+    }
+
+    SessionStats stats = recordSession(config, *feed, engine);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // Người xem vào sau cùng: nhảy tới keyframe mới nhất rồi đọc tiếp
+    ReplayCursor late(*feed, feed->latestKeyframe());
+    ReplayPlayer latePlayer;
+    ReplayRecord record;
+    while (late.next(record)) latePlayer.apply(record);
+
+    int mismatched = 0;
+    for (const ReplayPlayer& player : players) {
+        if (player.keyframeMismatches > 0 || memcmp(player.cells, engine.cells, sizeof(engine.cells)) != 0) ++mismatched;
+    }
+    bool lateOk = memcmp(latePlayer.cells, engine.cells, sizeof(engine.cells)) == 0 && latePlayer.score == engine.score;
+
+    uint64_t perViewer = records / config.viewers;
+    int cores = std::min(threads, (int)std::max(1u, std::thread::hardware_concurrency()));
+    double perCore = records / seconds / cores;
+    double liveRate = perViewer / (stats.durationMs / 1000.0);
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << config.viewers << " viewers on " << threads << " threads: " << records << " records ("
+              << perViewer << " each, " << feed->committed() << " byte stream) in " << seconds * 1000.0 << " ms" << std::endl;
+    std::cout << "Decode throughput " << perCore / 1e6 << " M records/s per core; at live pace ("
+              << std::setprecision(2) << liveRate << " records/s) one core keeps up with "
+              << std::setprecision(0) << perCore / liveRate << " viewers" << std::endl;
+    std::cout << "Per-viewer state " << sizeof(ReplayCursor) + sizeof(ReplayPlayer) << " bytes; late joiner from keyframe "
+              << (lateOk ? "matches" : "MISMATCHES") << std::endl;
+    std::cout << (mismatched == 0 && corrupt == 0 ? "All viewers match the writer"
+                                                  : "MISMATCHED viewers: " + std::to_string(mismatched + corrupt)) << std::endl;
+    return mismatched == 0 && corrupt == 0 && lateOk ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    ToolConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--minutes" && hasValue) config.minutes = atoi(argv[++i]);
+        else if (arg == "--level" && hasValue) config.level = atoi(argv[++i]) - 1;
+        else if (arg == "--seed" && hasValue) config.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--out" && hasValue) config.outFile = argv[++i];
+        else if (arg == "--verify" && hasValue) config.verifyFile = argv[++i];
+        else if (arg == "--fanout" && hasValue) config.viewers = std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) config.threads = atoi(argv[++i]);
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (!config.verifyFile.empty()) return runVerify(config);
+    if (config.viewers > 0) return runFanout(config);
+    return runRecord(config);
+}
@@ -0,0 +1,173 @@
+// Sinh dữ liệu self-play ra file dataset (JLDS), mỗi thread một file: PREFIX.N.jlds
+// Cách dùng: selfplay [--out PREFIX] [--games N] [--moves N] [--threads N] [--chunk ROWS]
+//                     [--explore P] [--seed N]
+//            selfplay --read FILE   (kiểm tra CRC và in thống kê)
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../bot.h"
+#include "../dataset.h"
+
+struct SelfPlayConfig {
+    std::string outPrefix = "selfplay";
+    int games = 1000;     // Tổng số ván, chia đều cho các thread
+    int maxMoves = 200;   // Số nước mỗi ván
+    int threads = 0;      // 0 = số core
+    uint32_t chunkRows = 65536;
+    double explore = 0.1; // Xác suất chọn nước ngẫu nhiên thay vì greedy
+    uint64_t seed = 1;
+};
+
+struct GeneratorStats {
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+    double stallMs = 0.0;
+    bool ok = true;
+};
+
+static void printUsage(std::ostream& out) {
+    out << "Usage: selfplay [--out PREFIX] [--games N] [--moves N] [--threads N] [--chunk ROWS]\n"
+           "                [--explore P] [--seed N]\n"
+           "       selfplay --read FILE" << std::endl;
+}
+
+static void generate(const SelfPlayConfig& config, int index, int firstGame, int lastGame, GeneratorStats& stats) {
+    DatasetWriter writer;
+    std::string filePath = config.outPrefix + "." + std::to_string(index) + ".jlds";
+    if (!writer.open(filePath, config.chunkRows)) {
+        std::cerr << "Generator " << index << ": cannot open " << filePath << std::endl;
+        stats.ok = false;
+        return;
+    }
+
+    TransitionRecorder recorder;
+    JewelRng policy(config.seed * 0x9E3779B97F4A7C15ULL + index);
+    Move moves[MAX_MOVES];
+
+    for (int game = firstGame; game < lastGame; ++game) {
+        BoardEngine engine;
+        engine.rng.seed(config.seed ^ ((uint64_t)game << 20));
+        engine.initBoard();
+        engine.listener = &recorder;
+
+        for (int step = 0; step < config.maxMoves; ++step) {
+            int count = engine.listMoves(moves);
+            if (count == 0) break;
+
+            bool explore = policy() < config.explore * 4294967296.0;
+            Move move = explore ? moves[policy.below(count)] : greedyMove(engine, moves, count);
+
+            recorder.begin(engine, (uint64_t)game, move);
+            engine.trySwap(move.x1, move.y1, move.x2, move.y2);
+            writer.append(recorder.finish(engine));
+        }
+    }
+
+    stats.ok = writer.close();
+    stats.rows = writer.rowsWritten();
+    stats.bytes = writer.bytesWritten();
+    stats.stallMs = writer.stallMs();
+}
+
+static int readDataset(const std::string& filePath) {
+    DatasetReader reader;
+    if (!reader.open(filePath)) {
+        return 1;
+    }
+
+    std::vector<Transition> rows;
+    uint64_t episodes = 0;
+    uint64_t totalReward = 0;
+    uint64_t lastEpisode = ~0ULL;
+    int maxCascade = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t chunk = 0; chunk < reader.chunkCount(); ++chunk) {
+        if (!reader.readChunk(chunk, rows)) {
+            return 1;
+        }
+        for (const Transition& row : rows) {
+            if (row.episode != lastEpisode) {
+                ++episodes;
+                lastEpisode = row.episode;
+            }
+            totalReward += row.reward;
+            maxCascade = std::max(maxCascade, (int)row.cascadeDepth);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << filePath << ": " << reader.totalRows() << " transitions in " << reader.chunkCount()
+              << " chunks, " << episodes << " episodes, mean reward "
+              << (reader.totalRows() ? (double)totalReward / reader.totalRows() : 0.0)
+              << ", max cascade " << maxCascade << ", decoded in " << seconds * 1000.0 << " ms" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    SelfPlayConfig config;
+    for (int i = 1; i < argc; i += 2) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printUsage(std::cout);
+            return 0;
+        }
+        // Option cuối thiếu giá trị mà bỏ qua thì sẽ chạy cả đợt sinh dữ liệu mặc định
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for option: " << argv[i] << std::endl;
+            printUsage(std::cerr);
+            return 1;
+        }
+        if (strcmp(argv[i], "--read") == 0) return readDataset(argv[i + 1]);
+        else if (strcmp(argv[i], "--out") == 0) config.outPrefix = argv[i + 1];
+        else if (strcmp(argv[i], "--games") == 0) config.games = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--moves") == 0) config.maxMoves = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) config.threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--chunk") == 0) config.chunkRows = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--explore") == 0) config.explore = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) config.seed = strtoull(argv[i + 1], nullptr, 10);
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            printUsage(std::cerr);
+            return 1;
+        }
+    }
+    if (config.chunkRows == 0 || config.chunkRows > (1u << 24)) {
+        std::cerr << "--chunk must be between 1 and " << (1u << 24) << " rows" << std::endl;
+        return 1;
+    }
+
+    int threads = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<GeneratorStats> stats(threads);
+    std::vector<std::thread> generators;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < threads; ++i) {
+        int firstGame = (int)((int64_t)config.games * i / threads);
+        int lastGame = (int)((int64_t)config.games * (i + 1) / threads);
+        generators.emplace_back(generate, std::cref(config), i, firstGame, lastGame, std::ref(stats[i]));
+    }
+    for (std::thread& generator : generators) {
+        generator.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    GeneratorStats total;
+    for (const GeneratorStats& s : stats) {
+        total.rows += s.rows;
+        total.bytes += s.bytes;
+        total.stallMs += s.stallMs;
+        total.ok = total.ok && s.ok;
+    }
+
+    std::cout << total.rows << " transitions, " << total.bytes << " bytes ("
+              << (total.rows ? (double)total.bytes / total.rows : 0.0) << " bytes/transition) in "
+              << seconds << " s, " << total.rows / std::max(seconds, 1e-9) << " transitions/sec, writer stalls "
+              << total.stallMs << " ms" << std::endl;
+    return total.ok ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+// Chạy các ván versus giữa hai bot qua UDP loopback, có giả lập mạng, để thử rollback netcode.
+// Cách dùng: versussim [--matches N] [--target N] [--net LATENCY,JITTER,LOSS] [--delay FRAMES]
+//                      [--move-ms N] [--seed N] [--verbose]
+//
+// Mỗi ván kiểm tra hai phía ra cùng trạng thái cuối (cùng người thắng, cùng hai bàn, cùng điểm):
+// sai khác nghĩa là cascade không tất định hoặc rollback lỗi. In chi phí tua lại mỗi frame của cả hai phía.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../rollback.h"
+#include "../versuspeer.h"
+
+struct SimConfig {
+    int matches = 5;
+    int targetScore = 1500;
+    int inputDelay = 2;
+    int moveMs = 300;       // Bot đi trung bình mỗi bấy nhiêu ms (ngẫu nhiên trong [moveMs/2, moveMs*3/2])
+    uint64_t seed = 1;
+    NetConditions conditions;
+    bool verbose = false;
+};
+
+const uint32_t MATCH_TIMEOUT_MS = 300000;
+
+struct MatchTotals {
+    uint64_t frames = 0;
+    uint64_t rollbacks = 0;
+    uint64_t framesResimulated = 0;
+    uint64_t stalls = 0;
+    int maxDepth = 0;
+    LatencyHistogram resimMs{0.001};
+};
+
+static void accumulate(MatchTotals& totals, const RollbackStats& stats) {
+    totals.frames += stats.framesSimulated;
+    totals.rollbacks += stats.rollbacks;
+    totals.framesResimulated += stats.framesResimulated;
+    totals.stalls += stats.stalls;
+    totals.maxDepth = std::max(totals.maxDepth, stats.maxDepth);
+    totals.resimMs.merge(stats.resimMs);
+}
+
+static bool sameOutcome(const RollbackSession& a, const RollbackSession& b) {
+    if (a.winner() != b.winner()) return false;
+    for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+        GameSnapshot left = {}, right = {};
+        a.board(player).capture(left);
+        b.board(player).capture(right);
+        if (memcmp(&left, &right, sizeof(GameSnapshot)) != 0) return false;
+    }
+    return true;
+}
+
+// false nếu ván không xong hoặc hai phía lệch nhau
+static bool playMatch(const SimConfig& config, int index, MatchTotals& totals) {
+    VersusConfig versus;
+    versus.seed = config.seed + index;
+    versus.targetScore = config.targetScore;
+    versus.inputDelay = config.inputDelay;
+    versus.conditions = config.conditions;
+
+    VersusPeer peers[VERSUS_PLAYERS];
+    if (!peers[0].host(0, versus) || !peers[1].join("127.0.0.1", peers[0].localPort(), config.conditions)) {
+        return false;
+    }
+
+    JewelRng bots[VERSUS_PLAYERS] = {JewelRng(versus.seed * 31 + 1), JewelRng(versus.seed * 31 + 2)};
+    uint32_t nextMove[VERSUS_PLAYERS] = {0, 0};
+    auto begin = std::chrono::steady_clock::now();
+
+    for (;;) {
+        uint32_t now = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+
+        bool finished = true;
+        for (int player = 0; player < VERSUS_PLAYERS; ++player) {
+            VersusPeer& peer = peers[player];
+            peer.update(now);
+            RollbackSession* session = peer.session();
+            if (peer.disconnected() || now >= MATCH_TIMEOUT_MS) {
+                std::cerr << "Match " << index << ": " << (peer.disconnected() ? "peer disconnected" : "timed out") << std::endl;
+                return false;
+            }
+            if (!session || !session->resultConfirmed()) finished = false;
+
+            if (session && session->winner() < 0 && now >= nextMove[player]) {
+                Move moves[MAX_MOVES];
+                int count = session->board(session->localPlayer()).listMoves(moves);
+                if (count > 0) {
+                    session->setLocalInput((uint8_t)moveToAction(moves[bots[player].below(count)]));
+                }
+                nextMove[player] = now + config.moveMs / 2 + bots[player].below(config.moveMs + 1);
+            }
+        }
+        if (finished) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const RollbackSession& host = *peers[0].session();
+    const RollbackSession& guest = *peers[1].session();
+    bool same = sameOutcome(host, guest);
+    std::cout << "Match " << index << ": winner " << host.winner() << ", score " << host.board(0).score << " - "
+              << host.board(1).score << ", frames " << host.frame() << "/" << guest.frame() << ", rollbacks "
+              << host.stats().rollbacks << "/" << guest.stats().rollbacks << ", rtt " << peers[0].roundTripMs()
+              << " ms" << (same ? "" : "  DESYNC") << std::endl;
+    if (config.verbose) {
+        peers[0].report(std::cout);
+        peers[1].report(std::cout);
+    }
+
+    accumulate(totals, host.stats());
+    accumulate(totals, guest.stats());
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    SimConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--matches" && hasValue) config.matches = atoi(argv[++i]);
+        else if (arg == "--target" && hasValue) config.targetScore = atoi(argv[++i]);
+        else if (arg == "--delay" && hasValue) config.inputDelay = atoi(argv[++i]);
+        else if (arg == "--move-ms" && hasValue) config.moveMs = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) config.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--verbose") config.verbose = true;
+        else if (arg == "--net" && hasValue) {
+            if (!parseNetConditions(argv[++i], config.conditions)) {
+                std::cerr << "Invalid --net, expected LATENCY,JITTER,LOSS" << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Network: " << config.conditions.latencyMs << " ms +-" << config.conditions.jitterMs << " ms, "
+              << config.conditions.lossPercent << "% loss each way; input delay " << config.inputDelay << " frames" << std::endl;
+
+    MatchTotals totals;
+    int failed = 0;
+    for (int match = 0; match < config.matches; ++match) {
+        if (!playMatch(config, match, totals)) {
+            ++failed;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Frames " << totals.frames << ", rollbacks " << totals.rollbacks << " ("
+              << (totals.frames ? 100.0 * totals.rollbacks / totals.frames : 0.0) << "% of frames), resimulated "
+              << totals.framesResimulated << " frames, max depth " << totals.maxDepth << ", stalled ticks " << totals.stalls << std::endl;
+    std::cout << "Re-simulation cost per rollback frame: mean " << totals.resimMs.mean() << " ms, p99 "
+              << totals.resimMs.percentile(0.99) << " ms, max " << totals.resimMs.max() << " ms" << std::endl;
+    std::cout << (failed == 0 ? "All matches consistent" : "FAILED matches: " + std::to_string(failed)) << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Triple buffer không khóa giữa một writer và một reader.
+// Writer ghi vào writeBuffer() rồi publish(); reader gọi acquire() để lấy bản mới nhất.
+// Hai bên không bao giờ chờ nhau: writer luôn có ô trống, reader giữ ô của mình tới lần acquire sau.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : m_middle(1), m_back(0), m_front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer: ô này có thể chứa dữ liệu cũ từ vài lần trước, cần ghi lại toàn bộ
+    T& writeBuffer() { return m_slots[m_back]; }
+
+    void publish() {
+        uint8_t previous = m_middle.exchange(m_back | DIRTY, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+    }
+
+    // Reader: true nếu có bản mới từ lần acquire trước
+    bool acquire() {
+        if (!(m_middle.load(std::memory_order_acquire) & DIRTY)) {
+            return false;
+        }
+        uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return m_slots[m_front]; }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t DIRTY = 0x4;
+
+    T m_slots[3];
+    alignas(64) std::atomic<uint8_t> m_middle; // Chỉ số ô ở giữa | DIRTY nếu chưa được đọc
+    alignas(64) uint8_t m_back;                // Chỉ writer dùng
+    alignas(64) uint8_t m_front;               // Chỉ reader dùng
+};
+
+#endif
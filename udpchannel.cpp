@@ -0,0 +1,199 @@
+#include "udpchannel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+static const intptr_t INVALID_UDP_SOCKET = (intptr_t)INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+static const intptr_t INVALID_UDP_SOCKET = -1;
+#endif
+
+static_assert(sizeof(sockaddr_in) <= 32, "peer address buffer too small");
+
+bool parseNetConditions(const std::string& text, NetConditions& conditions) {
+    NetConditions parsed;
+    int fields = sscanf(text.c_str(), "%d,%d,%d", &parsed.latencyMs, &parsed.jitterMs, &parsed.lossPercent);
+    if (fields < 1 || parsed.latencyMs < 0 || parsed.jitterMs < 0 || parsed.lossPercent < 0 || parsed.lossPercent > 100) {
+        return false;
+    }
+    conditions = parsed;
+    return true;
+}
+
+UdpChannel::UdpChannel()
+    : m_socket(INVALID_UDP_SOCKET), m_hasPeer(false), m_handshakeSize(0), m_queued(0), m_sent(0), m_dropped(0) {
+    memset(m_peer, 0, sizeof(m_peer));
+}
+
+void UdpChannel::setHandshake(const uint8_t* prefix, size_t size) {
+    m_handshakeSize = std::min(size, MAX_HANDSHAKE_PREFIX);
+    memcpy(m_handshake, prefix, m_handshakeSize);
+}
+
+UdpChannel::~UdpChannel() {
+    close();
+}
+
+bool UdpChannel::open(uint16_t port) {
+    close();
+#ifdef _WIN32
+    static bool winsockReady = false;
+    if (!winsockReady) {
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            std::cerr << "WSAStartup failed" << std::endl;
+            return false;
+        }
+        winsockReady = true;
+    }
+#endif
+
+    m_socket = (intptr_t)socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket == INVALID_UDP_SOCKET) {
+        std::cerr << "Failed to create UDP socket" << std::endl;
+        return false;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(m_socket, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::cerr << "Failed to bind UDP port " << port << std::endl;
+        close();
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(m_socket, FIONBIO, &nonBlocking);
+#else
+    fcntl((int)m_socket, F_SETFL, fcntl((int)m_socket, F_GETFL) | O_NONBLOCK);
+#endif
+    return true;
+}
+
+bool UdpChannel::setPeer(const std::string& host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        std::cerr << "Failed to resolve " << host << std::endl;
+        return false;
+    }
+
+    sockaddr_in addr;
+    memcpy(&addr, result->ai_addr, sizeof(addr));
+    freeaddrinfo(result);
+    addr.sin_port = htons(port);
+    memcpy(m_peer, &addr, sizeof(addr));
+    m_hasPeer = true;
+    return true;
+}
+
+void UdpChannel::close() {
+    if (m_socket != INVALID_UDP_SOCKET) {
+#ifdef _WIN32
+        closesocket(m_socket);
+#else
+        ::close((int)m_socket);
+#endif
+    }
+    m_socket = INVALID_UDP_SOCKET;
+    m_hasPeer = false;
+    m_queued = 0;
+}
+
+uint16_t UdpChannel::localPort() const {
+    sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    if (m_socket == INVALID_UDP_SOCKET || getsockname(m_socket, (sockaddr*)&addr, &length) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+void UdpChannel::setConditions(const NetConditions& conditions, uint64_t seed) {
+    m_conditions = conditions;
+    m_rng.seed(seed);
+}
+
+void UdpChannel::sendNow(const uint8_t* data, size_t size) {
+    sendto(m_socket, (const char*)data, (int)size, 0, (const sockaddr*)m_peer, sizeof(sockaddr_in));
+}
+
+void UdpChannel::send(const uint8_t* data, size_t size, uint32_t now) {
+    if (m_socket == INVALID_UDP_SOCKET || !m_hasPeer || size > MAX_DATAGRAM) return;
+    ++m_sent;
+
+    if (!m_conditions.active()) {
+        sendNow(data, size);
+        return;
+    }
+    if (m_conditions.lossPercent > 0 && m_rng.below(100) < m_conditions.lossPercent) {
+        ++m_dropped;
+        return;
+    }
+    if (m_queued == NETSIM_QUEUE) {
+        ++m_dropped; // Hàng đợi giả lập đầy: coi như router bỏ gói
+        return;
+    }
+
+    int jitter = m_conditions.jitterMs > 0 ? m_rng.below(2 * m_conditions.jitterMs + 1) - m_conditions.jitterMs : 0;
+    Delayed& delayed = m_queue[m_queued++];
+    delayed.deliverAt = now + (uint32_t)std::max(0, m_conditions.latencyMs + jitter);
+    delayed.size = (uint16_t)size;
+    memcpy(delayed.data, data, size);
+}
+
+void UdpChannel::flush(uint32_t now) {
+    // Hàng đợi nhỏ, quét tuyến tính; gói tới hạn lấy ra bằng cách đổi chỗ với phần tử cuối
+    for (int i = 0; i < m_queued;) {
+        if ((int32_t)(now - m_queue[i].deliverAt) >= 0) {
+            sendNow(m_queue[i].data, m_queue[i].size);
+            if (i != m_queued - 1) {
+                memcpy(&m_queue[i], &m_queue[m_queued - 1], sizeof(Delayed));
+            }
+            --m_queued;
+        } else {
+            ++i;
+        }
+    }
+}
+
+size_t UdpChannel::receive(uint8_t* data, size_t capacity) {
+    if (m_socket == INVALID_UDP_SOCKET) return 0;
+
+    for (;;) {
+        sockaddr_in from = {};
+        socklen_t fromLength = sizeof(from);
+        int received = (int)recvfrom(m_socket, (char*)data, (int)capacity, 0, (sockaddr*)&from, &fromLength);
+        if (received <= 0) return 0;
+
+        sockaddr_in peer;
+        memcpy(&peer, m_peer, sizeof(peer));
+        if (!m_hasPeer) {
+            if ((size_t)received < m_handshakeSize || memcmp(data, m_handshake, m_handshakeSize) != 0) {
+                continue; // Chưa chào thì không được làm peer
+            }
+            memcpy(m_peer, &from, sizeof(from));
+            m_hasPeer = true;
+        } else if (peer.sin_addr.s_addr != from.sin_addr.s_addr || peer.sin_port != from.sin_port) {
+            continue; // Gói từ máy khác, bỏ qua
+        }
+        return (size_t)received;
+    }
+}
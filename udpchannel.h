@@ -0,0 +1,77 @@
+#ifndef UDPCHANNEL_H
+#define UDPCHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rng.h"
+
+const size_t MAX_DATAGRAM = 512;
+const size_t MAX_HANDSHAKE_PREFIX = 16;
+const int NETSIM_QUEUE = 256; // Số gói giữ lại tối đa trong bộ giả lập mạng
+
+// Điều kiện mạng giả lập cho gói gửi đi: độ trễ cố định + jitter ngẫu nhiên (có thể đảo thứ tự gói) + tỉ lệ mất gói
+struct NetConditions {
+    int latencyMs = 0;
+    int jitterMs = 0;
+    int lossPercent = 0;
+
+    bool active() const { return latencyMs > 0 || jitterMs > 0 || lossPercent > 0; }
+};
+
+// "80,20,5" -> latency 80 ms, jitter ±20 ms, mất 5% gói
+bool parseNetConditions(const std::string& text, NetConditions& conditions);
+
+// Socket UDP không chặn (Winsock / BSD socket) kèm bộ giả lập mạng.
+// Mọi hàm nhận thời gian hiện tại (ms) từ người gọi, không phụ thuộc SDL.
+class UdpChannel {
+public:
+    UdpChannel();
+    ~UdpChannel();
+
+    UdpChannel(const UdpChannel&) = delete;
+    UdpChannel& operator=(const UdpChannel&) = delete;
+
+    bool open(uint16_t port);                          // 0 = cổng bất kỳ
+    bool setPeer(const std::string& host, uint16_t port);
+    void close();
+
+    bool hasPeer() const { return m_hasPeer; }
+    uint16_t localPort() const;
+    void setConditions(const NetConditions& conditions, uint64_t seed);
+    // Phía host: chỉ nhận làm peer người gửi gói bắt đầu bằng prefix này (gói chào), gói khác trước đó bỏ qua
+    void setHandshake(const uint8_t* prefix, size_t size);
+
+    void send(const uint8_t* data, size_t size, uint32_t now); // Tới peer, qua bộ giả lập
+    // Nhận một gói; chưa có peer thì lấy người gửi gói chào đầu tiên làm peer (phía host). Trả về số byte, 0 nếu không có.
+    size_t receive(uint8_t* data, size_t capacity);
+    void flush(uint32_t now); // Gửi các gói giả lập đã tới hạn
+
+    uint64_t sentCount() const { return m_sent; }
+    uint64_t droppedCount() const { return m_dropped; }
+
+private:
+    struct Delayed {
+        uint32_t deliverAt;
+        uint16_t size;
+        uint8_t data[MAX_DATAGRAM];
+    };
+
+    void sendNow(const uint8_t* data, size_t size);
+
+    intptr_t m_socket;
+    bool m_hasPeer;
+    uint8_t m_peer[32]; // sockaddr_in, giữ dạng byte để header không kéo theo winsock/socket.h
+    uint8_t m_handshake[MAX_HANDSHAKE_PREFIX];
+    size_t m_handshakeSize;
+
+    NetConditions m_conditions;
+    JewelRng m_rng;
+    Delayed m_queue[NETSIM_QUEUE];
+    int m_queued;
+    uint64_t m_sent;
+    uint64_t m_dropped;
+};
+
+#endif
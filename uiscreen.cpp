@@ -0,0 +1,200 @@
+#include "uiscreen.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "constants.h"
+
+namespace {
+    const SDL_Color DISABLED_COLOR = {150, 150, 150, 255};
+    const SDL_Color BUTTON_TEXT_COLOR = {0, 0, 0, 255};
+
+    bool sameColor(SDL_Color a, SDL_Color b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    }
+
+    // Giống isButtonClicked cũ: tính cả cạnh phải và cạnh dưới
+    bool contains(const SDL_Rect& rect, int x, int y) {
+        return x >= rect.x && x <= rect.x + rect.w && y >= rect.y && y <= rect.y + rect.h;
+    }
+}
+
+UiScreen::UiScreen() : m_atlas(nullptr), m_columns(0), m_rows(0) {}
+
+UiScreen::~UiScreen() {
+    release();
+}
+
+int UiScreen::addButton(SDL_Rect rect, const char* text, SDL_Color color, UiAction action, int param) {
+    return add(rect, text, color, UiStyle::Button, action, param);
+}
+
+int UiScreen::addLabel(SDL_Rect rect, const char* text, SDL_Color color, UiAction action) {
+    return add(rect, text, color, UiStyle::Label, action, 0);
+}
+
+int UiScreen::add(SDL_Rect rect, const char* text, SDL_Color color, UiStyle style, UiAction action, int param) {
+    if ((int)m_widgets.size() >= MAX_UI_WIDGETS) {
+        std::cerr << "Too many widgets on one screen: " << text << std::endl;
+        return -1;
+    }
+    UiWidget widget = {};
+    widget.rect = rect;
+    widget.color = color;
+    widget.style = style;
+    widget.action = action;
+    widget.param = param;
+    m_widgets.push_back(widget);
+    m_texts.push_back(text);
+    return (int)m_widgets.size() - 1;
+}
+
+bool UiScreen::build(SDL_Renderer* renderer, TTF_Font* font) {
+    release();
+
+    // Render chữ một lần, xếp chồng theo chiều dọc vào một surface
+    std::vector<SDL_Surface*> surfaces(m_widgets.size(), nullptr);
+    int atlasWidth = 1, atlasHeight = 0;
+    for (size_t i = 0; i < m_widgets.size(); ++i) {
+        UiWidget& widget = m_widgets[i];
+        SDL_Color textColor = widget.style == UiStyle::Button ? BUTTON_TEXT_COLOR : widget.color;
+        surfaces[i] = m_texts[i].empty() ? nullptr : TTF_RenderText_Solid(font, m_texts[i].c_str(), textColor);
+        if (!surfaces[i]) {
+            widget.textSource = {0, 0, 0, 0};
+            widget.textRect = {widget.rect.x, widget.rect.y, 0, 0};
+            continue;
+        }
+
+        widget.textSource = {0, atlasHeight, surfaces[i]->w, surfaces[i]->h};
+        atlasWidth = std::max(atlasWidth, surfaces[i]->w);
+        atlasHeight += surfaces[i]->h;
+
+        if (widget.style == UiStyle::Label && widget.rect.w == 0) {
+            widget.rect.w = surfaces[i]->w;
+            widget.rect.h = surfaces[i]->h;
+        }
+        // Canh giữa theo kích thước đo được, không đoán theo số ký tự
+        widget.textRect = {widget.rect.x + (widget.rect.w - surfaces[i]->w) / 2,
+                           widget.rect.y + (widget.rect.h - surfaces[i]->h) / 2,
+                           surfaces[i]->w, surfaces[i]->h};
+    }
+
+    bool ok = true;
+    if (atlasHeight > 0) {
+        SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+        if (atlas) {
+            SDL_FillRect(atlas, nullptr, SDL_MapRGBA(atlas->format, 0, 0, 0, 0));
+            for (size_t i = 0; i < m_widgets.size(); ++i) {
+                if (!surfaces[i]) continue;
+                SDL_Rect target = m_widgets[i].textSource;
+                SDL_BlitSurface(surfaces[i], nullptr, atlas, &target);
+            }
+            m_atlas = SDL_CreateTextureFromSurface(renderer, atlas);
+            SDL_FreeSurface(atlas);
+        }
+        if (m_atlas) {
+            SDL_SetTextureBlendMode(m_atlas, SDL_BLENDMODE_BLEND);
+        } else {
+            std::cerr << "Failed to build UI text atlas: " << SDL_GetError() << std::endl;
+            ok = false;
+        }
+    }
+    for (SDL_Surface* surface : surfaces) {
+        if (surface) SDL_FreeSurface(surface);
+    }
+
+    buildGrid();
+    return ok;
+}
+
+void UiScreen::buildGrid() {
+    m_columns = (SCREEN_WIDTH + UI_GRID_CELL - 1) / UI_GRID_CELL;
+    m_rows = (SCREEN_HEIGHT + UI_GRID_CELL - 1) / UI_GRID_CELL;
+    int cells = m_columns * m_rows;
+
+    // Đếm rồi điền, thứ tự vẽ giữ nguyên trong mỗi ô
+    std::vector<std::vector<uint8_t>> covering(cells);
+    for (size_t i = 0; i < m_widgets.size(); ++i) {
+        const UiWidget& widget = m_widgets[i];
+        if (widget.action == UiAction::None) continue;
+        int left = std::max(0, widget.rect.x / UI_GRID_CELL);
+        int top = std::max(0, widget.rect.y / UI_GRID_CELL);
+        int right = std::min(m_columns - 1, (widget.rect.x + widget.rect.w) / UI_GRID_CELL);
+        int bottom = std::min(m_rows - 1, (widget.rect.y + widget.rect.h) / UI_GRID_CELL);
+        for (int row = top; row <= bottom; ++row) {
+            for (int column = left; column <= right; ++column) {
+                covering[row * m_columns + column].push_back((uint8_t)i);
+            }
+        }
+    }
+
+    m_cellStart.assign(cells + 1, 0);
+    m_cellWidgets.clear();
+    for (int cell = 0; cell < cells; ++cell) {
+        m_cellStart[cell] = (uint16_t)m_cellWidgets.size();
+        m_cellWidgets.insert(m_cellWidgets.end(), covering[cell].begin(), covering[cell].end());
+    }
+    m_cellStart[cells] = (uint16_t)m_cellWidgets.size();
+}
+
+void UiScreen::release() {
+    if (m_atlas) {
+        SDL_DestroyTexture(m_atlas);
+        m_atlas = nullptr;
+    }
+}
+
+void UiScreen::draw(SDL_Renderer* renderer, uint32_t hidden, uint32_t disabled) const {
+    // Nền nút: gom các nút cùng màu vào một SDL_RenderFillRects
+    SDL_Rect rects[MAX_UI_WIDGETS];
+    uint32_t pending = 0;
+    for (int i = 0; i < (int)m_widgets.size(); ++i) {
+        if (m_widgets[i].style == UiStyle::Button && !(hidden & (1u << i))) pending |= 1u << i;
+    }
+    while (pending) {
+        int first = 0;
+        while (!(pending & (1u << first))) ++first;
+        SDL_Color color = (disabled & (1u << first)) ? DISABLED_COLOR : m_widgets[first].color;
+        int count = 0;
+        for (int i = first; i < (int)m_widgets.size(); ++i) {
+            if (!(pending & (1u << i))) continue;
+            SDL_Color other = (disabled & (1u << i)) ? DISABLED_COLOR : m_widgets[i].color;
+            if (sameColor(color, other)) {
+                rects[count++] = m_widgets[i].rect;
+                pending &= ~(1u << i);
+            }
+        }
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(renderer, rects, count);
+    }
+
+    // Chữ: mọi lệnh copy cùng một texture, SDL gộp thành một batch
+    if (!m_atlas) return;
+    for (int i = 0; i < (int)m_widgets.size(); ++i) {
+        const UiWidget& widget = m_widgets[i];
+        if ((hidden & (1u << i)) || widget.textSource.w == 0) continue;
+        SDL_RenderCopy(renderer, m_atlas, &widget.textSource, &widget.textRect);
+    }
+}
+
+int UiScreen::hitTest(int x, int y, uint32_t hidden) const {
+    if (x < 0 || y < 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT || m_cellStart.empty()) {
+        return -1;
+    }
+    int cell = (y / UI_GRID_CELL) * m_columns + x / UI_GRID_CELL;
+    // Widget thêm sau được vẽ đè lên nên được ưu tiên
+    for (int k = m_cellStart[cell + 1] - 1; k >= m_cellStart[cell]; --k) {
+        int index = m_cellWidgets[k];
+        if (!(hidden & (1u << index)) && contains(m_widgets[index].rect, x, y)) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+UiAction UiScreen::actionAt(int x, int y, uint32_t hidden, int* param) const {
+    int index = hitTest(x, y, hidden);
+    if (index < 0) return UiAction::None;
+    if (param) *param = m_widgets[index].param;
+    return m_widgets[index].action;
+}
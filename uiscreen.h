@@ -0,0 +1,91 @@
+#ifndef UISCREEN_H
+#define UISCREEN_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Một màn giao diện giữ sẵn (retained): nút và chữ tĩnh được thêm một lần, build() đo chữ thật,
+// gói mọi chữ của màn vào một texture và dựng lưới hit-test. Mỗi frame chỉ còn vài lệnh fill theo màu
+// và RenderCopy từ cùng một texture; một cú bấm chỉ xét các widget phủ ô lưới chứa điểm bấm.
+// Trạng thái động (ẩn, xám) truyền vào dưới dạng mask nên sim thread và render thread dùng chung một màn.
+enum class UiAction : uint8_t {
+    None, // Chữ tĩnh, không bấm được
+    Start,
+    Continue,
+    Instructions,
+    Back,
+    NormalMode,
+    PracticeMode,
+    TimedMode,
+    TimedLevel, // param là chỉ số level
+    EndlessMode,
+    Shuffle,
+    Restart,
+    Pause,
+    Resume,
+    Undo,
+    Redo,
+    BackToMainMenu
+};
+
+enum class UiStyle : uint8_t {
+    Button, // Nền màu, chữ đen canh giữa
+    Label   // Chỉ có chữ
+};
+
+struct UiWidget {
+    SDL_Rect rect;
+    SDL_Color color;     // Màu nền của nút, màu chữ của nhãn
+    UiStyle style;
+    UiAction action;
+    int param;
+    SDL_Rect textSource; // Vị trí chữ trong atlas của màn
+    SDL_Rect textRect;   // Vị trí chữ trên màn hình, tính một lần trong build()
+};
+
+const int MAX_UI_WIDGETS = 32;  // Một bit mỗi widget trong mask ẩn/xám
+const int UI_GRID_CELL = 40;    // px, một cạnh ô lưới hit-test
+
+class UiScreen {
+public:
+    UiScreen();
+    ~UiScreen();
+
+    UiScreen(const UiScreen&) = delete;
+    UiScreen& operator=(const UiScreen&) = delete;
+
+    // Trả chỉ số widget (để làm mask), -1 nếu đầy. Nhãn có rect.w = 0 thì lấy đúng kích thước chữ, (x, y) là góc trái trên.
+    int addButton(SDL_Rect rect, const char* text, SDL_Color color, UiAction action, int param = 0);
+    int addLabel(SDL_Rect rect, const char* text, SDL_Color color, UiAction action = UiAction::None);
+
+    // Gọi một lần trên render thread khi đã có font, trước khi sim thread hỏi hitTest
+    bool build(SDL_Renderer* renderer, TTF_Font* font);
+    void release();
+
+    void draw(SDL_Renderer* renderer, uint32_t hidden = 0, uint32_t disabled = 0) const;
+    int hitTest(int x, int y, uint32_t hidden = 0) const; // Widget trên cùng chứa điểm bấm, -1 nếu trượt
+    UiAction actionAt(int x, int y, uint32_t hidden = 0, int* param = nullptr) const;
+
+    const UiWidget& widget(int index) const { return m_widgets[index]; }
+    int widgetCount() const { return (int)m_widgets.size(); }
+
+private:
+    int add(SDL_Rect rect, const char* text, SDL_Color color, UiStyle style, UiAction action, int param);
+    void buildGrid();
+
+    std::vector<UiWidget> m_widgets;
+    std::vector<std::string> m_texts;
+    SDL_Texture* m_atlas;
+
+    // Lưới phủ cả màn hình: widget của ô c nằm ở m_cellWidgets[m_cellStart[c] .. m_cellStart[c + 1])
+    int m_columns;
+    int m_rows;
+    std::vector<uint16_t> m_cellStart;
+    std::vector<uint8_t> m_cellWidgets;
+};
+
+#endif
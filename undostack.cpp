@@ -0,0 +1,42 @@
+#include "undostack.h"
+
+UndoStack::UndoStack() : m_start(0), m_undoCount(0), m_redoCount(0) {}
+
+void UndoStack::clear() {
+    m_start = 0;
+    m_undoCount = 0;
+    m_redoCount = 0;
+}
+
+void UndoStack::push(const GameSnapshot& before) {
+    if (m_undoCount == CAPACITY) {
+        m_start = (m_start + 1) % CAPACITY;
+        m_undoCount--;
+    }
+    slot(m_undoCount) = before;
+    m_undoCount++;
+    m_redoCount = 0;
+}
+
+// Đổi chỗ trạng thái hiện tại với ô lịch sử, nên undo rồi redo không cần thêm bộ nhớ
+bool UndoStack::undo(const GameSnapshot& current, GameSnapshot& out) {
+    if (m_undoCount == 0) return false;
+
+    GameSnapshot saved = current; // current và out có thể là cùng một biến
+    m_undoCount--;
+    out = slot(m_undoCount);
+    slot(m_undoCount) = saved;
+    m_redoCount++;
+    return true;
+}
+
+bool UndoStack::redo(const GameSnapshot& current, GameSnapshot& out) {
+    if (m_redoCount == 0) return false;
+
+    GameSnapshot saved = current;
+    out = slot(m_undoCount);
+    slot(m_undoCount) = saved;
+    m_undoCount++;
+    m_redoCount--;
+    return true;
+}
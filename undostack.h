@@ -0,0 +1,31 @@
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include "gamesnapshot.h"
+
+// Lịch sử undo/redo kích thước cố định cho Practice Mode.
+// Khi đầy thì bản cũ nhất bị ghi đè; không cấp phát động.
+class UndoStack {
+public:
+    static const int CAPACITY = 64;
+
+    UndoStack();
+
+    void clear();
+    void push(const GameSnapshot& before); // Gọi ngay trước mỗi nước đi, xóa nhánh redo
+    bool undo(const GameSnapshot& current, GameSnapshot& out);
+    bool redo(const GameSnapshot& current, GameSnapshot& out);
+
+    int undoCount() const { return m_undoCount; }
+    int redoCount() const { return m_redoCount; }
+
+private:
+    GameSnapshot& slot(int index) { return m_ring[(m_start + index) % CAPACITY]; }
+
+    GameSnapshot m_ring[CAPACITY];
+    int m_start;     // Vị trí bản cũ nhất
+    int m_undoCount; // Các bản [0, m_undoCount) là quá khứ
+    int m_redoCount; // Các bản [m_undoCount, m_undoCount + m_redoCount) là tương lai
+};
+
+#endif
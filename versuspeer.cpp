@@ -0,0 +1,162 @@
+#include "versuspeer.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "sessionprotocol.h"
+
+namespace {
+    const size_t INPUT_HEADER_SIZE = 10;
+    const size_t WELCOME_SIZE = 18;
+}
+
+bool VersusPeer::host(uint16_t port, const VersusConfig& config) {
+    m_config = config;
+    m_isHost = true;
+    if (!m_channel.open(port)) {
+        return false;
+    }
+    m_channel.setConditions(config.conditions, config.seed ^ 0x686F7374ULL);
+    uint8_t hello[5];
+    hello[0] = VERSUS_HELLO;
+    putU32(hello + 1, VERSUS_MAGIC);
+    m_channel.setHandshake(hello, sizeof(hello));
+    return true;
+}
+
+bool VersusPeer::join(const std::string& host, uint16_t port, const NetConditions& conditions) {
+    m_config.conditions = conditions;
+    m_isHost = false;
+    if (!m_channel.open(0) || !m_channel.setPeer(host, port)) {
+        return false;
+    }
+    m_channel.setConditions(conditions, 0x6A6F696EULL ^ port);
+    return true;
+}
+
+void VersusPeer::start(uint64_t seed, int targetScore, int inputDelay, int localPlayer, uint32_t now) {
+    m_session.reset(new RollbackSession(seed, targetScore, localPlayer, inputDelay));
+    m_startTime = now;
+    m_lastReceive = now;
+    std::cout << "Versus started: player " << localPlayer << ", seed " << seed << ", target " << targetScore
+              << ", input delay " << inputDelay << " frames" << std::endl;
+}
+
+void VersusPeer::update(uint32_t now) {
+    uint8_t packet[MAX_DATAGRAM];
+    size_t size;
+    while ((size = m_channel.receive(packet, sizeof(packet))) > 0) {
+        m_lastReceive = now;
+        handlePacket(packet, size, now);
+    }
+
+    if (!m_session) {
+        // Khách gọi chủ tới khi có WELCOME
+        if (!m_isHost && now - m_lastSend >= VERSUS_HELLO_INTERVAL_MS) {
+            packet[0] = VERSUS_HELLO;
+            putU32(packet + 1, VERSUS_MAGIC);
+            m_channel.send(packet, 5, now);
+            m_lastSend = now;
+        }
+        m_channel.flush(now);
+        return;
+    }
+
+    if (now - m_lastReceive >= VERSUS_TIMEOUT_MS) {
+        m_disconnected = true;
+    }
+
+    // Bên chạy trước (thường là chủ, bắt đầu sớm hơn một lượt đi của gói) nhường một frame mỗi lần,
+    // để đoán sai dồn đều cho hai phía thay vì một phía tua lại hết
+    int remoteNow = (int)m_remoteFrame + m_roundTripMs / 2 / (int)VERSUS_FRAME_MS;
+    if ((int)m_session->frame() - remoteNow >= 2 && m_session->frame() >= m_nextSyncFrame) {
+        m_startTime += VERSUS_FRAME_MS;
+        m_nextSyncFrame = m_session->frame() + VERSUS_SYNC_INTERVAL;
+        ++m_syncDelays;
+    }
+
+    // Chạy các frame tới hạn; dừng ngay khi phải chờ input đối thủ
+    uint32_t targetFrame = (now - m_startTime) / VERSUS_FRAME_MS;
+    bool advanced = false;
+    while (m_session->frame() < targetFrame && m_session->advance()) {
+        advanced = true;
+    }
+
+    if (advanced || now - m_lastSend >= VERSUS_FRAME_MS) {
+        sendInputs(now);
+    }
+    m_channel.flush(now);
+}
+
+void VersusPeer::sendWelcome(uint32_t now) {
+    uint8_t packet[WELCOME_SIZE];
+    packet[0] = VERSUS_WELCOME;
+    putU32(packet + 1, VERSUS_MAGIC);
+    putU64(packet + 5, m_config.seed);
+    putU32(packet + 13, (uint32_t)m_config.targetScore);
+    packet[17] = (uint8_t)m_config.inputDelay;
+    m_channel.send(packet, sizeof(packet), now);
+}
+
+void VersusPeer::sendInputs(uint32_t now) {
+    uint32_t end = m_session->localInputEnd();
+    uint32_t start = std::max(m_peerAck, end > (uint32_t)VERSUS_RING ? end - VERSUS_RING : 0);
+    uint32_t count = std::min<uint32_t>(end - start, 255);
+
+    uint8_t packet[INPUT_HEADER_SIZE + 255];
+    packet[0] = VERSUS_INPUT;
+    putU32(packet + 1, m_session->remoteConfirmed());
+    putU32(packet + 5, start);
+    packet[9] = (uint8_t)count;
+    for (uint32_t i = 0; i < count; ++i) {
+        packet[INPUT_HEADER_SIZE + i] = m_session->localInput(start + i);
+    }
+    m_channel.send(packet, INPUT_HEADER_SIZE + count, now);
+    m_lastSend = now;
+
+    if (m_probeFrame == 0 && end > m_peerAck) {
+        m_probeFrame = end;
+        m_probeSentAt = now;
+    }
+}
+
+void VersusPeer::handlePacket(const uint8_t* data, size_t size, uint32_t now) {
+    if (data[0] == VERSUS_HELLO) {
+        if (!m_isHost || size < 5 || getU32(data + 1) != VERSUS_MAGIC) return;
+        sendWelcome(now); // Trả lời mọi HELLO, phòng WELCOME trước bị mất
+        if (!m_session) {
+            start(m_config.seed, m_config.targetScore, m_config.inputDelay, 0, now);
+        }
+    } else if (data[0] == VERSUS_WELCOME) {
+        if (m_isHost || m_session || size < WELCOME_SIZE || getU32(data + 1) != VERSUS_MAGIC) return;
+        m_config.seed = getU64(data + 5);
+        m_config.targetScore = (int32_t)getU32(data + 13);
+        m_config.inputDelay = data[17];
+        start(m_config.seed, m_config.targetScore, m_config.inputDelay, 1, now);
+    } else if (data[0] == VERSUS_INPUT) {
+        if (!m_session || size < INPUT_HEADER_SIZE || size < INPUT_HEADER_SIZE + data[9]) return;
+
+        uint32_t ack = getU32(data + 1);
+        m_peerAck = std::max(m_peerAck, std::min(ack, m_session->localInputEnd()));
+        if (m_probeFrame != 0 && m_peerAck >= m_probeFrame) {
+            int sample = (int)(now - m_probeSentAt);
+            m_roundTripMs = m_roundTripMs == 0 ? sample : (m_roundTripMs * 7 + sample) / 8;
+            m_probeFrame = 0;
+        }
+
+        uint32_t start = getU32(data + 5);
+        uint32_t end = start + data[9];
+        m_remoteFrame = std::max(m_remoteFrame, end >= (uint32_t)m_config.inputDelay ? end - m_config.inputDelay : 0);
+        for (uint32_t i = 0; i < data[9]; ++i) {
+            m_session->addRemoteInput(start + i, data[INPUT_HEADER_SIZE + i]);
+        }
+    }
+}
+
+void VersusPeer::report(std::ostream& out) const {
+    out << "[versus] rtt " << m_roundTripMs << " ms, packets sent " << m_channel.sentCount()
+        << ", dropped by netsim " << m_channel.droppedCount() << ", time sync waited " << m_syncDelays << " frames" << std::endl;
+    if (m_session) {
+        m_session->report(out);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef VERSUSPEER_H
+#define VERSUSPEER_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "rollback.h"
+#include "udpchannel.h"
+
+// Gói UDP của versus mode: [u8 kiểu][payload], little-endian như sessionprotocol.h.
+//   HELLO   u32 magic                                       (khách -> chủ, lặp lại tới khi có WELCOME)
+//   WELCOME u32 magic, u64 seed, i32 targetScore, u8 inputDelay (chủ -> khách, trả lời mỗi HELLO)
+//   INPUT   u32 ack (frame đầu tiên chưa nhận của bên kia), u32 start, u8 count, count byte input
+// INPUT gửi lại toàn bộ input cục bộ bên kia chưa ack, nên mất gói chỉ làm chậm chứ không mất input.
+const uint32_t VERSUS_MAGIC = 0x4A565331; // "JVS1"
+const uint32_t VERSUS_FRAME_MS = 16;
+const uint32_t VERSUS_HELLO_INTERVAL_MS = 100;
+const uint32_t VERSUS_TIMEOUT_MS = 5000; // Không nghe gì từ đối thủ lâu vậy thì coi như mất kết nối
+const int VERSUS_SYNC_INTERVAL = 10;     // Frame giữa hai lần chậm lại để đợi đối thủ
+
+enum VersusPacket : uint8_t {
+    VERSUS_HELLO = 1,
+    VERSUS_WELCOME = 2,
+    VERSUS_INPUT = 3
+};
+
+struct VersusConfig {
+    uint64_t seed = 1;
+    int targetScore = 1500;
+    int inputDelay = 2; // Frame; lớn hơn thì ít rollback hơn nhưng nước đi trễ hơn
+    NetConditions conditions;
+};
+
+// Một phía của ván versus: bắt tay, chạy RollbackSession theo nhịp VERSUS_FRAME_MS, trao đổi input.
+// Chủ (host) chọn seed và là người chơi 0, khách (join) là người chơi 1.
+class VersusPeer {
+public:
+    bool host(uint16_t port, const VersusConfig& config);
+    bool join(const std::string& host, uint16_t port, const NetConditions& conditions);
+
+    void update(uint32_t now); // Nhận gói, chạy các frame tới hạn, gửi input
+
+    bool started() const { return m_session != nullptr; }
+    bool disconnected() const { return m_disconnected; }
+    RollbackSession* session() { return m_session.get(); }
+    const RollbackSession* session() const { return m_session.get(); }
+    uint16_t localPort() const { return m_channel.localPort(); }
+    int roundTripMs() const { return m_roundTripMs; }
+
+    void report(std::ostream& out) const;
+
+private:
+    void start(uint64_t seed, int targetScore, int inputDelay, int localPlayer, uint32_t now);
+    void handlePacket(const uint8_t* data, size_t size, uint32_t now);
+    void sendInputs(uint32_t now);
+    void sendWelcome(uint32_t now);
+
+    UdpChannel m_channel;
+    VersusConfig m_config;
+    bool m_isHost = false;
+    std::unique_ptr<RollbackSession> m_session;
+
+    uint32_t m_startTime = 0;
+    uint32_t m_lastSend = 0;
+    uint32_t m_lastReceive = 0;
+    uint32_t m_peerAck = 0;      // Bên kia đã có input của ta cho [0, m_peerAck)
+    uint32_t m_remoteFrame = 0;  // Frame của bên kia lúc gửi gói INPUT mới nhất
+    uint32_t m_nextSyncFrame = 0;
+    uint32_t m_syncDelays = 0;   // Số frame đã nhường để hai bên chạy cùng nhịp
+    bool m_disconnected = false;
+
+    // RTT ước lượng: thời điểm gửi frame cục bộ mới nhất, đo khi ack vượt qua nó
+    uint32_t m_probeFrame = 0;
+    uint32_t m_probeSentAt = 0;
+    int m_roundTripMs = 0;
+};
+
+#endif